@@ -0,0 +1,48 @@
+/**
+ * @file alloc.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * Counts heap allocations made by venus itself. The allocator entry points are replaced in the benchmark executable and
+ * only calls from the executable's own code are counted, so allocations inside Xlib, Mesa and the C library do not
+ * hide ours.
+ */
+
+#include "bench.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *memory, size_t size);
+
+// Bounds of the executable's code, provided by the linker
+extern char __executable_start;
+extern char etext;
+
+static atomic_ulong g_bench_allocations = 0;
+
+static inline void bench_count(void *caller) {
+	if ((char*) caller >= &__executable_start && (char*) caller < &etext)
+		atomic_fetch_add_explicit(&g_bench_allocations, 1, memory_order_relaxed);
+}
+
+void *malloc(size_t size) {
+	bench_count(__builtin_return_address(0));
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+	bench_count(__builtin_return_address(0));
+	return __libc_calloc(n, size);
+}
+
+void *realloc(void *memory, size_t size) {
+	bench_count(__builtin_return_address(0));
+	return __libc_realloc(memory, size);
+}
+
+unsigned long bench_allocations() {
+	return atomic_load_explicit(&g_bench_allocations, memory_order_relaxed);
+}
@@ -0,0 +1,155 @@
+/**
+ * @file bench.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+bench_options g_bench_options = {NULL, 1.0};
+
+static bench_result g_bench_results[BENCH_MAX_RESULTS];
+static unsigned g_bench_n_results = 0;
+static unsigned g_bench_failures = 0;
+
+unsigned long bench_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long) now.tv_sec * 1000000000ul + now.tv_nsec;
+}
+
+int bench_selected(const char *name) {
+	return !g_bench_options.filter || strstr(name, g_bench_options.filter);
+}
+
+static int bench_compare_doubles(const void *a, const void *b) {
+	double x = *(const double*) a;
+	double y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+static double bench_percentile(double *sorted, unsigned n, double percentile) {
+	unsigned index = (unsigned) (percentile * (n - 1) + 0.5);
+	return sorted[index];
+}
+
+void bench_record_unit(const char *name, const char *unit, double *values, unsigned n) {
+	if (!n || g_bench_n_results == BENCH_MAX_RESULTS)
+		return;
+	qsort(values, n, sizeof(double), bench_compare_doubles);
+
+	bench_result *result = &g_bench_results[g_bench_n_results++];
+	snprintf(result->name, BENCH_NAME, "%s", name);
+	result->unit = unit;
+	result->samples = n;
+	result->min = values[0];
+	result->p50 = bench_percentile(values, n, 0.5);
+	result->p90 = bench_percentile(values, n, 0.9);
+	result->p99 = bench_percentile(values, n, 0.99);
+	result->max = values[n - 1];
+
+	double sum = 0;
+	for (unsigned i = 0; i < n; ++i)
+		sum += values[i];
+	result->mean = sum / n;
+
+	fprintf(stderr, "%-32s p50 %12.1f %s  p99 %12.1f %s\n", result->name, result->p50, unit, result->p99, unit);
+}
+
+void bench_record(const char *name, double *ns, unsigned n) {
+	bench_record_unit(name, "ns", ns, n);
+}
+
+void bench_fail(const char *name, const char *message) {
+	fprintf(stderr, "%-32s FAILED: %s\n", name, message);
+	g_bench_failures++;
+}
+
+unsigned bench_failures() {
+	return g_bench_failures;
+}
+
+void bench_run(const char *name, void (*func)(void*), void (*reset)(void*), void *arg, unsigned ops, unsigned samples) {
+	if (!bench_selected(name))
+		return;
+
+	samples = (unsigned) (samples * g_bench_options.scale);
+	if (samples < 10)
+		samples = 10;
+	unsigned warmup = samples / 10;
+
+	double *ns = malloc(sizeof(double) * samples);
+	if (!ns)
+		return;
+
+	for (unsigned i = 0; i < warmup + samples; ++i) {
+		if (reset)
+			reset(arg);
+		unsigned long start = bench_now();
+		func(arg);
+		unsigned long elapsed = bench_now() - start;
+		if (i >= warmup)
+			ns[i - warmup] = (double) elapsed / ops;
+	}
+
+	bench_record(name, ns, samples);
+	free(ns);
+}
+
+void bench_write_json(FILE *file) {
+	fputs("{\"results\": [\n", file);
+	for (unsigned i = 0; i < g_bench_n_results; ++i) {
+		bench_result *result = &g_bench_results[i];
+		fprintf(file, "{\"name\": \"%s\", \"unit\": \"%s\", \"samples\": %u, \"min\": %.1f, \"p50\": %.1f, "
+			"\"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f, \"mean\": %.1f}%s\n",
+			result->name, result->unit, result->samples, result->min, result->p50, result->p90, result->p99, result->max,
+			result->mean, i + 1 < g_bench_n_results ? "," : ""
+		);
+	}
+	fputs("]}\n", file);
+}
+
+static bench_result *bench_find(const char *name) {
+	for (unsigned i = 0; i < g_bench_n_results; ++i)
+		if (!strcmp(g_bench_results[i].name, name))
+			return &g_bench_results[i];
+	return NULL;
+}
+
+int bench_compare(const char *path, double threshold) {
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		fprintf(stderr, "Failed to open baseline %s\n", path);
+		return -1;
+	}
+
+	int regressions = 0;
+	char line[512];
+	printf("%-32s %12s %12s %8s\n", "benchmark", "baseline", "current", "change");
+	while (fgets(line, sizeof(line), file)) {
+		char name[BENCH_NAME];
+		char *p50 = strstr(line, "\"p50\": ");
+		if (!p50 || sscanf(line, " {\"name\": \"%63[^\"]\"", name) != 1)
+			continue;
+		double baseline = strtod(p50 + 7, NULL);
+
+		bench_result *result = bench_find(name);
+		if (!result) {
+			printf("%-32s %12.1f %12s\n", name, baseline, "missing");
+			continue;
+		}
+
+		// Counts, such as allocations or round trips, do not jitter like times do, so any increase is a regression
+		double change = baseline > 0 ? result->p50 / baseline - 1.0 : 0.0;
+		int regressed = strcmp(result->unit, "ns") ? result->p50 > baseline : change > threshold;
+		regressions += regressed;
+		printf("%-32s %12.1f %12.1f %+7.1f%%%s\n", name, baseline, result->p50, change * 100.0,
+			regressed ? "  REGRESSION" : "");
+	}
+	fclose(file);
+	return regressions;
+}
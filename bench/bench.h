@@ -0,0 +1,179 @@
+/**
+ * @file bench.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Benchmark harness used by venus_bench
+ *
+ * A benchmark is a function timed over a number of samples. Each sample is divided by the number of operations the
+ * function performs, and the samples are reduced to percentiles. Results are written as JSON with one result per line,
+ * which is also the format a baseline is read back in.
+ */
+
+#ifndef VS_BENCH_H
+#define VS_BENCH_H
+
+#include <stdio.h>
+
+/// Longest benchmark name
+#define BENCH_NAME			64
+
+/// Most results one run can hold
+#define BENCH_MAX_RESULTS	128
+
+/**
+ * @brief Percentiles of one benchmark, in nanoseconds per operation unless the unit says otherwise
+ */
+typedef struct {
+	char name[BENCH_NAME];
+	const char *unit;
+	unsigned samples;
+	double min;
+	double p50;
+	double p90;
+	double p99;
+	double max;
+	double mean;
+} bench_result;
+
+/**
+ * @brief Options shared by every benchmark in a run
+ */
+typedef struct {
+	/// Only benchmarks whose name contains this run, or all of them if it is NULL
+	const char *filter;
+
+	/// Multiplies the number of samples each benchmark takes
+	double scale;
+} bench_options;
+
+extern bench_options g_bench_options;
+
+/**
+ * @brief Gets the CLOCK_MONOTONIC time
+ *
+ * @return Returns the time in nanoseconds
+ */
+unsigned long bench_now();
+
+/**
+ * @brief Checks whether a benchmark was selected with --filter
+ *
+ * @param name Name of the benchmark
+ *
+ * @return Returns whether it should run
+ */
+int bench_selected(const char *name);
+
+/**
+ * @brief Times a function and records its percentiles
+ *
+ * The first tenth of the samples are thrown away to warm caches and lazy initialization.
+ *
+ * @param name Name of the benchmark
+ * @param func Function to time
+ * @param reset Function called before each sample without being timed, or NULL
+ * @param arg Argument passed to both functions
+ * @param ops Number of operations one call of func performs
+ * @param samples Number of samples to take before scaling
+ */
+void bench_run(const char *name, void (*func)(void*), void (*reset)(void*), void *arg, unsigned ops, unsigned samples);
+
+/**
+ * @brief Records percentiles of samples timed by the caller
+ *
+ * Scenarios that time whole frames take the samples themselves and hand them over here.
+ *
+ * @param name Name of the benchmark
+ * @param ns Sample times in nanoseconds. They are sorted in place.
+ * @param n Number of samples
+ */
+void bench_record(const char *name, double *ns, unsigned n);
+
+/**
+ * @brief Records percentiles of samples in a unit other than nanoseconds
+ *
+ * @param name Name of the benchmark
+ * @param unit Unit of the samples, such as "allocs"
+ * @param values Sample values. They are sorted in place.
+ * @param n Number of samples
+ */
+void bench_record_unit(const char *name, const char *unit, double *values, unsigned n);
+
+/**
+ * @brief Records a check that failed
+ *
+ * Checks are pass or fail, unlike benchmarks, so a failure makes venus_bench exit with 3 whatever the baseline says.
+ *
+ * @param name Name of the check
+ * @param message What went wrong
+ */
+void bench_fail(const char *name, const char *message);
+
+/**
+ * @brief Gets the number of checks that failed
+ *
+ * @return Returns the number of calls to bench_fail()
+ */
+unsigned bench_failures();
+
+/**
+ * @brief Gets the number of heap allocations venus has made
+ *
+ * @return Returns the number of calls to malloc(), calloc() and realloc() made from venus code
+ */
+unsigned long bench_allocations();
+
+/**
+ * @brief Gets the number of times the process has waited for the X server
+ *
+ * @return Returns the number of calls to xcb_wait_for_reply(), xcb_wait_for_reply64() and xcb_request_check(), from
+ * venus, Xlib and GLX alike
+ */
+unsigned long bench_round_trips();
+
+/**
+ * @brief Writes every result as JSON
+ *
+ * @param file File to write to
+ */
+void bench_write_json(FILE *file);
+
+/**
+ * @brief Compares the results against a baseline written by bench_write_json()
+ *
+ * A benchmark regresses when its median is slower than the baseline's by more than the threshold. Results in a unit
+ * other than nanoseconds are counts and regress when their median is above the baseline's at all. Benchmarks missing
+ * from either side are reported but do not count as regressions.
+ *
+ * @param path Path of the baseline
+ * @param threshold Allowed slowdown, such as 0.1 for 10%
+ *
+ * @return Returns the number of regressions, or -1 if the baseline could not be read
+ */
+int bench_compare(const char *path, double threshold);
+
+/**
+ * @brief Runs the micro-benchmarks
+ */
+void bench_micro();
+
+/**
+ * @brief Runs the scenarios that draw into real windows
+ *
+ * @return Returns whether it was successful or not
+ */
+int bench_macro();
+
+/**
+ * @brief Replays a recording from venus_record_events() into the table scenario and times every frame
+ *
+ * The replay runs in VS_REPLAY_FAST mode, so every run draws the same frames with the same input.
+ *
+ * @param path Path of the recording
+ *
+ * @return Returns whether it was successful or not
+ */
+int bench_replay(const char *path);
+
+#endif
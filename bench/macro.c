@@ -0,0 +1,547 @@
+/**
+ * @file macro.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * These scenarios open real windows, so they need an X server. Run them under Xvfb with Mesa's llvmpipe, as bench/run.sh
+ * does, to get numbers that do not depend on the machine's GPU.
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <X11/Xlib.h>
+
+#include "../src/venus.h"
+#include "../src/venus_common.h"
+#include "../src/window.h"
+#include "../src/engine/graphics.h"
+#include "../src/toolkit/ui.h"
+#include "../src/toolkit/widget.h"
+#include "../src/toolkit/widgets/panel.h"
+#include "../src/toolkit/widgets/text_field.h"
+
+#define BENCH_FRAMES		200
+#define BENCH_WARMUP		10
+#define BENCH_OPENS			20
+
+#define BENCH_PANELS		10000
+#define BENCH_TABLE_ROWS	100
+#define BENCH_TABLE_COLUMNS	8
+#define BENCH_ROW_HEIGHT	20
+#define BENCH_COLUMN_WIDTH	150
+
+#define BENCH_UI_GROUPS		200
+#define BENCH_UI_FIELDS		99
+#define BENCH_UI_SAMPLES	10
+#define BENCH_UI_SOURCE		"/tmp/venus_bench_ui.txt"
+#define BENCH_UI_BLOB		"/tmp/venus_bench_ui.vsui"
+
+// Enough widgets for four slices of VS_RECORD_MIN_SLICE each
+#define BENCH_THREAD_WIDGETS	2048
+#define BENCH_THREAD_COLUMNS	64
+#define BENCH_THREAD_CAPTURE	"/tmp/venus_bench_threads%u.raw"
+
+static int bench_frame(window *win) {
+	venus_process_events();
+	if (!draw_window(win))
+		return VS_FAILURE;
+	return swap_buffers(win);
+}
+
+static int bench_open_window(window *win) {
+	if (!create_window(win))
+		return VS_FAILURE;
+	show(win);
+	return VS_SUCCESS;
+}
+
+/*
+ * Times frames of a window, calling step before each one. The warm up frames let the layer and texture caches settle.
+ * Heap allocations are counted per frame alongside, since a settled frame should not make any.
+ */
+static void bench_frames(const char *name, window *win, void (*step)(window*, unsigned)) {
+	if (!bench_selected(name))
+		return;
+
+	unsigned frames = (unsigned) (BENCH_FRAMES * g_bench_options.scale);
+	if (frames < 10)
+		frames = 10;
+	double *ns = malloc(sizeof(double) * frames * 2);
+	if (!ns)
+		return;
+	double *allocations = ns + frames;
+
+	for (unsigned i = 0; i < BENCH_WARMUP + frames; ++i) {
+		unsigned long allocated = bench_allocations();
+		unsigned long start = bench_now();
+		if (step)
+			step(win, i);
+		bench_frame(win);
+		unsigned long elapsed = bench_now() - start;
+		if (i >= BENCH_WARMUP) {
+			ns[i - BENCH_WARMUP] = (double) elapsed;
+			allocations[i - BENCH_WARMUP] = (double) (bench_allocations() - allocated);
+		}
+	}
+
+	char allocations_name[BENCH_NAME];
+	snprintf(allocations_name, BENCH_NAME, "%s_allocs", name);
+	bench_record(name, ns, frames);
+	bench_record_unit(allocations_name, "allocs", allocations, frames);
+	free(ns);
+}
+
+static void bench_window_open() {
+	if (!bench_selected("window_open"))
+		return;
+
+	double ns[BENCH_OPENS];
+	double round_trips[BENCH_OPENS];
+	for (unsigned i = 0; i < BENCH_OPENS; ++i) {
+		window win;
+		unsigned long start = bench_now();
+		unsigned long trips = bench_round_trips();
+		if (!bench_open_window(&win))
+			return;
+		round_trips[i] = (double) (bench_round_trips() - trips);
+		bench_frame(&win);
+		ns[i] = (double) (bench_now() - start);
+		destroy_window(&win);
+	}
+	bench_record("window_open", ns, BENCH_OPENS);
+
+	// Every wait on the server while opening is counted, so any new round trip fails the comparison with the baseline
+	bench_record_unit("window_open_round_trips", "round trips", round_trips, BENCH_OPENS);
+}
+
+/*
+ * Time to first frame of a 20k widget tree, built from a compiled blob and then imperatively one widget at a time.
+ */
+static int bench_ui_compile() {
+	FILE *source = fopen(BENCH_UI_SOURCE, "w");
+	if (!source)
+		return VS_FAILURE;
+	for (unsigned g = 0; g < BENCH_UI_GROUPS; ++g) {
+		fprintf(source, "panel name=group%u y=%u width=%u height=%u\n", g, g * BENCH_ROW_HEIGHT,
+			BENCH_UI_FIELDS * 12, BENCH_ROW_HEIGHT);
+		for (unsigned f = 0; f < BENCH_UI_FIELDS; ++f)
+			fprintf(source, "\ttext_field x=%u width=10 height=%u text=\"%u\"\n", f * 12, BENCH_ROW_HEIGHT, f);
+	}
+	fclose(source);
+	return compile_ui(BENCH_UI_SOURCE, BENCH_UI_BLOB);
+}
+
+static void bench_ui_imperative(window *win, vpanel **groups) {
+	for (unsigned g = 0; g < BENCH_UI_GROUPS; ++g) {
+		vpanel *group = create_panel();
+		group->y = (int) (g * BENCH_ROW_HEIGHT);
+		group->width = BENCH_UI_FIELDS * 12;
+		group->height = BENCH_ROW_HEIGHT;
+		add_widget(win, group);
+		for (unsigned f = 0; f < BENCH_UI_FIELDS; ++f) {
+			vtext_field *field = create_text_field();
+			field->x = (int) (f * 12);
+			field->width = 10;
+			field->height = BENCH_ROW_HEIGHT;
+			field->default_text = "0";
+			add_widget(group, field);
+		}
+		groups[g] = group;
+	}
+}
+
+static void bench_ui_first_frame() {
+	int compiled = bench_selected("ui_first_frame_20k");
+	int imperative = bench_selected("imperative_first_frame_20k");
+	if (!compiled && !imperative)
+		return;
+
+	window win;
+	if (!bench_open_window(&win))
+		return;
+	bench_frame(&win);
+
+	double ns[BENCH_UI_SAMPLES];
+	unsigned samples = 0;
+	for (compiled = compiled && bench_ui_compile(); compiled && samples < BENCH_UI_SAMPLES; ++samples) {
+		ui_blob blob;
+		unsigned long start = bench_now();
+		if (!load_ui(&win, &win, BENCH_UI_BLOB, &blob))
+			break;
+		bench_frame(&win);
+		ns[samples] = (double) (bench_now() - start);
+		unload_ui(&blob);
+	}
+	if (samples)
+		bench_record("ui_first_frame_20k", ns, samples);
+
+	vpanel *groups[BENCH_UI_GROUPS];
+	for (unsigned i = 0; imperative && i < BENCH_UI_SAMPLES; ++i) {
+		unsigned long start = bench_now();
+		bench_ui_imperative(&win, groups);
+		bench_frame(&win);
+		ns[i] = (double) (bench_now() - start);
+		for (unsigned g = 0; g < BENCH_UI_GROUPS; ++g)
+			destroy_widget(groups[g]);
+	}
+	if (imperative)
+		bench_record("imperative_first_frame_20k", ns, BENCH_UI_SAMPLES);
+
+	destroy_window(&win);
+}
+
+static void bench_panels() {
+	window win;
+	if (!bench_open_window(&win))
+		return;
+
+	vpanel **panels = malloc(sizeof(vpanel*) * BENCH_PANELS);
+	unsigned columns = 100;
+	for (unsigned i = 0; panels && i < BENCH_PANELS; ++i) {
+		panels[i] = create_panel();
+		panels[i]->x = (int) (i % columns) * 12;
+		panels[i]->y = (int) (i / columns) * 7;
+		panels[i]->width = 10;
+		panels[i]->height = 5;
+		add_widget(&win, panels[i]);
+	}
+
+	bench_frames("panels_10k", &win, NULL);
+
+	destroy_window(&win);
+	free(panels);
+}
+
+/*
+ * A table of text fields in one container. Scrolling moves the container, which invalidates every layer above it.
+ */
+typedef struct {
+	vpanel *body;
+	vtext_field **cells;
+} bench_table;
+
+static bench_table g_bench_table;
+
+static int bench_table_create(window *win) {
+	g_bench_table.body = create_panel();
+	g_bench_table.cells = malloc(sizeof(vtext_field*) * BENCH_TABLE_ROWS * BENCH_TABLE_COLUMNS);
+	if (!g_bench_table.body || !g_bench_table.cells)
+		return VS_FAILURE;
+
+	g_bench_table.body->width = BENCH_TABLE_COLUMNS * BENCH_COLUMN_WIDTH;
+	g_bench_table.body->height = BENCH_TABLE_ROWS * BENCH_ROW_HEIGHT;
+	add_widget(win, g_bench_table.body);
+
+	for (unsigned r = 0; r < BENCH_TABLE_ROWS; ++r) {
+		for (unsigned c = 0; c < BENCH_TABLE_COLUMNS; ++c) {
+			vtext_field *cell = create_text_field();
+			cell->x = (int) (c * BENCH_COLUMN_WIDTH);
+			cell->y = (int) (r * BENCH_ROW_HEIGHT);
+			cell->width = BENCH_COLUMN_WIDTH - 2;
+			cell->height = BENCH_ROW_HEIGHT - 2;
+			g_bench_table.cells[r * BENCH_TABLE_COLUMNS + c] = cell;
+			add_widget(g_bench_table.body, cell);
+		}
+	}
+	return VS_SUCCESS;
+}
+
+// The widgets themselves are destroyed with their window
+static void bench_table_free() {
+	free(g_bench_table.cells);
+}
+
+static void bench_scroll_step(window *win, unsigned frame) {
+	int range = BENCH_TABLE_ROWS * BENCH_ROW_HEIGHT - (int) win->height;
+	g_bench_table.body->y = -(int) ((frame * 4) % (range > 0 ? range : 1));
+	invalidate_widget(g_bench_table.body);
+}
+
+static void bench_resize_step(window *win, unsigned frame) {
+	unsigned width = 800 + (frame % 16) * 20;
+	unsigned height = 600 + (frame % 16) * 10;
+	XResizeWindow(g_display, win->xwin, width, height);
+	XSync(g_display, False);
+}
+
+/*
+ * Captures every frame at full rate. Frame times should match table_text, with captures dropped rather than waited for.
+ */
+static void bench_capture_step(window *win, unsigned frame) {
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/venus_bench_capture%u.png", frame % VS_CAPTURE_SLOTS);
+	capture_frame(win, path, VS_CAPTURE_PNG);
+}
+
+/*
+ * Scrolls the table with the profiler off for even frames and on for odd ones, so both see the same caches and clocks.
+ * The profiler should cost less than 1% of a frame.
+ */
+static void bench_profiler_cost(window *win) {
+	if (!bench_selected("table_scroll_profiler"))
+		return;
+
+	unsigned frames = (unsigned) (BENCH_FRAMES * g_bench_options.scale);
+	if (frames < 10)
+		frames = 10;
+	double *off = malloc(sizeof(double) * frames * 2);
+	if (!off)
+		return;
+	double *on = off + frames;
+
+	for (unsigned i = 0; i < BENCH_WARMUP + frames * 2; ++i) {
+		int enabled = i & 1;
+		venus_enable_profiler(enabled);
+		unsigned long start = bench_now();
+		bench_scroll_step(win, i);
+		bench_frame(win);
+		unsigned long elapsed = bench_now() - start;
+		if (i >= BENCH_WARMUP)
+			(enabled ? on : off)[(i - BENCH_WARMUP) / 2] = (double) elapsed;
+	}
+	venus_enable_profiler(VS_FALSE);
+
+	// Recording sorts the samples, so the medians can be read straight after
+	bench_record("table_scroll_profiler_off", off, frames);
+	bench_record("table_scroll_profiler_on", on, frames);
+	if (on[frames / 2] > off[frames / 2] * 1.01)
+		bench_fail("table_scroll_profiler", "the profiler cost more than 1% of a frame");
+	free(off);
+}
+
+static void bench_table_scenarios() {
+	window win;
+	if (!bench_open_window(&win))
+		return;
+	if (!bench_table_create(&win)) {
+		destroy_window(&win);
+		return;
+	}
+
+	bench_frames("table_text", &win, NULL);
+	bench_frames("table_scroll", &win, bench_scroll_step);
+	bench_profiler_cost(&win);
+	bench_frames("table_capture", &win, bench_capture_step);
+	bench_frames("table_resize", &win, bench_resize_step);
+
+	// Every step of the drag changes the size, so only the first and the last one should be laid out
+	resize_stats resizes;
+	get_resize_stats(&win, &resizes);
+	double relayouts = (double) resizes.resizes;
+	bench_record_unit("table_resize_relayouts", "relayouts", &relayouts, 1);
+
+	destroy_window(&win);
+	bench_table_free();
+}
+
+/*
+ * Captures the next frame that is swapped and keeps drawing until the capture is written out. Every frame is damaged,
+ * since captures only move along on frames that are swapped.
+ */
+static int bench_capture_next(window *win, void *widget, const char *path) {
+	capture_stats before;
+	get_capture_stats(win, &before);
+	if (!capture_frame(win, path, VS_CAPTURE_RAW))
+		return VS_FAILURE;
+	for (unsigned i = 0; i < BENCH_FRAMES; ++i) {
+		invalidate_widget(widget);
+		bench_frame(win);
+		capture_stats after;
+		get_capture_stats(win, &after);
+		if (after.failed > before.failed)
+			return VS_FAILURE;
+		if (after.written > before.written)
+			return VS_SUCCESS;
+	}
+	return VS_FAILURE;
+}
+
+static int bench_files_equal(const char *a, const char *b) {
+	FILE *fa = fopen(a, "rb");
+	FILE *fb = fopen(b, "rb");
+	int equal = fa && fb;
+	while (equal) {
+		int ca = fgetc(fa);
+		int cb = fgetc(fb);
+		equal = ca == cb;
+		if (ca == EOF)
+			break;
+	}
+	if (fa)
+		fclose(fa);
+	if (fb)
+		fclose(fb);
+	return equal;
+}
+
+/*
+ * Check rather than benchmark: the same tree drawn with its render list recorded on one thread and on four has to come
+ * out the same to the byte.
+ */
+static void bench_render_threads() {
+	if (!bench_selected("render_threads_match"))
+		return;
+
+	window win;
+	if (!bench_open_window(&win))
+		return;
+
+	// Panels and text fields alternate so that the slices hold different kinds of commands
+	void *first = NULL;
+	for (unsigned i = 0; i < BENCH_THREAD_WIDGETS; ++i) {
+		widget_t *w = i % 2 ? (widget_t*) create_text_field() : (widget_t*) create_panel();
+		if (!w)
+			break;
+		w->x = (int) (i % BENCH_THREAD_COLUMNS) * 12;
+		w->y = (int) (i / BENCH_THREAD_COLUMNS) * 9;
+		w->width = 11;
+		w->height = 8;
+		add_widget(&win, w);
+		if (!first)
+			first = w;
+	}
+	for (unsigned i = 0; i < BENCH_WARMUP; ++i)
+		bench_frame(&win);
+
+	char paths[2][64];
+	static const unsigned threads[2] = {1, 4};
+	int captured = first != NULL;
+	for (unsigned i = 0; captured && i < 2; ++i) {
+		snprintf(paths[i], sizeof(paths[i]), BENCH_THREAD_CAPTURE, threads[i]);
+		set_render_threads(&win, threads[i]);
+		captured = bench_capture_next(&win, first, paths[i]);
+	}
+
+	if (!captured)
+		bench_fail("render_threads_match", "could not capture a frame");
+	else if (!bench_files_equal(paths[0], paths[1]))
+		bench_fail("render_threads_match", "frames recorded on 1 and 4 threads differ");
+	destroy_window(&win);
+}
+
+/*
+ * Input latency with synthetic events. The callback moves a small panel to the pointer, so every event damages the
+ * window and is measured.
+ */
+static vpanel *g_bench_cursor;
+
+static int bench_cursor_callback(void *win, void *event) {
+	XEvent *e = (XEvent*) event;
+	if (e->type == MotionNotify) {
+		g_bench_cursor->x = e->xmotion.x;
+		g_bench_cursor->y = e->xmotion.y;
+	} else if (e->type != ButtonPress && e->type != KeyPress) {
+		return VS_SUCCESS;
+	}
+	invalidate_widget(g_bench_cursor);
+	return VS_SUCCESS;
+}
+
+static void bench_latency_record(const char *name, unsigned kind) {
+	latency_histogram histogram;
+	venus_get_latency_histogram(kind, &histogram);
+	if (!histogram.count)
+		return;
+
+	// Every event counts as the middle of its bucket, which is as precise as the histogram gets
+	double *ns = malloc(sizeof(double) * histogram.count);
+	if (!ns)
+		return;
+	unsigned n = 0;
+	for (unsigned i = 0; i < VS_LATENCY_BUCKETS; ++i)
+		for (unsigned long c = 0; c < histogram.buckets[i]; ++c)
+			ns[n++] = (i + 0.5) * VS_LATENCY_BUCKET_NS;
+	for (unsigned long c = 0; c < histogram.overflow; ++c)
+		ns[n++] = (double) VS_LATENCY_BUCKETS * VS_LATENCY_BUCKET_NS;
+
+	bench_record(name, ns, n);
+	free(ns);
+}
+
+static void bench_input_latency() {
+	static const char *names[VS_LATENCY_N_KINDS] = {"input_latency_key", "input_latency_button", "input_latency_motion"};
+
+	window win;
+	if (!bench_open_window(&win))
+		return;
+	g_bench_cursor = create_panel();
+	g_bench_cursor->width = 16;
+	g_bench_cursor->height = 16;
+	add_widget(&win, g_bench_cursor);
+	set_event_callback(&win, bench_cursor_callback);
+
+	// Let the window be mapped before it is given focus and input
+	for (unsigned i = 0; i < BENCH_WARMUP; ++i)
+		bench_frame(&win);
+	XSetInputFocus(g_display, win.xwin, RevertToParent, CurrentTime);
+
+	unsigned frames = (unsigned) (BENCH_FRAMES * g_bench_options.scale);
+	venus_enable_latency_probe(VS_TRUE);
+	for (unsigned kind = 0; kind < VS_LATENCY_N_KINDS; ++kind) {
+		if (!bench_selected(names[kind]))
+			continue;
+		venus_reset_latency_histograms();
+		for (unsigned i = 0; i < frames; ++i) {
+			synthesize_input(&win, kind);
+			XSync(g_display, False);
+			bench_frame(&win);
+		}
+		// The last frame is only finished by the swap after it
+		bench_frame(&win);
+		bench_latency_record(names[kind], kind);
+	}
+	venus_enable_latency_probe(VS_FALSE);
+
+	destroy_window(&win);
+}
+
+int bench_replay(const char *path) {
+	window win;
+	if (!g_display || !bench_open_window(&win))
+		return VS_FAILURE;
+	if (!bench_table_create(&win) || !venus_replay_events(path, VS_REPLAY_FAST)) {
+		destroy_window(&win);
+		return VS_FAILURE;
+	}
+
+	unsigned capacity = 1024;
+	unsigned frames = 0;
+	double *ns = malloc(sizeof(double) * capacity);
+	while (ns && !venus_replay_finished()) {
+		if (frames == capacity) {
+			double *grown = realloc(ns, sizeof(double) * capacity * 2);
+			if (!grown)
+				break;
+			ns = grown;
+			capacity *= 2;
+		}
+		unsigned long start = bench_now();
+		bench_frame(&win);
+		ns[frames++] = (double) (bench_now() - start);
+	}
+	venus_stop_replay();
+	if (ns)
+		bench_record("replay", ns, frames);
+	free(ns);
+
+	destroy_window(&win);
+	bench_table_free();
+	return VS_SUCCESS;
+}
+
+int bench_macro() {
+	if (!g_display) {
+		fprintf(stderr, "Skipping macro benchmarks because there is no X display\n");
+		return VS_FAILURE;
+	}
+	bench_window_open();
+	bench_panels();
+	bench_ui_first_frame();
+	bench_table_scenarios();
+	bench_render_threads();
+	bench_input_latency();
+	return VS_SUCCESS;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file main.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * venus_bench [--micro] [--macro] [--replay RECORDING] [--filter NAME] [--scale FACTOR] [--out FILE]
+ *     [--compare BASELINE] [--threshold RATIO]
+ *
+ * With neither --micro, --macro nor --replay, both suites run. Results go to stdout as JSON unless --out names a file. --compare
+ * prints a table against a saved baseline and exits with 2 if any benchmark regressed past the threshold, 10% unless
+ * told otherwise. Counts, such as allocations and round trips, regress as soon as they go up. A failed check, such as frames that differ between render thread counts, exits with 3.
+ */
+
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/venus.h"
+#include "../src/venus_common.h"
+
+static void bench_usage() {
+	fprintf(stderr, "usage: venus_bench [--micro] [--macro] [--replay RECORDING] [--filter NAME] [--scale FACTOR] [--out FILE] "
+		"[--compare BASELINE] [--threshold RATIO]\n");
+}
+
+int main(int argc, char **argv) {
+	int micro = VS_FALSE;
+	int macro = VS_FALSE;
+	const char *replay = NULL;
+	const char *out = NULL;
+	const char *baseline = NULL;
+	double threshold = 0.1;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--micro")) {
+			micro = VS_TRUE;
+		} else if (!strcmp(argv[i], "--macro")) {
+			macro = VS_TRUE;
+		} else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+			replay = argv[++i];
+		} else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+			g_bench_options.filter = argv[++i];
+		} else if (!strcmp(argv[i], "--scale") && i + 1 < argc) {
+			g_bench_options.scale = strtod(argv[++i], NULL);
+		} else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+			out = argv[++i];
+		} else if (!strcmp(argv[i], "--compare") && i + 1 < argc) {
+			baseline = argv[++i];
+		} else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+			threshold = strtod(argv[++i], NULL);
+		} else {
+			bench_usage();
+			return 1;
+		}
+	}
+	if (!micro && !macro && !replay)
+		micro = macro = VS_TRUE;
+
+	if (!venus_initialize())
+		return 1;
+	log_initialize();
+
+	if (micro)
+		bench_micro();
+	if (macro)
+		bench_macro();
+	if (replay)
+		bench_replay(replay);
+
+	FILE *file = out ? fopen(out, "w") : stdout;
+	if (file) {
+		bench_write_json(file);
+		if (out)
+			fclose(file);
+	}
+
+	int regressions = 0;
+	if (baseline)
+		regressions = bench_compare(baseline, threshold);
+
+	log_terminate();
+	venus_terminate();
+
+	if (regressions < 0)
+		return 1;
+	if (bench_failures())
+		return 3;
+	return regressions ? 2 : 0;
+}
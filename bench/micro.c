@@ -0,0 +1,404 @@
+/**
+ * @file micro.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "bench.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <X11/Xlib.h>
+
+#include "../src/venus_common.h"
+#include "../src/util/vector.h"
+#include "../src/util/matrix.h"
+#include "../src/engine/arena.h"
+#include "../src/engine/graphics.h"
+#include "../src/engine/memory.h"
+#include "../src/engine/path.h"
+#include "../src/toolkit/widget.h"
+#include "../src/toolkit/animation.h"
+#include "../src/toolkit/theme.h"
+#include "../src/toolkit/widgets/chart.h"
+#include "../src/toolkit/widgets/panel.h"
+
+VS_DEFINE_VECTOR_HEADER(float, bench_vec)
+VS_DEFINE_VECTOR_SOURCE(float, bench_vec)
+VS_DEFINE_MATRIX(float, bench_mat)
+
+#define BENCH_VECTOR_OPS	1000
+#define BENCH_MATRIX_OPS	100
+#define BENCH_WIDGETS		10000
+#define BENCH_INSERTS		2000
+#define BENCH_CHURN			1000
+#define BENCH_STYLED		50000
+#define BENCH_EVENTS		10000
+#define BENCH_WINDOWS		8
+#define BENCH_LOGS			512
+#define BENCH_ANIMATIONS	10000
+#define BENCH_CHART_SAMPLES	10000000
+#define BENCH_CHART_FRAMES	16
+#define BENCH_ICONS			1000
+#define BENCH_ARENA_ALLOCS	1000
+
+// Keeps the compiler from throwing away results nobody reads
+static volatile float g_bench_sink;
+
+typedef struct {
+	bench_vec a;
+	bench_vec b;
+	bench_vec dest;
+	bench_mat m0;
+	bench_mat m1;
+	bench_mat product;
+} bench_math;
+
+static void bench_vector_add(void *arg) {
+	bench_math *math = arg;
+	for (unsigned i = 0; i < BENCH_VECTOR_OPS; ++i)
+		bench_vec_add(math->dest, math->a, math->b);
+	g_bench_sink = math->dest[0];
+}
+
+static void bench_vector_dot(void *arg) {
+	bench_math *math = arg;
+	float sum = 0;
+	for (unsigned i = 0; i < BENCH_VECTOR_OPS; ++i)
+		sum += bench_vec_dot(math->a, math->b);
+	g_bench_sink = sum;
+}
+
+static void bench_vector_cross(void *arg) {
+	bench_math *math = arg;
+	for (unsigned i = 0; i < BENCH_VECTOR_OPS; ++i)
+		bench_vec_cross(math->dest, math->a, math->b);
+	g_bench_sink = math->dest[0];
+}
+
+static void bench_matrix_multiply(void *arg) {
+	bench_math *math = arg;
+	for (unsigned i = 0; i < BENCH_MATRIX_OPS; ++i)
+		bench_mat_multiply(math->product, math->m0, math->m1);
+	g_bench_sink = math->product[0];
+}
+
+static void bench_matrix_transpose(void *arg) {
+	bench_math *math = arg;
+	for (unsigned i = 0; i < BENCH_MATRIX_OPS; ++i)
+		bench_mat_transpose(math->product, math->m0);
+	g_bench_sink = math->product[0];
+}
+
+static void bench_matrix_determinant(void *arg) {
+	bench_math *math = arg;
+	float sum = 0;
+	for (unsigned i = 0; i < BENCH_MATRIX_OPS; ++i)
+		sum += bench_mat_determinant(math->m0);
+	g_bench_sink = sum;
+}
+
+typedef struct {
+	vpanel root;
+	vpanel *children;
+} bench_tree;
+
+static void bench_tree_clear(void *arg) {
+	bench_tree *tree = arg;
+	allocate_children(&tree->root, 0);
+	tree->root.n_children = 0;
+}
+
+static void bench_tree_fill(void *arg) {
+	bench_tree *tree = arg;
+	bench_tree_clear(tree);
+	for (unsigned i = 0; i < BENCH_INSERTS; ++i)
+		add_widget(&tree->root, &tree->children[i]);
+}
+
+static void bench_widget_add(void *arg) {
+	bench_tree *tree = arg;
+	for (unsigned i = 0; i < BENCH_WIDGETS; ++i)
+		add_widget(&tree->root, &tree->children[i]);
+}
+
+static void bench_widget_insert(void *arg) {
+	bench_tree *tree = arg;
+	for (unsigned i = 0; i < BENCH_INSERTS; ++i)
+		insert_widget(&tree->root, 0, &tree->children[i]);
+}
+
+static void bench_widget_remove(void *arg) {
+	bench_tree *tree = arg;
+	while (tree->root.n_children)
+		remove_widget_index(&tree->root, tree->root.n_children / 2);
+}
+
+static void bench_widget_churn(void *arg) {
+	bench_tree *tree = arg;
+	vpanel *created[BENCH_CHURN];
+	for (unsigned i = 0; i < BENCH_CHURN; ++i) {
+		created[i] = create_panel();
+		add_widget(&tree->root, created[i]);
+	}
+	// Newest first, so each removal is from the end of the parent's children
+	for (unsigned i = BENCH_CHURN; i-- > 0;)
+		destroy_widget(created[i]);
+}
+
+typedef struct {
+	arena arena;
+	unsigned misaligned;
+} bench_arena;
+
+static void bench_arena_reset(void *arg) {
+	arena_reset(&((bench_arena*) arg)->arena);
+}
+
+/*
+ * Sizes that are not multiples of the alignment, so the rounding in arena_alloc() is what keeps each one aligned
+ */
+static void bench_arena_alloc(void *arg) {
+	bench_arena *a = arg;
+	for (unsigned i = 0; i < BENCH_ARENA_ALLOCS; ++i) {
+		void *memory = arena_alloc(&a->arena, i % 40 + 1);
+		if ((uintptr_t) memory % VS_ARENA_ALIGN)
+			a->misaligned++;
+	}
+}
+
+typedef struct {
+	vtheme themes[2];
+	unsigned next;
+} bench_themes;
+
+static void bench_theme_switch(void *arg) {
+	bench_themes *themes = arg;
+	set_theme(&themes->themes[themes->next]);
+	themes->next ^= 1;
+}
+
+static int bench_event_callback(void *win, void *event) {
+	g_bench_sink++;
+	return VS_SUCCESS;
+}
+
+static void bench_event_dispatch(void *arg) {
+	XEvent *event = arg;
+	for (unsigned i = 0; i < BENCH_EVENTS; ++i)
+		xlib_dispatch_event(event);
+}
+
+static void bench_log_removed(void *arg) {
+	for (unsigned i = 0; i < BENCH_LOGS; ++i)
+		vs_log_debug("removed %u", i);
+}
+
+static void bench_log_queued(void *arg) {
+	for (unsigned i = 0; i < BENCH_LOGS; ++i)
+		log_write(VS_LOG_INFO, "queued %u", i);
+}
+
+// Gives the logging thread time to empty the ring, so samples measure queueing and not dropping
+static void bench_log_drain(void *arg) {
+	usleep(2000);
+}
+
+static void bench_log_synchronous(void *arg) {
+	for (unsigned i = 0; i < BENCH_LOGS; ++i)
+		zlog_info(g_log, "synchronous %u", i);
+}
+
+static void bench_animation_update(void *arg) {
+	(void) arg;
+	update_animations();
+}
+
+typedef struct {
+	vchart *chart;
+	render_list list;
+} bench_chart;
+
+/*
+ * Pans across the whole series zoomed all the way out, then zoomed in on a thousandth of it
+ */
+static void bench_chart_pan(void *arg) {
+	bench_chart *bench = arg;
+	void *params[VS_DRAW_N_PARAMS];
+	int origin[2] = {0, 0};
+	params[VS_DRAW_PARAM_LIST] = &bench->list;
+	params[VS_DRAW_PARAM_ORIGIN] = origin;
+	for (unsigned i = 0; i < BENCH_CHART_FRAMES; ++i) {
+		double span = i % 2 ? BENCH_CHART_SAMPLES : BENCH_CHART_SAMPLES / 1000.0;
+		set_chart_view(bench->chart, (BENCH_CHART_SAMPLES - span) * i / BENCH_CHART_FRAMES, span, -1.0f, 1.0f);
+		render_list_clear(&bench->list);
+		g_theme.draw_chart(NULL, bench->chart, params, VS_DRAW_N_PARAMS);
+	}
+}
+
+typedef struct {
+	path_t icon;
+	path_style stroke;
+	path_cache cache;
+	render_list list;
+} bench_path;
+
+/*
+ * A circled checkmark, about as much as a theme icon holds
+ */
+static void bench_path_icon(path_t *icon) {
+	path_arc(icon, 12.0f, 12.0f, 10.0f, 0.0f, 2.0f * (float) M_PI);
+	path_close(icon);
+	path_move_to(icon, 7.0f, 12.5f);
+	path_line_to(icon, 10.5f, 16.0f);
+	path_quad_to(icon, 13.0f, 11.0f, 17.0f, 8.0f);
+}
+
+static void bench_path_tessellate(void *arg) {
+	bench_path *bench = arg;
+	path_mesh mesh;
+	path_tessellate(&bench->icon, &bench->stroke, 2.0f, &mesh);
+	g_bench_sink = (float) mesh.n_vertices;
+	memory_free(VS_MEMORY_RENDER, mesh.vertices);
+}
+
+static void bench_path_draw(void *arg) {
+	bench_path *bench = arg;
+	static const unsigned char color[] = {0x21, 0x96, 0xF3, 0xFF};
+	render_list_clear(&bench->list);
+	for (unsigned i = 0; i < BENCH_ICONS; ++i)
+		path_draw(&bench->cache, &bench->list, &bench->icon, &bench->stroke, (float) (i % 40) * 24.0f,
+			(float) (i / 40) * 24.0f, 1.0f, color);
+}
+
+void bench_micro() {
+	bench_math math;
+	math.a = make_bench_vec(3, 1.0, 2.0, 3.0);
+	math.b = make_bench_vec(3, 4.0, 5.0, 6.0);
+	math.dest = create_bench_vec(3);
+	math.m0 = create_bench_mat(4, 4);
+	math.m1 = create_bench_mat(4, 4);
+	math.product = create_bench_mat(4, 4);
+	for (unsigned i = 0; i < 16; ++i) {
+		math.m0[i] = (float) ((i * 7) % 5) + 1.0f;
+		math.m1[i] = (float) ((i * 3) % 4) - 1.0f;
+	}
+
+	bench_run("vector_add", bench_vector_add, NULL, &math, BENCH_VECTOR_OPS, 1000);
+	bench_run("vector_dot", bench_vector_dot, NULL, &math, BENCH_VECTOR_OPS, 1000);
+	bench_run("vector_cross", bench_vector_cross, NULL, &math, BENCH_VECTOR_OPS, 1000);
+	bench_run("matrix_multiply_4x4", bench_matrix_multiply, NULL, &math, BENCH_MATRIX_OPS, 1000);
+	bench_run("matrix_transpose_4x4", bench_matrix_transpose, NULL, &math, BENCH_MATRIX_OPS, 1000);
+	bench_run("matrix_determinant_4x4", bench_matrix_determinant, NULL, &math, BENCH_MATRIX_OPS, 200);
+
+	vec_delete(math.a);
+	vec_delete(math.b);
+	vec_delete(math.dest);
+	matrix_delete(math.m0);
+	matrix_delete(math.m1);
+	matrix_delete(math.product);
+
+	// Arena memory has to be aligned for SSE and long double, so a misaligned allocation fails the run
+	bench_arena arena = {.misaligned = 0};
+	arena_init(&arena.arena);
+	bench_run("arena_alloc", bench_arena_alloc, bench_arena_reset, &arena, BENCH_ARENA_ALLOCS, 1000);
+	if (arena.misaligned)
+		bench_fail("arena_alloc", "allocations were not aligned to VS_ARENA_ALIGN");
+	arena_free(&arena.arena);
+
+	bench_tree tree;
+	memset(&tree.root, 0, sizeof(vpanel));
+	tree.children = calloc(BENCH_WIDGETS, sizeof(vpanel));
+	if (tree.children) {
+		bench_run("widget_add", bench_widget_add, bench_tree_clear, &tree, BENCH_WIDGETS, 50);
+		bench_run("widget_insert_front", bench_widget_insert, bench_tree_clear, &tree, BENCH_INSERTS, 50);
+		bench_run("widget_remove_middle", bench_widget_remove, bench_tree_fill, &tree, BENCH_INSERTS, 50);
+		bench_run("widget_create_destroy", bench_widget_churn, bench_tree_clear, &tree, BENCH_CHURN, 200);
+		bench_tree_clear(&tree);
+		free(tree.children);
+	}
+
+	// Switching between two themes restyles every live widget, whether or not it is in a window
+	vpanel **styled = malloc(sizeof(vpanel*) * BENCH_STYLED);
+	if (styled) {
+		bench_themes themes = {{g_theme, g_theme}, 0};
+		themes.themes[1].base.background[0] = 0x30;
+		unsigned n_styled = 0;
+		while (n_styled < BENCH_STYLED && (styled[n_styled] = create_panel()))
+			n_styled++;
+		bench_run("theme_switch_50k", bench_theme_switch, NULL, &themes, BENCH_STYLED, 20);
+		set_theme(&themes.themes[0]);
+		for (unsigned i = 0; i < n_styled; ++i)
+			destroy_widget(styled[i]);
+		free(styled);
+	}
+
+	// Slow animations on every easing curve, so most frames only move a few of them by a whole pixel
+	vpanel **animated = malloc(sizeof(vpanel*) * BENCH_ANIMATIONS);
+	if (animated) {
+		unsigned n_animated = 0;
+		while (n_animated < BENCH_ANIMATIONS && (animated[n_animated] = create_panel())) {
+			animation_key keys[] = {{0.0f, 0.0f}, {10.0f, 100.0f}, {20.0f, 0.0f}};
+			animate_widget(animated[n_animated], n_animated % 2 ? VS_ANIM_X : VS_ANIM_Y, keys, 3,
+				n_animated % VS_EASE_COUNT, 0.0f, VS_ANIM_REPEAT);
+			n_animated++;
+		}
+		bench_run("animation_update_10k", bench_animation_update, NULL, NULL, BENCH_ANIMATIONS, 200);
+		for (unsigned i = 0; i < n_animated; ++i)
+			destroy_widget(animated[i]);
+		free(animated);
+	}
+
+	// A chart a thousand pixels wide over ten million samples
+	bench_chart chart = {create_chart()};
+	float *samples = malloc(sizeof(float) * BENCH_CHART_SAMPLES);
+	if (chart.chart && samples) {
+		for (unsigned i = 0; i < BENCH_CHART_SAMPLES; ++i)
+			samples[i] = (float) (rand() % 2000) / 1000.0f - 1.0f;
+		const unsigned char color[] = {0x21, 0x96, 0xF3, 0xFF};
+		chart.chart->width = 1000;
+		append_chart_samples(chart.chart, add_chart_series(chart.chart, color), samples, BENCH_CHART_SAMPLES);
+		render_list_init(&chart.list);
+		bench_run("chart_pan_10m", bench_chart_pan, NULL, &chart, BENCH_CHART_FRAMES, 50);
+		render_list_free(&chart.list);
+	}
+	free(samples);
+	if (chart.chart)
+		destroy_widget(chart.chart);
+
+	// One icon tessellated from scratch, then drawn a thousand times from the mesh cache
+	bench_path path = {.stroke = {VS_TRUE, VS_FILL_NONZERO, 2.0f, VS_JOIN_ROUND, VS_CAP_ROUND, 0.0f}};
+	path_init(&path.icon);
+	bench_path_icon(&path.icon);
+	path_cache_init(&path.cache);
+	render_list_init(&path.list);
+	bench_run("path_tessellate_icon", bench_path_tessellate, NULL, &path, 1, 500);
+	bench_run("path_draw_cached_1k", bench_path_draw, NULL, &path, BENCH_ICONS, 200);
+	render_list_free(&path.list);
+	path_cache_destroy(&path.cache);
+	path_free(&path.icon);
+
+	// Dispatch looks windows up by X id, so register a few that are never created
+	window windows[BENCH_WINDOWS];
+	memset(windows, 0, sizeof(windows));
+	for (unsigned i = 0; i < BENCH_WINDOWS; ++i) {
+		windows[i].xwin = i + 1;
+		windows[i].event_callback = bench_event_callback;
+		xlib_register_window(&windows[i]);
+	}
+	XEvent event;
+	memset(&event, 0, sizeof(XEvent));
+	event.type = MotionNotify;
+	event.xany.window = BENCH_WINDOWS;
+	bench_run("event_dispatch", bench_event_dispatch, NULL, &event, BENCH_EVENTS, 200);
+	for (unsigned i = 0; i < BENCH_WINDOWS; ++i)
+		xlib_unregister_window(&windows[i]);
+
+	bench_run("log_removed", bench_log_removed, NULL, NULL, BENCH_LOGS, 200);
+	bench_run("log_queued", bench_log_queued, bench_log_drain, NULL, BENCH_LOGS, 200);
+	bench_run("log_synchronous", bench_log_synchronous, NULL, NULL, BENCH_LOGS, 50);
+}
@@ -0,0 +1,11 @@
+#!/bin/sh
+# Runs venus_bench under a virtual X server with Mesa's software rasterizer, so results only depend on the CPU.
+#
+#   cmake -S . -B build && cmake --build build --target venus_bench
+#   bench/run.sh build/venus_bench --out current.json --compare baseline.json
+
+BENCH=${1:-./venus_bench}
+shift
+
+exec env LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe vblank_mode=0 \
+	xvfb-run -a -s "-screen 0 1920x1080x24" taskset -c 0-3 "$BENCH" "$@"
@@ -0,0 +1,52 @@
+/**
+ * @file xcb.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * Counts round trips to the X server. The XCB calls that block for a reply are replaced in the benchmark executable and
+ * passed on to libxcb, so waits made by Xlib and GLX on venus's behalf are counted along with venus's own.
+ */
+
+#define _GNU_SOURCE
+
+#include "bench.h"
+
+#include <dlfcn.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+static atomic_ulong g_bench_round_trips = 0;
+
+/*
+ * Looks up the libxcb function a wrapper stands in for
+ */
+static void *bench_next(void **next, const char *name) {
+	atomic_fetch_add_explicit(&g_bench_round_trips, 1, memory_order_relaxed);
+	if (!*next)
+		*next = dlsym(RTLD_NEXT, name);
+	return *next;
+}
+
+void *xcb_wait_for_reply(xcb_connection_t *c, unsigned int request, xcb_generic_error_t **e) {
+	static void *next = NULL;
+	void *(*wait)(xcb_connection_t*, unsigned int, xcb_generic_error_t**) = bench_next(&next, "xcb_wait_for_reply");
+	return wait(c, request, e);
+}
+
+void *xcb_wait_for_reply64(xcb_connection_t *c, uint64_t request, xcb_generic_error_t **e) {
+	static void *next = NULL;
+	void *(*wait)(xcb_connection_t*, uint64_t, xcb_generic_error_t**) = bench_next(&next, "xcb_wait_for_reply64");
+	return wait(c, request, e);
+}
+
+xcb_generic_error_t *xcb_request_check(xcb_connection_t *c, xcb_void_cookie_t cookie) {
+	static void *next = NULL;
+	xcb_generic_error_t *(*check)(xcb_connection_t*, xcb_void_cookie_t) = bench_next(&next, "xcb_request_check");
+	return check(c, cookie);
+}
+
+unsigned long bench_round_trips() {
+	return atomic_load_explicit(&g_bench_round_trips, memory_order_relaxed);
+}
@@ -1,29 +0,0 @@
-# The set of languages for which implicit dependencies are needed:
-set(CMAKE_DEPENDS_LANGUAGES
-  "C"
-  )
-# The set of files for implicit dependencies of each language:
-set(CMAKE_DEPENDS_CHECK_C
-  "/home/wesley/Workspace/venus/glad.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/glad.c.o"
-  "/home/wesley/Workspace/venus/src/engine/graphics.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/src/engine/graphics.c.o"
-  "/home/wesley/Workspace/venus/src/toolkit/default_theme.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/src/toolkit/default_theme.c.o"
-  "/home/wesley/Workspace/venus/src/toolkit/widget.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/src/toolkit/widget.c.o"
-  "/home/wesley/Workspace/venus/src/toolkit/widgets/panel.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/src/toolkit/widgets/panel.c.o"
-  "/home/wesley/Workspace/venus/src/toolkit/widgets/text_field.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/src/toolkit/widgets/text_field.c.o"
-  "/home/wesley/Workspace/venus/src/util/types.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/src/util/types.c.o"
-  "/home/wesley/Workspace/venus/src/venus.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/src/venus.c.o"
-  "/home/wesley/Workspace/venus/src/window.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/src/window.c.o"
-  "/home/wesley/Workspace/venus/test.c" "/home/wesley/Workspace/venus/build/CMakeFiles/venus.dir/test.c.o"
-  )
-set(CMAKE_C_COMPILER_ID "GNU")
-
-# The include file search paths:
-set(CMAKE_C_TARGET_INCLUDE_PATH
-  )
-
-# Targets to which this target links.
-set(CMAKE_TARGET_LINKED_INFO_FILES
-  )
-
-# Fortran module output directory.
-set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -1,19 +0,0 @@
-file(REMOVE_RECURSE
-  "CMakeFiles/venus.dir/test.c.o"
-  "CMakeFiles/venus.dir/src/venus.c.o"
-  "CMakeFiles/venus.dir/src/window.c.o"
-  "CMakeFiles/venus.dir/src/util/types.c.o"
-  "CMakeFiles/venus.dir/src/toolkit/widget.c.o"
-  "CMakeFiles/venus.dir/src/toolkit/default_theme.c.o"
-  "CMakeFiles/venus.dir/src/toolkit/widgets/text_field.c.o"
-  "CMakeFiles/venus.dir/src/toolkit/widgets/panel.c.o"
-  "CMakeFiles/venus.dir/src/engine/graphics.c.o"
-  "CMakeFiles/venus.dir/glad.c.o"
-  "venus.pdb"
-  "venus"
-)
-
-# Per-language clean rules from dependency scanning.
-foreach(lang C)
-  include(CMakeFiles/venus.dir/cmake_clean_${lang}.cmake OPTIONAL)
-endforeach()
@@ -0,0 +1,124 @@
+/**
+ * @file arena.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "arena.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "memory.h"
+
+static atomic_ulong g_arena_frame = 0;
+static atomic_ulong g_arena_blocks = 0;
+
+static __thread arena t_frame_arena;
+static __thread arena t_scratch_arena;
+
+static arena_block *arena_new_block(size_t size, arena_block *next) {
+	arena_block *block = memory_alloc(VS_MEMORY_ENGINE, sizeof(arena_block) + size);
+	if (!block)
+		return NULL;
+	atomic_fetch_add_explicit(&g_arena_blocks, 1, memory_order_relaxed);
+	block->next = next;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+void arena_init(arena *a) {
+	memset(a, 0, sizeof(arena));
+}
+
+void arena_free(arena *a) {
+	arena_block *block = a->current;
+	while (block) {
+		arena_block *next = block->next;
+		memory_free(VS_MEMORY_ENGINE, block);
+		block = next;
+	}
+	arena_init(a);
+}
+
+void *arena_alloc(arena *a, size_t bytes) {
+	bytes = (bytes + VS_ARENA_ALIGN - 1) & ~(size_t) (VS_ARENA_ALIGN - 1);
+
+	arena_block *block = a->current;
+	if (!block || block->used + bytes > block->size) {
+		size_t size = block ? block->size * 2 : VS_ARENA_BLOCK;
+		while (size < bytes)
+			size *= 2;
+		block = arena_new_block(size, block);
+		if (!block)
+			return NULL;
+		a->current = block;
+	}
+
+	void *memory = block->data + block->used;
+	block->used += bytes;
+	a->used += bytes;
+	return memory;
+}
+
+void arena_reset(arena *a) {
+	arena_block *block = a->current;
+	if (block && block->next) {
+		// Fold the chain into one block that fits everything the arena just held
+		size_t size = block->size;
+		while (size < a->used)
+			size *= 2;
+		arena_free(a);
+		a->current = arena_new_block(size, NULL);
+	} else if (block) {
+		block->used = 0;
+	}
+	a->used = 0;
+}
+
+arena_mark arena_get_mark(arena *a) {
+	arena_mark mark = {a->current, a->current ? a->current->used : 0, a->used};
+	return mark;
+}
+
+void arena_release(arena *a, arena_mark mark) {
+	// Blocks chained after the mark are kept, so a scratch arena that had to grow stays grown
+	for (arena_block *block = a->current; block && block != mark.block; block = block->next)
+		block->used = 0;
+	if (mark.block)
+		mark.block->used = mark.used;
+	a->used = mark.total;
+}
+
+arena *frame_arena() {
+	unsigned long frame = atomic_load_explicit(&g_arena_frame, memory_order_relaxed);
+	if (t_frame_arena.frame != frame) {
+		arena_reset(&t_frame_arena);
+		t_frame_arena.frame = frame;
+	}
+	return &t_frame_arena;
+}
+
+void *frame_alloc(size_t bytes) {
+	return arena_alloc(frame_arena(), bytes);
+}
+
+arena *scratch_arena() {
+	return &t_scratch_arena;
+}
+
+void arena_free_thread() {
+	arena_free(&t_frame_arena);
+	arena_free(&t_scratch_arena);
+}
+
+void arena_end_frame() {
+	atomic_fetch_add_explicit(&g_arena_frame, 1, memory_order_relaxed);
+}
+
+unsigned long arena_block_allocations() {
+	return atomic_load_explicit(&g_arena_blocks, memory_order_relaxed);
+}
@@ -0,0 +1,148 @@
+/**
+ * @file arena.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Linear allocators for data that does not outlive a frame or a function
+ *
+ * An arena hands out memory by bumping a pointer and frees all of it at once. When an arena runs out it chains another
+ * block, and the next reset folds every block into one big enough for the whole load, so an arena stops calling malloc()
+ * once it has seen its busiest frame.
+ *
+ * Every thread has a frame arena, emptied after each swap_buffers(), and a scratch arena for temporaries that are
+ * released with arena_release() before the function that made them returns.
+ */
+
+#ifndef VS_ARENA_H
+#define VS_ARENA_H
+
+#include <stddef.h>
+
+/// Size of the first block of an arena
+#define VS_ARENA_BLOCK			(64 * 1024)
+
+/// Alignment of every allocation
+#define VS_ARENA_ALIGN			16
+
+typedef struct arena_block {
+	struct arena_block *next;
+	size_t size;
+	size_t used;
+
+	/// Aligned so that rounding used keeps every allocation aligned, since the header alone would leave it 8 bytes off
+	_Alignas(VS_ARENA_ALIGN) unsigned char data[];
+} arena_block;
+
+typedef struct {
+	/// Block allocations are made from. Earlier blocks follow it through next.
+	arena_block *current;
+
+	/// Bytes allocated from the arena since it was last reset, including those in earlier blocks
+	size_t used;
+
+	/// Frame the arena was last reset in, for frame arenas
+	unsigned long frame;
+} arena;
+
+/**
+ * @brief A position in an arena to release back to
+ */
+typedef struct {
+	arena_block *block;
+	size_t used;
+	size_t total;
+} arena_mark;
+
+void arena_init(arena *a);
+
+/**
+ * @brief Frees every block of an arena
+ *
+ * @param a Pointer to arena
+ */
+void arena_free(arena *a);
+
+/**
+ * @brief Allocates memory from an arena
+ *
+ * @param a Pointer to arena
+ * @param bytes Number of bytes
+ *
+ * @return Returns memory aligned to VS_ARENA_ALIGN, or NULL if a new block could not be allocated
+ */
+void *arena_alloc(arena *a, size_t bytes);
+
+/**
+ * @brief Releases every allocation of an arena
+ *
+ * @param a Pointer to arena
+ */
+void arena_reset(arena *a);
+
+/**
+ * @brief Remembers the current position of an arena
+ *
+ * @param a Pointer to arena
+ *
+ * @return Returns the mark to give arena_release()
+ */
+arena_mark arena_get_mark(arena *a);
+
+/**
+ * @brief Releases everything allocated since a mark
+ *
+ * @param a Pointer to arena
+ * @param mark Mark from arena_get_mark()
+ */
+void arena_release(arena *a, arena_mark mark);
+
+/**
+ * @brief Gets the calling thread's frame arena
+ *
+ * The arena is emptied the first time it is used after a frame was swapped, so memory from it is valid until the end of
+ * the frame and must not be freed.
+ *
+ * @return Returns the arena
+ */
+arena *frame_arena();
+
+/**
+ * @brief Allocates memory that lasts until the end of the frame
+ *
+ * @param bytes Number of bytes
+ *
+ * @return Returns the memory or NULL
+ */
+void *frame_alloc(size_t bytes);
+
+/**
+ * @brief Gets the calling thread's scratch arena
+ *
+ * @return Returns the arena
+ */
+arena *scratch_arena();
+
+/**
+ * @brief Frees the calling thread's frame and scratch arenas
+ *
+ * Threads that use them call this before they exit, since their blocks are not freed with the thread.
+ */
+void arena_free_thread();
+
+/**
+ * @brief Ends the frame for every frame arena
+ *
+ * It is called by swap_buffers().
+ */
+void arena_end_frame();
+
+/**
+ * @brief Gets the number of blocks arenas have allocated with malloc()
+ *
+ * This stops growing once every arena has seen its busiest frame.
+ *
+ * @return Returns the number of blocks
+ */
+unsigned long arena_block_allocations();
+
+#endif
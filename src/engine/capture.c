@@ -0,0 +1,197 @@
+/**
+ * @file capture.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "capture.h"
+
+#include <glad/glad.h>
+
+#include <png.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../venus_common.h"
+#include "glstate.h"
+#include "jobs.h"
+#include "memory.h"
+
+#define VS_CAPTURE_FREE			0
+/// Waiting for the next swap to be read back
+#define VS_CAPTURE_QUEUED		1
+/// Read back, waiting for the GPU to finish the copy
+#define VS_CAPTURE_READING		2
+/// Mapped and being written out by a worker
+#define VS_CAPTURE_WRITING		3
+/// Written out, waiting to be unmapped on the GL thread
+#define VS_CAPTURE_WRITTEN		4
+
+static int capture_write_raw(capture_slot *slot) {
+	FILE *file = fopen(slot->path, "wb");
+	if (!file)
+		return VS_FAILURE;
+
+	// GL rows are bottom up
+	size_t stride = (size_t) slot->width * 4;
+	int result = VS_SUCCESS;
+	for (unsigned y = slot->height; result && y-- > 0;)
+		result = fwrite(slot->pixels + stride * y, stride, 1, file) == 1;
+	return !fclose(file) && result;
+}
+
+static int capture_write_png(capture_slot *slot) {
+	png_image image;
+	memset(&image, 0, sizeof(png_image));
+	image.version = PNG_IMAGE_VERSION;
+	image.width = slot->width;
+	image.height = slot->height;
+	image.format = PNG_FORMAT_RGBA;
+
+	// A negative stride has libpng write the bottom up rows top down
+	png_int_32 stride = -(png_int_32) PNG_IMAGE_ROW_STRIDE(image);
+	return png_image_write_to_file(&image, slot->path, 0, slot->pixels, stride, NULL);
+}
+
+static void capture_write(void *arg) {
+	VS_TRACE_SCOPE("capture_write");
+	capture_slot *slot = (capture_slot*) arg;
+
+	int result = slot->format == VS_CAPTURE_PNG ? capture_write_png(slot) : capture_write_raw(slot);
+	if (result) {
+		atomic_fetch_add_explicit(slot->written, 1, memory_order_relaxed);
+	} else {
+		vs_log_error("Failed to write capture %s", slot->path);
+		atomic_fetch_add_explicit(slot->failed, 1, memory_order_relaxed);
+	}
+	atomic_store_explicit(&slot->state, VS_CAPTURE_WRITTEN, memory_order_release);
+}
+
+static void capture_release(capture_ring *ring, capture_slot *slot) {
+	memory_free(VS_MEMORY_IMAGES, slot->path);
+	slot->path = NULL;
+	slot->pixels = NULL;
+	atomic_store_explicit(&slot->state, VS_CAPTURE_FREE, memory_order_relaxed);
+	ring->n_busy--;
+}
+
+static void capture_read_back(capture_ring *ring, capture_slot *slot, unsigned width, unsigned height) {
+	unsigned long size = (unsigned long) width * height * 4;
+	gl_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+	if (size > slot->pbo_size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		memory_gpu_resize(VS_MEMORY_GL_BUFFERS, slot->pbo_size, size);
+		slot->pbo_size = size;
+	}
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*) 0);
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->width = width;
+	slot->height = height;
+	atomic_store_explicit(&slot->state, VS_CAPTURE_READING, memory_order_relaxed);
+	ring->captured++;
+}
+
+static void capture_map(capture_ring *ring, capture_slot *slot) {
+	if (glClientWaitSync((GLsync) slot->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		return;
+	glDeleteSync((GLsync) slot->fence);
+	slot->fence = NULL;
+
+	unsigned long size = (unsigned long) slot->width * slot->height * 4;
+	gl_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+	slot->pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (!slot->pixels) {
+		vs_log_error("Failed to map capture %s", slot->path);
+		atomic_fetch_add_explicit(&ring->failed, 1, memory_order_relaxed);
+		capture_release(ring, slot);
+		return;
+	}
+
+	// The mapping stays valid on other threads until it is unmapped here
+	atomic_store_explicit(&slot->state, VS_CAPTURE_WRITING, memory_order_relaxed);
+	jobs_submit(capture_write, slot);
+}
+
+void capture_init(capture_ring *ring) {
+	memset(ring, 0, sizeof(capture_ring));
+	for (unsigned i = 0; i < VS_CAPTURE_SLOTS; ++i) {
+		capture_slot *slot = &ring->slots[i];
+		glGenBuffers(1, &slot->pbo);
+		slot->written = &ring->written;
+		slot->failed = &ring->failed;
+		memory_gpu_alloc(VS_MEMORY_GL_BUFFERS, 0);
+	}
+}
+
+void capture_destroy(capture_ring *ring) {
+	for (unsigned i = 0; i < VS_CAPTURE_SLOTS; ++i) {
+		capture_slot *slot = &ring->slots[i];
+		while (atomic_load_explicit(&slot->state, memory_order_acquire) == VS_CAPTURE_WRITING)
+			usleep(1000);
+		if (slot->fence)
+			glDeleteSync((GLsync) slot->fence);
+		if (slot->pixels) {
+			gl_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+		memory_free(VS_MEMORY_IMAGES, slot->path);
+		gl_delete_buffers(1, &slot->pbo);
+		memory_gpu_free(VS_MEMORY_GL_BUFFERS, slot->pbo_size);
+	}
+	memset(ring, 0, sizeof(capture_ring));
+}
+
+int capture_request(capture_ring *ring, const char *path, int format) {
+	for (unsigned i = 0; i < VS_CAPTURE_SLOTS; ++i) {
+		capture_slot *slot = &ring->slots[i];
+		if (atomic_load_explicit(&slot->state, memory_order_relaxed) != VS_CAPTURE_FREE)
+			continue;
+		slot->path = memory_strdup(VS_MEMORY_IMAGES, path);
+		if (!slot->path)
+			vs_err(VS_FAILURE);
+		slot->format = format;
+		atomic_store_explicit(&slot->state, VS_CAPTURE_QUEUED, memory_order_relaxed);
+		ring->n_busy++;
+		return VS_SUCCESS;
+	}
+	ring->dropped++;
+	return VS_FAILURE;
+}
+
+void capture_end_frame(capture_ring *ring, unsigned width, unsigned height, int swap) {
+	if (!ring->n_busy)
+		return;
+	VS_TRACE_SCOPE("capture_end_frame");
+
+	// The read back has to come from the window, not whatever framebuffer was last drawn to
+	if (swap)
+		gl_bind_framebuffer(0);
+	for (unsigned i = 0; i < VS_CAPTURE_SLOTS; ++i) {
+		capture_slot *slot = &ring->slots[i];
+		switch (atomic_load_explicit(&slot->state, memory_order_acquire)) {
+		case VS_CAPTURE_QUEUED:
+			if (swap)
+				capture_read_back(ring, slot, width, height);
+			break;
+		case VS_CAPTURE_READING:
+			capture_map(ring, slot);
+			break;
+		case VS_CAPTURE_WRITTEN:
+			gl_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			capture_release(ring, slot);
+			break;
+		}
+	}
+	gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void capture_get_stats(capture_ring *ring, capture_stats *stats) {
+	stats->captured = ring->captured;
+	stats->dropped = ring->dropped;
+	stats->written = atomic_load_explicit(&ring->written, memory_order_relaxed);
+	stats->failed = atomic_load_explicit(&ring->failed, memory_order_relaxed);
+}
@@ -0,0 +1,135 @@
+/**
+ * @file capture.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Frame captures read back without stalling
+ *
+ * A capture is read into one of a ring of pixel buffer objects right before the frame is swapped. A frame or two later,
+ * once the GPU has finished the copy, the buffer is mapped and a worker thread writes it out straight from the mapping.
+ * The buffer goes back to the ring after the worker is done. When every buffer is busy a capture is dropped rather than
+ * waiting for one.
+ */
+
+#ifndef VS_CAPTURE_H
+#define VS_CAPTURE_H
+
+#include <stdatomic.h>
+
+/// Pixel buffer objects each window can have captures in flight in
+#define VS_CAPTURE_SLOTS		4
+
+/// PNG file
+#define VS_CAPTURE_PNG			0
+/// Raw RGBA rows, top to bottom, with no header
+#define VS_CAPTURE_RAW			1
+
+/**
+ * @brief Capture counts since the window was created
+ */
+typedef struct {
+	/// Captures read back from a frame
+	unsigned long captured;
+
+	/// Captures written out
+	unsigned long written;
+
+	/// Captures dropped because every buffer was busy
+	unsigned long dropped;
+
+	/// Captures that could not be mapped or written
+	unsigned long failed;
+} capture_stats;
+
+/**
+ * @brief One pixel buffer object of the ring
+ */
+typedef struct {
+	/// VS_CAPTURE_FREE and friends, written by the worker when it is done
+	atomic_int state;
+
+	unsigned pbo;
+	unsigned long pbo_size;
+
+	/// Fence after the read back, until the GPU is done with it
+	void *fence;
+
+	/// The mapped buffer, while it is being written out
+	const unsigned char *pixels;
+
+	unsigned width;
+	unsigned height;
+	int format;
+	char *path;
+
+	atomic_ulong *written;
+	atomic_ulong *failed;
+} capture_slot;
+
+/**
+ * @brief Captures of one window
+ */
+typedef struct {
+	capture_slot slots[VS_CAPTURE_SLOTS];
+
+	/// Slots that are not free, so idle frames can skip the ring
+	unsigned n_busy;
+
+	unsigned long captured;
+	unsigned long dropped;
+	atomic_ulong written;
+	atomic_ulong failed;
+} capture_ring;
+
+/**
+ * @brief Initializes the captures of a window
+ *
+ * The window's GL context must be current.
+ *
+ * @param ring Pointer to capture ring
+ */
+void capture_init(capture_ring *ring);
+
+/**
+ * @brief Waits for captures being written and deletes the ring's buffers
+ *
+ * The window's GL context must be current.
+ *
+ * @param ring Pointer to capture ring
+ */
+void capture_destroy(capture_ring *ring);
+
+/**
+ * @brief Queues a capture of the next frame that is swapped
+ *
+ * @param ring Pointer to capture ring
+ * @param path File to write the capture to
+ * @param format VS_CAPTURE_PNG or VS_CAPTURE_RAW
+ *
+ * @return Returns whether it was successful or not. It fails when every buffer is busy.
+ */
+int capture_request(capture_ring *ring, const char *path, int format);
+
+/**
+ * @brief Reads back queued captures and moves finished ones along
+ *
+ * This is called at the end of every frame, including frames that are not swapped, so captures of a window that sits
+ * still are still written out and their buffers freed.
+ *
+ * @param ring Pointer to capture ring
+ * @param width Width of the frame
+ * @param height Height of the frame
+ * @param swap Whether the frame is about to be swapped, with it in the draw buffer. Queued captures are only read back
+ * from frames that are.
+ */
+void capture_end_frame(capture_ring *ring, unsigned width, unsigned height, int swap);
+
+/**
+ * @brief Gets the capture counts of a ring
+ *
+ * @param ring Pointer to capture ring
+ * @param stats Memory address where the counts will be saved
+ */
+void capture_get_stats(capture_ring *ring, capture_stats *stats);
+
+#endif
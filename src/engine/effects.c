@@ -0,0 +1,510 @@
+/**
+ * @file effects.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "effects.h"
+
+#include <glad/glad.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "graphics.h"
+#include "glstate.h"
+#include "memory.h"
+
+static const unsigned char effect_white[] = {0xFF, 0xFF, 0xFF, 0xFF};
+
+/// Pixels per texel blurs are run at, by quality
+static const unsigned effect_downsamples[] = {4, 2, 1};
+
+static void effect_target_release(effect_target *t) {
+	if (t->fbo) {
+		gl_delete_framebuffers(1, &t->fbo);
+		gl_delete_textures(1, &t->texture);
+		memory_gpu_free(VS_MEMORY_LAYERS, (unsigned long) t->width * t->height * 4);
+	}
+	memset(t, 0, sizeof(effect_target));
+}
+
+/*
+ * Creates a texture and a framebuffer drawing into it, leaving the framebuffer bound
+ */
+static int effect_target_create(effect_target *t, unsigned width, unsigned height) {
+	glGenTextures(1, &t->texture);
+	gl_bind_texture(0, t->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &t->fbo);
+	gl_bind_framebuffer(t->fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, t->texture, 0);
+
+	t->width = width;
+	t->height = height;
+	memory_gpu_alloc(VS_MEMORY_LAYERS, (unsigned long) width * height * 4);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		vs_log_error("Effect framebuffer is incomplete");
+		effect_target_release(t);
+		return VS_FAILURE;
+	}
+	return VS_SUCCESS;
+}
+
+static unsigned effect_round(unsigned size) {
+	return (size + VS_EFFECT_GRANULARITY - 1) / VS_EFFECT_GRANULARITY * VS_EFFECT_GRANULARITY;
+}
+
+/*
+ * Makes sure a scratch target is at least width by height
+ */
+static int effect_scratch(effect_cache *cache, effect_target *t, unsigned width, unsigned height) {
+	if (t->fbo && t->width >= width && t->height >= height)
+		return VS_SUCCESS;
+
+	// Keep whichever side was already big enough, so alternating shapes do not keep reallocating
+	width = effect_round(width > t->width ? width : t->width);
+	height = effect_round(height > t->height ? height : t->height);
+	cache->scratch_bytes -= (unsigned long) t->width * t->height * 4;
+	effect_target_release(t);
+	if (!effect_target_create(t, width, height))
+		return VS_FAILURE;
+	cache->scratch_bytes += (unsigned long) width * height * 4;
+	return VS_SUCCESS;
+}
+
+/*
+ * Makes the blur program the first time it is needed
+ */
+static int effect_program(effect_cache *cache) {
+	if (cache->program)
+		return VS_SUCCESS;
+
+	// One triangle that covers the viewport, made from the vertex index
+	const char *vsh_src = "#version 450 core\n"
+			"void main() {\n"
+			"	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+			"	gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);\n"
+			"}\0";
+
+	// The source and the target line up texel for texel, and reads are kept inside the part of the source in use
+	const char *fsh_src = "#version 450 core\n"
+			"uniform sampler2D sampler;\n"
+			"uniform vec2 texel;\n"
+			"uniform vec2 direction;\n"
+			"uniform vec2 limit;\n"
+			"uniform int n_taps;\n"
+			"uniform float offsets[16];\n"
+			"uniform float weights[16];\n"
+			"out vec4 fragment_color;\n"
+			"void main() {\n"
+			"	vec2 uv = gl_FragCoord.xy * texel;\n"
+			"	vec2 low = texel * 0.5;\n"
+			"	vec4 sum = texture(sampler, uv) * weights[0];\n"
+			"	for (int i = 1; i < n_taps; ++i) {\n"
+			"		vec2 step = direction * texel * offsets[i];\n"
+			"		sum += texture(sampler, clamp(uv + step, low, limit)) * weights[i];\n"
+			"		sum += texture(sampler, clamp(uv - step, low, limit)) * weights[i];\n"
+			"	}\n"
+			"	fragment_color = sum;\n"
+			"}\0";
+
+	unsigned vsh = gl_create_shader(GL_VERTEX_SHADER, &vsh_src);
+	unsigned fsh = gl_create_shader(GL_FRAGMENT_SHADER, &fsh_src);
+	if (!vsh || !fsh) {
+		glDeleteShader(vsh);
+		glDeleteShader(fsh);
+		return VS_FAILURE;
+	}
+
+	cache->program = gl_create_program(vsh, fsh);
+	if (!cache->program)
+		return VS_FAILURE;
+	cache->texel_location = glGetUniformLocation(cache->program, "texel");
+	cache->direction_location = glGetUniformLocation(cache->program, "direction");
+	cache->limit_location = glGetUniformLocation(cache->program, "limit");
+	cache->n_taps_location = glGetUniformLocation(cache->program, "n_taps");
+	cache->offsets_location = glGetUniformLocation(cache->program, "offsets");
+	cache->weights_location = glGetUniformLocation(cache->program, "weights");
+
+	// The core profile draws nothing without a vertex array, even one with no attributes
+	glGenVertexArrays(1, &cache->vao);
+	return VS_SUCCESS;
+}
+
+/*
+ * Works out the taps of a gaussian. Each tap past the center reads two neighbouring texels at once, placed between them
+ * so that linear filtering weighs them as the gaussian would.
+ */
+static unsigned effect_taps(float sigma, float *offsets, float *weights) {
+	offsets[0] = 0.0f;
+	weights[0] = 1.0f;
+	if (sigma < 0.1f)
+		return 1;
+
+	const int most = (VS_EFFECT_MAX_TAPS - 1) * 2;
+	int reach = (int) ceilf(sigma * 3.0f);
+	if (reach > most)
+		reach = most;
+
+	float g[(VS_EFFECT_MAX_TAPS - 1) * 2 + 2];
+	float sum = 0.0f;
+	for (int i = 0; i <= reach; ++i) {
+		g[i] = expf(-0.5f * i * i / (sigma * sigma));
+		sum += i ? g[i] * 2.0f : g[i];
+	}
+	g[reach + 1] = 0.0f;
+
+	unsigned n = 1;
+	weights[0] = g[0] / sum;
+	for (int i = 1; i <= reach; i += 2) {
+		float w = g[i] + g[i + 1];
+		offsets[n] = (i * g[i] + (i + 1) * g[i + 1]) / w;
+		weights[n] = w / sum;
+		n++;
+	}
+	return n;
+}
+
+/*
+ * Pixels per texel to blur at. Small blurs are not downsampled as far, since the blur would not hide the blockiness, and
+ * blurs too wide for the taps are downsampled further.
+ */
+static unsigned effect_downsample(const effect_cache *cache, unsigned blur) {
+	unsigned d = effect_downsamples[cache->quality];
+	while (d > 1 && d * 2 > blur)
+		d /= 2;
+	while (blur / 3.0f / d > VS_EFFECT_MAX_SIGMA)
+		d *= 2;
+	return d;
+}
+
+/*
+ * Blurs the width by height texels at the bottom left of src along one axis into dest
+ */
+static void effect_pass(effect_cache *cache, const effect_target *src, const effect_target *dest, unsigned width,
+	unsigned height, int vertical) {
+	gl_bind_framebuffer(dest->fbo);
+	gl_viewport(0, 0, width, height);
+	gl_bind_texture(0, src->texture);
+	glUniform2f(cache->texel_location, 1.0f / src->width, 1.0f / src->height);
+	glUniform2f(cache->direction_location, vertical ? 0.0f : 1.0f, vertical ? 1.0f : 0.0f);
+	glUniform2f(cache->limit_location, (width - 0.5f) / src->width, (height - 0.5f) / src->height);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+/*
+ * Blurs the width by height texels at the bottom left of src into dest, going through scratch in between
+ */
+static void effect_blur(effect_cache *cache, const effect_target *src, const effect_target *scratch,
+	const effect_target *dest, unsigned width, unsigned height, float sigma) {
+	float offsets[VS_EFFECT_MAX_TAPS];
+	float weights[VS_EFFECT_MAX_TAPS];
+	unsigned n_taps = effect_taps(sigma, offsets, weights);
+
+	gl_use_program(cache->program);
+	gl_bind_vertex_array(cache->vao);
+	gl_set_blend(VS_FALSE);
+	gl_set_scissor_test(VS_FALSE);
+	gl_set_stencil_test(VS_FALSE);
+	gl_color_mask(VS_TRUE);
+	glUniform1i(cache->n_taps_location, n_taps);
+	glUniform1fv(cache->offsets_location, n_taps, offsets);
+	glUniform1fv(cache->weights_location, n_taps, weights);
+
+	effect_pass(cache, src, scratch, width, height, VS_FALSE);
+	effect_pass(cache, scratch, dest, width, height, VS_TRUE);
+}
+
+static void effect_shadow_free(effect_cache *cache, effect_shadow *s) {
+	if (s->target.fbo) {
+		cache->stats.bytes -= (unsigned long) s->target.width * s->target.height * 4;
+		effect_target_release(&s->target);
+	}
+	if (!s->ready)
+		cache->n_pending--;
+	cache->stats.n_shadows--;
+	memory_free(VS_MEMORY_RENDER, s);
+}
+
+/*
+ * Frees the least recently drawn shadows until bytes more fit in the budget. Shadows drawn in the last frame are kept.
+ */
+static int effect_make_room(effect_cache *cache, unsigned long bytes) {
+	while (cache->stats.bytes + bytes > cache->stats.budget) {
+		effect_shadow **oldest = NULL;
+		for (unsigned b = 0; b < VS_EFFECT_BUCKETS; ++b) {
+			for (effect_shadow **link = &cache->buckets[b]; *link; link = &(*link)->next) {
+				effect_shadow *s = *link;
+				unsigned last_used = atomic_load_explicit(&s->last_used, memory_order_relaxed);
+				if (!s->target.fbo || last_used + 1 >= cache->frame)
+					continue;
+				if (!oldest || last_used < atomic_load_explicit(&(*oldest)->last_used, memory_order_relaxed))
+					oldest = link;
+			}
+		}
+		if (!oldest)
+			return VS_FAILURE;
+		effect_shadow *s = *oldest;
+		*oldest = s->next;
+		effect_shadow_free(cache, s);
+		cache->stats.evictions++;
+	}
+	return VS_SUCCESS;
+}
+
+/*
+ * Draws the shape of a shadow white on transparent white, so blurring it only changes the alpha, and blurs it into the
+ * shadow's texture
+ */
+static int effect_render_shadow(effect_cache *cache, effect_shadow *s, render_context *ctx) {
+	unsigned d = s->downsample;
+	unsigned width = (s->shape_width + s->blur * 2 + d - 1) / d;
+	unsigned height = (s->shape_height + s->blur * 2 + d - 1) / d;
+	if (!effect_program(cache) || !effect_scratch(cache, &cache->scratch[1], width, height) ||
+		!effect_scratch(cache, &cache->scratch[2], width, height))
+		return VS_FAILURE;
+
+	const path_style style = {VS_FALSE, VS_FILL_NONZERO};
+	float scale = 1.0f / d;
+	path_mesh mesh;
+	path_clear(&cache->path);
+	render_list_clear(&cache->list);
+	if (!path_rounded_rect(&cache->path, s->blur, s->blur, s->shape_width, s->shape_height, s->radius) ||
+		!path_tessellate(&cache->path, &style, scale, &mesh))
+		return VS_FAILURE;
+	int result = render_push_mesh(&cache->list, mesh.vertices, mesh.n_vertices, mesh.bounds, 0.0f, 0.0f, scale,
+		effect_white);
+	memory_free(VS_MEMORY_RENDER, mesh.vertices);
+	if (!result)
+		return VS_FAILURE;
+
+	unsigned long bytes = (unsigned long) width * height * 4;
+	if (!effect_make_room(cache, bytes) || !effect_target_create(&s->target, width, height))
+		return VS_FAILURE;
+	cache->stats.bytes += bytes;
+
+	const float transparent[] = {1.0f, 1.0f, 1.0f, 0.0f};
+	gl_bind_framebuffer(cache->scratch[1].fbo);
+	glClearBufferfv(GL_COLOR, 0, transparent);
+	gl_render_submit(ctx, &cache->list, width, height);
+	effect_blur(cache, &cache->scratch[1], &cache->scratch[2], &s->target, width, height, s->blur / 3.0f / d);
+	return VS_SUCCESS;
+}
+
+void effect_cache_init(effect_cache *cache, unsigned long budget) {
+	memset(cache, 0, sizeof(effect_cache));
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->quality = VS_EFFECT_QUALITY_MEDIUM;
+	cache->stats.budget = budget;
+	path_init(&cache->path);
+	render_list_init(&cache->list);
+}
+
+void effect_cache_destroy(effect_cache *cache) {
+	for (unsigned b = 0; b < VS_EFFECT_BUCKETS; ++b) {
+		while (cache->buckets[b]) {
+			effect_shadow *s = cache->buckets[b];
+			cache->buckets[b] = s->next;
+			effect_shadow_free(cache, s);
+		}
+	}
+	for (unsigned i = 0; i < 3; ++i)
+		effect_target_release(&cache->scratch[i]);
+	cache->scratch_bytes = 0;
+	gl_delete_vertex_arrays(1, &cache->vao);
+	gl_delete_program(cache->program);
+	cache->vao = 0;
+	cache->program = 0;
+	path_free(&cache->path);
+	render_list_free(&cache->list);
+	pthread_mutex_destroy(&cache->lock);
+}
+
+int effect_cache_set_quality(effect_cache *cache, unsigned quality) {
+	if (quality > VS_EFFECT_QUALITY_HIGH)
+		vs_err(VS_FAILURE);
+	cache->quality = quality;
+	return VS_SUCCESS;
+}
+
+unsigned effect_cache_update(effect_cache *cache, render_context *ctx) {
+	VS_TRACE_SCOPE("effect_cache_update");
+	pthread_mutex_lock(&cache->lock);
+	cache->frame++;
+	cache->stats.backdrops = 0;
+	cache->stats.backdrop_pixels = 0;
+
+	// Failed shadows are forgotten too, so they are tried again if they are still wanted
+	unsigned rendered = 0;
+	for (unsigned b = 0; b < VS_EFFECT_BUCKETS; ++b) {
+		for (effect_shadow **link = &cache->buckets[b]; *link;) {
+			effect_shadow *s = *link;
+			unsigned since = s->failed ? s->failed : atomic_load_explicit(&s->last_used, memory_order_relaxed);
+			if (since + VS_EFFECT_FORGET < cache->frame) {
+				*link = s->next;
+				effect_shadow_free(cache, s);
+				continue;
+			}
+			link = &s->next;
+
+			if (s->ready || rendered >= VS_EFFECT_RENDERS_PER_FRAME)
+				continue;
+			if (effect_render_shadow(cache, s, ctx)) {
+				rendered++;
+				cache->stats.renders++;
+			} else {
+				s->failed = cache->frame;
+			}
+			s->ready = VS_TRUE;
+			cache->n_pending--;
+		}
+	}
+	if (rendered)
+		gl_bind_framebuffer(0);
+	pthread_mutex_unlock(&cache->lock);
+	return rendered;
+}
+
+/*
+ * Finds a shadow, or adds it to be rendered by the next update. Returns NULL until it is ready to draw.
+ */
+static effect_shadow *effect_shadow_get(effect_cache *cache, unsigned width, unsigned height, unsigned radius,
+	unsigned blur, unsigned downsample) {
+	unsigned long h = width;
+	h = h * 0x100000001B3ul ^ height;
+	h = h * 0x100000001B3ul ^ radius;
+	h = h * 0x100000001B3ul ^ blur;
+	h = h * 0x100000001B3ul ^ downsample;
+	h *= 0x9E3779B97F4A7C15ul;
+	unsigned slot = (unsigned) (h >> 32 ^ h) & (VS_EFFECT_BUCKETS - 1);
+
+	pthread_mutex_lock(&cache->lock);
+	for (effect_shadow *s = cache->buckets[slot]; s; s = s->next) {
+		if (s->width == width && s->height == height && s->radius == radius && s->blur == blur &&
+			s->downsample == downsample) {
+			atomic_store_explicit(&s->last_used, cache->frame, memory_order_relaxed);
+			int drawable = s->ready && !s->failed;
+			if (drawable)
+				cache->stats.hits++;
+			pthread_mutex_unlock(&cache->lock);
+			return drawable ? s : NULL;
+		}
+	}
+
+	cache->stats.misses++;
+	effect_shadow *s = memory_calloc(VS_MEMORY_RENDER, 1, sizeof(effect_shadow));
+	if (s) {
+		s->width = width;
+		s->height = height;
+		s->radius = radius;
+		s->blur = blur;
+		s->downsample = downsample;
+
+		// The shared shadow is of the smallest rectangle whose middle is flat, with two texels of it to stretch
+		unsigned flat = (radius + blur) * 2 + downsample * 2;
+		s->shape_width = width ? width : flat;
+		s->shape_height = height ? height : flat;
+		atomic_init(&s->last_used, cache->frame);
+		s->next = cache->buckets[slot];
+		cache->buckets[slot] = s;
+		cache->stats.n_shadows++;
+		cache->n_pending++;
+	}
+	pthread_mutex_unlock(&cache->lock);
+	return NULL;
+}
+
+int effect_draw_shadow(effect_cache *cache, render_list *list, float x, float y, unsigned width, unsigned height,
+	unsigned radius, unsigned blur, const unsigned char *rgba) {
+	if (!width || !height || !rgba[3])
+		return VS_SUCCESS;
+	if (radius > width / 2)
+		radius = width / 2;
+	if (radius > height / 2)
+		radius = height / 2;
+
+	// Past the blur from the corners, every row or column of a shadow is the same, so the middle can be stretched
+	unsigned d = effect_downsample(cache, blur);
+	unsigned reach = radius + blur;
+	unsigned flat = reach * 2 + d * 2;
+	int sliced = width >= flat && height >= flat;
+	effect_shadow *s = effect_shadow_get(cache, sliced ? 0 : width, sliced ? 0 : height, radius, blur, d);
+	if (!s)
+		return VS_SUCCESS;
+
+	// Edges of the slices on the screen and in the shadow's texture, in pixels from its top left corner
+	float full_width = s->shape_width + blur * 2.0f;
+	float full_height = s->shape_height + blur * 2.0f;
+	float screen_x[] = {x - blur, x + reach, x + width - reach, x + width + blur};
+	float screen_y[] = {y - blur, y + reach, y + height - reach, y + height + blur};
+	float source_x[] = {0.0f, reach + blur, full_width - reach - blur, full_width};
+	float source_y[] = {0.0f, reach + blur, full_height - reach - blur, full_height};
+	unsigned n = 3;
+	if (!sliced) {
+		screen_x[1] = screen_x[3];
+		screen_y[1] = screen_y[3];
+		source_x[1] = source_x[3];
+		source_y[1] = source_y[3];
+		n = 1;
+	}
+
+	// The stretched slices read the middle column and row. Textures are bottom up.
+	float su = 1.0f / (d * s->target.width);
+	float sv = 1.0f / (d * s->target.height);
+	for (unsigned j = 0; j < n; ++j) {
+		for (unsigned i = 0; i < n; ++i) {
+			float u0 = (n == 3 && i == 1 ? full_width * 0.5f : source_x[i]) * su;
+			float u1 = (n == 3 && i == 1 ? full_width * 0.5f : source_x[i + 1]) * su;
+			float v0 = 1.0f - (n == 3 && j == 1 ? full_height * 0.5f : source_y[j]) * sv;
+			float v1 = 1.0f - (n == 3 && j == 1 ? full_height * 0.5f : source_y[j + 1]) * sv;
+			float uv[] = {u0, v0, u1, v1};
+			if (!render_push_quad(list, screen_x[i], screen_y[j], screen_x[i + 1] - screen_x[i],
+				screen_y[j + 1] - screen_y[j], rgba, s->target.texture, uv))
+				return VS_FAILURE;
+		}
+	}
+	return VS_SUCCESS;
+}
+
+unsigned gl_effect_backdrop(effect_cache *cache, const int *rect, unsigned blur, float *uv) {
+	VS_TRACE_SCOPE("gl_effect_backdrop");
+	unsigned d = effect_downsample(cache, blur);
+	unsigned width = (rect[2] + d - 1) / d;
+	unsigned height = (rect[3] + d - 1) / d;
+	unsigned source = g_gl_state->framebuffer;
+
+	// Without downsampling, the copy goes straight to where the blur starts
+	effect_target *copy = d > 1 ? &cache->scratch[0] : &cache->scratch[1];
+	if (!effect_program(cache) || !effect_scratch(cache, copy, rect[2], rect[3]) ||
+		!effect_scratch(cache, &cache->scratch[1], width, height) ||
+		!effect_scratch(cache, &cache->scratch[2], width, height))
+		return 0;
+
+	// The first copy is the same size, which a multisampled target needs to resolve
+	const int area[4] = {rect[0], rect[1], rect[0] + rect[2], rect[1] + rect[3]};
+	const int full[4] = {0, 0, rect[2], rect[3]};
+	gl_blit_framebuffer(source, copy->fbo, area, full, GL_NEAREST);
+	if (d > 1) {
+		const int small[4] = {0, 0, (int) width, (int) height};
+		gl_blit_framebuffer(copy->fbo, cache->scratch[1].fbo, full, small, GL_LINEAR);
+	}
+
+	effect_blur(cache, &cache->scratch[1], &cache->scratch[2], &cache->scratch[1], width, height, blur / 3.0f / d);
+	cache->stats.backdrops++;
+	cache->stats.backdrop_pixels += (unsigned long) rect[2] * rect[3];
+
+	uv[0] = 0.0f;
+	uv[1] = 0.0f;
+	uv[2] = (float) width / cache->scratch[1].width;
+	uv[3] = (float) height / cache->scratch[1].height;
+	return cache->scratch[1].texture;
+}
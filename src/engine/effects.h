@@ -0,0 +1,224 @@
+/**
+ * @file effects.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Drop shadows and backdrop blur
+ *
+ * Both are made with the same separable gaussian blur, run on a downsampled copy of only the pixels it affects: a
+ * horizontal pass and then a vertical one, each reading two texels per tap through linear filtering.
+ *
+ * A shadow is the blurred shape of a rounded rectangle. It is rendered once into a texture and cached by its corner
+ * radius, blur and downsampling. Rectangles wide and tall enough to have a flat middle all share the shadow of the
+ * smallest such rectangle, which is drawn in nine slices with the middle ones stretched, so resizing a popup does not
+ * render its shadow again. Only smaller rectangles are cached by their size too.
+ *
+ * A backdrop is recorded as a quad whose texture is made while the render list is being submitted: everything drawn
+ * before it is copied from the target around the quad, blurred, and drawn back through the quad.
+ */
+
+#ifndef VS_EFFECTS_H
+#define VS_EFFECTS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "render.h"
+#include "path.h"
+
+/*
+ * Effect quality. Lower quality blurs at a lower resolution, which costs a quarter as much per halving.
+ */
+#define VS_EFFECT_QUALITY_LOW		0
+#define VS_EFFECT_QUALITY_MEDIUM	1
+#define VS_EFFECT_QUALITY_HIGH		2
+
+/// Most taps a blur pass takes, each reading two texels, including the center one
+#define VS_EFFECT_MAX_TAPS			16
+
+/// Widest gaussian in texels a blur pass can take. Wider blurs are run at a lower resolution.
+#define VS_EFFECT_MAX_SIGMA			10.0f
+
+/// Hash buckets shadows are looked up in
+#define VS_EFFECT_BUCKETS			64
+
+/// Frames a shadow is kept for after it was last drawn
+#define VS_EFFECT_FORGET			300
+
+/// Most shadows rendered in one frame, so a screen full of new ones is spread over a few frames
+#define VS_EFFECT_RENDERS_PER_FRAME	16
+
+/// Scratch textures are allocated in multiples of this many pixels so that small size changes reuse them
+#define VS_EFFECT_GRANULARITY		64
+
+/**
+ * @brief A texture with a framebuffer to draw into it
+ */
+typedef struct {
+	unsigned fbo;
+	unsigned texture;
+	unsigned width;
+	unsigned height;
+} effect_target;
+
+/**
+ * @brief A cached shadow
+ */
+typedef struct effect_shadow {
+	/// Size of the rectangle in pixels, or 0 for the shadow shared by every rectangle big enough to slice
+	unsigned width;
+	unsigned height;
+	unsigned radius;
+	unsigned blur;
+	unsigned downsample;
+
+	/// Size of the rectangle the shadow was rendered for
+	unsigned shape_width;
+	unsigned shape_height;
+
+	/// Holds the shadow, white with the coverage in alpha, from the bottom left corner up
+	effect_target target;
+
+	/// Set once the shadow has been rendered, or has failed to
+	int ready;
+
+	/// Frame rendering the shadow failed in, or 0. Failed shadows are tried again after VS_EFFECT_FORGET frames.
+	unsigned failed;
+
+	/// Frame the shadow was last drawn
+	atomic_uint last_used;
+
+	struct effect_shadow *next;
+} effect_shadow;
+
+/**
+ * @brief Effect statistics
+ */
+typedef struct {
+	unsigned n_shadows;
+	unsigned long bytes;
+	unsigned long budget;
+
+	/// Totals since the cache was created
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long renders;
+	unsigned long evictions;
+
+	/// Backdrops blurred and the pixels they covered in the last frame
+	unsigned backdrops;
+	unsigned long backdrop_pixels;
+} effect_stats;
+
+typedef struct effect_cache effect_cache;
+
+struct effect_cache {
+	pthread_mutex_t lock;
+	effect_shadow *buckets[VS_EFFECT_BUCKETS];
+	unsigned frame;
+
+	/// VS_EFFECT_QUALITY_LOW and friends
+	unsigned quality;
+
+	/// Shadows that were asked for and are waiting to be rendered
+	unsigned n_pending;
+
+	effect_stats stats;
+
+	/// Blur program and its uniforms, made the first time something is blurred
+	unsigned program;
+	unsigned vao;
+	int texel_location;
+	int direction_location;
+	int limit_location;
+	int n_taps_location;
+	int offsets_location;
+	int weights_location;
+
+	/// Copy of a backdrop, and the two targets blur passes go back and forth between
+	effect_target scratch[3];
+	unsigned long scratch_bytes;
+
+	/// Used to draw the shapes of shadows
+	path_t path;
+	render_list list;
+};
+
+/**
+ * @brief Initializes an effect cache
+ *
+ * @param cache Pointer to effect cache
+ * @param budget Most GPU bytes the cached shadows may hold
+ */
+void effect_cache_init(effect_cache *cache, unsigned long budget);
+
+/**
+ * @brief Deletes every shadow and GL object of an effect cache
+ *
+ * The GL context the cache belongs to must be current.
+ *
+ * @param cache Pointer to effect cache
+ */
+void effect_cache_destroy(effect_cache *cache);
+
+/**
+ * @brief Sets the resolution effects are blurred at
+ *
+ * Shadows already cached at another quality are left to age out.
+ *
+ * @param cache Pointer to effect cache
+ * @param quality VS_EFFECT_QUALITY_LOW, VS_EFFECT_QUALITY_MEDIUM or VS_EFFECT_QUALITY_HIGH
+ *
+ * @return Returns whether it was successful or not
+ */
+int effect_cache_set_quality(effect_cache *cache, unsigned quality);
+
+/**
+ * @brief Renders the shadows asked for since the last update and evicts old ones
+ *
+ * This must be called on the GL thread before the frame is recorded.
+ *
+ * @param cache Pointer to effect cache
+ * @param ctx Render context used to draw the shapes of shadows
+ *
+ * @return Returns the number of shadows rendered
+ */
+unsigned effect_cache_update(effect_cache *cache, render_context *ctx);
+
+/**
+ * @brief Records the shadow of a rounded rectangle
+ *
+ * This is safe to call on any thread while recording. A shadow that is not cached yet is left out and rendered by the
+ * next update.
+ *
+ * @param cache Pointer to effect cache
+ * @param list Pointer to render list
+ * @param x Left edge of the rectangle in pixels
+ * @param y Top edge of the rectangle in pixels
+ * @param width Width of the rectangle in pixels
+ * @param height Height of the rectangle in pixels
+ * @param radius Corner radius in pixels
+ * @param blur Distance in pixels the shadow fades out over, past the edges of the rectangle
+ * @param rgba Color of the shadow
+ *
+ * @return Returns whether it was successful or not
+ */
+int effect_draw_shadow(effect_cache *cache, render_list *list, float x, float y, unsigned width, unsigned height,
+	unsigned radius, unsigned blur, const unsigned char *rgba);
+
+/**
+ * @brief Blurs part of the framebuffer being drawn into
+ *
+ * This is called by gl_render_submit() for VS_RENDER_BACKDROP commands. The GL state it changes is left for the caller
+ * to set back.
+ *
+ * @param cache Pointer to effect cache
+ * @param rect Pixels to blur as {x, y, width, height}, from the bottom left corner of the framebuffer
+ * @param blur Blur radius in pixels
+ * @param uv Memory address where the part of the texture that holds the result will be saved as {u0, v0, u1, v1}
+ *
+ * @return Returns the texture holding the result, or 0 if it failed
+ */
+unsigned gl_effect_backdrop(effect_cache *cache, const int *rect, unsigned blur, float *uv);
+
+#endif
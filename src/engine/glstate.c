@@ -0,0 +1,253 @@
+/**
+ * @file glstate.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "glstate.h"
+
+#include <glad/glad.h>
+
+#include <string.h>
+
+#include "../venus_common.h"
+#include "memory.h"
+
+gl_state *g_gl_state = NULL;
+
+#define VS_GL_ELIDE(CONDITION)				\
+	if (CONDITION) {						\
+		g_gl_state->frame.elided++;			\
+		return;								\
+	}										\
+	g_gl_state->frame.changes++;
+
+void gl_state_init(gl_state *state) {
+	memset(state, 0, sizeof(gl_state));
+	state->blend_src = GL_ONE;
+	state->blend_dst = GL_ZERO;
+	state->blend_src_alpha = GL_ONE;
+	state->blend_dst_alpha = GL_ZERO;
+	state->stencil_func = GL_ALWAYS;
+	state->stencil_pass = GL_KEEP;
+	state->color_mask = VS_TRUE;
+
+	// The default viewport and scissor box are the size of the drawable, which is not known here
+	for (unsigned i = 0; i < 4; ++i) {
+		state->viewport[i] = -1;
+		state->scissor[i] = -1;
+	}
+}
+
+void gl_state_end_frame(gl_state *state) {
+	state->last_frame = state->frame;
+	state->frame.changes = 0;
+	state->frame.elided = 0;
+}
+
+void gl_use_program(unsigned program) {
+	VS_GL_ELIDE(g_gl_state->program == program);
+	g_gl_state->program = program;
+	glUseProgram(program);
+}
+
+void gl_bind_vertex_array(unsigned vertex_array) {
+	VS_GL_ELIDE(g_gl_state->vertex_array == vertex_array);
+	g_gl_state->vertex_array = vertex_array;
+
+	// The element buffer binding belongs to the vertex array
+	g_gl_state->element_buffer = VS_GL_UNKNOWN;
+	glBindVertexArray(vertex_array);
+}
+
+void gl_bind_framebuffer(unsigned framebuffer) {
+	VS_GL_ELIDE(g_gl_state->framebuffer == framebuffer);
+	g_gl_state->framebuffer = framebuffer;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void gl_blit_framebuffer(unsigned read, unsigned draw, const int *src, const int *dst, unsigned filter) {
+	gl_set_scissor_test(VS_FALSE);
+
+	// The shadow only tracks GL_FRAMEBUFFER, so these three binds are counted but never skipped
+	g_gl_state->frame.changes += 3;
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, read);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw);
+	glBlitFramebuffer(src[0], src[1], src[2], src[3], dst[0], dst[1], dst[2], dst[3], GL_COLOR_BUFFER_BIT, filter);
+	glBindFramebuffer(GL_FRAMEBUFFER, g_gl_state->framebuffer);
+}
+
+static unsigned *gl_buffer_binding(unsigned target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER:			return &g_gl_state->array_buffer;
+	case GL_ELEMENT_ARRAY_BUFFER:	return &g_gl_state->element_buffer;
+	case GL_PIXEL_PACK_BUFFER:		return &g_gl_state->pixel_pack_buffer;
+	case GL_PIXEL_UNPACK_BUFFER:	return &g_gl_state->pixel_unpack_buffer;
+	}
+	return NULL;
+}
+
+void gl_bind_buffer(unsigned target, unsigned buffer) {
+	unsigned *binding = gl_buffer_binding(target);
+	if (!binding) {
+		g_gl_state->frame.changes++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+	VS_GL_ELIDE(*binding == buffer);
+	*binding = buffer;
+	glBindBuffer(target, buffer);
+}
+
+void gl_bind_texture(unsigned unit, unsigned texture) {
+	VS_GL_ELIDE(g_gl_state->textures[unit] == texture);
+	g_gl_state->textures[unit] = texture;
+	if (g_gl_state->active_texture != unit) {
+		g_gl_state->active_texture = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void gl_set_blend(int enabled) {
+	VS_GL_ELIDE(g_gl_state->blend == (unsigned) !!enabled);
+	g_gl_state->blend = !!enabled;
+	if (enabled)
+		glEnable(GL_BLEND);
+	else
+		glDisable(GL_BLEND);
+}
+
+void gl_blend_func(unsigned src, unsigned dst) {
+	gl_blend_func_separate(src, dst, src, dst);
+}
+
+void gl_blend_func_separate(unsigned src, unsigned dst, unsigned src_alpha, unsigned dst_alpha) {
+	VS_GL_ELIDE(g_gl_state->blend_src == src && g_gl_state->blend_dst == dst &&
+		g_gl_state->blend_src_alpha == src_alpha && g_gl_state->blend_dst_alpha == dst_alpha);
+	g_gl_state->blend_src = src;
+	g_gl_state->blend_dst = dst;
+	g_gl_state->blend_src_alpha = src_alpha;
+	g_gl_state->blend_dst_alpha = dst_alpha;
+	glBlendFuncSeparate(src, dst, src_alpha, dst_alpha);
+}
+
+void gl_set_scissor_test(int enabled) {
+	VS_GL_ELIDE(g_gl_state->scissor_test == (unsigned) !!enabled);
+	g_gl_state->scissor_test = !!enabled;
+	if (enabled)
+		glEnable(GL_SCISSOR_TEST);
+	else
+		glDisable(GL_SCISSOR_TEST);
+}
+
+void gl_scissor(int x, int y, int width, int height) {
+	int *s = g_gl_state->scissor;
+	VS_GL_ELIDE(s[0] == x && s[1] == y && s[2] == width && s[3] == height);
+	s[0] = x;
+	s[1] = y;
+	s[2] = width;
+	s[3] = height;
+	glScissor(x, y, width, height);
+}
+
+void gl_viewport(int x, int y, int width, int height) {
+	int *v = g_gl_state->viewport;
+	VS_GL_ELIDE(v[0] == x && v[1] == y && v[2] == width && v[3] == height);
+	v[0] = x;
+	v[1] = y;
+	v[2] = width;
+	v[3] = height;
+	glViewport(x, y, width, height);
+}
+
+void gl_set_stencil_test(int enabled) {
+	VS_GL_ELIDE(g_gl_state->stencil_test == (unsigned) !!enabled);
+	g_gl_state->stencil_test = !!enabled;
+	if (enabled)
+		glEnable(GL_STENCIL_TEST);
+	else
+		glDisable(GL_STENCIL_TEST);
+}
+
+void gl_stencil_func(unsigned func, int ref) {
+	VS_GL_ELIDE(g_gl_state->stencil_func == func && g_gl_state->stencil_ref == ref);
+	g_gl_state->stencil_func = func;
+	g_gl_state->stencil_ref = ref;
+	glStencilFunc(func, ref, 0xFF);
+}
+
+void gl_stencil_op(unsigned pass) {
+	VS_GL_ELIDE(g_gl_state->stencil_pass == pass);
+	g_gl_state->stencil_pass = pass;
+	glStencilOp(GL_KEEP, GL_KEEP, pass);
+}
+
+void gl_color_mask(int enabled) {
+	VS_GL_ELIDE(g_gl_state->color_mask == (unsigned) !!enabled);
+	g_gl_state->color_mask = !!enabled;
+	glColorMask(!!enabled, !!enabled, !!enabled, !!enabled);
+}
+
+void gl_clear_color(float r, float g, float b, float a) {
+	float *c = g_gl_state->clear_color;
+	VS_GL_ELIDE(c[0] == r && c[1] == g && c[2] == b && c[3] == a);
+	c[0] = r;
+	c[1] = g;
+	c[2] = b;
+	c[3] = a;
+	glClearColor(r, g, b, a);
+}
+
+void gl_delete_program(unsigned program) {
+	if (!program)
+		return;
+	if (g_gl_state->program == program)
+		g_gl_state->program = 0;
+	int bytes = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &bytes);
+	memory_gpu_free(VS_MEMORY_PROGRAMS, bytes);
+	glDeleteProgram(program);
+}
+
+void gl_delete_vertex_arrays(unsigned n, const unsigned *vertex_arrays) {
+	for (unsigned i = 0; i < n; ++i) {
+		if (vertex_arrays[i] && g_gl_state->vertex_array == vertex_arrays[i]) {
+			g_gl_state->vertex_array = 0;
+			g_gl_state->element_buffer = VS_GL_UNKNOWN;
+		}
+	}
+	glDeleteVertexArrays(n, vertex_arrays);
+}
+
+void gl_delete_framebuffers(unsigned n, const unsigned *framebuffers) {
+	for (unsigned i = 0; i < n; ++i)
+		if (framebuffers[i] && g_gl_state->framebuffer == framebuffers[i])
+			g_gl_state->framebuffer = 0;
+	glDeleteFramebuffers(n, framebuffers);
+}
+
+void gl_delete_buffers(unsigned n, const unsigned *buffers) {
+	for (unsigned i = 0; i < n; ++i) {
+		if (!buffers[i])
+			continue;
+		if (g_gl_state->array_buffer == buffers[i])
+			g_gl_state->array_buffer = 0;
+		if (g_gl_state->element_buffer == buffers[i])
+			g_gl_state->element_buffer = 0;
+		if (g_gl_state->pixel_pack_buffer == buffers[i])
+			g_gl_state->pixel_pack_buffer = 0;
+		if (g_gl_state->pixel_unpack_buffer == buffers[i])
+			g_gl_state->pixel_unpack_buffer = 0;
+	}
+	glDeleteBuffers(n, buffers);
+}
+
+void gl_delete_textures(unsigned n, const unsigned *textures) {
+	for (unsigned i = 0; i < n; ++i)
+		if (textures[i])
+			for (unsigned u = 0; u < VS_GL_TEXTURE_UNITS; ++u)
+				if (g_gl_state->textures[u] == textures[i])
+					g_gl_state->textures[u] = 0;
+	glDeleteTextures(n, textures);
+}
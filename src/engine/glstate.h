@@ -0,0 +1,157 @@
+/**
+ * @file glstate.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Shadow copy of the GL state that skips redundant state changes
+ *
+ * Every bind and state change in the engine goes through these functions instead of calling OpenGL directly. Each
+ * context has its own gl_state, made current along with the context by glx_make_current(). A call that would not
+ * change anything is skipped and counted.
+ */
+
+#ifndef VS_GLSTATE_H
+#define VS_GLSTATE_H
+
+/// Number of texture units that are shadowed
+#define VS_GL_TEXTURE_UNITS		16
+
+/// Shadow value for state that is not known, which never matches a real value
+#define VS_GL_UNKNOWN			0xFFFFFFFFu
+
+/**
+ * @brief Counts of state changes made and skipped
+ */
+typedef struct {
+	unsigned long changes;
+	unsigned long elided;
+} gl_state_stats;
+
+/**
+ * @brief The shadowed state of one GL context
+ */
+typedef struct {
+	unsigned program;
+	unsigned vertex_array;
+	unsigned framebuffer;
+
+	unsigned array_buffer;
+	unsigned element_buffer;
+	unsigned pixel_pack_buffer;
+	unsigned pixel_unpack_buffer;
+
+	unsigned active_texture;
+	unsigned textures[VS_GL_TEXTURE_UNITS];
+
+	unsigned blend;
+	unsigned blend_src;
+	unsigned blend_dst;
+	unsigned blend_src_alpha;
+	unsigned blend_dst_alpha;
+
+	unsigned scissor_test;
+	int scissor[4];
+	int viewport[4];
+
+	unsigned stencil_test;
+	unsigned stencil_func;
+	int stencil_ref;
+	unsigned stencil_pass;
+	unsigned color_mask;
+
+	float clear_color[4];
+
+	/// Counts for the frame being drawn
+	gl_state_stats frame;
+
+	/// Counts for the last finished frame
+	gl_state_stats last_frame;
+} gl_state;
+
+/// The state of the current context
+extern gl_state *g_gl_state;
+
+/**
+ * @brief Sets a shadow to the state of a newly created context
+ *
+ * @param state Pointer to shadow state
+ */
+void gl_state_init(gl_state *state);
+
+/**
+ * @brief Marks the end of a frame, moving the frame's counts to last_frame
+ *
+ * @param state Pointer to shadow state
+ */
+void gl_state_end_frame(gl_state *state);
+
+void gl_use_program(unsigned program);
+void gl_bind_vertex_array(unsigned vertex_array);
+void gl_bind_framebuffer(unsigned framebuffer);
+
+/**
+ * @brief Copies the color of one framebuffer's rectangle into another's
+ *
+ * The read and draw bindings are set separately for the copy, so the shadowed framebuffer is bound again afterwards. The
+ * scissor test is turned off, since it would clip the copy.
+ *
+ * @param read Framebuffer to copy from
+ * @param draw Framebuffer to copy to
+ * @param src Rectangle to copy from, as x0, y0, x1, y1
+ * @param dst Rectangle to copy to, as x0, y0, x1, y1
+ * @param filter GL_NEAREST or GL_LINEAR
+ */
+void gl_blit_framebuffer(unsigned read, unsigned draw, const int *src, const int *dst, unsigned filter);
+
+/**
+ * @brief Binds a buffer
+ *
+ * @param target GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_PIXEL_PACK_BUFFER or GL_PIXEL_UNPACK_BUFFER. Other targets
+ * are passed through without being shadowed.
+ * @param buffer Buffer to bind
+ */
+void gl_bind_buffer(unsigned target, unsigned buffer);
+
+/**
+ * @brief Binds a 2D texture to a texture unit
+ *
+ * @param unit Texture unit, starting at 0 rather than GL_TEXTURE0
+ * @param texture Texture to bind
+ */
+void gl_bind_texture(unsigned unit, unsigned texture);
+
+void gl_set_blend(int enabled);
+void gl_blend_func(unsigned src, unsigned dst);
+void gl_blend_func_separate(unsigned src, unsigned dst, unsigned src_alpha, unsigned dst_alpha);
+void gl_set_scissor_test(int enabled);
+void gl_scissor(int x, int y, int width, int height);
+void gl_viewport(int x, int y, int width, int height);
+void gl_set_stencil_test(int enabled);
+
+/**
+ * @brief Sets the stencil function, comparing against all 8 bits
+ */
+void gl_stencil_func(unsigned func, int ref);
+
+/**
+ * @brief Sets what happens to the stencil when a fragment passes. Failing fragments always keep it.
+ */
+void gl_stencil_op(unsigned pass);
+
+/**
+ * @brief Turns writing to all four color channels on or off
+ */
+void gl_color_mask(int enabled);
+void gl_clear_color(float r, float g, float b, float a);
+
+/*
+ * Deleting an object unbinds it from the current context, so deletion also goes through the shadow. Deleted programs are
+ * taken off VS_MEMORY_PROGRAMS, so only programs made by gl_create_program() should go through gl_delete_program().
+ */
+void gl_delete_program(unsigned program);
+void gl_delete_vertex_arrays(unsigned n, const unsigned *vertex_arrays);
+void gl_delete_framebuffers(unsigned n, const unsigned *framebuffers);
+void gl_delete_buffers(unsigned n, const unsigned *buffers);
+void gl_delete_textures(unsigned n, const unsigned *textures);
+
+#endif
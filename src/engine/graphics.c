@@ -7,6 +7,8 @@
 #include "graphics.h"
 
 #include "../venus_common.h"
+#include "glstate.h"
+#include "memory.h"
 
 #include <stdlib.h>
 #include <math.h>
@@ -24,15 +26,17 @@ int (*g_error_callback)(void *win, unsigned err);
 
 GLXContext glx_make_current(window *window) {
 	if (g_current_window == window) {
-		return *window->context;
+		return window->context;
 	} else {
-		glXMakeCurrent(g_display, window->xwin, *window->context);
+		glXMakeCurrent(g_display, window->xwin, window->context);
 		g_current_window = window;
-		return *window->context;
+		g_gl_state = &window->gl;
+		return window->context;
 	}
 }
 
 unsigned gl_create_shader(int shader_type, const char **shader_source) {
+	VS_TRACE_SCOPE("gl_create_shader");
 	unsigned sh = glCreateShader(shader_type);
 	glShaderSource(sh, 1, shader_source, NULL);
 	glCompileShader(sh);
@@ -43,20 +47,51 @@ unsigned gl_create_shader(int shader_type, const char **shader_source) {
 	if (!success) {
 		glGetShaderInfoLog(sh, 512, NULL, log);
 		glDeleteShader(sh);
-		zlog_error(g_log, "vertex shader compilation failed\n%s", log);
+		vs_log_error("vertex shader compilation failed\n%s", log);
 		return 0;
 	}
 	return sh;
 }
 
 unsigned gl_load_buffer(void *data, unsigned bytecount) {
+	VS_TRACE_SCOPE("gl_load_buffer");
 	unsigned buffer;
 	glGenBuffers(1, &buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	gl_bind_buffer(GL_ARRAY_BUFFER, buffer);
 	glBufferData(GL_ARRAY_BUFFER, bytecount, data, GL_STATIC_DRAW);
+	memory_gpu_alloc(VS_MEMORY_GL_BUFFERS, bytecount);
 	return buffer;
 }
 
+void gl_unload_buffer(unsigned buffer, unsigned bytecount) {
+	gl_delete_buffers(1, &buffer);
+	memory_gpu_free(VS_MEMORY_GL_BUFFERS, bytecount);
+}
+
+unsigned gl_create_program(unsigned vsh, unsigned fsh) {
+	unsigned program = glCreateProgram();
+	glAttachShader(program, vsh);
+	glAttachShader(program, fsh);
+	glLinkProgram(program);
+	glDeleteShader(vsh);
+	glDeleteShader(fsh);
+	
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		char log[512];
+		glGetProgramInfoLog(program, 512, NULL, log);
+		glDeleteProgram(program);
+		vs_log_error("program linking failed\n%s", log);
+		return 0;
+	}
+	// The size of the program's binary is the closest thing GL has to the memory a program holds
+	int bytes = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &bytes);
+	memory_gpu_alloc(VS_MEMORY_PROGRAMS, bytes);
+	return program;
+}
+
 int glx_check_support(const char *ext_list, const char *extension) {
 	const char *start;
 	const char *where;
@@ -83,13 +118,16 @@ int glx_check_support(const char *ext_list, const char *extension) {
 }
 
 XVisualInfo *glx_get_visual(int *attributes, GLXFBConfig *framebuffer) {
-	zlog_debug(g_log, "Getting framebuffer via GLX...");
-	int glx_version_major;
-	int glx_version_minor;
-	if (!glXQueryVersion(g_display, &glx_version_major, &glx_version_minor) ||
+	vs_log_debug("Getting framebuffer via GLX...");
+	
+	// The version cannot change while the display is open, so it is only asked for by the first window
+	static int glx_version_major = 0;
+	static int glx_version_minor = 0;
+	if ((!glx_version_major && !glXQueryVersion(g_display, &glx_version_major, &glx_version_minor)) ||
 		((glx_version_major == 1) && (glx_version_minor < 3)) || (glx_version_major < 1)
 	) {
-		zlog_error(g_log, "Invalid GLX version. (%i,%i)", glx_version_major, glx_version_minor);
+		vs_log_error("Invalid GLX version. (%i,%i)", glx_version_major, glx_version_minor);
+		glx_version_major = 0;
 		return NULL;
 	}
 	
@@ -97,27 +135,29 @@ XVisualInfo *glx_get_visual(int *attributes, GLXFBConfig *framebuffer) {
 	GLXFBConfig *framebuffer_configs = glXChooseFBConfig(g_display, DefaultScreen(g_display), attributes, &framebuffer_count);
 	
 	if (!framebuffer_configs) {
-		zlog_error(g_log, "Failed to get a framebuffer configuration with the desired attributes");
+		vs_log_error("Failed to get a framebuffer configuration with the desired attributes");
 		return NULL;
 	}
 	
-	zlog_debug(g_log, "Grabbed matching framebuffer configurations.");
+	vs_log_debug("Grabbed matching framebuffer configurations.");
 	int best_config = -1;
 	int worst_config = -1;
 	int best_samples = -1;
 	int worst_samples = 999;
 	for (int i = 0; i < framebuffer_count; ++i) {
-		XVisualInfo *buffer_visual_info = glXGetVisualFromFBConfig(g_display, framebuffer_configs[i]);
+		// The ID is enough to tell whether a config has a visual, so only the chosen one is made into an XVisualInfo
+		int visual_id = 0;
+		glXGetFBConfigAttrib(g_display, framebuffer_configs[i], GLX_VISUAL_ID, &visual_id);
 		
-		if (buffer_visual_info) {
+		if (visual_id) {
 			int sample_buffer;
 			int samples;
 			
 			glXGetFBConfigAttrib(g_display, framebuffer_configs[i], GLX_SAMPLE_BUFFERS, &sample_buffer);
 			glXGetFBConfigAttrib(g_display, framebuffer_configs[i], GLX_SAMPLES, &samples);
 			
-			zlog_debug(g_log, "Matching framebuffer configuration %d, visual ID %p: GLX_SAMPLE_BUFFERS = %d, GLX_SAMPLES = %d",
-				i, (void*) buffer_visual_info->visualid, sample_buffer, samples
+			vs_log_debug("Matching framebuffer configuration %d, visual ID %p: GLX_SAMPLE_BUFFERS = %d, GLX_SAMPLES = %d",
+				i, (void*) (unsigned long) visual_id, sample_buffer, samples
 			);
 			
 			if (best_config < 0 || (sample_buffer && samples > best_samples)) {
@@ -129,18 +169,20 @@ XVisualInfo *glx_get_visual(int *attributes, GLXFBConfig *framebuffer) {
 				worst_samples = samples;
 			}
 		}
-		
-		XFree(buffer_visual_info);
 	}
 	
+	if (best_config < 0) {
+		vs_log_error("None of the framebuffer configurations has a visual");
+		XFree(framebuffer_configs);
+		return NULL;
+	}
 	*framebuffer = framebuffer_configs[best_config];
 	XFree(framebuffer_configs);
 	return glXGetVisualFromFBConfig(g_display, *framebuffer);
 }
 
-
-int g_context_err = 0;
-int glx_context_error(Display *display, XErrorEvent *event) {
+static int g_context_err = 0;
+static int glx_context_error(Display *display, XErrorEvent *event) {
     g_context_err = 1;
     return 0;
 }
@@ -150,12 +192,18 @@ GLXContext glx_make_context(XVisualInfo *visual_info, GLXFBConfig framebuffer, G
 	PFNGLXCREATECONTEXTATTRIBSARBPROC glXCreateContextAttribsARB =
 		(PFNGLXCREATECONTEXTATTRIBSARBPROC) glXGetProcAddressARB((const GLubyte*) "glXCreateContextAttribsARB");
 	
+	// glXCreateContextAttribsARB() waits for the server and returns NULL when it fails, so it needs no sync to find out.
+	// The handler is only there so the error that comes with a failure does not end the program.
 	GLXContext context = NULL;
+	g_context_err = 0;
 	int (*glx_old_error_handler)(Display*, XErrorEvent*) = XSetErrorHandler(&glx_context_error);
 	
 	if (!glx_check_support(extensions, "GLX_ARB_create_context") || !glXCreateContextAttribsARB) {
-		zlog_info(g_log, "glXCreateContextAttribsARB() not found. Reverting to deprecated GLX context.");
+		vs_log_info("glXCreateContextAttribsARB() not found. Reverting to deprecated GLX context.");
 		context = glXCreateNewContext(g_display, framebuffer, GLX_RGBA_TYPE, 0, True);
+
+		// This one does not wait, so its error has to come back while the handler is still set
+		XSync(g_display, False);
 	} else {
 		int context_attribs[] = {
 			GLX_CONTEXT_MAJOR_VERSION_ARB, 4,
@@ -165,37 +213,35 @@ GLXContext glx_make_context(XVisualInfo *visual_info, GLXFBConfig framebuffer, G
 		};
 		context = glXCreateContextAttribsARB(g_display, framebuffer, 0, True, context_attribs);
 		
-		XSync(g_display, False);
-		if (!g_context_err && context) {
-			zlog_info(g_log, "Created new context");
-			return context;
-		} else {
+		if (g_context_err || !context) {
 			context_attribs[1] = 1;
 			context_attribs[3] = 0;
 			g_context_err = 0;
-			zlog_info(g_log, "Failed to create modern context. Reverting to deprecated GLX context.");
+			vs_log_info("Failed to create modern context. Reverting to deprecated GLX context.");
 			context = glXCreateContextAttribsARB(g_display, framebuffer, 0, True, context_attribs);
+		} else {
+			vs_log_info("Created new context");
 		}
 	}
-	XSync(g_display, False);
 	XSetErrorHandler(glx_old_error_handler);
 	
 	if (g_context_err || !context) {
-		zlog_info(g_log, "Failed to create GLX context");
+		vs_log_info("Failed to create GLX context");
 		return NULL;
 	}
 	
 	if (glXIsDirect(g_display, context)) {
-		zlog_info(g_log, "Rendering context directly");
+		vs_log_info("Rendering context directly");
 	} else {
-		zlog_info(g_log, "Rendering context indirectly");
+		vs_log_info("Rendering context indirectly");
 	}
+	return context;
 }
 
 void graph_test(window *win) {
 	unsigned int array;
 	glGenVertexArrays(1, &array); 
-	glBindVertexArray(array);
+	gl_bind_vertex_array(array);
 	
 	float vertices[] = {
     -0.5f, -0.5f, 0.0f,
@@ -216,19 +262,19 @@ void graph_test(window *win) {
 			"	fragment_color = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
 			"}\0";
 	
-	unsigned program = glCreateProgram();
 	unsigned buffer = gl_load_buffer(vertices, 9 * sizeof(float));
 	unsigned vsh = gl_create_shader(GL_VERTEX_SHADER,	&vsh_src);
 	unsigned fsh = gl_create_shader(GL_FRAGMENT_SHADER,	&fsh_src);
-	glAttachShader(program, vsh);
-	glAttachShader(program, fsh);
-	glLinkProgram(program);
-	glDeleteShader(vsh);
-	glDeleteShader(fsh);
+	unsigned program = gl_create_program(vsh, fsh);
 	
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
-	glUseProgram(program);
+	gl_use_program(program);
 	
 	glDrawArrays(GL_TRIANGLES, 0, 3);
+	
+	// GL holds on to deleted objects until the draw that uses them is done
+	gl_delete_program(program);
+	gl_unload_buffer(buffer, 9 * sizeof(float));
+	gl_delete_vertex_arrays(1, &array);
 }
@@ -11,6 +11,8 @@
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
 #include <GL/glx.h>
 
 #include "../window.h"
@@ -19,6 +21,15 @@
 extern Display *g_display;
 extern Window 	g_root;
 extern window  *g_current_window;
+extern xcb_connection_t *g_xcb;
+
+/*
+ * Atoms the platform layer uses. They are all asked for when XCB is set up and only waited for the first time one is
+ * needed.
+ */
+#define VS_ATOM_NET_WM_NAME		0
+#define VS_ATOM_UTF8_STRING		1
+#define VS_ATOM_COUNT			2
 
 /**
  * @brief Load a shader into OpenGL
@@ -33,7 +44,7 @@ unsigned gl_create_shader(int shader_type, const char **shader_source);
 /**
  * @brief Load a buffer into OpenGL
  * 
- * Loads a stream of information into OpenGL.
+ * Loads a stream of information into OpenGL. The buffer is freed with gl_unload_buffer().
  * 
  * @param data Pointer to the start of the data
  * @param bytecount Number of bytes to load
@@ -42,6 +53,26 @@ unsigned gl_create_shader(int shader_type, const char **shader_source);
  */
 unsigned gl_load_buffer(void *data, unsigned bytecount);
 
+/**
+ * @brief Deletes a buffer made by gl_load_buffer()
+ * 
+ * @param buffer The bufferID
+ * @param bytecount Number of bytes that were loaded into it
+ */
+void gl_unload_buffer(unsigned buffer, unsigned bytecount);
+
+/**
+ * @brief Links a vertex and a fragment shader into a program
+ * 
+ * The shaders are deleted whether or not linking succeeds. The program is freed with gl_delete_program().
+ * 
+ * @param vsh Vertex shader from gl_create_shader()
+ * @param fsh Fragment shader from gl_create_shader()
+ * 
+ * @return Returns the programID or 0 if linking failed
+ */
+unsigned gl_create_program(unsigned vsh, unsigned fsh);
+
 
 
 /**
@@ -87,6 +118,92 @@ GLXContext glx_make_current(window *window);
  */
 GLXContext glx_make_context(XVisualInfo *visual_info, GLXFBConfig framebuffer, GLXContext sharelist, int direct);
 
+/**
+ * @brief Starts sending a window's X events to it
+ * 
+ * @param win Pointer to window
+ * 
+ * @return Returns whether it was successful or not
+ */
+int xlib_register_window(window *win);
+
+/**
+ * @brief Stops sending a window's X events to it
+ * 
+ * @param win Pointer to window
+ * 
+ * @return Returns whether it was successful or not
+ */
+int xlib_unregister_window(window *win);
+
+/**
+ * @brief Finds the venus window of an X window
+ * 
+ * @param xwin X window
+ * 
+ * @return Returns the venus window or NULL
+ */
+window *xlib_find_window(Window xwin);
+
+/**
+ * @brief Gets the position of a window in registration order
+ * 
+ * @param win Pointer to window
+ * 
+ * @return Returns the index, or the number of windows if it is not registered
+ */
+unsigned xlib_window_index(window *win);
+
+/**
+ * @brief Gets a window by its position in registration order
+ * 
+ * @param index Index of the window
+ * 
+ * @return Returns the venus window or NULL
+ */
+window *xlib_window_at(unsigned index);
+
+/**
+ * @brief Sends an X event to the window it belongs to
+ * 
+ * @param event The event
+ * 
+ * @return Returns whether it was successful or not
+ */
+int xlib_dispatch_event(XEvent *event);
+
+/**
+ * @brief Sets up XCB on the display's connection
+ * 
+ * Windows are made and events are read through XCB, whose requests go out without waiting for the server, and Xlib is
+ * kept for GLX and XTest. XCB takes over the event queue, so this has to run before Xlib reads any events. It does
+ * nothing after the first call.
+ * 
+ * @return Returns whether it was successful or not
+ */
+int xcb_platform_init();
+
+/**
+ * @brief Gets an atom, waiting for the server the first time it is needed
+ * 
+ * @param atom VS_ATOM_NET_WM_NAME and friends
+ * 
+ * @return Returns the atom or XCB_ATOM_NONE
+ */
+xcb_atom_t xcb_platform_atom(unsigned atom);
+
+/**
+ * @brief Waits for the reply to an XCB request
+ * 
+ * Replies that have already arrived are taken as they are. Anything else is a round trip to the server and is counted.
+ * 
+ * @param sequence Sequence number of the request's cookie
+ * @param error Memory address where the error will be saved, or NULL
+ * 
+ * @return Returns the reply, which is freed with free(), or NULL
+ */
+void *xcb_platform_reply(unsigned sequence, xcb_generic_error_t **error);
+
 void graph_test(window *win);
 
 #endif
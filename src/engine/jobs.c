@@ -0,0 +1,228 @@
+/**
+ * @file jobs.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "jobs.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../venus_common.h"
+#include "memory.h"
+#include "arena.h"
+
+static pthread_mutex_t g_jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_jobs_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_jobs_done = PTHREAD_COND_INITIALIZER;
+
+// Only one batch can be in flight at a time
+static pthread_mutex_t g_jobs_batch_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t *g_workers = NULL;
+static unsigned g_n_workers = 0;
+static int g_jobs_running = VS_FALSE;
+
+/*
+ * The current batch. It is only written while holding g_jobs_lock and with no workers active, so a worker can copy it
+ * once when it joins and then only touch the atomic counters.
+ */
+static struct {
+	void (*func)(void *arg, unsigned index);
+	void *arg;
+	unsigned n;
+	unsigned generation;
+	unsigned active;
+	atomic_uint next;
+	atomic_uint completed;
+} g_batch;
+
+/*
+ * Queue of jobs submitted with jobs_submit(), protected by g_jobs_lock
+ */
+typedef struct jobs_task {
+	void (*func)(void *arg);
+	void *arg;
+	struct jobs_task *next;
+} jobs_task;
+
+static jobs_task *g_tasks_head = NULL;
+static jobs_task *g_tasks_tail = NULL;
+
+static void jobs_run_batch(void (*func)(void*, unsigned), void *arg, unsigned n) {
+	for (;;) {
+		unsigned i = atomic_fetch_add(&g_batch.next, 1);
+		if (i >= n)
+			break;
+		func(arg, i);
+		atomic_fetch_add(&g_batch.completed, 1);
+	}
+}
+
+static void *jobs_worker(void *unused) {
+	unsigned seen = 0;
+
+	pthread_mutex_lock(&g_jobs_lock);
+	for (;;) {
+		while (g_jobs_running && g_batch.generation == seen && !g_tasks_head)
+			pthread_cond_wait(&g_jobs_wake, &g_jobs_lock);
+		if (!g_jobs_running)
+			break;
+		
+		// Batches go first since a thread is blocked waiting on them
+		if (g_batch.generation == seen) {
+			jobs_task *task = g_tasks_head;
+			g_tasks_head = task->next;
+			if (!g_tasks_head)
+				g_tasks_tail = NULL;
+			pthread_mutex_unlock(&g_jobs_lock);
+			
+			task->func(task->arg);
+			memory_free(VS_MEMORY_ENGINE, task);
+			
+			pthread_mutex_lock(&g_jobs_lock);
+			continue;
+		}
+
+		seen = g_batch.generation;
+		void (*func)(void*, unsigned) = g_batch.func;
+		void *arg = g_batch.arg;
+		unsigned n = g_batch.n;
+		g_batch.active++;
+		pthread_mutex_unlock(&g_jobs_lock);
+
+		jobs_run_batch(func, arg, n);
+
+		pthread_mutex_lock(&g_jobs_lock);
+		g_batch.active--;
+		pthread_cond_broadcast(&g_jobs_done);
+	}
+	pthread_mutex_unlock(&g_jobs_lock);
+	arena_free_thread();
+	return NULL;
+}
+
+int jobs_initialize(unsigned n_workers) {
+	pthread_mutex_lock(&g_jobs_lock);
+	if (g_jobs_running) {
+		pthread_mutex_unlock(&g_jobs_lock);
+		return VS_SUCCESS;
+	}
+
+	if (!n_workers) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		n_workers = cpus > 1 ? (unsigned) cpus - 1 : 0;
+	}
+
+	g_workers = memory_alloc(VS_MEMORY_ENGINE, sizeof(pthread_t) * (n_workers ? n_workers : 1));
+	if (!g_workers) {
+		pthread_mutex_unlock(&g_jobs_lock);
+		return VS_FAILURE;
+	}
+	g_jobs_running = VS_TRUE;
+	g_n_workers = 0;
+	for (unsigned i = 0; i < n_workers; ++i) {
+		if (pthread_create(&g_workers[i], NULL, jobs_worker, NULL))
+			break;
+		g_n_workers++;
+	}
+	pthread_mutex_unlock(&g_jobs_lock);
+
+	vs_log_info("Started %u worker threads", g_n_workers);
+	return VS_SUCCESS;
+}
+
+void jobs_terminate() {
+	pthread_mutex_lock(&g_jobs_lock);
+	if (!g_jobs_running) {
+		pthread_mutex_unlock(&g_jobs_lock);
+		return;
+	}
+	g_jobs_running = VS_FALSE;
+	pthread_cond_broadcast(&g_jobs_wake);
+	pthread_mutex_unlock(&g_jobs_lock);
+
+	for (unsigned i = 0; i < g_n_workers; ++i)
+		pthread_join(g_workers[i], NULL);
+	memory_free(VS_MEMORY_ENGINE, g_workers);
+	g_workers = NULL;
+	g_n_workers = 0;
+	
+	// Anything still queued runs here so that nobody waits forever on it
+	while (g_tasks_head) {
+		jobs_task *task = g_tasks_head;
+		g_tasks_head = task->next;
+		task->func(task->arg);
+		memory_free(VS_MEMORY_ENGINE, task);
+	}
+	g_tasks_tail = NULL;
+}
+
+unsigned jobs_thread_count() {
+	jobs_initialize(0);
+	return g_n_workers + 1;
+}
+
+int jobs_parallel(void (*func)(void *arg, unsigned index), void *arg, unsigned n) {
+	if (!n)
+		return VS_SUCCESS;
+
+	if (n == 1 || jobs_thread_count() == 1) {
+		for (unsigned i = 0; i < n; ++i)
+			func(arg, i);
+		return VS_SUCCESS;
+	}
+
+	pthread_mutex_lock(&g_jobs_batch_lock);
+
+	pthread_mutex_lock(&g_jobs_lock);
+	// A worker that woke up late may have joined the last batch after it finished. It still holds that batch's function
+	// and argument, so the next batch has to wait for it to see the counters run out and leave.
+	while (g_batch.active)
+		pthread_cond_wait(&g_jobs_done, &g_jobs_lock);
+	g_batch.func = func;
+	g_batch.arg = arg;
+	g_batch.n = n;
+	atomic_store(&g_batch.next, 0);
+	atomic_store(&g_batch.completed, 0);
+	g_batch.generation++;
+	pthread_cond_broadcast(&g_jobs_wake);
+	pthread_mutex_unlock(&g_jobs_lock);
+
+	jobs_run_batch(func, arg, n);
+
+	pthread_mutex_lock(&g_jobs_lock);
+	while (g_batch.active || atomic_load(&g_batch.completed) < n)
+		pthread_cond_wait(&g_jobs_done, &g_jobs_lock);
+	pthread_mutex_unlock(&g_jobs_lock);
+
+	pthread_mutex_unlock(&g_jobs_batch_lock);
+	return VS_SUCCESS;
+}
+
+int jobs_submit(void (*func)(void *arg), void *arg) {
+	if (jobs_thread_count() == 1) {
+		func(arg);
+		return VS_SUCCESS;
+	}
+	
+	jobs_task *task = memory_alloc(VS_MEMORY_ENGINE, sizeof(jobs_task));
+	if (!task)
+		return VS_FAILURE;
+	task->func = func;
+	task->arg = arg;
+	task->next = NULL;
+	
+	pthread_mutex_lock(&g_jobs_lock);
+	if (g_tasks_tail)
+		g_tasks_tail->next = task;
+	else
+		g_tasks_head = task;
+	g_tasks_tail = task;
+	pthread_cond_signal(&g_jobs_wake);
+	pthread_mutex_unlock(&g_jobs_lock);
+	return VS_SUCCESS;
+}
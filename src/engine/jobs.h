@@ -0,0 +1,63 @@
+/**
+ * @file jobs.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief A small pool of worker threads shared by the engine
+ */
+
+#ifndef VS_JOBS_H
+#define VS_JOBS_H
+
+/**
+ * @brief Starts the worker pool
+ *
+ * Calling this more than once does nothing. If it is never called, the pool is started with one worker per online CPU the
+ * first time it is needed.
+ *
+ * @param n_workers Number of worker threads to start. If it is 0, one worker per online CPU is started.
+ *
+ * @return Returns whether it was successful or not
+ */
+int jobs_initialize(unsigned n_workers);
+
+/**
+ * @brief Stops and joins every worker thread
+ */
+void jobs_terminate();
+
+/**
+ * @brief Gets the number of threads that can run work at once, counting the calling thread
+ *
+ * @return Returns the number of threads
+ */
+unsigned jobs_thread_count();
+
+/**
+ * @brief Runs a function once for every index in [0, n) and waits for all of them to finish
+ *
+ * The calling thread takes part in the work, so this never waits on a pool that is busy with something else. The
+ * indices are handed out in no particular order.
+ *
+ * @param func Function to run
+ * @param arg Argument passed through to func
+ * @param n Number of indices
+ *
+ * @return Returns whether it was successful or not
+ */
+int jobs_parallel(void (*func)(void *arg, unsigned index), void *arg, unsigned n);
+
+/**
+ * @brief Queues a function to run on a worker thread without waiting for it
+ *
+ * Queued functions run in the order they were submitted whenever a worker is not busy with jobs_parallel(). If the pool
+ * has no worker threads, the function runs immediately on the calling thread.
+ *
+ * @param func Function to run
+ * @param arg Argument passed through to func
+ *
+ * @return Returns whether it was successful or not
+ */
+int jobs_submit(void (*func)(void *arg), void *arg);
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * @file latency.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "latency.h"
+
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+#include <GL/glxext.h>
+
+#include <pthread.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "graphics.h"
+#include "profile.h"
+
+atomic_int g_latency_enabled = VS_FALSE;
+atomic_ulong g_latency_damage = 0;
+
+static pthread_mutex_t g_latency_lock = PTHREAD_MUTEX_INITIALIZER;
+static latency_histogram g_latency_histograms[VS_LATENCY_N_KINDS];
+
+// -1 until the extension has been looked for
+static int g_latency_oml = -1;
+static PFNGLXSWAPBUFFERSMSCOMLPROC glXSwapBuffersMscOML = NULL;
+static PFNGLXWAITFORSBCOMLPROC glXWaitForSbcOML = NULL;
+
+static void latency_load_oml() {
+	if (g_latency_oml != -1)
+		return;
+
+	const char *extensions = glXQueryExtensionsString(g_display, DefaultScreen(g_display));
+	glXSwapBuffersMscOML = (PFNGLXSWAPBUFFERSMSCOMLPROC) glXGetProcAddressARB((const GLubyte*) "glXSwapBuffersMscOML");
+	glXWaitForSbcOML = (PFNGLXWAITFORSBCOMLPROC) glXGetProcAddressARB((const GLubyte*) "glXWaitForSbcOML");
+	g_latency_oml = glx_check_support(extensions, "GLX_OML_sync_control") && glXSwapBuffersMscOML && glXWaitForSbcOML;
+	if (!g_latency_oml)
+		vs_log_info("GLX_OML_sync_control not found. Input latency is measured to the return of the swap.");
+}
+
+int latency_arrive(latency_event *event, void *xevent) {
+	if (!atomic_load_explicit(&g_latency_enabled, memory_order_relaxed))
+		return VS_FALSE;
+
+	XEvent *e = (XEvent*) xevent;
+	switch (e->type) {
+	case KeyPress:
+	case KeyRelease:
+		event->kind = VS_LATENCY_KEY;
+		event->server_ms = e->xkey.time;
+		break;
+	case ButtonPress:
+	case ButtonRelease:
+		event->kind = VS_LATENCY_BUTTON;
+		event->server_ms = e->xbutton.time;
+		break;
+	case MotionNotify:
+		event->kind = VS_LATENCY_MOTION;
+		event->server_ms = e->xmotion.time;
+		break;
+	default:
+		return VS_FALSE;
+	}
+
+	event->damage = atomic_load_explicit(&g_latency_damage, memory_order_relaxed);
+	event->arrived = profile_now();
+	event->dispatched = 0;
+	event->rendered = 0;
+	return VS_TRUE;
+}
+
+void latency_dispatched(latency_probe *probe, latency_event *event) {
+	if (atomic_load_explicit(&g_latency_damage, memory_order_relaxed) == event->damage)
+		return;
+	if (probe->n_pending == VS_LATENCY_PENDING)
+		return;
+	event->dispatched = profile_now();
+	probe->pending[probe->n_pending++] = *event;
+}
+
+void latency_rendered(latency_probe *probe) {
+	unsigned long now = profile_now();
+	for (unsigned i = 0; i < probe->n_pending; ++i)
+		if (!probe->pending[i].rendered)
+			probe->pending[i].rendered = now;
+}
+
+/*
+ * On Linux the X server stamps events with CLOCK_MONOTONIC milliseconds, the same clock profile_now() reads. Servers that
+ * use another clock give nonsense differences, so queueing time only counts when it is under a second.
+ */
+static unsigned long latency_queued(latency_event *event) {
+	unsigned long server = event->server_ms * 1000000ul;
+	if (!event->server_ms || server > event->arrived || event->arrived - server > 1000000000ul)
+		return 0;
+	return event->arrived - server;
+}
+
+static void latency_resolve(latency_probe *probe, unsigned long presented, int exact) {
+	pthread_mutex_lock(&g_latency_lock);
+	for (unsigned i = 0; i < probe->n_in_flight; ++i) {
+		latency_event *event = &probe->in_flight[i];
+		latency_histogram *histogram = &g_latency_histograms[event->kind];
+		unsigned long rendered = event->rendered ? event->rendered : probe->swapped;
+		unsigned long queued = latency_queued(event);
+		unsigned long total = presented - event->arrived + queued;
+
+		unsigned long bucket = total / VS_LATENCY_BUCKET_NS;
+		if (bucket < VS_LATENCY_BUCKETS)
+			histogram->buckets[bucket]++;
+		else
+			histogram->overflow++;
+
+		if (!histogram->count || total < histogram->min_ns)
+			histogram->min_ns = total;
+		if (total > histogram->max_ns)
+			histogram->max_ns = total;
+		histogram->count++;
+		histogram->total_ns += total;
+		histogram->presented += exact;
+
+		histogram->stage_ns[VS_LATENCY_QUEUE] += queued;
+		histogram->stage_ns[VS_LATENCY_DISPATCH] += event->dispatched - event->arrived;
+		histogram->stage_ns[VS_LATENCY_RENDER] += rendered - event->dispatched;
+		histogram->stage_ns[VS_LATENCY_SWAP] += probe->swapped - rendered;
+		histogram->stage_ns[VS_LATENCY_PRESENT] += presented - probe->swapped;
+	}
+	pthread_mutex_unlock(&g_latency_lock);
+	probe->n_in_flight = 0;
+}
+
+void glx_latency_swap(latency_probe *probe, unsigned long xwin) {
+	latency_load_oml();
+
+	if (probe->n_in_flight) {
+		unsigned long presented = 0;
+		if (probe->target_sbc) {
+			int64_t ust, msc, sbc;
+			if (glXWaitForSbcOML(g_display, xwin, probe->target_sbc, &ust, &msc, &sbc))
+				presented = (unsigned long) ust * 1000ul;
+			// UST is CLOCK_MONOTONIC on Mesa, but nothing promises it
+			if (presented < probe->swapped || presented > profile_now())
+				presented = 0;
+		}
+		if (presented)
+			latency_resolve(probe, presented, VS_TRUE);
+		else
+			latency_resolve(probe, probe->swapped, VS_FALSE);
+	}
+
+	memcpy(probe->in_flight, probe->pending, sizeof(latency_event) * probe->n_pending);
+	probe->n_in_flight = probe->n_pending;
+	probe->n_pending = 0;
+
+	if (g_latency_oml) {
+		probe->target_sbc = glXSwapBuffersMscOML(g_display, xwin, 0, 0, 0);
+	} else {
+		glXSwapBuffers(g_display, xwin);
+		probe->target_sbc = 0;
+	}
+	probe->swapped = profile_now();
+
+	if (!probe->target_sbc && probe->n_in_flight)
+		latency_resolve(probe, probe->swapped, VS_FALSE);
+}
+
+int venus_enable_latency_probe(int enabled) {
+	atomic_store(&g_latency_enabled, !!enabled);
+	return VS_SUCCESS;
+}
+
+int venus_get_latency_histogram(unsigned kind, latency_histogram *histogram) {
+	if (kind >= VS_LATENCY_N_KINDS)
+		vs_err(VS_FAILURE);
+	pthread_mutex_lock(&g_latency_lock);
+	*histogram = g_latency_histograms[kind];
+	pthread_mutex_unlock(&g_latency_lock);
+	return VS_SUCCESS;
+}
+
+int venus_reset_latency_histograms() {
+	pthread_mutex_lock(&g_latency_lock);
+	memset(g_latency_histograms, 0, sizeof(g_latency_histograms));
+	pthread_mutex_unlock(&g_latency_lock);
+	return VS_SUCCESS;
+}
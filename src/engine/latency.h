@@ -0,0 +1,106 @@
+/**
+ * @file latency.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Input-to-photon latency probe behind venus_enable_latency_probe()
+ *
+ * An input event is stamped when it is dispatched. If its callback damaged anything, it rides along with the next frame
+ * through rendering and the swap. With GLX_OML_sync_control the frame is finished when its swap completes. Without it,
+ * the frame is finished when glXSwapBuffers() returns.
+ */
+
+#ifndef VS_LATENCY_H
+#define VS_LATENCY_H
+
+#include <stdatomic.h>
+
+#include "../venus.h"
+
+/// Most damaging input events one frame carries. More are not measured.
+#define VS_LATENCY_PENDING		64
+
+/// Set while the probe is on
+extern atomic_int g_latency_enabled;
+
+/// Counts invalidated widgets, so dispatch can tell whether an event damaged anything
+extern atomic_ulong g_latency_damage;
+
+/**
+ * @brief Timestamps of one input event on its way to the screen
+ */
+typedef struct {
+	/// VS_LATENCY_KEY, VS_LATENCY_BUTTON or VS_LATENCY_MOTION
+	unsigned kind;
+
+	/// X server time of the event in milliseconds
+	unsigned long server_ms;
+
+	/// g_latency_damage before the event was dispatched
+	unsigned long damage;
+
+	unsigned long arrived;
+	unsigned long dispatched;
+	unsigned long rendered;
+} latency_event;
+
+/**
+ * @brief Input events waiting for a window's next frame and the frame before it
+ */
+typedef struct {
+	latency_event pending[VS_LATENCY_PENDING];
+	unsigned n_pending;
+
+	/// Events in the last frame swapped, waiting for the swap to complete
+	latency_event in_flight[VS_LATENCY_PENDING];
+	unsigned n_in_flight;
+
+	/// When the swap of the last frame returned
+	unsigned long swapped;
+
+	/// Swap buffer count the last frame completes at, or 0 without GLX_OML_sync_control
+	long long target_sbc;
+} latency_probe;
+
+static inline void latency_damage() {
+	if (atomic_load_explicit(&g_latency_enabled, memory_order_relaxed))
+		atomic_fetch_add_explicit(&g_latency_damage, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Stamps an X event as it arrives, if it is input and the probe is on
+ *
+ * @param event Memory address where the stamps will be saved
+ * @param xevent Pointer to the XEvent
+ *
+ * @return Returns whether the event should be followed
+ */
+int latency_arrive(latency_event *event, void *xevent);
+
+/**
+ * @brief Keeps an event for the next frame if its callback damaged anything
+ *
+ * @param probe Pointer to the probe of the window the event was sent to
+ * @param event Pointer to the stamps from latency_arrive()
+ */
+void latency_dispatched(latency_probe *probe, latency_event *event);
+
+/**
+ * @brief Marks the pending events as rendered
+ *
+ * @param probe Pointer to the probe of the window that was drawn
+ */
+void latency_rendered(latency_probe *probe);
+
+/**
+ * @brief Swaps a window's buffers while the probe is on
+ *
+ * The events of the frame before are finished first. With GLX_OML_sync_control this waits until that frame's swap has
+ * completed, which a swap with vsync would mostly wait for anyway.
+ *
+ * @param probe Pointer to the probe of the window
+ * @param xwin X window to swap
+ */
+void glx_latency_swap(latency_probe *probe, unsigned long xwin);
+
+#endif
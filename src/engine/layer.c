@@ -0,0 +1,241 @@
+/**
+ * @file layer.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "layer.h"
+
+#include <glad/glad.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "glstate.h"
+#include "memory.h"
+#include "../window.h"
+#include "../toolkit/widget.h"
+
+static const unsigned char layer_color[] = {0xFF, 0xFF, 0xFF, 0xFF};
+
+static void layer_release(layer_cache *cache, layer *l) {
+	if (l->fbo) {
+		gl_delete_framebuffers(1, &l->fbo);
+		gl_delete_textures(1, &l->texture);
+		memory_gpu_free(VS_MEMORY_LAYERS, l->bytes);
+		cache->stats.bytes -= l->bytes;
+	}
+	l->fbo = 0;
+	l->texture = 0;
+	l->texture_width = 0;
+	l->texture_height = 0;
+	l->bytes = 0;
+	l->valid = VS_FALSE;
+	l->active = VS_FALSE;
+}
+
+static unsigned layer_round(unsigned size) {
+	if (!size)
+		size = 1;
+	return (size + VS_LAYER_GRANULARITY - 1) / VS_LAYER_GRANULARITY * VS_LAYER_GRANULARITY;
+}
+
+/*
+ * Makes sure a layer has a texture big enough for its widget, evicting the least recently used layers if needed
+ */
+static int layer_allocate(layer_cache *cache, layer *l, unsigned width, unsigned height) {
+	unsigned texture_width = layer_round(width);
+	unsigned texture_height = layer_round(height);
+
+	if (l->fbo && l->texture_width >= texture_width && l->texture_height >= texture_height)
+		return VS_SUCCESS;
+
+	// A layer that outgrew its texture is likely being resized, so it gets room to keep growing
+	if (l->fbo) {
+		texture_width = layer_round(width + width / VS_LAYER_HEADROOM);
+		texture_height = layer_round(height + height / VS_LAYER_HEADROOM);
+	}
+	layer_release(cache, l);
+
+	unsigned long bytes = (unsigned long) texture_width * texture_height * 4;
+	while (cache->stats.bytes + bytes > cache->stats.budget) {
+		layer *oldest = NULL;
+		for (unsigned i = 0; i < cache->n_layers; ++i) {
+			layer *other = cache->layers[i];
+			if (other == l || !other->fbo || atomic_load(&other->last_used) + 1 >= cache->frame)
+				continue;
+			if (!oldest || atomic_load(&other->last_used) < atomic_load(&oldest->last_used))
+				oldest = other;
+		}
+		if (!oldest)
+			return VS_FAILURE;
+		layer_release(cache, oldest);
+		cache->stats.evictions++;
+	}
+
+	glGenTextures(1, &l->texture);
+	gl_bind_texture(0, l->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture_width, texture_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &l->fbo);
+	gl_bind_framebuffer(l->fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, l->texture, 0);
+	int complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	gl_bind_framebuffer(0);
+
+	l->texture_width = texture_width;
+	l->texture_height = texture_height;
+	l->bytes = bytes;
+	cache->stats.bytes += bytes;
+	memory_gpu_alloc(VS_MEMORY_LAYERS, bytes);
+
+	if (!complete) {
+		vs_log_error("Layer framebuffer is incomplete");
+		layer_release(cache, l);
+		return VS_FAILURE;
+	}
+	return VS_SUCCESS;
+}
+
+static int layer_compare_depth(const void *a, const void *b) {
+	unsigned depth_a = (*(layer**) a)->depth;
+	unsigned depth_b = (*(layer**) b)->depth;
+	return (depth_a < depth_b) - (depth_a > depth_b);
+}
+
+void layer_cache_init(layer_cache *cache, unsigned long budget) {
+	memset(cache, 0, sizeof(layer_cache));
+	cache->stats.budget = budget;
+}
+
+void layer_cache_destroy(layer_cache *cache) {
+	for (unsigned i = 0; i < cache->n_layers; ++i) {
+		layer *l = cache->layers[i];
+		layer_release(cache, l);
+		render_list_free(&l->list);
+		((widget_t*) l->widget)->layer = NULL;
+		memory_free(VS_MEMORY_RENDER, l);
+	}
+	memory_free(VS_MEMORY_RENDER, cache->layers);
+	cache->layers = NULL;
+	cache->n_layers = 0;
+}
+
+layer *layer_cache_set(layer_cache *cache, void *widget, int mode) {
+	widget_t *w = (widget_t*) widget;
+	layer *l = (layer*) w->layer;
+
+	if (mode == VS_LAYER_NONE) {
+		if (!l)
+			return NULL;
+		for (unsigned i = 0; i < cache->n_layers; ++i) {
+			if (cache->layers[i] == l) {
+				cache->layers[i] = cache->layers[--cache->n_layers];
+				break;
+			}
+		}
+		layer_release(cache, l);
+		render_list_free(&l->list);
+		memory_free(VS_MEMORY_RENDER, l);
+		w->layer = NULL;
+		return NULL;
+	}
+
+	if (!l) {
+		layer **layers = memory_realloc(VS_MEMORY_RENDER, cache->layers, sizeof(layer*) * (cache->n_layers + 1));
+		if (!layers)
+			return NULL;
+		cache->layers = layers;
+
+		l = memory_calloc(VS_MEMORY_RENDER, 1, sizeof(layer));
+		if (!l)
+			return NULL;
+		l->cache = cache;
+		l->widget = widget;
+		l->last_invalidated = cache->frame;
+		render_list_init(&l->list);
+		cache->layers[cache->n_layers++] = l;
+		w->layer = l;
+	}
+	l->mode = mode;
+	return l;
+}
+
+void layer_invalidate(layer *l) {
+	l->valid = VS_FALSE;
+	l->last_invalidated = l->cache->frame;
+}
+
+int layer_cache_update(layer_cache *cache, void *win, render_context *ctx) {
+	VS_TRACE_SCOPE("layer_cache_update");
+	cache->frame++;
+	cache->stats.hits = 0;
+	cache->stats.misses = 0;
+	if (!cache->n_layers)
+		return VS_SUCCESS;
+
+	for (unsigned i = 0; i < cache->n_layers; ++i) {
+		layer *l = cache->layers[i];
+		l->depth = 0;
+		for (widget_t *w = l->widget; w->parent; w = w->parent)
+			l->depth++;
+	}
+	qsort(cache->layers, cache->n_layers, sizeof(layer*), layer_compare_depth);
+
+	for (unsigned i = 0; i < cache->n_layers; ++i) {
+		layer *l = cache->layers[i];
+		widget_t *w = (widget_t*) l->widget;
+
+		int want = l->mode == VS_LAYER_CACHED ||
+			(l->mode == VS_LAYER_AUTO && cache->frame - l->last_invalidated >= VS_LAYER_STABLE_FRAMES);
+		if (!want || !w->parent) {
+			l->active = VS_FALSE;
+			continue;
+		}
+
+		if (l->active && l->valid && l->width == w->width && l->height == w->height) {
+			cache->stats.hits++;
+			continue;
+		}
+
+		cache->stats.misses++;
+		l->active = VS_FALSE;
+		if (!layer_allocate(cache, l, w->width, w->height))
+			continue;
+
+		if (!record_subtree(win, w, &l->list))
+			continue;
+
+		// glClearBufferfv() leaves the window's clear color alone
+		const float transparent[] = {0.0f, 0.0f, 0.0f, 0.0f};
+		gl_bind_framebuffer(l->fbo);
+		glClearBufferfv(GL_COLOR, 0, transparent);
+		gl_render_submit(ctx, &l->list, l->texture_width, l->texture_height);
+
+		l->width = w->width;
+		l->height = w->height;
+		l->valid = VS_TRUE;
+		l->active = VS_TRUE;
+	}
+	gl_bind_framebuffer(0);
+
+	cache->stats.total_hits += cache->stats.hits;
+	cache->stats.total_misses += cache->stats.misses;
+	return VS_SUCCESS;
+}
+
+int layer_record(layer *l, render_list *list, int x, int y) {
+	atomic_store_explicit(&l->last_used, l->cache->frame, memory_order_relaxed);
+
+	// Framebuffer textures are stored bottom up, so the widget occupies the top of the texture
+	float uv[] = {
+		0.0f,
+		1.0f,
+		(float) l->width / l->texture_width,
+		1.0f - (float) l->height / l->texture_height
+	};
+	return render_push_premultiplied(list, x, y, l->width, l->height, layer_color, l->texture, uv);
+}
@@ -0,0 +1,160 @@
+/**
+ * @file layer.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Render-to-texture caching of widget subtrees
+ *
+ * A widget promoted to a layer has its whole subtree rendered once into a framebuffer texture. Until something in the
+ * subtree is invalidated, the subtree is drawn as a single textured quad instead of recording every widget again.
+ */
+
+#ifndef VS_LAYER_H
+#define VS_LAYER_H
+
+#include <stdatomic.h>
+
+#include "render.h"
+
+/// Never cache the widget
+#define VS_LAYER_NONE			0
+/// Always cache the widget while it fits in the budget
+#define VS_LAYER_CACHED			1
+/// Cache the widget while it is not changing
+#define VS_LAYER_AUTO			2
+
+/// Frames a VS_LAYER_AUTO widget has to go without being invalidated before it is cached
+#define VS_LAYER_STABLE_FRAMES	30
+
+/// Layer textures are allocated in multiples of this many pixels so that small size changes reuse them
+#define VS_LAYER_GRANULARITY	64
+
+/// A layer texture that has to grow gets an extra 1/VS_LAYER_HEADROOM of the size it needs
+#define VS_LAYER_HEADROOM		4
+
+typedef struct layer_cache layer_cache;
+
+/**
+ * @brief A cached widget subtree
+ */
+typedef struct {
+	layer_cache *cache;
+	void *widget;
+	int mode;
+
+	/// Depth of the widget in the tree. Deeper layers are rendered first so that outer layers can use them.
+	unsigned depth;
+
+	unsigned fbo;
+	unsigned texture;
+	unsigned texture_width;
+	unsigned texture_height;
+	unsigned long bytes;
+
+	/// Size of the subtree when it was rendered
+	unsigned width;
+	unsigned height;
+
+	/// Set while the texture holds an up to date copy of the subtree
+	int valid;
+
+	/// Set while the subtree should be drawn from the texture
+	int active;
+
+	unsigned last_invalidated;
+
+	/// Frame the layer was last recorded in. This is written while recording, so it may come from any thread.
+	atomic_uint last_used;
+
+	render_list list;
+} layer;
+
+/**
+ * @brief Layer cache statistics
+ */
+typedef struct {
+	/// Layers drawn from their texture in the last frame
+	unsigned hits;
+	/// Layers that had to be rendered again in the last frame, or could not be cached
+	unsigned misses;
+
+	/// Totals since the cache was created
+	unsigned long total_hits;
+	unsigned long total_misses;
+	unsigned long evictions;
+
+	unsigned n_layers;
+	unsigned n_active;
+	unsigned long bytes;
+	unsigned long budget;
+} layer_stats;
+
+struct layer_cache {
+	unsigned n_layers;
+	layer **layers;
+	unsigned frame;
+	layer_stats stats;
+};
+
+/**
+ * @brief Initializes a layer cache
+ *
+ * @param cache Pointer to layer cache
+ * @param budget Most GPU bytes the layer textures may hold
+ */
+void layer_cache_init(layer_cache *cache, unsigned long budget);
+
+/**
+ * @brief Deletes every layer of a cache
+ *
+ * The GL context the layers belong to must be current.
+ *
+ * @param cache Pointer to layer cache
+ */
+void layer_cache_destroy(layer_cache *cache);
+
+/**
+ * @brief Creates or finds the layer of a widget and sets its mode
+ *
+ * @param cache Pointer to layer cache
+ * @param widget Pointer to widget
+ * @param mode VS_LAYER_NONE, VS_LAYER_CACHED or VS_LAYER_AUTO
+ *
+ * @return Returns the widget's layer, or NULL when the mode is VS_LAYER_NONE
+ */
+layer *layer_cache_set(layer_cache *cache, void *widget, int mode);
+
+/**
+ * @brief Marks a layer as out of date
+ *
+ * @param l Pointer to layer
+ */
+void layer_invalidate(layer *l);
+
+/**
+ * @brief Renders every layer that should be cached and is out of date
+ *
+ * This must be called on the GL thread before the frame is recorded. Layers that no longer fit in the budget fall back to
+ * being drawn normally.
+ *
+ * @param cache Pointer to layer cache
+ * @param win Pointer to the window the layers belong to
+ * @param ctx Render context used to draw into the layers
+ *
+ * @return Returns whether it was successful or not
+ */
+int layer_cache_update(layer_cache *cache, void *win, render_context *ctx);
+
+/**
+ * @brief Records a layer as a single quad
+ *
+ * @param l Pointer to layer
+ * @param list Render list to record into
+ * @param x Left edge in pixels
+ * @param y Top edge in pixels
+ *
+ * @return Returns whether it was successful or not
+ */
+int layer_record(layer *l, render_list *list, int x, int y);
+
+#endif
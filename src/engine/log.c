@@ -0,0 +1,161 @@
+/**
+ * @file log.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "log.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "../venus_common.h"
+
+/*
+ * A bounded multi-producer ring with one consumer. A slot is free for the writer claiming position p when its sequence
+ * is p, and holds a message for the reader at position p when its sequence is p + 1.
+ */
+typedef struct {
+	atomic_ulong sequence;
+	int level;
+	char message[VS_LOG_MESSAGE];
+} log_slot;
+
+static log_slot g_log_ring[VS_LOG_RING];
+static atomic_ulong g_log_tail = 0;
+static unsigned long g_log_head = 0;
+
+static atomic_ulong g_log_dropped = 0;
+static atomic_int g_log_running = VS_FALSE;
+static sem_t g_log_pending;
+static pthread_t g_log_thread;
+
+static void log_emit(int level, const char *message) {
+	switch (level) {
+	case VS_LOG_DEBUG:
+		zlog_debug(g_log, "%s", message);
+		break;
+	case VS_LOG_INFO:
+		zlog_info(g_log, "%s", message);
+		break;
+	case VS_LOG_WARN:
+		zlog_warn(g_log, "%s", message);
+		break;
+	case VS_LOG_ERROR:
+		zlog_error(g_log, "%s", message);
+		break;
+	default:
+		zlog_fatal(g_log, "%s", message);
+		break;
+	}
+}
+
+/*
+ * Writes the message at the head of the ring. The semaphore is only posted once a message is published, but a writer
+ * that claimed an earlier slot may still be formatting, so this waits for that slot rather than skipping it.
+ */
+static void log_drain_one() {
+	log_slot *slot = &g_log_ring[g_log_head % VS_LOG_RING];
+	while (atomic_load_explicit(&slot->sequence, memory_order_acquire) != g_log_head + 1)
+		sched_yield();
+
+	log_emit(slot->level, slot->message);
+	atomic_store_explicit(&slot->sequence, g_log_head + VS_LOG_RING, memory_order_release);
+	g_log_head++;
+}
+
+static void *log_thread(void *arg) {
+	for (;;) {
+		sem_wait(&g_log_pending);
+		if (g_log_head == atomic_load(&g_log_tail)) {
+			if (!atomic_load(&g_log_running))
+				break;
+			continue;
+		}
+		log_drain_one();
+	}
+	return NULL;
+}
+
+int log_initialize() {
+	if (atomic_load(&g_log_running))
+		return VS_SUCCESS;
+
+	for (unsigned long i = 0; i < VS_LOG_RING; ++i)
+		atomic_store(&g_log_ring[i].sequence, i);
+	atomic_store(&g_log_tail, 0);
+	g_log_head = 0;
+
+	if (sem_init(&g_log_pending, 0, 0))
+		vs_err(VS_FAILURE);
+	atomic_store(&g_log_running, VS_TRUE);
+	if (pthread_create(&g_log_thread, NULL, log_thread, NULL)) {
+		atomic_store(&g_log_running, VS_FALSE);
+		sem_destroy(&g_log_pending);
+		vs_err(VS_FAILURE);
+	}
+	return VS_SUCCESS;
+}
+
+void log_terminate() {
+	if (!atomic_load(&g_log_running))
+		return;
+
+	// The wake up with an empty ring tells the thread to stop once it has written everything before it
+	atomic_store(&g_log_running, VS_FALSE);
+	sem_post(&g_log_pending);
+	pthread_join(g_log_thread, NULL);
+
+	while (g_log_head != atomic_load(&g_log_tail))
+		log_drain_one();
+	sem_destroy(&g_log_pending);
+
+	unsigned long dropped = atomic_load(&g_log_dropped);
+	if (dropped)
+		zlog_warn(g_log, "%lu log messages were dropped because the log ring was full", dropped);
+}
+
+void log_write(int level, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+
+	if (!atomic_load_explicit(&g_log_running, memory_order_acquire)) {
+		char message[VS_LOG_MESSAGE];
+		vsnprintf(message, VS_LOG_MESSAGE, format, args);
+		va_end(args);
+		log_emit(level, message);
+		return;
+	}
+
+	unsigned long position = atomic_load_explicit(&g_log_tail, memory_order_relaxed);
+	log_slot *slot;
+	for (;;) {
+		slot = &g_log_ring[position % VS_LOG_RING];
+		long difference = (long) (atomic_load_explicit(&slot->sequence, memory_order_acquire) - position);
+		if (difference == 0) {
+			if (atomic_compare_exchange_weak_explicit(&g_log_tail, &position, position + 1,
+				memory_order_relaxed, memory_order_relaxed))
+				break;
+		} else if (difference < 0) {
+			va_end(args);
+			atomic_fetch_add_explicit(&g_log_dropped, 1, memory_order_relaxed);
+			return;
+		} else {
+			position = atomic_load_explicit(&g_log_tail, memory_order_relaxed);
+		}
+	}
+
+	slot->level = level;
+	vsnprintf(slot->message, VS_LOG_MESSAGE, format, args);
+	va_end(args);
+	atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+	sem_post(&g_log_pending);
+}
+
+unsigned long log_dropped() {
+	return atomic_load(&g_log_dropped);
+}
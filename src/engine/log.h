@@ -0,0 +1,61 @@
+/**
+ * @file log.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Asynchronous logging on top of zlog
+ *
+ * Messages are formatted by the caller into a bounded ring and written to zlog by a background thread, so logging never
+ * waits on file I/O. When the ring is full the message is dropped and counted rather than blocking. Use the vs_log_*
+ * macros from venus_common.h, which compile away below VS_COMPILE_LOG_LEVEL.
+ */
+
+#ifndef VS_LOG_H
+#define VS_LOG_H
+
+#define VS_LOG_DEBUG		0
+#define VS_LOG_INFO			1
+#define VS_LOG_WARN			2
+#define VS_LOG_ERROR		3
+#define VS_LOG_FATAL		4
+#define VS_LOG_NONE			5
+
+/// Number of messages the ring holds, a power of two
+#define VS_LOG_RING			1024
+
+/// Longest message kept, including the terminator. Longer ones are truncated.
+#define VS_LOG_MESSAGE		256
+
+/**
+ * @brief Starts the thread that writes logged messages
+ *
+ * Until this is called, and after log_terminate(), messages are written to zlog on the calling thread. It should be
+ * called by venus_initialize() once zlog is ready.
+ *
+ * @return Returns whether it was successful or not
+ */
+int log_initialize();
+
+/**
+ * @brief Writes every queued message and stops the logging thread
+ *
+ * It should be called by venus_terminate() before zlog is finished.
+ */
+void log_terminate();
+
+/**
+ * @brief Queues a message
+ *
+ * @param level One of VS_LOG_DEBUG, VS_LOG_INFO, VS_LOG_WARN, VS_LOG_ERROR or VS_LOG_FATAL
+ * @param format printf style format of the message
+ */
+void log_write(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Gets the number of messages dropped because the ring was full
+ *
+ * @return Returns the number of dropped messages
+ */
+unsigned long log_dropped();
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * @file memory.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "memory.h"
+
+#include <malloc.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../venus_common.h"
+
+typedef struct {
+	atomic_ulong live_bytes;
+	atomic_ulong peak_bytes;
+	atomic_ulong live_objects;
+	atomic_ulong total_objects;
+} memory_counter;
+
+static memory_counter g_memory[VS_MEMORY_N_TAGS];
+
+// Only used to log leaks, which VS_COMPILE_LOG_LEVEL can compile out
+static const char *g_memory_names[VS_MEMORY_N_TAGS] __attribute__((unused)) = {
+	"widgets",
+	"vectors and matrices",
+	"render lists",
+	"images",
+	"engine",
+	"GL buffers",
+	"textures",
+	"programs",
+	"atlas pages",
+	"layers"
+};
+
+static void memory_grow(memory_counter *counter, unsigned long bytes) {
+	unsigned long live = atomic_fetch_add_explicit(&counter->live_bytes, bytes, memory_order_relaxed) + bytes;
+	unsigned long peak = atomic_load_explicit(&counter->peak_bytes, memory_order_relaxed);
+	while (live > peak &&
+		!atomic_compare_exchange_weak_explicit(&counter->peak_bytes, &peak, live, memory_order_relaxed, memory_order_relaxed)
+	);
+}
+
+static void memory_count(unsigned tag, unsigned long bytes) {
+	memory_counter *counter = &g_memory[tag];
+	memory_grow(counter, bytes);
+	atomic_fetch_add_explicit(&counter->live_objects, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&counter->total_objects, 1, memory_order_relaxed);
+}
+
+static void memory_uncount(unsigned tag, unsigned long bytes) {
+	memory_counter *counter = &g_memory[tag];
+	atomic_fetch_sub_explicit(&counter->live_bytes, bytes, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&counter->live_objects, 1, memory_order_relaxed);
+}
+
+static void memory_recount(unsigned tag, unsigned long old_bytes, unsigned long new_bytes) {
+	memory_counter *counter = &g_memory[tag];
+	if (new_bytes >= old_bytes)
+		memory_grow(counter, new_bytes - old_bytes);
+	else
+		atomic_fetch_sub_explicit(&counter->live_bytes, old_bytes - new_bytes, memory_order_relaxed);
+}
+
+void *memory_alloc(unsigned tag, size_t size) {
+	void *memory = malloc(size);
+	if (memory)
+		memory_count(tag, malloc_usable_size(memory));
+	return memory;
+}
+
+void *memory_calloc(unsigned tag, size_t n, size_t size) {
+	void *memory = calloc(n, size);
+	if (memory)
+		memory_count(tag, malloc_usable_size(memory));
+	return memory;
+}
+
+void *memory_realloc(unsigned tag, void *memory, size_t size) {
+	if (!memory)
+		return memory_alloc(tag, size);
+
+	size_t old_size = malloc_usable_size(memory);
+	void *resized = realloc(memory, size);
+	if (resized)
+		memory_recount(tag, old_size, malloc_usable_size(resized));
+	return resized;
+}
+
+char *memory_strdup(unsigned tag, const char *string) {
+	size_t length = strlen(string) + 1;
+	char *copy = memory_alloc(tag, length);
+	if (copy)
+		memcpy(copy, string, length);
+	return copy;
+}
+
+void memory_free(unsigned tag, void *memory) {
+	if (!memory)
+		return;
+	memory_uncount(tag, malloc_usable_size(memory));
+	free(memory);
+}
+
+void memory_gpu_alloc(unsigned tag, unsigned long bytes) {
+	memory_count(tag, bytes);
+}
+
+void memory_gpu_free(unsigned tag, unsigned long bytes) {
+	memory_uncount(tag, bytes);
+}
+
+void memory_gpu_resize(unsigned tag, unsigned long old_bytes, unsigned long new_bytes) {
+	memory_recount(tag, old_bytes, new_bytes);
+}
+
+int venus_get_memory_usage(unsigned tag, memory_usage *usage) {
+	if (tag >= VS_MEMORY_N_TAGS)
+		return VS_FAILURE;
+	memory_counter *counter = &g_memory[tag];
+	usage->live_bytes = atomic_load_explicit(&counter->live_bytes, memory_order_relaxed);
+	usage->peak_bytes = atomic_load_explicit(&counter->peak_bytes, memory_order_relaxed);
+	usage->live_objects = atomic_load_explicit(&counter->live_objects, memory_order_relaxed);
+	usage->total_objects = atomic_load_explicit(&counter->total_objects, memory_order_relaxed);
+	return VS_SUCCESS;
+}
+
+unsigned long venus_report_leaks() {
+	unsigned long leaked = 0;
+	for (unsigned tag = 0; tag < VS_MEMORY_N_TAGS; ++tag) {
+		memory_usage usage;
+		venus_get_memory_usage(tag, &usage);
+		if (!usage.live_objects)
+			continue;
+		vs_log_warn("%s still hold %lu bytes in %lu %s (peak %lu bytes)", g_memory_names[tag], usage.live_bytes,
+			usage.live_objects, tag < VS_MEMORY_FIRST_GPU ? "allocations" : "objects", usage.peak_bytes);
+		leaked += usage.live_objects;
+	}
+	if (!leaked)
+		vs_log_info("No memory leaked");
+	return leaked;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file memory.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Memory accounting behind venus_get_memory_usage() and venus_report_leaks()
+ *
+ * Every heap allocation made by the engine and the toolkit goes through memory_alloc() and friends with the tag of the
+ * subsystem it belongs to. The blocks are ordinary malloc() blocks, sized with malloc_usable_size(), so memory that is
+ * handed to code outside venus can still be given to free(); it is just no longer counted. GL objects are counted by
+ * the code that creates and deletes them, since only it knows how much storage it asked for.
+ */
+
+#ifndef VS_MEMORY_H
+#define VS_MEMORY_H
+
+#include <stddef.h>
+
+#include "../venus.h"
+
+/**
+ * @brief Allocates memory counted against a subsystem
+ *
+ * @param tag VS_MEMORY tag of the subsystem
+ * @param size Number of bytes
+ *
+ * @return Returns the memory or NULL
+ */
+void *memory_alloc(unsigned tag, size_t size);
+
+/**
+ * @brief Allocates zeroed memory counted against a subsystem
+ *
+ * @param tag VS_MEMORY tag of the subsystem
+ * @param n Number of elements
+ * @param size Size of each element
+ *
+ * @return Returns the memory or NULL
+ */
+void *memory_calloc(unsigned tag, size_t n, size_t size);
+
+/**
+ * @brief Resizes memory counted against a subsystem
+ *
+ * @param tag VS_MEMORY tag the memory was allocated with
+ * @param memory Memory to resize, or NULL
+ * @param size New number of bytes
+ *
+ * @return Returns the memory, or NULL with the old memory left alone
+ */
+void *memory_realloc(unsigned tag, void *memory, size_t size);
+
+/**
+ * @brief Copies a string into memory counted against a subsystem
+ *
+ * @param tag VS_MEMORY tag of the subsystem
+ * @param string String to copy
+ *
+ * @return Returns the copy or NULL
+ */
+char *memory_strdup(unsigned tag, const char *string);
+
+/**
+ * @brief Frees memory counted against a subsystem
+ *
+ * @param tag VS_MEMORY tag the memory was allocated with
+ * @param memory Memory to free, or NULL
+ */
+void memory_free(unsigned tag, void *memory);
+
+/**
+ * @brief Counts GPU storage that was just created
+ *
+ * @param tag VS_MEMORY tag of the subsystem
+ * @param bytes Bytes of storage
+ */
+void memory_gpu_alloc(unsigned tag, unsigned long bytes);
+
+/**
+ * @brief Counts GPU storage that was just deleted
+ *
+ * @param tag VS_MEMORY tag of the subsystem
+ * @param bytes Bytes given to memory_gpu_alloc()
+ */
+void memory_gpu_free(unsigned tag, unsigned long bytes);
+
+/**
+ * @brief Counts a change in the size of GPU storage that already exists, such as a buffer being respecified
+ *
+ * @param tag VS_MEMORY tag of the subsystem
+ * @param old_bytes Bytes the storage held before
+ * @param new_bytes Bytes the storage holds now
+ */
+void memory_gpu_resize(unsigned tag, unsigned long old_bytes, unsigned long new_bytes);
+
+#endif
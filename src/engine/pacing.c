@@ -0,0 +1,151 @@
+/**
+ * @file pacing.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "pacing.h"
+
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+#include <GL/glxext.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#include "../venus_common.h"
+#include "graphics.h"
+#include "profile.h"
+
+// -1 until the extensions have been looked for
+static int g_swap_control = -1;
+static int g_swap_control_tear = VS_FALSE;
+static PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT = NULL;
+static PFNGLXSWAPINTERVALMESAPROC glXSwapIntervalMESA = NULL;
+static PFNGLXGETMSCRATEOMLPROC glXGetMscRateOML = NULL;
+
+// Earliest time a finished frame asked the loop to sleep until, or ULONG_MAX if none did
+static atomic_ulong g_pacer_wake = ULONG_MAX;
+
+static void pacer_load_swap_control() {
+	if (g_swap_control != -1)
+		return;
+
+	const char *extensions = glXQueryExtensionsString(g_display, DefaultScreen(g_display));
+	if (glx_check_support(extensions, "GLX_EXT_swap_control"))
+		glXSwapIntervalEXT = (PFNGLXSWAPINTERVALEXTPROC) glXGetProcAddressARB((const GLubyte*) "glXSwapIntervalEXT");
+	if (glx_check_support(extensions, "GLX_MESA_swap_control"))
+		glXSwapIntervalMESA = (PFNGLXSWAPINTERVALMESAPROC) glXGetProcAddressARB((const GLubyte*) "glXSwapIntervalMESA");
+	if (glx_check_support(extensions, "GLX_OML_sync_control"))
+		glXGetMscRateOML = (PFNGLXGETMSCRATEOMLPROC) glXGetProcAddressARB((const GLubyte*) "glXGetMscRateOML");
+	g_swap_control_tear = glXSwapIntervalEXT && glx_check_support(extensions, "GLX_EXT_swap_control_tear");
+
+	g_swap_control = glXSwapIntervalEXT || glXSwapIntervalMESA;
+	if (!g_swap_control)
+		vs_log_info("Neither GLX_EXT_swap_control nor GLX_MESA_swap_control found. The swap interval is left alone.");
+}
+
+void pacer_init(frame_pacer *p) {
+	memset(p, 0, sizeof(frame_pacer));
+	p->interval = VS_SWAP_VSYNC;
+	p->stats.refresh_ns = VS_PACING_DEFAULT_REFRESH_NS;
+}
+
+int pacer_set_interval(frame_pacer *p, unsigned long xwin, int interval) {
+	pacer_load_swap_control();
+	if (!g_swap_control)
+		vs_err(VS_FAILURE);
+
+	if (interval < 0 && !g_swap_control_tear) {
+		vs_log_info("GLX_EXT_swap_control_tear not found. Using vsync instead of adaptive vsync.");
+		interval = -interval;
+	}
+	if (glXSwapIntervalEXT)
+		glXSwapIntervalEXT(g_display, xwin, interval);
+	else if (glXSwapIntervalMESA(interval))
+		vs_err(VS_FAILURE);
+	p->interval = interval;
+
+	int32_t numerator, denominator;
+	if (glXGetMscRateOML && glXGetMscRateOML(g_display, xwin, &numerator, &denominator) && numerator > 0)
+		p->stats.refresh_ns = (unsigned long) denominator * 1000000000ul / (unsigned long) numerator;
+	return VS_SUCCESS;
+}
+
+int pacer_begin_frame(frame_pacer *p) {
+	p->skip = p->present_on_damage && !p->damaged;
+	p->frame_start = profile_now();
+	return !p->skip;
+}
+
+int pacer_should_swap(frame_pacer *p) {
+	if (p->skip)
+		return VS_FALSE;
+
+	// Rise at once to a slow frame and fall back slowly, so one fast frame does not make the next one late
+	if (p->frame_start) {
+		unsigned long work = profile_now() - p->frame_start;
+		if (work > p->stats.work_ns)
+			p->stats.work_ns = work;
+		else
+			p->stats.work_ns = (p->stats.work_ns * 7 + work) / 8;
+	}
+	return VS_TRUE;
+}
+
+static void pacer_sleep_until(unsigned long wake) {
+	struct timespec until = {wake / 1000000000ul, wake % 1000000000ul};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR);
+}
+
+static void pacer_wake_at(unsigned long wake) {
+	unsigned long current = atomic_load_explicit(&g_pacer_wake, memory_order_relaxed);
+	while (wake < current && !atomic_compare_exchange_weak_explicit(&g_pacer_wake, &current, wake, memory_order_relaxed,
+		memory_order_relaxed));
+}
+
+void pacer_end_frame(frame_pacer *p, int swapped) {
+	unsigned long now = profile_now();
+	unsigned vblanks = p->interval < 0 ? -p->interval : p->interval ? p->interval : 1;
+	unsigned long period = p->stats.refresh_ns * vblanks;
+
+	if (swapped) {
+		// Without vsync there is nothing to miss
+		if (p->interval && p->last_swap) {
+			unsigned long elapsed = (now - p->last_swap + period / 2) / period;
+			if (elapsed > 1)
+				p->stats.missed += elapsed - 1;
+		}
+		p->stats.presented++;
+		p->last_swap = now;
+		p->vblank = now;
+		p->damaged = VS_FALSE;
+	} else {
+		p->stats.skipped++;
+		p->last_swap = 0;
+	}
+	p->skip = VS_FALSE;
+	p->frame_start = 0;
+
+	// A skipped frame waits too, or an idle window would spin. A window that has to draw right away keeps the loop awake.
+	if (swapped && !(p->pacing && p->interval)) {
+		pacer_wake_at(now);
+		return;
+	}
+	if (!p->vblank)
+		p->vblank = now;
+	unsigned long next = p->vblank + ((now - p->vblank) / period + 1) * period;
+	unsigned long lead = p->pacing ? p->stats.work_ns + VS_PACING_MARGIN_NS : 0;
+	if (!swapped && next <= now + lead)
+		next += period;
+	pacer_wake_at(next > now + lead ? next - lead : now);
+}
+
+void pacer_wait() {
+	unsigned long wake = atomic_exchange_explicit(&g_pacer_wake, ULONG_MAX, memory_order_relaxed);
+	if (wake != ULONG_MAX && wake > profile_now())
+		pacer_sleep_until(wake);
+}
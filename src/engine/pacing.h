@@ -0,0 +1,151 @@
+/**
+ * @file pacing.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Swap interval, frame pacing and damage driven presentation
+ *
+ * Each window keeps an estimate of how long its frames take from the start of draw_window() to the swap. With pacing on,
+ * the loop sleeps until that long before the next vblank, so the events handled before the next frame are as fresh as
+ * they can be. A window that only presents on damage does not draw or swap a frame until something has invalidated it,
+ * and waits a refresh period instead.
+ *
+ * Windows do not sleep on their own. Each one only asks for a time to wake at, and venus_process_events() sleeps once
+ * until the earliest of them, so a loop over many idle windows does not sleep once for each.
+ */
+
+#ifndef VS_PACING_H
+#define VS_PACING_H
+
+/// Swap as soon as the frame is done, tearing if the frame is not on time
+#define VS_SWAP_IMMEDIATE		0
+/// Wait for vblank before swapping
+#define VS_SWAP_VSYNC			1
+/// Wait for vblank, unless the frame already missed it, in which case it swaps right away
+#define VS_SWAP_ADAPTIVE		-1
+
+/// Refresh period assumed when the display does not report one
+#define VS_PACING_DEFAULT_REFRESH_NS	16666667ul
+
+/// Time left between the end of a paced frame and vblank, to absorb frames that take longer than the estimate
+#define VS_PACING_MARGIN_NS		2000000ul
+
+/**
+ * @brief Presentation counts since the window was created
+ */
+typedef struct {
+	/// Frames swapped
+	unsigned long presented;
+
+	/// Frames that were neither drawn nor swapped, since nothing was damaged
+	unsigned long skipped;
+
+	/// Vblanks missed between frames presented back to back
+	unsigned long missed;
+
+	/// Refresh period of the display
+	unsigned long refresh_ns;
+
+	/// Estimate of the time from the start of a frame to its swap
+	unsigned long work_ns;
+} frame_stats;
+
+/**
+ * @brief Frame pacing state of a window
+ */
+typedef struct {
+	/// VS_SWAP_IMMEDIATE, VS_SWAP_VSYNC, VS_SWAP_ADAPTIVE, or a higher interval
+	int interval;
+
+	int pacing;
+	int present_on_damage;
+
+	/// Set when something changed since the last frame was presented
+	int damaged;
+
+	/// Set by pacer_begin_frame() when the frame should not be drawn or swapped
+	int skip;
+
+	/// When the frame being drawn started
+	unsigned long frame_start;
+
+	/// When the last swap returned, which is taken to be a vblank, or 0 if the last frame was skipped
+	unsigned long last_swap;
+
+	/// A recent vblank that later ones are predicted from
+	unsigned long vblank;
+
+	frame_stats stats;
+} frame_pacer;
+
+/**
+ * @brief Initializes the pacing state of a window
+ *
+ * Swaps start out with vsync, unpaced, and presenting every frame.
+ *
+ * @param p Pointer to frame pacer
+ */
+void pacer_init(frame_pacer *p);
+
+/**
+ * @brief Sets the swap interval of a window through GLX_EXT_swap_control or GLX_MESA_swap_control
+ *
+ * Adaptive vsync needs GLX_EXT_swap_control_tear, and falls back to plain vsync without it. The window's context must
+ * be current.
+ *
+ * @param p Pointer to frame pacer
+ * @param xwin X window the interval is for
+ * @param interval VS_SWAP_IMMEDIATE, VS_SWAP_VSYNC, VS_SWAP_ADAPTIVE, or a number of vblanks per swap
+ *
+ * @return Returns whether it was successful or not
+ */
+int pacer_set_interval(frame_pacer *p, unsigned long xwin, int interval);
+
+/**
+ * @brief Marks a window as needing its next frame
+ *
+ * @param p Pointer to frame pacer
+ */
+static inline void pacer_damage(frame_pacer *p) {
+	p->damaged = 1;
+}
+
+/**
+ * @brief Starts a frame
+ *
+ * @param p Pointer to frame pacer
+ *
+ * @return Returns whether the frame should be drawn
+ */
+int pacer_begin_frame(frame_pacer *p);
+
+/**
+ * @brief Gets whether the frame being drawn should be swapped
+ *
+ * The time spent on the frame so far is taken into the work estimate.
+ *
+ * @param p Pointer to frame pacer
+ *
+ * @return Returns whether the frame should be swapped
+ */
+int pacer_should_swap(frame_pacer *p);
+
+/**
+ * @brief Finishes a frame
+ *
+ * Missed vblanks are counted. If pacing is on or the frame was skipped, the time to start the next one is handed to
+ * pacer_wait(). Otherwise the next pacer_wait() does not sleep at all.
+ *
+ * @param p Pointer to frame pacer
+ * @param swapped Whether the frame was swapped
+ */
+void pacer_end_frame(frame_pacer *p, int swapped);
+
+/**
+ * @brief Sleeps until the earliest time a window finished since the last call asked to start its next frame
+ *
+ * It is called once per turn of the loop, by venus_process_events().
+ */
+void pacer_wait();
+
+#endif
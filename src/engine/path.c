@@ -0,0 +1,862 @@
+/**
+ * @file path.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "path.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "memory.h"
+
+/// Most lines a single curve is flattened into
+#define VS_PATH_MAX_SEGMENTS	256
+
+/// Miter limit of styles that leave it at 0
+#define VS_PATH_MITER_LIMIT		4.0f
+
+static const unsigned path_verb_points[] = {1, 1, 2, 3, 0};
+
+typedef struct {
+	/// One past the last point of the contour, which starts where the one before it ends
+	unsigned end;
+	int closed;
+} path_contour;
+
+/*
+ * Flattened contours, with their points as x, y pairs
+ */
+typedef struct {
+	unsigned n_points;
+	unsigned point_capacity;
+	float *points;
+
+	unsigned n_contours;
+	unsigned contour_capacity;
+	path_contour *contours;
+} path_contours;
+
+/*
+ * An edge of a filled polygon, pointing down. winding is +1 for edges that pointed down in the contour and -1 for edges
+ * that pointed up.
+ */
+typedef struct {
+	float x0;
+	float y0;
+	float y1;
+	float slope;
+	int winding;
+} path_edge;
+
+/*
+ * An edge crossing the slab being swept, with where it is at the top and bottom of the slab
+ */
+typedef struct {
+	const path_edge *edge;
+	float top;
+	float bottom;
+} path_span;
+
+typedef struct {
+	unsigned n_vertices;
+	unsigned vertex_capacity;
+	float *vertices;
+} path_output;
+
+static int path_grow(void **array, unsigned *capacity, unsigned needed, size_t size, unsigned initial) {
+	if (needed <= *capacity)
+		return VS_SUCCESS;
+	unsigned n = *capacity ? *capacity * 2 : initial;
+	while (n < needed)
+		n *= 2;
+	void *grown = memory_realloc(VS_MEMORY_RENDER, *array, size * n);
+	if (!grown)
+		return VS_FAILURE;
+	*array = grown;
+	*capacity = n;
+	return VS_SUCCESS;
+}
+
+#define VS_PATH_FNV_BASIS		0xCBF29CE484222325ul
+
+static unsigned long path_fnv(unsigned long hash, const void *data, size_t size) {
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ bytes[i]) * 0x100000001B3ul;
+	return hash;
+}
+
+static int path_append(path_t *path, unsigned char verb, const float *points) {
+	unsigned n = path_verb_points[verb];
+	if (!path_grow((void**) &path->verbs, &path->verb_capacity, path->n_verbs + 1, 1, 16))
+		return VS_FAILURE;
+	if (!path_grow((void**) &path->points, &path->point_capacity, (path->n_points + n) * 2, sizeof(float), 32))
+		return VS_FAILURE;
+	if (!path->n_verbs)
+		path->hash = VS_PATH_FNV_BASIS;
+	path->hash = path_fnv(path->hash, &verb, 1);
+	path->verbs[path->n_verbs++] = verb;
+	if (n) {
+		memcpy(path->points + path->n_points * 2, points, sizeof(float) * 2 * n);
+		path->hash = path_fnv(path->hash, points, sizeof(float) * 2 * n);
+	}
+	path->n_points += n;
+	return VS_SUCCESS;
+}
+
+void path_init(path_t *path) {
+	memset(path, 0, sizeof(path_t));
+}
+
+void path_clear(path_t *path) {
+	path->n_verbs = 0;
+	path->n_points = 0;
+	path->hash = 0;
+}
+
+void path_free(path_t *path) {
+	memory_free(VS_MEMORY_RENDER, path->verbs);
+	memory_free(VS_MEMORY_RENDER, path->points);
+	path_init(path);
+}
+
+int path_move_to(path_t *path, float x, float y) {
+	const float points[] = {x, y};
+	return path_append(path, VS_PATH_MOVE, points);
+}
+
+int path_line_to(path_t *path, float x, float y) {
+	const float points[] = {x, y};
+	return path_append(path, path->n_verbs ? VS_PATH_LINE : VS_PATH_MOVE, points);
+}
+
+int path_quad_to(path_t *path, float cx, float cy, float x, float y) {
+	if (!path->n_verbs)
+		vs_err(VS_FAILURE);
+	const float points[] = {cx, cy, x, y};
+	return path_append(path, VS_PATH_QUAD, points);
+}
+
+int path_cubic_to(path_t *path, float c0x, float c0y, float c1x, float c1y, float x, float y) {
+	if (!path->n_verbs)
+		vs_err(VS_FAILURE);
+	const float points[] = {c0x, c0y, c1x, c1y, x, y};
+	return path_append(path, VS_PATH_CUBIC, points);
+}
+
+int path_arc(path_t *path, float cx, float cy, float radius, float a0, float a1) {
+	if (!path_line_to(path, cx + cosf(a0) * radius, cy + sinf(a0) * radius))
+		return VS_FAILURE;
+
+	// Each piece is a cubic with its control points along the tangents, which stays within 0.03% of the circle
+	float sweep = a1 - a0;
+	unsigned n = (unsigned) ceilf(fabsf(sweep) / ((float) M_PI * 0.5f) - 1e-4f);
+	float step = n ? sweep / n : 0.0f;
+	float k = 4.0f / 3.0f * tanf(step / 4.0f) * radius;
+	for (unsigned i = 0; i < n; ++i) {
+		float b0 = a0 + step * i;
+		float b1 = b0 + step;
+		float c0 = cosf(b0);
+		float s0 = sinf(b0);
+		float c1 = cosf(b1);
+		float s1 = sinf(b1);
+		if (!path_cubic_to(path, cx + c0 * radius - s0 * k, cy + s0 * radius + c0 * k, cx + c1 * radius + s1 * k,
+			cy + s1 * radius - c1 * k, cx + c1 * radius, cy + s1 * radius))
+			return VS_FAILURE;
+	}
+	return VS_SUCCESS;
+}
+
+int path_close(path_t *path) {
+	if (!path->n_verbs || path->verbs[path->n_verbs - 1] == VS_PATH_CLOSE)
+		return VS_SUCCESS;
+	return path_append(path, VS_PATH_CLOSE, NULL);
+}
+
+int path_rounded_rect(path_t *path, float x, float y, float width, float height, float radius) {
+	if (radius > width / 2.0f)
+		radius = width / 2.0f;
+	if (radius > height / 2.0f)
+		radius = height / 2.0f;
+	const float half = (float) M_PI * 0.5f;
+	int result = path_move_to(path, x + radius, y);
+	if (radius > 0) {
+		result = result && path_arc(path, x + width - radius, y + radius, radius, -half, 0.0f);
+		result = result && path_arc(path, x + width - radius, y + height - radius, radius, 0.0f, half);
+		result = result && path_arc(path, x + radius, y + height - radius, radius, half, half * 2.0f);
+		result = result && path_arc(path, x + radius, y + radius, radius, half * 2.0f, half * 3.0f);
+	} else {
+		result = result && path_line_to(path, x + width, y);
+		result = result && path_line_to(path, x + width, y + height);
+		result = result && path_line_to(path, x, y + height);
+	}
+	return result && path_close(path);
+}
+
+static unsigned path_contour_start(const path_contours *c) {
+	return c->n_contours ? c->contours[c->n_contours - 1].end : 0;
+}
+
+/*
+ * Adds a point to the open contour, unless it is where the contour already is
+ */
+static int path_contour_point(path_contours *c, float x, float y) {
+	if (c->n_points > path_contour_start(c)) {
+		const float *last = c->points + (c->n_points - 1) * 2;
+		if (last[0] == x && last[1] == y)
+			return VS_SUCCESS;
+	}
+	if (!path_grow((void**) &c->points, &c->point_capacity, (c->n_points + 1) * 2, sizeof(float), 256))
+		return VS_FAILURE;
+	c->points[c->n_points * 2] = x;
+	c->points[c->n_points * 2 + 1] = y;
+	c->n_points++;
+	return VS_SUCCESS;
+}
+
+static int path_contour_end(path_contours *c, int closed) {
+	unsigned start = path_contour_start(c);
+	if (c->n_points == start)
+		return VS_SUCCESS;
+
+	// A contour that comes back to its start is closed by that point, which is dropped
+	const float *first = c->points + start * 2;
+	const float *last = c->points + (c->n_points - 1) * 2;
+	if (closed && c->n_points - start > 1 && first[0] == last[0] && first[1] == last[1])
+		c->n_points--;
+
+	if (!path_grow((void**) &c->contours, &c->contour_capacity, c->n_contours + 1, sizeof(path_contour), 16))
+		return VS_FAILURE;
+	c->contours[c->n_contours].end = c->n_points;
+	c->contours[c->n_contours++].closed = closed;
+	return VS_SUCCESS;
+}
+
+static void path_contours_free(path_contours *c) {
+	memory_free(VS_MEMORY_RENDER, c->points);
+	memory_free(VS_MEMORY_RENDER, c->contours);
+}
+
+/*
+ * Segments a curve needs to stay within tol of the lines, from Wang's formula: the largest second difference of the
+ * control points bounds how far the curve can bend away from a chord
+ */
+static unsigned path_segments(float bend, float degree_factor, float tol) {
+	float n = ceilf(sqrtf(bend * degree_factor / tol));
+	if (!(n >= 1.0f))
+		return 1;
+	return n > VS_PATH_MAX_SEGMENTS ? VS_PATH_MAX_SEGMENTS : (unsigned) n;
+}
+
+static float path_bend(const float *a, const float *b, const float *c) {
+	return hypotf(a[0] - 2.0f * b[0] + c[0], a[1] - 2.0f * b[1] + c[1]);
+}
+
+static int path_flatten(const path_t *path, float tol, path_contours *out) {
+	const float *p = path->points;
+	float current[2] = {0.0f, 0.0f};
+	float start[2] = {0.0f, 0.0f};
+	int open = VS_FALSE;
+	int result = VS_SUCCESS;
+
+	for (unsigned i = 0; i < path->n_verbs && result; ++i) {
+		unsigned verb = path->verbs[i];
+		if (verb == VS_PATH_MOVE) {
+			if (open)
+				result = path_contour_end(out, VS_FALSE);
+			current[0] = start[0] = p[0];
+			current[1] = start[1] = p[1];
+			result = result && path_contour_point(out, p[0], p[1]);
+			open = VS_TRUE;
+		} else if (verb == VS_PATH_CLOSE) {
+			if (open)
+				result = path_contour_end(out, VS_TRUE);
+			current[0] = start[0];
+			current[1] = start[1];
+			open = VS_FALSE;
+		} else {
+			// Drawing after a close starts a new contour where the closed one started
+			if (!open) {
+				result = path_contour_point(out, current[0], current[1]);
+				open = VS_TRUE;
+			}
+			if (verb == VS_PATH_LINE) {
+				result = result && path_contour_point(out, p[0], p[1]);
+			} else if (verb == VS_PATH_QUAD) {
+				unsigned n = path_segments(path_bend(current, p, p + 2), 0.25f, tol);
+				for (unsigned s = 1; s <= n && result; ++s) {
+					float t = (float) s / n;
+					float u = 1.0f - t;
+					result = path_contour_point(out, u * u * current[0] + 2.0f * u * t * p[0] + t * t * p[2],
+						u * u * current[1] + 2.0f * u * t * p[1] + t * t * p[3]);
+				}
+			} else {
+				float bend = fmaxf(path_bend(current, p, p + 2), path_bend(p, p + 2, p + 4));
+				unsigned n = path_segments(bend, 0.75f, tol);
+				for (unsigned s = 1; s <= n && result; ++s) {
+					float t = (float) s / n;
+					float u = 1.0f - t;
+					float w0 = u * u * u;
+					float w1 = 3.0f * u * u * t;
+					float w2 = 3.0f * u * t * t;
+					float w3 = t * t * t;
+					result = path_contour_point(out, w0 * current[0] + w1 * p[0] + w2 * p[2] + w3 * p[4],
+						w0 * current[1] + w1 * p[1] + w2 * p[3] + w3 * p[5]);
+				}
+			}
+			current[0] = p[path_verb_points[verb] * 2 - 2];
+			current[1] = p[path_verb_points[verb] * 2 - 1];
+		}
+		p += path_verb_points[verb] * 2;
+	}
+	if (open && result)
+		result = path_contour_end(out, VS_FALSE);
+	return result;
+}
+
+/*
+ * Adds a closed polygon to a set of stroke pieces, turned so that every piece winds the same way and the nonzero rule
+ * fills their union
+ */
+static int path_stroke_piece(path_contours *out, const float (*points)[2], unsigned n) {
+	float area = 0.0f;
+	for (unsigned i = 0; i < n; ++i) {
+		const float *a = points[i];
+		const float *b = points[(i + 1) % n];
+		area += a[0] * b[1] - b[0] * a[1];
+	}
+	if (area == 0.0f)
+		return VS_SUCCESS;
+	for (unsigned i = 0; i < n; ++i) {
+		const float *p = points[area > 0 ? i : n - 1 - i];
+		if (!path_contour_point(out, p[0], p[1]))
+			return VS_FAILURE;
+	}
+	return path_contour_end(out, VS_TRUE);
+}
+
+/*
+ * Adds the points of an arc around center from angle a0 through sweep, including both ends
+ */
+static unsigned path_arc_points(float (*points)[2], const float *center, float radius, float a0, float sweep,
+	float tol) {
+
+	float step = tol < radius ? 2.0f * acosf(1.0f - tol / radius) : (float) M_PI * 0.5f;
+	unsigned n = (unsigned) ceilf(fabsf(sweep) / step);
+	if (n < 1)
+		n = 1;
+	if (n > VS_PATH_MAX_SEGMENTS)
+		n = VS_PATH_MAX_SEGMENTS;
+	for (unsigned i = 0; i <= n; ++i) {
+		float a = a0 + sweep * i / n;
+		points[i][0] = center[0] + cosf(a) * radius;
+		points[i][1] = center[1] + sinf(a) * radius;
+	}
+	return n + 1;
+}
+
+/*
+ * Adds the cap at the end of a contour, where d is the unit direction pointing away from the contour
+ */
+static int path_stroke_cap(path_contours *out, const float *p, const float *d, float hw, unsigned cap, float tol) {
+	float u[2] = {-d[1] * hw, d[0] * hw};
+	if (cap == VS_CAP_SQUARE) {
+		const float square[4][2] = {
+			{p[0] + u[0], p[1] + u[1]},
+			{p[0] + u[0] + d[0] * hw, p[1] + u[1] + d[1] * hw},
+			{p[0] - u[0] + d[0] * hw, p[1] - u[1] + d[1] * hw},
+			{p[0] - u[0], p[1] - u[1]}
+		};
+		return path_stroke_piece(out, square, 4);
+	}
+	if (cap == VS_CAP_ROUND) {
+		float points[VS_PATH_MAX_SEGMENTS + 1][2];
+		unsigned n = path_arc_points(points, p, hw, atan2f(u[1], u[0]), -(float) M_PI, tol);
+		return path_stroke_piece(out, (const float (*)[2]) points, n);
+	}
+	return VS_SUCCESS;
+}
+
+/*
+ * Adds the join at v between a segment coming in along d0 and one going out along d1, both unit directions
+ */
+static int path_stroke_join(path_contours *out, const float *v, const float *d0, const float *d1, float hw,
+	const path_style *style, float tol) {
+
+	float cross = d0[0] * d1[1] - d0[1] * d1[0];
+	float dot = d0[0] * d1[0] + d0[1] * d1[1];
+	if (fabsf(cross) < 1e-6f && dot > 0)
+		return VS_SUCCESS;
+
+	// The join fills the gap on the outside of the turn
+	float side = cross > 0 ? -hw : hw;
+	float u0[2] = {-d0[1] * side, d0[0] * side};
+	float u1[2] = {-d1[1] * side, d1[0] * side};
+	float a[2] = {v[0] + u0[0], v[1] + u0[1]};
+	float b[2] = {v[0] + u1[0], v[1] + u1[1]};
+
+	if (style->join == VS_JOIN_ROUND) {
+		float points[VS_PATH_MAX_SEGMENTS + 2][2];
+		points[0][0] = v[0];
+		points[0][1] = v[1];
+		float a0 = atan2f(u0[1], u0[0]);
+		float sweep = atan2f(u1[1], u1[0]) - a0;
+		if (sweep > (float) M_PI)
+			sweep -= 2.0f * (float) M_PI;
+		if (sweep < -(float) M_PI)
+			sweep += 2.0f * (float) M_PI;
+		unsigned n = path_arc_points(points + 1, v, hw, a0, sweep, tol);
+		return path_stroke_piece(out, (const float (*)[2]) points, n + 1);
+	}
+
+	// A miter is as long as the width over the cosine of half the angle between the segments
+	float limit = style->miter_limit > 0 ? style->miter_limit : VS_PATH_MITER_LIMIT;
+	float half_cos = sqrtf(fmaxf((1.0f + dot) * 0.5f, 0.0f));
+	if (style->join == VS_JOIN_MITER && half_cos * limit >= 1.0f) {
+		float k = 1.0f / (1.0f + dot);
+		const float miter[4][2] = {
+			{v[0], v[1]},
+			{a[0], a[1]},
+			{v[0] + (u0[0] + u1[0]) * k, v[1] + (u0[1] + u1[1]) * k},
+			{b[0], b[1]}
+		};
+		return path_stroke_piece(out, miter, 4);
+	}
+	const float bevel[3][2] = {{v[0], v[1]}, {a[0], a[1]}, {b[0], b[1]}};
+	return path_stroke_piece(out, bevel, 3);
+}
+
+static void path_direction(const float *a, const float *b, float *d) {
+	float dx = b[0] - a[0];
+	float dy = b[1] - a[1];
+	float length = hypotf(dx, dy);
+	d[0] = dx / length;
+	d[1] = dy / length;
+}
+
+/*
+ * Turns flattened contours into the polygons that make up their stroke: a quad per segment, a piece per join and a
+ * piece per cap
+ */
+static int path_stroke(const path_contours *in, const path_style *style, float tol, path_contours *out) {
+	float hw = style->width * 0.5f;
+	if (!(hw > 0))
+		return VS_SUCCESS;
+
+	unsigned start = 0;
+	for (unsigned c = 0; c < in->n_contours; start = in->contours[c++].end) {
+		const float (*p)[2] = (const float (*)[2]) (in->points + start * 2);
+		unsigned n = in->contours[c].end - start;
+
+		// A contour that never leaves its first point is a dot if it has caps that stick out
+		if (n == 1) {
+			const float right[2] = {1.0f, 0.0f};
+			const float left[2] = {-1.0f, 0.0f};
+			if (style->cap == VS_CAP_BUTT)
+				continue;
+			if (!path_stroke_cap(out, p[0], right, hw, style->cap, tol) ||
+				!path_stroke_cap(out, p[0], left, hw, style->cap, tol))
+				return VS_FAILURE;
+			continue;
+		}
+
+		int closed = in->contours[c].closed && n > 2;
+		unsigned n_segments = closed ? n : n - 1;
+		for (unsigned i = 0; i < n_segments; ++i) {
+			const float *a = p[i];
+			const float *b = p[(i + 1) % n];
+			float d[2];
+			path_direction(a, b, d);
+			float u[2] = {-d[1] * hw, d[0] * hw};
+			const float quad[4][2] = {
+				{a[0] + u[0], a[1] + u[1]},
+				{b[0] + u[0], b[1] + u[1]},
+				{b[0] - u[0], b[1] - u[1]},
+				{a[0] - u[0], a[1] - u[1]}
+			};
+			if (!path_stroke_piece(out, quad, 4))
+				return VS_FAILURE;
+		}
+
+		for (unsigned i = closed ? 0 : 1; i < (closed ? n : n - 1); ++i) {
+			float d0[2];
+			float d1[2];
+			path_direction(p[(i + n - 1) % n], p[i], d0);
+			path_direction(p[i], p[(i + 1) % n], d1);
+			if (!path_stroke_join(out, p[i], d0, d1, hw, style, tol))
+				return VS_FAILURE;
+		}
+
+		if (!closed) {
+			float d[2];
+			path_direction(p[1], p[0], d);
+			if (!path_stroke_cap(out, p[0], d, hw, style->cap, tol))
+				return VS_FAILURE;
+			path_direction(p[n - 2], p[n - 1], d);
+			if (!path_stroke_cap(out, p[n - 1], d, hw, style->cap, tol))
+				return VS_FAILURE;
+		}
+	}
+	return VS_SUCCESS;
+}
+
+static int path_compare_edges(const void *a, const void *b) {
+	float ya = ((const path_edge*) a)->y0;
+	float yb = ((const path_edge*) b)->y0;
+	return (ya > yb) - (ya < yb);
+}
+
+static int path_compare_floats(const void *a, const void *b) {
+	float fa = *(const float*) a;
+	float fb = *(const float*) b;
+	return (fa > fb) - (fa < fb);
+}
+
+static int path_emit(path_output *out, float lt, float rt, float lb, float rb, float top, float bottom) {
+	if (!path_grow((void**) &out->vertices, &out->vertex_capacity, (out->n_vertices + 6) * 2, sizeof(float), 384))
+		return VS_FAILURE;
+	float *v = out->vertices + out->n_vertices * 2;
+	if (rt > lt) {
+		const float triangle[] = {lt, top, rt, top, rb, bottom};
+		memcpy(v, triangle, sizeof(triangle));
+		v += 6;
+		out->n_vertices += 3;
+	}
+	if (rb > lb) {
+		const float triangle[] = {lt, top, rb, bottom, lb, bottom};
+		memcpy(v, triangle, sizeof(triangle));
+		out->n_vertices += 3;
+	}
+	return VS_SUCCESS;
+}
+
+/*
+ * Fills polygons by sweeping down through the slabs between the heights of their points. Edges are sorted across each
+ * slab, and the runs between them where the winding number is inside are emitted as trapezoids. Slabs are split where
+ * two edges cross, so the order of the edges never changes inside a slab.
+ */
+static int path_fill(const path_contours *in, unsigned rule, float tol, path_output *out) {
+	if (!in->n_points)
+		return VS_SUCCESS;
+	unsigned n_edges = 0;
+	path_edge *edges = memory_alloc(VS_MEMORY_RENDER, sizeof(path_edge) * (in->n_points + 1));
+	float *ys = memory_alloc(VS_MEMORY_RENDER, sizeof(float) * (in->n_points + 1));
+	path_span *spans = memory_alloc(VS_MEMORY_RENDER, sizeof(path_span) * (in->n_points + 1));
+	int result = edges && ys && spans;
+
+	unsigned start = 0;
+	for (unsigned c = 0; c < in->n_contours && result; start = in->contours[c++].end) {
+		unsigned n = in->contours[c].end - start;
+		const float (*p)[2] = (const float (*)[2]) (in->points + start * 2);
+		for (unsigned i = 0; i < n; ++i) {
+			const float *a = p[i];
+			const float *b = p[(i + 1) % n];
+			if (a[1] == b[1])
+				continue;
+			path_edge *e = &edges[n_edges++];
+			int down = a[1] < b[1];
+			const float *top = down ? a : b;
+			const float *bottom = down ? b : a;
+			e->x0 = top[0];
+			e->y0 = top[1];
+			e->y1 = bottom[1];
+			e->slope = (bottom[0] - top[0]) / (bottom[1] - top[1]);
+			e->winding = down ? 1 : -1;
+		}
+	}
+
+	unsigned n_ys = 0;
+	if (result) {
+		qsort(edges, n_edges, sizeof(path_edge), path_compare_edges);
+		for (unsigned i = 0; i < in->n_points; ++i)
+			ys[i] = in->points[i * 2 + 1];
+		qsort(ys, in->n_points, sizeof(float), path_compare_floats);
+		for (unsigned i = 0; i < in->n_points; ++i)
+			if (!n_ys || ys[i] != ys[n_ys - 1])
+				ys[n_ys++] = ys[i];
+	}
+
+	// Crossings closer than this to the top of a slab are left alone, which moves them by far less than a pixel
+	const float min_step = tol * 0.01f;
+	unsigned n_spans = 0;
+	unsigned next = 0;
+	for (unsigned k = 0; k + 1 < n_ys && result; ++k) {
+		float top = ys[k];
+		float bottom = ys[k + 1];
+
+		unsigned kept = 0;
+		for (unsigned i = 0; i < n_spans; ++i)
+			if (spans[i].edge->y1 > top)
+				spans[kept++] = spans[i];
+		n_spans = kept;
+		for (; next < n_edges && edges[next].y0 <= top; ++next)
+			if (edges[next].y1 > top)
+				spans[n_spans++].edge = &edges[next];
+
+		while (top < bottom && result) {
+			// Edges are ordered just below the top, since edges that meet at the top can round either way there.
+			// Insertion sort, since the order barely changes from one slab to the next.
+			float probe = top + min_step < bottom ? top + min_step : (top + bottom) * 0.5f;
+			for (unsigned i = 0; i < n_spans; ++i)
+				spans[i].top = spans[i].edge->x0 + (probe - spans[i].edge->y0) * spans[i].edge->slope;
+			for (unsigned i = 1; i < n_spans; ++i) {
+				path_span span = spans[i];
+				unsigned j = i;
+				for (; j && spans[j - 1].top > span.top; --j)
+					spans[j] = spans[j - 1];
+				spans[j] = span;
+			}
+
+			// The first crossing below the probe is always between neighbours
+			float end = bottom;
+			for (unsigned i = 0; i < n_spans; ++i)
+				spans[i].bottom = spans[i].edge->x0 + (bottom - spans[i].edge->y0) * spans[i].edge->slope;
+			for (unsigned i = 0; i + 1 < n_spans; ++i) {
+				const path_span *a = &spans[i];
+				const path_span *b = &spans[i + 1];
+				if (a->bottom <= b->bottom)
+					continue;
+				float t = (b->top - a->top) / ((a->bottom - a->top) - (b->bottom - b->top));
+				float y = probe + (bottom - probe) * t;
+				if (y > probe && y < end)
+					end = y;
+			}
+			for (unsigned i = 0; i < n_spans; ++i) {
+				spans[i].top = spans[i].edge->x0 + (top - spans[i].edge->y0) * spans[i].edge->slope;
+				spans[i].bottom = spans[i].edge->x0 + (end - spans[i].edge->y0) * spans[i].edge->slope;
+			}
+
+			int winding = 0;
+			const path_span *left = NULL;
+			for (unsigned i = 0; i < n_spans && result; ++i) {
+				winding += spans[i].edge->winding;
+				int inside = rule == VS_FILL_EVENODD ? winding & 1 : winding != 0;
+				if (inside && !left) {
+					left = &spans[i];
+				} else if (!inside && left) {
+					result = path_emit(out, left->top, spans[i].top, left->bottom, spans[i].bottom, top, end);
+					left = NULL;
+				}
+			}
+			top = end;
+		}
+	}
+
+	memory_free(VS_MEMORY_RENDER, edges);
+	memory_free(VS_MEMORY_RENDER, ys);
+	memory_free(VS_MEMORY_RENDER, spans);
+	return result;
+}
+
+int path_tessellate(const path_t *path, const path_style *style, float scale, path_mesh *mesh) {
+	VS_TRACE_SCOPE("path_tessellate");
+	float tol = VS_PATH_TOLERANCE / scale;
+	path_contours contours;
+	path_contours stroke;
+	path_output output;
+	memset(&contours, 0, sizeof(path_contours));
+	memset(&stroke, 0, sizeof(path_contours));
+	memset(&output, 0, sizeof(path_output));
+
+	int result = path_flatten(path, tol, &contours);
+	if (result && style->stroke) {
+		result = path_stroke(&contours, style, tol, &stroke) && path_fill(&stroke, VS_FILL_NONZERO, tol, &output);
+	} else if (result) {
+		result = path_fill(&contours, style->fill_rule, tol, &output);
+	}
+	path_contours_free(&contours);
+	path_contours_free(&stroke);
+	if (!result) {
+		memory_free(VS_MEMORY_RENDER, output.vertices);
+		return VS_FAILURE;
+	}
+
+	mesh->n_vertices = output.n_vertices;
+	mesh->vertices = output.vertices;
+	for (unsigned i = 0; i < 4; ++i)
+		mesh->bounds[i] = 0.0f;
+	for (unsigned i = 0; i < output.n_vertices; ++i) {
+		const float *v = output.vertices + i * 2;
+		if (!i || v[0] < mesh->bounds[0])
+			mesh->bounds[0] = v[0];
+		if (!i || v[1] < mesh->bounds[1])
+			mesh->bounds[1] = v[1];
+		if (!i || v[0] > mesh->bounds[2])
+			mesh->bounds[2] = v[0];
+		if (!i || v[1] > mesh->bounds[3])
+			mesh->bounds[3] = v[1];
+	}
+	return VS_SUCCESS;
+}
+
+/*
+ * Picks out the parts of a style that change the mesh, so fills never differ by stroke settings and the other way around
+ */
+static void path_style_parts(const path_style *style, float *numbers, unsigned *modes) {
+	memset(numbers, 0, sizeof(float) * 2);
+	memset(modes, 0, sizeof(unsigned) * 4);
+	modes[0] = !!style->stroke;
+	if (style->stroke) {
+		numbers[0] = style->width;
+		numbers[1] = style->join == VS_JOIN_MITER ? style->miter_limit : 0.0f;
+		modes[1] = style->join;
+		modes[2] = style->cap;
+	} else {
+		modes[3] = style->fill_rule;
+	}
+}
+
+static unsigned long path_key(const path_t *path, const float *numbers, const unsigned *modes) {
+	unsigned long hash = path_fnv(path->hash, numbers, sizeof(float) * 2);
+	return path_fnv(hash, modes, sizeof(unsigned) * 4);
+}
+
+/*
+ * Checks that a mesh was made from this path and style, and not only from ones with the same key
+ */
+static int path_mesh_matches(const path_mesh *mesh, const path_t *path, const float *numbers, const unsigned *modes) {
+	return mesh->path.n_verbs == path->n_verbs && mesh->path.n_points == path->n_points &&
+		!memcmp(mesh->style_numbers, numbers, sizeof(mesh->style_numbers)) &&
+		!memcmp(mesh->style_modes, modes, sizeof(mesh->style_modes)) &&
+		!memcmp(mesh->path.verbs, path->verbs, path->n_verbs) &&
+		!memcmp(mesh->path.points, path->points, sizeof(float) * 2 * path->n_points);
+}
+
+/*
+ * Finds a mesh in a slot of the cache. The cache's lock has to be held.
+ */
+static path_mesh *path_cache_find(path_cache *cache, unsigned slot, unsigned long key, int bucket, const path_t *path,
+	const float *numbers, const unsigned *modes) {
+	for (path_mesh *mesh = cache->buckets[slot]; mesh; mesh = mesh->next)
+		if (mesh->key == key && mesh->bucket == bucket && path_mesh_matches(mesh, path, numbers, modes))
+			return mesh;
+	return NULL;
+}
+
+static unsigned long path_mesh_bytes(const path_mesh *mesh) {
+	return sizeof(path_mesh) + sizeof(float) * 2 * (mesh->n_vertices + mesh->path.n_points) + mesh->path.n_verbs;
+}
+
+void path_cache_init(path_cache *cache) {
+	memset(cache, 0, sizeof(path_cache));
+	pthread_mutex_init(&cache->lock, NULL);
+}
+
+static void path_mesh_delete(path_mesh *mesh) {
+	if (!mesh)
+		return;
+	path_free(&mesh->path);
+	memory_free(VS_MEMORY_RENDER, mesh->vertices);
+	memory_free(VS_MEMORY_RENDER, mesh);
+}
+
+static void path_mesh_free(path_cache *cache, path_mesh *mesh) {
+	cache->stats.n_meshes--;
+	cache->stats.bytes -= path_mesh_bytes(mesh);
+	path_mesh_delete(mesh);
+}
+
+void path_cache_destroy(path_cache *cache) {
+	for (unsigned b = 0; b < VS_PATH_BUCKETS; ++b) {
+		while (cache->buckets[b]) {
+			path_mesh *mesh = cache->buckets[b];
+			cache->buckets[b] = mesh->next;
+			path_mesh_free(cache, mesh);
+		}
+	}
+	pthread_mutex_destroy(&cache->lock);
+}
+
+void path_cache_update(path_cache *cache) {
+	pthread_mutex_lock(&cache->lock);
+	cache->frame++;
+	for (unsigned b = 0; b < VS_PATH_BUCKETS; ++b) {
+		for (path_mesh **link = &cache->buckets[b]; *link;) {
+			path_mesh *mesh = *link;
+			if (atomic_load_explicit(&mesh->last_used, memory_order_relaxed) + VS_PATH_FORGET < cache->frame) {
+				*link = mesh->next;
+				path_mesh_free(cache, mesh);
+			} else {
+				link = &mesh->next;
+			}
+		}
+	}
+	pthread_mutex_unlock(&cache->lock);
+}
+
+path_mesh *path_cache_get(path_cache *cache, path_t *path, const path_style *style, float scale) {
+	if (!(scale > 0))
+		vs_err(NULL);
+
+	// Meshes are tessellated for the largest scale of their bucket, so their curves are never too coarse
+	int bucket = (int) ceilf(log2f(scale) * VS_PATH_SCALE_STEPS - 1e-3f);
+	float numbers[2];
+	unsigned modes[4];
+	path_style_parts(style, numbers, modes);
+	unsigned long key = path_key(path, numbers, modes);
+	unsigned long h = (key + (unsigned long) bucket) * 0x9E3779B97F4A7C15ul;
+	unsigned slot = (unsigned) (h >> 32 ^ h) & (VS_PATH_BUCKETS - 1);
+
+	pthread_mutex_lock(&cache->lock);
+	path_mesh *mesh = path_cache_find(cache, slot, key, bucket, path, numbers, modes);
+	if (mesh) {
+		atomic_store_explicit(&mesh->last_used, cache->frame, memory_order_relaxed);
+		cache->stats.hits++;
+		pthread_mutex_unlock(&cache->lock);
+		return mesh;
+	}
+	cache->stats.misses++;
+	pthread_mutex_unlock(&cache->lock);
+
+	// Other threads keep recording while this one tessellates
+	path_mesh *made = memory_calloc(VS_MEMORY_RENDER, 1, sizeof(path_mesh));
+	if (!made)
+		return NULL;
+	made->key = key;
+	made->bucket = bucket;
+	memcpy(made->style_numbers, numbers, sizeof(made->style_numbers));
+	memcpy(made->style_modes, modes, sizeof(made->style_modes));
+	path_init(&made->path);
+	if (!path_tessellate(path, style, exp2f((float) bucket / VS_PATH_SCALE_STEPS), made) ||
+		!path_grow((void**) &made->path.verbs, &made->path.verb_capacity, path->n_verbs, 1, 1) ||
+		!path_grow((void**) &made->path.points, &made->path.point_capacity, path->n_points * 2, sizeof(float), 2)) {
+		path_mesh_delete(made);
+		return NULL;
+	}
+	memcpy(made->path.verbs, path->verbs, path->n_verbs);
+	memcpy(made->path.points, path->points, sizeof(float) * 2 * path->n_points);
+	made->path.n_verbs = path->n_verbs;
+	made->path.n_points = path->n_points;
+	made->path.hash = path->hash;
+
+	// Another thread may have made the same mesh in the meantime
+	pthread_mutex_lock(&cache->lock);
+	mesh = path_cache_find(cache, slot, key, bucket, path, numbers, modes);
+	if (mesh) {
+		atomic_store_explicit(&mesh->last_used, cache->frame, memory_order_relaxed);
+		pthread_mutex_unlock(&cache->lock);
+		path_mesh_delete(made);
+		return mesh;
+	}
+	atomic_init(&made->last_used, cache->frame);
+	made->next = cache->buckets[slot];
+	cache->buckets[slot] = made;
+	cache->stats.n_meshes++;
+	cache->stats.bytes += path_mesh_bytes(made);
+	cache->stats.triangles += made->n_vertices / 3;
+	pthread_mutex_unlock(&cache->lock);
+	return made;
+}
+
+int path_draw(path_cache *cache, render_list *list, path_t *path, const path_style *style, float x, float y,
+	float scale, const unsigned char *rgba) {
+
+	path_mesh *mesh = path_cache_get(cache, path, style, scale);
+	if (!mesh)
+		return VS_FAILURE;
+	return render_push_mesh(list, mesh->vertices, mesh->n_vertices, mesh->bounds, x, y, scale, rgba);
+}
@@ -0,0 +1,298 @@
+/**
+ * @file path.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Vector paths and the meshes they are tessellated into
+ *
+ * A path is made of contours of lines and bezier curves. To draw one, its curves are flattened into lines, finely
+ * enough that they stay within VS_PATH_TOLERANCE pixels of the curve at the scale it is drawn at, and the result is cut
+ * into trapezoids by a single sweep from top to bottom, which handles both fill rules and contours that cross themselves
+ * or each other. Strokes are turned into polygons first, one per segment, join and cap, which are filled together.
+ *
+ * Meshes are cached by a hash of the path and its style and by scale bucket, so a static icon is tessellated once and
+ * is then only copied into the render list, where it shares draw calls with every other solid quad and mesh.
+ */
+
+#ifndef VS_PATH_H
+#define VS_PATH_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "render.h"
+
+#define VS_PATH_MOVE			0
+#define VS_PATH_LINE			1
+#define VS_PATH_QUAD			2
+#define VS_PATH_CUBIC			3
+#define VS_PATH_CLOSE			4
+
+#define VS_FILL_NONZERO			0
+#define VS_FILL_EVENODD			1
+
+#define VS_JOIN_MITER			0
+#define VS_JOIN_ROUND			1
+#define VS_JOIN_BEVEL			2
+
+#define VS_CAP_BUTT				0
+#define VS_CAP_ROUND			1
+#define VS_CAP_SQUARE			2
+
+/// Most distance in pixels between a curve and the lines it is flattened into
+#define VS_PATH_TOLERANCE		0.25f
+
+/// Scale buckets per doubling of size. Meshes are tessellated at the top of their bucket and shared by every scale in it.
+#define VS_PATH_SCALE_STEPS		4
+
+/// Hash buckets meshes are looked up in
+#define VS_PATH_BUCKETS			256
+
+/// Frames a mesh is kept for after it was last drawn
+#define VS_PATH_FORGET			300
+
+/**
+ * @brief A vector path
+ *
+ * Each verb takes its points from the point array in order: a move or line takes one, a quadratic curve two, a cubic
+ * curve three and a close none. Points are x, y pairs.
+ */
+typedef struct {
+	unsigned n_verbs;
+	unsigned verb_capacity;
+	unsigned char *verbs;
+
+	unsigned n_points;
+	unsigned point_capacity;
+	float *points;
+
+	/// Hash of the verbs and points, kept up to date as they are added so that drawing only has to read it
+	unsigned long hash;
+} path_t;
+
+/**
+ * @brief How a path is drawn
+ */
+typedef struct {
+	/// Set to stroke the outline of the path instead of filling it
+	int stroke;
+
+	/// VS_FILL_NONZERO or VS_FILL_EVENODD, for fills
+	unsigned fill_rule;
+
+	/// Width of strokes in path units
+	float width;
+
+	/// VS_JOIN_MITER and friends
+	unsigned join;
+
+	/// VS_CAP_BUTT and friends, for contours that are not closed
+	unsigned cap;
+
+	/// Longest a miter can be as a multiple of the width before it is beveled instead
+	float miter_limit;
+} path_style;
+
+/**
+ * @brief Triangles a path is drawn with
+ */
+typedef struct path_mesh {
+	/// Hash of the path and its style, and the scale bucket
+	unsigned long key;
+	int bucket;
+
+	/// Copy of the path and the parts of its style that shaped the mesh, which a hit has to match as well as the key
+	path_t path;
+	float style_numbers[2];
+	unsigned style_modes[4];
+
+	/// Positions in path units, three per triangle, as x, y pairs
+	unsigned n_vertices;
+	float *vertices;
+
+	/// Bounding box of the vertices as {x0, y0, x1, y1}
+	float bounds[4];
+
+	/// Frame the mesh was last drawn
+	atomic_uint last_used;
+
+	struct path_mesh *next;
+} path_mesh;
+
+/**
+ * @brief Path cache statistics
+ */
+typedef struct {
+	unsigned n_meshes;
+	unsigned long bytes;
+
+	/// Totals since the cache was created
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long triangles;
+} path_stats;
+
+typedef struct {
+	pthread_mutex_t lock;
+	path_mesh *buckets[VS_PATH_BUCKETS];
+	unsigned frame;
+	path_stats stats;
+} path_cache;
+
+/**
+ * @brief Initializes an empty path
+ *
+ * @param path Pointer to path
+ */
+void path_init(path_t *path);
+
+/**
+ * @brief Empties a path without releasing its memory
+ *
+ * @param path Pointer to path
+ */
+void path_clear(path_t *path);
+
+/**
+ * @brief Releases the memory held by a path
+ *
+ * @param path Pointer to path
+ */
+void path_free(path_t *path);
+
+/**
+ * @brief Starts a new contour
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_move_to(path_t *path, float x, float y);
+
+/**
+ * @brief Adds a line from the current point
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_line_to(path_t *path, float x, float y);
+
+/**
+ * @brief Adds a quadratic bezier curve from the current point
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_quad_to(path_t *path, float cx, float cy, float x, float y);
+
+/**
+ * @brief Adds a cubic bezier curve from the current point
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_cubic_to(path_t *path, float c0x, float c0y, float c1x, float c1y, float x, float y);
+
+/**
+ * @brief Adds a circular arc
+ *
+ * A line is added from the current point to the start of the arc, or a contour is started there if there is none. The
+ * arc is stored as cubic curves of at most a quarter turn each.
+ *
+ * @param path Pointer to path
+ * @param cx Horizontal center
+ * @param cy Vertical center
+ * @param radius Radius
+ * @param a0 Starting angle in radians, clockwise from the positive x axis since y points down
+ * @param a1 Ending angle in radians
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_arc(path_t *path, float cx, float cy, float radius, float a0, float a1);
+
+/**
+ * @brief Closes the current contour with a line back to its start
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_close(path_t *path);
+
+/**
+ * @brief Adds a rectangle with rounded corners as a closed contour
+ *
+ * @param path Pointer to path
+ * @param x Left edge
+ * @param y Top edge
+ * @param width Width
+ * @param height Height
+ * @param radius Corner radius, which is clamped to half the width and height
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_rounded_rect(path_t *path, float x, float y, float width, float height, float radius);
+
+/**
+ * @brief Tessellates a path into triangles
+ *
+ * The mesh's vertices are allocated and must be freed with memory_free() under VS_MEMORY_RENDER.
+ *
+ * @param path Pointer to path
+ * @param style How the path is drawn
+ * @param scale Pixels per path unit, which decides how finely curves are flattened
+ * @param mesh Memory address where the triangles will be saved
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_tessellate(const path_t *path, const path_style *style, float scale, path_mesh *mesh);
+
+/**
+ * @brief Initializes a path cache
+ *
+ * @param cache Pointer to path cache
+ */
+void path_cache_init(path_cache *cache);
+
+/**
+ * @brief Deletes every mesh in a path cache
+ *
+ * @param cache Pointer to path cache
+ */
+void path_cache_destroy(path_cache *cache);
+
+/**
+ * @brief Advances a path cache by one frame, deleting meshes that have not been drawn for VS_PATH_FORGET frames
+ *
+ * This must not be called while recording.
+ *
+ * @param cache Pointer to path cache
+ */
+void path_cache_update(path_cache *cache);
+
+/**
+ * @brief Gets the mesh of a path, tessellating it if it is not in the cache
+ *
+ * This is safe to call on any thread while recording, as long as nothing changes the path at the same time. A path
+ * that is missing is tessellated without holding the cache's lock. The mesh stays valid until the next update.
+ *
+ * @param cache Pointer to path cache
+ * @param path Pointer to path
+ * @param style How the path is drawn
+ * @param scale Pixels per path unit
+ *
+ * @return Returns the mesh or NULL
+ */
+path_mesh *path_cache_get(path_cache *cache, path_t *path, const path_style *style, float scale);
+
+/**
+ * @brief Records a path into a render list through a path cache
+ *
+ * @param cache Pointer to path cache
+ * @param list Pointer to render list
+ * @param path Pointer to path
+ * @param style How the path is drawn
+ * @param x Horizontal position of the path's origin in pixels
+ * @param y Vertical position of the path's origin in pixels
+ * @param scale Pixels per path unit
+ * @param rgba Color of the path
+ *
+ * @return Returns whether it was successful or not
+ */
+int path_draw(path_cache *cache, render_list *list, path_t *path, const path_style *style, float x, float y,
+	float scale, const unsigned char *rgba);
+
+#endif
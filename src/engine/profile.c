@@ -0,0 +1,211 @@
+/**
+ * @file profile.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "profile.h"
+
+#include <glad/glad.h>
+
+#include <string.h>
+#include <time.h>
+
+#include "../venus_common.h"
+#include "../toolkit/widget.h"
+
+atomic_int g_profile_enabled = VS_FALSE;
+
+/*
+ * A record is being written while its sequence is odd. Readers copy it and only keep the copy if the sequence was even
+ * and unchanged on both sides of the copy.
+ */
+typedef struct {
+	atomic_ulong sequence;
+	frame_record record;
+} profile_slot;
+
+static profile_slot g_profile_ring[VS_PROFILE_FRAMES];
+
+// Number of frames published so far
+static atomic_ulong g_profile_published = 0;
+
+// The frame being timed. Only the drawing thread touches it.
+static frame_record g_profile_current;
+static unsigned long g_profile_started[VS_PROFILE_N_PHASES];
+
+static void *g_profile_watchers[VS_PROFILE_WATCHERS];
+static unsigned g_profile_n_watchers = 0;
+
+unsigned long profile_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long) now.tv_sec * 1000000000ul + now.tv_nsec;
+}
+
+static void profile_slot_write_begin(profile_slot *slot) {
+	atomic_fetch_add_explicit(&slot->sequence, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+static void profile_slot_write_end(profile_slot *slot) {
+	atomic_fetch_add_explicit(&slot->sequence, 1, memory_order_release);
+}
+
+void profile_begin(unsigned phase) {
+	if (!atomic_load_explicit(&g_profile_enabled, memory_order_relaxed))
+		return;
+	unsigned long now = profile_now();
+	if (!g_profile_current.start_ns)
+		g_profile_current.start_ns = now;
+	g_profile_started[phase] = now;
+}
+
+void profile_end(unsigned phase) {
+	if (!atomic_load_explicit(&g_profile_enabled, memory_order_relaxed) || !g_profile_started[phase])
+		return;
+	g_profile_current.cpu_ns[phase] += profile_now() - g_profile_started[phase];
+	g_profile_started[phase] = 0;
+}
+
+void profile_frame_end() {
+	if (!atomic_load_explicit(&g_profile_enabled, memory_order_relaxed))
+		return;
+
+	unsigned long frame = atomic_load_explicit(&g_profile_published, memory_order_relaxed) + 1;
+	g_profile_current.frame = frame;
+	if (g_profile_current.start_ns)
+		g_profile_current.frame_ns = profile_now() - g_profile_current.start_ns;
+
+	profile_slot *slot = &g_profile_ring[frame % VS_PROFILE_FRAMES];
+	profile_slot_write_begin(slot);
+	slot->record = g_profile_current;
+	profile_slot_write_end(slot);
+	atomic_store_explicit(&g_profile_published, frame, memory_order_release);
+
+	memset(&g_profile_current, 0, sizeof(frame_record));
+
+	// The new record has to be drawn, or a window that only presents damaged frames would show the last one it drew
+	for (unsigned i = 0; i < g_profile_n_watchers; ++i)
+		if (((widget_t*) g_profile_watchers[i])->parent)
+			invalidate_widget(g_profile_watchers[i]);
+}
+
+int profile_watch(void *widget) {
+	if (g_profile_n_watchers == VS_PROFILE_WATCHERS)
+		vs_err(VS_FAILURE);
+	g_profile_watchers[g_profile_n_watchers++] = widget;
+	return VS_SUCCESS;
+}
+
+void profile_unwatch(void *widget) {
+	for (unsigned i = 0; i < g_profile_n_watchers; ++i) {
+		if (g_profile_watchers[i] == widget) {
+			g_profile_watchers[i] = g_profile_watchers[--g_profile_n_watchers];
+			return;
+		}
+	}
+}
+
+unsigned long profile_frame() {
+	return atomic_load_explicit(&g_profile_published, memory_order_relaxed) + 1;
+}
+
+/*
+ * GPU results arrive frames after their record was published, so they are patched into the ring if it still holds the
+ * frame.
+ */
+static void profile_gpu_result(unsigned long frame, unsigned long ns) {
+	if (frame == profile_frame()) {
+		g_profile_current.gpu_ns = ns;
+		return;
+	}
+	profile_slot *slot = &g_profile_ring[frame % VS_PROFILE_FRAMES];
+	if (slot->record.frame != frame)
+		return;
+	profile_slot_write_begin(slot);
+	slot->record.gpu_ns = ns;
+	profile_slot_write_end(slot);
+}
+
+int venus_enable_profiler(int enabled) {
+	if (enabled && !atomic_load(&g_profile_enabled)) {
+		memset(&g_profile_current, 0, sizeof(frame_record));
+		memset(g_profile_started, 0, sizeof(g_profile_started));
+	}
+	atomic_store(&g_profile_enabled, !!enabled);
+	return VS_SUCCESS;
+}
+
+unsigned venus_get_frame_records(frame_record *records, unsigned n) {
+	if (n > VS_PROFILE_FRAMES)
+		n = VS_PROFILE_FRAMES;
+
+	unsigned long last = atomic_load_explicit(&g_profile_published, memory_order_acquire);
+	unsigned long first = last >= n ? last - n + 1 : 1;
+
+	unsigned copied = 0;
+	for (unsigned long frame = first; frame <= last; ++frame) {
+		profile_slot *slot = &g_profile_ring[frame % VS_PROFILE_FRAMES];
+		for (;;) {
+			unsigned long before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+			if (before & 1)
+				continue;
+			records[copied] = slot->record;
+			atomic_thread_fence(memory_order_acquire);
+			if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) == before)
+				break;
+		}
+		// The writer lapped us and this slot now holds a newer frame
+		if (records[copied].frame == frame)
+			copied++;
+	}
+	return copied;
+}
+
+void gl_profile_gpu_begin(gpu_timer *timer) {
+	if (!atomic_load_explicit(&g_profile_enabled, memory_order_relaxed))
+		return;
+	if (!timer->queries[0])
+		glGenQueries(VS_PROFILE_GPU_QUERIES, timer->queries);
+
+	unsigned index = timer->next;
+	if (timer->pending & (1u << index))
+		return;
+
+	glBeginQuery(GL_TIME_ELAPSED, timer->queries[index]);
+	timer->frames[index] = profile_frame();
+	timer->running = VS_TRUE;
+}
+
+void gl_profile_gpu_end(gpu_timer *timer) {
+	if (!timer->running)
+		return;
+	glEndQuery(GL_TIME_ELAPSED);
+	timer->pending |= 1u << timer->next;
+	timer->next = (timer->next + 1) % VS_PROFILE_GPU_QUERIES;
+	timer->running = VS_FALSE;
+}
+
+void gl_profile_gpu_poll(gpu_timer *timer) {
+	for (unsigned i = 0; i < VS_PROFILE_GPU_QUERIES; ++i) {
+		if (!(timer->pending & (1u << i)))
+			continue;
+
+		int available = 0;
+		glGetQueryObjectiv(timer->queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(timer->queries[i], GL_QUERY_RESULT, &ns);
+		timer->pending &= ~(1u << i);
+		profile_gpu_result(timer->frames[i], ns);
+	}
+}
+
+void gl_profile_gpu_destroy(gpu_timer *timer) {
+	if (timer->queries[0])
+		glDeleteQueries(VS_PROFILE_GPU_QUERIES, timer->queries);
+	memset(timer, 0, sizeof(gpu_timer));
+}
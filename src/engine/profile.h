@@ -0,0 +1,121 @@
+/**
+ * @file profile.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Frame profiler behind venus_enable_profiler() and venus_get_frame_records()
+ *
+ * Phases are stamped with CLOCK_MONOTONIC on the thread that draws. Finished frames go into a ring of records guarded by
+ * per-record sequence counters, so readers on other threads never take a lock and never block the drawing thread.
+ */
+
+#ifndef VS_PROFILE_H
+#define VS_PROFILE_H
+
+#include <stdatomic.h>
+
+#include "../venus.h"
+
+/// Number of GPU timer queries in flight per window
+#define VS_PROFILE_GPU_QUERIES	4
+
+/// Most widgets that can watch the frame records at once
+#define VS_PROFILE_WATCHERS		8
+
+/// Set while the profiler is on
+extern atomic_int g_profile_enabled;
+
+/**
+ * @brief GPU timer queries of one GL context
+ */
+typedef struct {
+	unsigned queries[VS_PROFILE_GPU_QUERIES];
+	unsigned long frames[VS_PROFILE_GPU_QUERIES];
+	unsigned pending;
+	unsigned next;
+	int running;
+} gpu_timer;
+
+/**
+ * @brief Gets the CLOCK_MONOTONIC time
+ *
+ * @return Returns the time in nanoseconds
+ */
+unsigned long profile_now();
+
+/**
+ * @brief Starts timing a phase of the current frame
+ *
+ * @param phase One of VS_PROFILE_EVENTS, VS_PROFILE_LAYOUT, VS_PROFILE_RECORD, VS_PROFILE_SUBMIT or VS_PROFILE_SWAP
+ */
+void profile_begin(unsigned phase);
+
+/**
+ * @brief Stops timing a phase of the current frame
+ *
+ * @param phase The phase given to profile_begin()
+ */
+void profile_end(unsigned phase);
+
+/**
+ * @brief Finishes the current frame and publishes its record
+ */
+void profile_frame_end();
+
+/**
+ * @brief Has a widget invalidated whenever a frame record is published
+ *
+ * Widgets that draw the records, such as profile overlays, watch them so that they keep up even when only damaged frames
+ * are presented. Watchers that are not in a tree are skipped.
+ *
+ * @param widget Widget to invalidate
+ *
+ * @return Returns whether it was successful or not. It fails when VS_PROFILE_WATCHERS widgets already watch.
+ */
+int profile_watch(void *widget);
+
+/**
+ * @brief Stops invalidating a widget given to profile_watch()
+ *
+ * @param widget Widget to stop invalidating
+ */
+void profile_unwatch(void *widget);
+
+/**
+ * @brief Gets the number of the frame being timed
+ *
+ * @return Returns the frame number
+ */
+unsigned long profile_frame();
+
+/**
+ * @brief Starts a GPU timer query for the current frame
+ *
+ * If every query is still waiting for its result, the frame is simply not timed on the GPU.
+ *
+ * @param timer Pointer to the GPU timer of the current context
+ */
+void gl_profile_gpu_begin(gpu_timer *timer);
+
+/**
+ * @brief Ends the GPU timer query started by gl_profile_gpu_begin()
+ *
+ * @param timer Pointer to the GPU timer of the current context
+ */
+void gl_profile_gpu_end(gpu_timer *timer);
+
+/**
+ * @brief Collects the results of finished GPU timer queries without waiting for unfinished ones
+ *
+ * @param timer Pointer to the GPU timer of the current context
+ */
+void gl_profile_gpu_poll(gpu_timer *timer);
+
+/**
+ * @brief Deletes the queries of a GPU timer
+ *
+ * @param timer Pointer to the GPU timer of the current context
+ */
+void gl_profile_gpu_destroy(gpu_timer *timer);
+
+#endif
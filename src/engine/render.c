@@ -0,0 +1,556 @@
+/**
+ * @file render.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "render.h"
+
+#include <glad/glad.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "../venus_common.h"
+#include "graphics.h"
+#include "effects.h"
+#include "glstate.h"
+#include "memory.h"
+
+static int render_reserve(render_list *list, unsigned n_cmds, unsigned n_vertices) {
+	if (list->n_cmds + n_cmds > list->cmd_capacity) {
+		unsigned capacity = list->cmd_capacity ? list->cmd_capacity * 2 : 64;
+		while (capacity < list->n_cmds + n_cmds)
+			capacity *= 2;
+		render_cmd *cmds = memory_realloc(VS_MEMORY_RENDER, list->cmds, sizeof(render_cmd) * capacity);
+		if (!cmds)
+			return VS_FAILURE;
+		list->cmds = cmds;
+		list->cmd_capacity = capacity;
+	}
+	if (list->n_vertices + n_vertices > list->vertex_capacity) {
+		unsigned capacity = list->vertex_capacity ? list->vertex_capacity * 2 : 384;
+		while (capacity < list->n_vertices + n_vertices)
+			capacity *= 2;
+		render_vertex *vertices = memory_realloc(VS_MEMORY_RENDER, list->vertices, sizeof(render_vertex) * capacity);
+		if (!vertices)
+			return VS_FAILURE;
+		list->vertices = vertices;
+		list->vertex_capacity = capacity;
+	}
+	return VS_SUCCESS;
+}
+
+/*
+ * Adds a command for vertices that were just appended, merging it into the last command when the state matches
+ */
+static void render_append_cmd(render_list *list, const render_cmd *cmd) {
+	if (list->n_cmds && cmd->kind == VS_RENDER_DRAW) {
+		render_cmd *last = &list->cmds[list->n_cmds - 1];
+		if (last->kind == VS_RENDER_DRAW && last->texture == cmd->texture && last->stencil == cmd->stencil &&
+			last->premultiplied == cmd->premultiplied && last->first + last->count == cmd->first) {
+			last->count += cmd->count;
+			return;
+		}
+	}
+	list->cmds[list->n_cmds++] = *cmd;
+}
+
+/*
+ * Cuts one axis of a quad to [lo, hi], moving its texture coordinates along with it
+ */
+static void render_clip_span(float *a0, float *a1, float *t0, float *t1, float lo, float hi) {
+	float a = *a0;
+	float b = *a1;
+	float s = *t0;
+	float t = *t1;
+	if (a < lo) {
+		*a0 = lo;
+		*t0 = s + (t - s) * (lo - a) / (b - a);
+	}
+	if (b > hi) {
+		*a1 = hi;
+		*t1 = s + (t - s) * (hi - a) / (b - a);
+	}
+}
+
+/*
+ * Cuts a convex polygon to the side of an axis aligned line where (point[axis] - limit) * sign is not negative. Each cut
+ * adds at most one point.
+ */
+static unsigned render_clip_polygon(float (*in)[2], unsigned n, float (*out)[2], unsigned axis, float limit, float sign) {
+	if (!n)
+		return 0;
+	unsigned m = 0;
+	for (unsigned i = 0; i < n; ++i) {
+		const float *a = in[i];
+		const float *b = in[(i + 1) % n];
+		float da = (a[axis] - limit) * sign;
+		float db = (b[axis] - limit) * sign;
+		if (da >= 0) {
+			out[m][0] = a[0];
+			out[m][1] = a[1];
+			m++;
+		}
+		if ((da >= 0) != (db >= 0)) {
+			float t = da / (da - db);
+			out[m][0] = a[0] + (b[0] - a[0]) * t;
+			out[m][1] = a[1] + (b[1] - a[1]) * t;
+			m++;
+		}
+	}
+	return m;
+}
+
+void render_list_init(render_list *list) {
+	memset(list, 0, sizeof(render_list));
+}
+
+void render_list_clear(render_list *list) {
+	list->n_cmds = 0;
+	list->n_vertices = 0;
+	list->clipping = VS_FALSE;
+	list->stencil = 0;
+	list->tinting = VS_FALSE;
+}
+
+void render_list_free(render_list *list) {
+	memory_free(VS_MEMORY_RENDER, list->cmds);
+	memory_free(VS_MEMORY_RENDER, list->vertices);
+	render_list_init(list);
+}
+
+void render_set_clip(render_list *list, const int *rect, unsigned stencil) {
+	list->clipping = rect != NULL;
+	if (rect)
+		for (unsigned i = 0; i < 4; ++i)
+			list->clip[i] = (float) rect[i];
+	list->stencil = stencil;
+}
+
+void render_set_tint(render_list *list, const unsigned char *rgba) {
+	static const unsigned char white[] = {255, 255, 255, 255};
+	list->tinting = rgba && memcmp(rgba, white, 4);
+	if (list->tinting)
+		memcpy(list->tint, rgba, 4);
+}
+
+int render_push_clip_shape(render_list *list, unsigned kind, float x, float y, float width, float height, float radius) {
+	const unsigned n_points = 4 * (VS_RENDER_CORNER_SEGMENTS + 1);
+	if (!render_reserve(list, 1, n_points * 3))
+		return VS_FAILURE;
+
+	if (radius > width / 2.0f)
+		radius = width / 2.0f;
+	if (radius > height / 2.0f)
+		radius = height / 2.0f;
+
+	// Corner centers clockwise from the top right, each swept through a quarter turn
+	const float centers[4][2] = {
+		{x + width - radius,	y + radius},
+		{x + width - radius,	y + height - radius},
+		{x + radius,			y + height - radius},
+		{x + radius,			y + radius}
+	};
+	float points[4 * (VS_RENDER_CORNER_SEGMENTS + 1)][2];
+	for (unsigned c = 0; c < 4; ++c) {
+		for (unsigned i = 0; i <= VS_RENDER_CORNER_SEGMENTS; ++i) {
+			float angle = (float) M_PI * 0.5f * ((float) c - 1.0f + (float) i / VS_RENDER_CORNER_SEGMENTS);
+			points[c * (VS_RENDER_CORNER_SEGMENTS + 1) + i][0] = centers[c][0] + cosf(angle) * radius;
+			points[c * (VS_RENDER_CORNER_SEGMENTS + 1) + i][1] = centers[c][1] + sinf(angle) * radius;
+		}
+	}
+
+	static const unsigned char white[] = {255, 255, 255, 255};
+	const float center[2] = {x + width / 2.0f, y + height / 2.0f};
+	render_cmd cmd = {0, list->n_vertices, n_points * 3, list->stencil, kind};
+	for (unsigned i = 0; i < n_points; ++i) {
+		const float *triangle[3] = {center, points[i], points[(i + 1) % n_points]};
+		for (unsigned v = 0; v < 3; ++v) {
+			render_vertex *vertex = &list->vertices[list->n_vertices++];
+			vertex->x = triangle[v][0];
+			vertex->y = triangle[v][1];
+			vertex->u = 0.0f;
+			vertex->v = 0.0f;
+			memcpy(vertex->rgba, white, 4);
+		}
+	}
+	render_append_cmd(list, &cmd);
+	return VS_SUCCESS;
+}
+
+static int render_quad(render_list *list, float x, float y, float width, float height, const unsigned char *rgba,
+	unsigned texture, const float *uv, unsigned kind, unsigned premultiplied) {
+
+	static const float full[] = {0.0f, 0.0f, 1.0f, 1.0f};
+	if (!uv)
+		uv = full;
+
+	float x0 = x;
+	float y0 = y;
+	float x1 = x + width;
+	float y1 = y + height;
+	float u0 = uv[0];
+	float v0 = uv[1];
+	float u1 = uv[2];
+	float v1 = uv[3];
+	if (list->clipping) {
+		const float *clip = list->clip;
+		if (x0 >= clip[2] || x1 <= clip[0] || y0 >= clip[3] || y1 <= clip[1] || x1 <= x0 || y1 <= y0)
+			return VS_SUCCESS;
+		render_clip_span(&x0, &x1, &u0, &u1, clip[0], clip[2]);
+		render_clip_span(&y0, &y1, &v0, &v1, clip[1], clip[3]);
+	}
+
+	if (!render_reserve(list, 1, 6))
+		return VS_FAILURE;
+
+	unsigned char tinted[4];
+	if (list->tinting) {
+		for (unsigned i = 0; i < 4; ++i)
+			tinted[i] = (unsigned char) ((rgba[i] * list->tint[i] + 127) / 255);
+		rgba = tinted;
+	}
+	unsigned char multiplied[4];
+	if (premultiplied) {
+		for (unsigned i = 0; i < 3; ++i)
+			multiplied[i] = (unsigned char) ((rgba[i] * rgba[3] + 127) / 255);
+		multiplied[3] = rgba[3];
+		rgba = multiplied;
+	}
+
+	const float corners[6][4] = {
+		{x0, y0, u0, v0},
+		{x1, y0, u1, v0},
+		{x0, y1, u0, v1},
+		{x1, y0, u1, v0},
+		{x1, y1, u1, v1},
+		{x0, y1, u0, v1}
+	};
+
+	unsigned first = list->n_vertices;
+	for (unsigned i = 0; i < 6; ++i) {
+		render_vertex *vertex = &list->vertices[first + i];
+		vertex->x = corners[i][0];
+		vertex->y = corners[i][1];
+		vertex->u = corners[i][2];
+		vertex->v = corners[i][3];
+		memcpy(vertex->rgba, rgba, 4);
+	}
+	list->n_vertices += 6;
+
+	render_cmd cmd = {texture, first, 6, list->stencil, kind, premultiplied};
+	render_append_cmd(list, &cmd);
+	return VS_SUCCESS;
+}
+
+int render_push_quad(render_list *list, float x, float y, float width, float height, const unsigned char *rgba,
+	unsigned texture, const float *uv) {
+	return render_quad(list, x, y, width, height, rgba, texture, uv, VS_RENDER_DRAW, VS_FALSE);
+}
+
+int render_push_premultiplied(render_list *list, float x, float y, float width, float height,
+	const unsigned char *rgba, unsigned texture, const float *uv) {
+	return render_quad(list, x, y, width, height, rgba, texture, uv, VS_RENDER_DRAW, VS_TRUE);
+}
+
+int render_push_backdrop(render_list *list, float x, float y, float width, float height, unsigned blur,
+	const unsigned char *rgba) {
+	return render_quad(list, x, y, width, height, rgba, blur, NULL, VS_RENDER_BACKDROP, VS_FALSE);
+}
+
+int render_push_mesh(render_list *list, const float *positions, unsigned n_vertices, const float *bounds, float x,
+	float y, float scale, const unsigned char *rgba) {
+
+	const float *clip = list->clip;
+	int cut = VS_FALSE;
+	if (list->clipping) {
+		float x0 = x + bounds[0] * scale;
+		float y0 = y + bounds[1] * scale;
+		float x1 = x + bounds[2] * scale;
+		float y1 = y + bounds[3] * scale;
+		if (x0 >= clip[2] || x1 <= clip[0] || y0 >= clip[3] || y1 <= clip[1])
+			return VS_SUCCESS;
+		cut = x0 < clip[0] || y0 < clip[1] || x1 > clip[2] || y1 > clip[3];
+	}
+
+	// A cut triangle is a polygon of up to seven points, which fans out into five triangles
+	n_vertices -= n_vertices % 3;
+	if (!n_vertices || !render_reserve(list, 1, cut ? n_vertices * 5 : n_vertices))
+		return n_vertices ? VS_FAILURE : VS_SUCCESS;
+
+	unsigned char tinted[4];
+	if (list->tinting) {
+		for (unsigned i = 0; i < 4; ++i)
+			tinted[i] = (unsigned char) ((rgba[i] * list->tint[i] + 127) / 255);
+		rgba = tinted;
+	}
+
+	unsigned first = list->n_vertices;
+	render_vertex *vertex = &list->vertices[first];
+	for (unsigned t = 0; t < n_vertices; t += 3) {
+		float polygon[7][2];
+		float scratch[7][2];
+		for (unsigned v = 0; v < 3; ++v) {
+			polygon[v][0] = x + positions[(t + v) * 2] * scale;
+			polygon[v][1] = y + positions[(t + v) * 2 + 1] * scale;
+		}
+		unsigned n = 3;
+		if (cut) {
+			n = render_clip_polygon(polygon, n, scratch, 0, clip[0], 1.0f);
+			n = render_clip_polygon(scratch, n, polygon, 0, clip[2], -1.0f);
+			n = render_clip_polygon(polygon, n, scratch, 1, clip[1], 1.0f);
+			n = render_clip_polygon(scratch, n, polygon, 1, clip[3], -1.0f);
+		}
+		for (unsigned i = 1; i + 1 < n; ++i) {
+			const unsigned corners[3] = {0, i, i + 1};
+			for (unsigned c = 0; c < 3; ++c) {
+				vertex->x = polygon[corners[c]][0];
+				vertex->y = polygon[corners[c]][1];
+				vertex->u = 0.0f;
+				vertex->v = 0.0f;
+				memcpy(vertex->rgba, rgba, 4);
+				vertex++;
+			}
+		}
+	}
+	list->n_vertices = (unsigned) (vertex - list->vertices);
+	if (list->n_vertices == first)
+		return VS_SUCCESS;
+
+	render_cmd cmd = {0, first, list->n_vertices - first, list->stencil, VS_RENDER_DRAW};
+	render_append_cmd(list, &cmd);
+	return VS_SUCCESS;
+}
+
+int render_list_merge(render_list *dest, render_list *slices, unsigned n_slices) {
+	unsigned n_cmds = 0;
+	unsigned n_vertices = 0;
+	for (unsigned i = 0; i < n_slices; ++i) {
+		n_cmds += slices[i].n_cmds;
+		n_vertices += slices[i].n_vertices;
+	}
+	if (!render_reserve(dest, n_cmds, n_vertices))
+		return VS_FAILURE;
+
+	for (unsigned i = 0; i < n_slices; ++i) {
+		render_list *slice = &slices[i];
+		unsigned base = dest->n_vertices;
+
+		memcpy(dest->vertices + base, slice->vertices, sizeof(render_vertex) * slice->n_vertices);
+		dest->n_vertices += slice->n_vertices;
+
+		for (unsigned c = 0; c < slice->n_cmds; ++c) {
+			render_cmd cmd = slice->cmds[c];
+			cmd.first += base;
+			render_append_cmd(dest, &cmd);
+		}
+	}
+	return VS_SUCCESS;
+}
+
+int render_list_equal(render_list *a, render_list *b) {
+	if (a->n_cmds != b->n_cmds || a->n_vertices != b->n_vertices)
+		return VS_FALSE;
+	if (memcmp(a->cmds, b->cmds, sizeof(render_cmd) * a->n_cmds))
+		return VS_FALSE;
+	if (memcmp(a->vertices, b->vertices, sizeof(render_vertex) * a->n_vertices))
+		return VS_FALSE;
+	return VS_TRUE;
+}
+
+void render_recorder_init(render_recorder *recorder) {
+	memset(recorder, 0, sizeof(render_recorder));
+}
+
+void render_recorder_free(render_recorder *recorder) {
+	for (unsigned i = 0; i < recorder->n_slices; ++i)
+		render_list_free(&recorder->slices[i]);
+	memory_free(VS_MEMORY_RENDER, recorder->slices);
+	memory_free(VS_MEMORY_RENDER, recorder->nodes);
+	render_recorder_init(recorder);
+}
+
+int gl_render_init(render_context *ctx) {
+	const char *vsh_src = "#version 450 core\n"
+			"layout (location = 0) in vec2 position;\n"
+			"layout (location = 1) in vec2 uv;\n"
+			"layout (location = 2) in vec4 rgba;\n"
+			"uniform vec2 viewport;\n"
+			"out vec2 fragment_uv;\n"
+			"out vec4 fragment_rgba;\n"
+			"void main() {\n"
+			"	gl_Position = vec4(position.x / viewport.x * 2.0 - 1.0, 1.0 - position.y / viewport.y * 2.0, 0.0, 1.0);\n"
+			"	fragment_uv = uv;\n"
+			"	fragment_rgba = rgba;\n"
+			"}\0";
+
+	const char *fsh_src = "#version 450 core\n"
+			"in vec2 fragment_uv;\n"
+			"in vec4 fragment_rgba;\n"
+			"uniform sampler2D sampler;\n"
+			"out vec4 fragment_color;\n"
+			"void main() {\n"
+			"	fragment_color = texture(sampler, fragment_uv) * fragment_rgba;\n"
+			"}\0";
+
+	unsigned vsh = gl_create_shader(GL_VERTEX_SHADER, &vsh_src);
+	unsigned fsh = gl_create_shader(GL_FRAGMENT_SHADER, &fsh_src);
+	if (!vsh || !fsh) {
+		glDeleteShader(vsh);
+		glDeleteShader(fsh);
+		return VS_FAILURE;
+	}
+
+	ctx->program = gl_create_program(vsh, fsh);
+	if (!ctx->program)
+		return VS_FAILURE;
+	ctx->viewport_location = glGetUniformLocation(ctx->program, "viewport");
+
+	glGenVertexArrays(1, &ctx->vao);
+	gl_bind_vertex_array(ctx->vao);
+	glGenBuffers(1, &ctx->vbo);
+	gl_bind_buffer(GL_ARRAY_BUFFER, ctx->vbo);
+	ctx->vbo_capacity = 0;
+	memory_gpu_alloc(VS_MEMORY_GL_BUFFERS, 0);
+
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(render_vertex), (void*) offsetof(render_vertex, x));
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(render_vertex), (void*) offsetof(render_vertex, u));
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(render_vertex), (void*) offsetof(render_vertex, rgba));
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	// Solid quads sample a white texel so one program can draw everything
+	const unsigned char white[] = {255, 255, 255, 255};
+	glGenTextures(1, &ctx->white_texture);
+	gl_bind_texture(0, ctx->white_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	memory_gpu_alloc(VS_MEMORY_TEXTURES, sizeof(white));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	return VS_SUCCESS;
+}
+
+void gl_render_destroy(render_context *ctx) {
+	if (ctx->vao) {
+		memory_gpu_free(VS_MEMORY_TEXTURES, 4);
+		memory_gpu_free(VS_MEMORY_GL_BUFFERS, ctx->vbo_capacity);
+	}
+	gl_delete_textures(1, &ctx->white_texture);
+	gl_delete_buffers(1, &ctx->vbo);
+	gl_delete_vertex_arrays(1, &ctx->vao);
+	gl_delete_program(ctx->program);
+	memset(ctx, 0, sizeof(render_context));
+}
+
+/*
+ * Blurs what was drawn behind a backdrop and points the backdrop's vertices at the result. Returns the texture to draw
+ * the backdrop with, or 0 to draw it as a plain quad.
+ */
+static unsigned render_backdrop(render_context *ctx, render_list *list, const render_cmd *cmd, unsigned width,
+	unsigned height) {
+	if (!ctx->effects || cmd->count != 6)
+		return 0;
+
+	// The first and fifth corners of a quad are its top left and bottom right
+	const render_vertex *quad = &list->vertices[cmd->first];
+	int blur = (int) cmd->texture;
+	int left = (int) floorf(quad[0].x) - blur;
+	int top = (int) floorf(quad[0].y) - blur;
+	int right = (int) ceilf(quad[4].x) + blur;
+	int bottom = (int) ceilf(quad[4].y) + blur;
+	left = left < 0 ? 0 : left;
+	top = top < 0 ? 0 : top;
+	right = right > (int) width ? (int) width : right;
+	bottom = bottom > (int) height ? (int) height : bottom;
+	if (right <= left || bottom <= top)
+		return 0;
+
+	// Framebuffers are bottom up
+	int rect[] = {left, (int) height - bottom, right - left, bottom - top};
+	unsigned target = g_gl_state->framebuffer;
+	float uv[4];
+	unsigned texture = gl_effect_backdrop(ctx->effects, rect, cmd->texture, uv);
+
+	gl_bind_framebuffer(target);
+	gl_viewport(0, 0, width, height);
+	gl_use_program(ctx->program);
+	gl_bind_vertex_array(ctx->vao);
+	gl_bind_buffer(GL_ARRAY_BUFFER, ctx->vbo);
+	gl_set_blend(VS_TRUE);
+	if (!texture)
+		return 0;
+
+	render_vertex moved[6];
+	for (unsigned i = 0; i < 6; ++i) {
+		moved[i] = quad[i];
+		moved[i].u = uv[0] + (quad[i].x - rect[0]) / rect[2] * (uv[2] - uv[0]);
+		moved[i].v = uv[1] + (height - quad[i].y - rect[1]) / rect[3] * (uv[3] - uv[1]);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(render_vertex) * cmd->first, sizeof(moved), moved);
+	return texture;
+}
+
+int gl_render_submit(render_context *ctx, render_list *list, unsigned width, unsigned height) {
+	if (!list->n_cmds)
+		return VS_SUCCESS;
+	VS_TRACE_SCOPE("gl_render_submit");
+
+	gl_bind_vertex_array(ctx->vao);
+	gl_bind_buffer(GL_ARRAY_BUFFER, ctx->vbo);
+
+	// Orphan the old storage so the driver does not have to wait for the last frame to finish with it
+	unsigned bytes = sizeof(render_vertex) * list->n_vertices;
+	if (bytes > ctx->vbo_capacity) {
+		memory_gpu_resize(VS_MEMORY_GL_BUFFERS, ctx->vbo_capacity, bytes * 2);
+		ctx->vbo_capacity = bytes * 2;
+	}
+	glBufferData(GL_ARRAY_BUFFER, ctx->vbo_capacity, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, list->vertices);
+
+	gl_use_program(ctx->program);
+	if (ctx->viewport[0] != width || ctx->viewport[1] != height) {
+		ctx->viewport[0] = width;
+		ctx->viewport[1] = height;
+		glUniform2f(ctx->viewport_location, (float) width, (float) height);
+	}
+	gl_viewport(0, 0, width, height);
+	gl_set_blend(VS_TRUE);
+
+	for (unsigned i = 0; i < list->n_cmds; ++i) {
+		render_cmd *cmd = &list->cmds[i];
+		unsigned texture = cmd->texture;
+		if (cmd->kind == VS_RENDER_BACKDROP)
+			texture = render_backdrop(ctx, list, cmd, width, height);
+		if (cmd->kind == VS_RENDER_DRAW || cmd->kind == VS_RENDER_BACKDROP) {
+			gl_set_stencil_test(cmd->stencil != 0);
+			if (cmd->stencil) {
+				gl_stencil_func(GL_EQUAL, cmd->stencil);
+				gl_stencil_op(GL_KEEP);
+			}
+			gl_color_mask(VS_TRUE);
+
+			// Alpha is blended as coverage, so what is drawn into a transparent layer ends up premultiplied
+			if (cmd->premultiplied)
+				gl_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			else
+				gl_blend_func_separate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		} else {
+			// Only fragments inside every enclosing clip move the stencil, so nested clips intersect
+			int push = cmd->kind == VS_RENDER_CLIP_PUSH;
+			gl_set_stencil_test(VS_TRUE);
+			gl_stencil_func(GL_EQUAL, cmd->stencil - push);
+			gl_stencil_op(push ? GL_INCR : GL_DECR);
+			gl_color_mask(VS_FALSE);
+		}
+		gl_bind_texture(0, texture ? texture : ctx->white_texture);
+		glDrawArrays(GL_TRIANGLES, cmd->first, cmd->count);
+	}
+	gl_set_stencil_test(VS_FALSE);
+	gl_color_mask(VS_TRUE);
+	return VS_SUCCESS;
+}
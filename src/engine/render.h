@@ -0,0 +1,359 @@
+/**
+ * @file render.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Render lists that widgets record into and the GL code that submits them
+ *
+ * Recording a render list does not touch OpenGL, so any thread can record one. Only gl_render_submit() needs the
+ * window's GL context.
+ */
+
+#ifndef VS_RENDER_H
+#define VS_RENDER_H
+
+/**
+ * @brief A single vertex in a render list
+ *
+ * Positions are in window pixels with the origin at the top left corner.
+ */
+typedef struct {
+	float x;
+	float y;
+	float u;
+	float v;
+	unsigned char rgba[4];
+} render_vertex;
+
+/*
+ * Kinds of render commands. Clip commands draw the shape of a rounded clip into the stencil buffer, leaving the color
+ * buffer alone. A backdrop draws a blurred copy of what is behind it.
+ */
+#define VS_RENDER_DRAW				0
+#define VS_RENDER_CLIP_PUSH			1
+#define VS_RENDER_CLIP_POP			2
+#define VS_RENDER_BACKDROP			3
+
+/// Segments each corner of a rounded clip is drawn with
+#define VS_RENDER_CORNER_SEGMENTS	8
+
+/// Most rounded clips that can be nested, which is what fits in the 8 bit stencil buffer
+#define VS_RENDER_MAX_STENCIL		255
+
+/**
+ * @brief A run of triangles that share the same state
+ */
+typedef struct {
+	/// GL texture to sample, or 0 for solid color. Backdrops keep their blur radius in pixels here instead.
+	unsigned texture;
+
+	/// Index of the first vertex
+	unsigned first;
+
+	/// Number of vertices
+	unsigned count;
+
+	/// Number of rounded clips the command is inside, which the stencil buffer has to equal for it to draw
+	unsigned stencil;
+
+	/// VS_RENDER_DRAW, VS_RENDER_CLIP_PUSH, VS_RENDER_CLIP_POP or VS_RENDER_BACKDROP
+	unsigned kind;
+
+	/// Set when the texture's color is already multiplied by its alpha, as in layers
+	unsigned premultiplied;
+} render_cmd;
+
+/**
+ * @brief A list of draw commands and the vertices they use
+ *
+ * Consecutive commands that share the same state are merged as they are recorded, so the number of commands is the
+ * number of draw calls gl_render_submit() will make.
+ */
+typedef struct {
+	unsigned n_cmds;
+	unsigned cmd_capacity;
+	render_cmd *cmds;
+
+	unsigned n_vertices;
+	unsigned vertex_capacity;
+	render_vertex *vertices;
+
+	/// Rectangle quads are cut to as {x0, y0, x1, y1}, if clipping is set
+	float clip[4];
+	int clipping;
+
+	/// Stencil value of the commands being recorded
+	unsigned stencil;
+
+	/// Color quads are multiplied by, if tinting is set
+	unsigned char tint[4];
+	int tinting;
+} render_list;
+
+/**
+ * @brief GL objects used to submit render lists
+ *
+ * GL objects belong to a context, so each window has its own.
+ */
+typedef struct {
+	unsigned program;
+	unsigned vao;
+	unsigned vbo;
+	unsigned vbo_capacity;
+	unsigned white_texture;
+	int viewport_location;
+
+	/// Viewport size last given to the program, so the uniform is only set when it changes
+	unsigned viewport[2];
+
+	/// Blurs backdrops, or NULL to draw them as plain quads
+	struct effect_cache *effects;
+} render_context;
+
+/**
+ * @brief A widget scheduled to be recorded, with its absolute position
+ */
+typedef struct {
+	void *widget;
+	int x;
+	int y;
+
+	/// Cached layer drawn in place of the widget and its children, or NULL
+	void *layer;
+
+	/// Rectangle the widget is clipped to by its ancestors, as {x0, y0, x1, y1}
+	int clip[4];
+
+	/// Number of rounded clips the widget is inside
+	unsigned stencil;
+
+	/// VS_RENDER_DRAW for the widget itself, or VS_RENDER_CLIP_PUSH and VS_RENDER_CLIP_POP around its clipped children
+	unsigned kind;
+
+	/// Tint of the widget and its ancestors, multiplied together
+	unsigned char tint[4];
+} render_node;
+
+/**
+ * @brief Scratch state used to record a widget tree, kept between frames so its memory can be reused
+ */
+typedef struct {
+	/// Number of threads to record with. 0 or 1 records everything on the calling thread.
+	unsigned n_threads;
+
+	/// Set when the target has a stencil buffer for rounded clips to use
+	int stencil;
+
+	/// Widgets in drawing order
+	unsigned n_nodes;
+	unsigned node_capacity;
+	render_node *nodes;
+
+	/// One render list per slice of nodes
+	unsigned n_slices;
+	render_list *slices;
+} render_recorder;
+
+/**
+ * @brief Initializes an empty render list
+ *
+ * @param list Pointer to render list
+ */
+void render_list_init(render_list *list);
+
+/**
+ * @brief Empties a render list without releasing its memory
+ *
+ * @param list Pointer to render list
+ */
+void render_list_clear(render_list *list);
+
+/**
+ * @brief Releases the memory held by a render list
+ *
+ * @param list Pointer to render list
+ */
+void render_list_free(render_list *list);
+
+/**
+ * @brief Sets the clip of everything recorded after it
+ *
+ * Quads are cut to the rectangle as they are recorded, with their texture coordinates adjusted to match, and quads
+ * outside of it are dropped. Clipping a rectangle never adds a draw call.
+ *
+ * @param list Pointer to render list
+ * @param rect Clip rectangle as {x0, y0, x1, y1} in pixels, or NULL for none
+ * @param stencil Number of rounded clips the commands are inside
+ */
+void render_set_clip(render_list *list, const int *rect, unsigned stencil);
+
+/**
+ * @brief Sets the color everything recorded after it is multiplied by
+ *
+ * Tinting is done to the vertex colors as quads are recorded, so it never adds a draw call either.
+ *
+ * @param list Pointer to render list
+ * @param rgba Color to multiply by, or NULL for none
+ */
+void render_set_tint(render_list *list, const unsigned char *rgba);
+
+/**
+ * @brief Records the shape of a rounded clip into the stencil buffer, or takes it back out
+ *
+ * A push raises the stencil inside the shape from the list's stencil value minus one to the list's stencil value, and a
+ * pop lowers it back, so both are recorded with the stencil value inside the clip.
+ *
+ * @param list Pointer to render list
+ * @param kind VS_RENDER_CLIP_PUSH or VS_RENDER_CLIP_POP
+ * @param x Left edge in pixels
+ * @param y Top edge in pixels
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param radius Corner radius in pixels
+ *
+ * @return Returns whether it was successful or not
+ */
+int render_push_clip_shape(render_list *list, unsigned kind, float x, float y, float width, float height, float radius);
+
+/**
+ * @brief Records a textured quad
+ *
+ * @param list Pointer to render list
+ * @param x Left edge in pixels
+ * @param y Top edge in pixels
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param rgba Color the texture is multiplied by
+ * @param texture GL texture, or 0 for a solid quad
+ * @param uv Texture coordinates as {u0, v0, u1, v1}, or NULL for the whole texture
+ *
+ * @return Returns whether it was successful or not
+ */
+int render_push_quad(render_list *list, float x, float y, float width, float height, const unsigned char *rgba,
+	unsigned texture, const float *uv);
+
+/**
+ * @brief Records a quad whose texture holds premultiplied color
+ *
+ * Render lists are drawn into layers premultiplied, so that translucent content is not multiplied by its alpha a
+ * second time when the layer is drawn. This is how layers are drawn.
+ *
+ * @param list Pointer to render list
+ * @param x Left edge in pixels
+ * @param y Top edge in pixels
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param rgba Color the texture is multiplied by, which is premultiplied here along with the tint
+ * @param texture GL texture
+ * @param uv Texture coordinates as {u0, v0, u1, v1}, or NULL for the whole texture
+ *
+ * @return Returns whether it was successful or not
+ */
+int render_push_premultiplied(render_list *list, float x, float y, float width, float height,
+	const unsigned char *rgba, unsigned texture, const float *uv);
+
+/**
+ * @brief Records a quad that shows a blurred copy of what was drawn behind it
+ *
+ * The blur reaches blur pixels past the quad on each side, so it is taken from a little more than the quad. Backdrops
+ * are never merged with other commands, and each one costs a copy and two blur passes when the list is submitted.
+ *
+ * @param list Pointer to render list
+ * @param x Left edge in pixels
+ * @param y Top edge in pixels
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param blur Blur radius in pixels
+ * @param rgba Color the blurred copy is multiplied by
+ *
+ * @return Returns whether it was successful or not
+ */
+int render_push_backdrop(render_list *list, float x, float y, float width, float height, unsigned blur,
+	const unsigned char *rgba);
+
+/**
+ * @brief Records solid triangles
+ *
+ * Vertices are scaled and then moved by x and y. Triangles are cut to the clip rectangle like quads are, and tinted the
+ * same way, so meshes share draw calls with solid quads.
+ *
+ * @param list Pointer to render list
+ * @param positions Positions as x, y pairs, three vertices per triangle
+ * @param n_vertices Number of vertices
+ * @param bounds Bounding box of the positions as {x0, y0, x1, y1}, so clipping can be skipped when it is inside the clip
+ * @param x Horizontal offset in pixels
+ * @param y Vertical offset in pixels
+ * @param scale Pixels per unit of the positions
+ * @param rgba Color of the triangles
+ *
+ * @return Returns whether it was successful or not
+ */
+int render_push_mesh(render_list *list, const float *positions, unsigned n_vertices, const float *bounds, float x,
+	float y, float scale, const unsigned char *rgba);
+
+/**
+ * @brief Appends render lists to the end of another one, in order
+ *
+ * Commands at the seams are merged the same way render_push_quad() merges them, so recording a widget tree in slices
+ * and merging them gives exactly the same list as recording the whole tree into one list.
+ *
+ * @param dest Pointer to the render list to append to
+ * @param slices Render lists to append
+ * @param n_slices Number of render lists
+ *
+ * @return Returns whether it was successful or not
+ */
+int render_list_merge(render_list *dest, render_list *slices, unsigned n_slices);
+
+/**
+ * @brief Compares two render lists
+ *
+ * @return Returns VS_TRUE if both lists contain the same commands and vertices
+ */
+int render_list_equal(render_list *a, render_list *b);
+
+/**
+ * @brief Initializes a render recorder
+ *
+ * @param recorder Pointer to render recorder
+ */
+void render_recorder_init(render_recorder *recorder);
+
+/**
+ * @brief Releases the memory held by a render recorder
+ *
+ * @param recorder Pointer to render recorder
+ */
+void render_recorder_free(render_recorder *recorder);
+
+/**
+ * @brief Creates the GL objects needed to submit render lists
+ *
+ * The context the objects should belong to must be current.
+ *
+ * @param ctx Pointer to render context
+ *
+ * @return Returns whether it was successful or not
+ */
+int gl_render_init(render_context *ctx);
+
+/**
+ * @brief Deletes the GL objects of a render context
+ *
+ * @param ctx Pointer to render context
+ */
+void gl_render_destroy(render_context *ctx);
+
+/**
+ * @brief Uploads a render list and draws it
+ *
+ * @param ctx Pointer to render context
+ * @param list Pointer to render list
+ * @param width Width of the viewport in pixels
+ * @param height Height of the viewport in pixels
+ *
+ * @return Returns whether it was successful or not
+ */
+int gl_render_submit(render_context *ctx, render_list *list, unsigned width, unsigned height);
+
+#endif
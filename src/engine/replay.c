@@ -0,0 +1,230 @@
+/**
+ * @file replay.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "replay.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "graphics.h"
+#include "profile.h"
+#include "memory.h"
+
+typedef struct {
+	uint32_t delta_us;
+	uint16_t size;
+	uint8_t window;
+	uint8_t kind;
+} replay_header;
+
+static FILE *g_record_file = NULL;
+static unsigned long g_record_last = 0;
+
+/*
+ * The whole recording is read into memory when a replay starts, so replaying never touches the disk.
+ */
+static unsigned char *g_replay_data = NULL;
+static unsigned long g_replay_size = 0;
+static unsigned long g_replay_offset = 0;
+static int g_replay_mode = VS_REPLAY_REALTIME;
+
+// Time the replay started and the recorded time of the next record, both in nanoseconds
+static unsigned long g_replay_start = 0;
+static unsigned long g_replay_time = 0;
+
+// Set when a frame record was reached and the frame has not been swapped yet
+static int g_replay_waiting = VS_FALSE;
+
+static unsigned replay_event_size(int type) {
+	switch (type) {
+	case KeyPress:
+	case KeyRelease:
+		return sizeof(XKeyEvent);
+	case ButtonPress:
+	case ButtonRelease:
+		return sizeof(XButtonEvent);
+	case MotionNotify:
+		return sizeof(XMotionEvent);
+	case EnterNotify:
+	case LeaveNotify:
+		return sizeof(XCrossingEvent);
+	case FocusIn:
+	case FocusOut:
+		return sizeof(XFocusChangeEvent);
+	case Expose:
+		return sizeof(XExposeEvent);
+	case ConfigureNotify:
+		return sizeof(XConfigureEvent);
+	case ClientMessage:
+		return sizeof(XClientMessageEvent);
+	default:
+		return sizeof(XEvent);
+	}
+}
+
+static int replay_is_structure(int type) {
+	return type == Expose || type == ConfigureNotify || type == MapNotify || type == UnmapNotify ||
+		type == ReparentNotify || type == DestroyNotify;
+}
+
+static int replay_is_input(int type) {
+	return type == KeyPress || type == KeyRelease || type == ButtonPress || type == ButtonRelease ||
+		type == MotionNotify || type == EnterNotify || type == LeaveNotify;
+}
+
+static void replay_write(unsigned kind, unsigned window, void *data, unsigned size) {
+	unsigned long now = profile_now();
+	unsigned long delta_us = (now - g_record_last) / 1000;
+	replay_header header;
+	header.delta_us = delta_us > UINT32_MAX ? UINT32_MAX : (uint32_t) delta_us;
+	header.size = (uint16_t) size;
+	header.window = (uint8_t) window;
+	header.kind = (uint8_t) kind;
+	g_record_last += (unsigned long) header.delta_us * 1000;
+
+	fwrite(&header, sizeof(replay_header), 1, g_record_file);
+	if (size)
+		fwrite(data, size, 1, g_record_file);
+}
+
+void replay_record_event(XEvent *event, unsigned window) {
+	if (!g_record_file || window > UINT8_MAX)
+		return;
+	replay_write(VS_REPLAY_EVENT, window, event, replay_event_size(event->type));
+}
+
+int venus_record_events(const char *path) {
+	if (g_record_file || g_replay_data)
+		vs_err(VS_FAILURE);
+
+	g_record_file = fopen(path, "wb");
+	if (!g_record_file) {
+		vs_log_error("Failed to open %s for recording", path);
+		return VS_FAILURE;
+	}
+
+	uint32_t version = VS_REPLAY_VERSION;
+	fwrite(VS_REPLAY_MAGIC, 4, 1, g_record_file);
+	fwrite(&version, sizeof(uint32_t), 1, g_record_file);
+	g_record_last = profile_now();
+	return VS_SUCCESS;
+}
+
+int venus_stop_recording() {
+	if (!g_record_file)
+		return VS_FAILURE;
+	int closed = !fclose(g_record_file);
+	g_record_file = NULL;
+	return closed ? VS_SUCCESS : VS_FAILURE;
+}
+
+int venus_replay_events(const char *path, int mode) {
+	if (g_record_file || g_replay_data)
+		vs_err(VS_FAILURE);
+
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		vs_log_error("Failed to open recording %s", path);
+		return VS_FAILURE;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	unsigned char *data = size > 8 ? memory_alloc(VS_MEMORY_ENGINE, size) : NULL;
+	if (!data || fread(data, size, 1, file) != 1 || memcmp(data, VS_REPLAY_MAGIC, 4) ||
+		*(uint32_t*) (data + 4) != VS_REPLAY_VERSION) {
+
+		vs_log_error("%s is not a venus event recording", path);
+		memory_free(VS_MEMORY_ENGINE, data);
+		fclose(file);
+		return VS_FAILURE;
+	}
+	fclose(file);
+
+	g_replay_data = data;
+	g_replay_size = size;
+	g_replay_offset = 8;
+	g_replay_mode = mode;
+	g_replay_start = profile_now();
+	g_replay_time = 0;
+	g_replay_waiting = VS_FALSE;
+	return VS_SUCCESS;
+}
+
+int venus_stop_replay() {
+	if (!g_replay_data)
+		return VS_FAILURE;
+	memory_free(VS_MEMORY_ENGINE, g_replay_data);
+	g_replay_data = NULL;
+	return VS_SUCCESS;
+}
+
+int venus_replay_finished() {
+	return !g_replay_data;
+}
+
+void replay_frame() {
+	if (g_record_file)
+		replay_write(VS_REPLAY_FRAME, 0, NULL, 0);
+	g_replay_waiting = VS_FALSE;
+}
+
+int replay_blocks(XEvent *event) {
+	return g_replay_data && replay_is_input(event->type);
+}
+
+void replay_dispatch() {
+	while (g_replay_data && !g_replay_waiting) {
+		if (g_replay_offset + sizeof(replay_header) > g_replay_size) {
+			venus_stop_replay();
+			return;
+		}
+		replay_header header;
+		memcpy(&header, g_replay_data + g_replay_offset, sizeof(replay_header));
+		if (g_replay_offset + sizeof(replay_header) + header.size > g_replay_size) {
+			vs_log_error("Event recording is truncated");
+			venus_stop_replay();
+			return;
+		}
+
+		unsigned long time = g_replay_time + (unsigned long) header.delta_us * 1000;
+		if (g_replay_mode == VS_REPLAY_REALTIME && time > profile_now() - g_replay_start)
+			return;
+		g_replay_time = time;
+		g_replay_offset += sizeof(replay_header);
+
+		if (header.kind == VS_REPLAY_FRAME) {
+			if (g_replay_mode == VS_REPLAY_FAST)
+				g_replay_waiting = VS_TRUE;
+			continue;
+		}
+
+		XEvent event;
+		memset(&event, 0, sizeof(XEvent));
+		memcpy(&event, g_replay_data + g_replay_offset, header.size < sizeof(XEvent) ? header.size : sizeof(XEvent));
+		g_replay_offset += header.size;
+
+		// Windows that were never opened in this session simply miss their events, and the windows that were get their sizes
+		// and exposures from the server, not from the recording
+		window *win = xlib_window_at(header.window);
+		if (!win || replay_is_structure(event.type))
+			continue;
+		event.xany.display = g_display;
+		event.xany.window = win->xwin;
+		event.xany.send_event = True;
+		if (event.type == KeyPress || event.type == KeyRelease)
+			event.xkey.root = g_root;
+		else if (event.type == ButtonPress || event.type == ButtonRelease)
+			event.xbutton.root = g_root;
+		else if (event.type == MotionNotify)
+			event.xmotion.root = g_root;
+		xlib_dispatch_event(&event);
+	}
+}
@@ -0,0 +1,65 @@
+/**
+ * @file replay.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Event recording and replay behind venus_record_events() and venus_replay_events()
+ *
+ * A recording is a small header followed by one record per dispatched event or swapped frame:
+ *
+ *     "VSEV", version (u32)
+ *     delta_us (u32), size (u16), window (u8), kind (u8), then size bytes of the event
+ *
+ * delta_us is the time since the previous record. A longer gap is carried over into the records after it, so it is
+ * spread out rather than wrapped. Events keep only the member of the XEvent union their type uses, and name their window
+ * by its registration order, since X window ids change from one session to the next.
+ *
+ * Structure events, such as ConfigureNotify and Expose, are recorded but not replayed. They describe the windows of the
+ * recording session, and the windows being replayed into keep getting their own from the server.
+ */
+
+#ifndef VS_REPLAY_H
+#define VS_REPLAY_H
+
+#include <X11/Xlib.h>
+
+#define VS_REPLAY_MAGIC			"VSEV"
+#define VS_REPLAY_VERSION		1
+
+#define VS_REPLAY_EVENT			0
+#define VS_REPLAY_FRAME			1
+
+/**
+ * @brief Writes a dispatched event to the recording, if one is open
+ *
+ * @param event The event
+ * @param window Registration index of the window it was sent to
+ */
+void replay_record_event(XEvent *event, unsigned window);
+
+/**
+ * @brief Marks the end of a frame
+ *
+ * While recording, this writes a frame record. While replaying as fast as possible, it lets the events of the next frame
+ * through. It is called by swap_buffers().
+ */
+void replay_frame();
+
+/**
+ * @brief Checks whether real input should be dropped because a replay is feeding input instead
+ *
+ * @param event The event
+ *
+ * @return Returns whether to drop the event
+ */
+int replay_blocks(XEvent *event);
+
+/**
+ * @brief Dispatches the replayed events that are due
+ *
+ * In real time, that is every event recorded before the time since the replay started. As fast as possible, it is every
+ * event up to the next frame record. It is called by venus_process_events().
+ */
+void replay_dispatch();
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file resize.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "resize.h"
+
+#include <glad/glad.h>
+
+#include <string.h>
+
+#include "../venus_common.h"
+#include "glstate.h"
+#include "layer.h"
+#include "memory.h"
+#include "profile.h"
+
+static void resize_release(resize_state *r) {
+	if (r->fbo) {
+		gl_delete_framebuffers(1, &r->fbo);
+		gl_delete_textures(1, &r->texture);
+		memory_gpu_free(VS_MEMORY_LAYERS, r->bytes);
+	}
+	r->fbo = 0;
+	r->texture = 0;
+	r->texture_width = 0;
+	r->texture_height = 0;
+	r->bytes = 0;
+	r->width = 0;
+	r->height = 0;
+}
+
+static int resize_allocate(resize_state *r, unsigned width, unsigned height) {
+	if (r->fbo && r->texture_width >= width && r->texture_height >= height)
+		return VS_SUCCESS;
+	resize_release(r);
+
+	// Leave room for the window to grow, so the next drag can keep its frame in the same texture
+	unsigned texture_width = width + width / VS_LAYER_HEADROOM;
+	unsigned texture_height = height + height / VS_LAYER_HEADROOM;
+	texture_width = (texture_width + VS_LAYER_GRANULARITY - 1) / VS_LAYER_GRANULARITY * VS_LAYER_GRANULARITY;
+	texture_height = (texture_height + VS_LAYER_GRANULARITY - 1) / VS_LAYER_GRANULARITY * VS_LAYER_GRANULARITY;
+
+	glGenTextures(1, &r->texture);
+	gl_bind_texture(0, r->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture_width, texture_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glGenFramebuffers(1, &r->fbo);
+	gl_bind_framebuffer(r->fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, r->texture, 0);
+	int complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	gl_bind_framebuffer(0);
+
+	r->texture_width = texture_width;
+	r->texture_height = texture_height;
+	r->bytes = (unsigned long) texture_width * texture_height * 4;
+	r->stats.allocations++;
+	memory_gpu_alloc(VS_MEMORY_LAYERS, r->bytes);
+
+	if (!complete) {
+		vs_log_error("Resize framebuffer is incomplete");
+		resize_release(r);
+		return VS_FAILURE;
+	}
+	return VS_SUCCESS;
+}
+
+static void resize_blit(unsigned read, unsigned draw, unsigned src_width, unsigned src_height, unsigned dst_width,
+	unsigned dst_height) {
+	const int src[4] = {0, 0, (int) src_width, (int) src_height};
+	const int dst[4] = {0, 0, (int) dst_width, (int) dst_height};
+	gl_blit_framebuffer(read, draw, src, dst, GL_LINEAR);
+}
+
+void resize_init(resize_state *r, unsigned width, unsigned height) {
+	memset(r, 0, sizeof(resize_state));
+	r->target_width = width;
+	r->target_height = height;
+}
+
+void resize_destroy(resize_state *r) {
+	resize_release(r);
+}
+
+void resize_configure(resize_state *r, unsigned width, unsigned height) {
+	// Moves and restacking send ConfigureNotify too
+	if (width == r->target_width && height == r->target_height)
+		return;
+	r->target_width = width;
+	r->target_height = height;
+	r->pending = VS_TRUE;
+	r->changed = profile_now();
+	r->stats.configures++;
+}
+
+int resize_begin_frame(resize_state *r, unsigned *width, unsigned *height) {
+	if (!r->pending) {
+		// A kept frame nothing followed goes out of date as soon as the window changes
+		if (r->width && profile_now() - r->changed >= VS_RESIZE_SETTLE_NS)
+			r->width = 0;
+		return VS_RESIZE_NONE;
+	}
+
+	if (r->width && profile_now() - r->changed < VS_RESIZE_SETTLE_NS) {
+		r->stats.stale_frames++;
+		return VS_RESIZE_STALE;
+	}
+
+	// The first step of a drag is drawn for real and kept, and the drag is over once the size settles
+	r->capture = !r->width;
+	r->width = 0;
+	r->height = 0;
+	r->pending = VS_FALSE;
+	r->stats.resizes++;
+	*width = r->target_width;
+	*height = r->target_height;
+	return VS_RESIZE_APPLY;
+}
+
+int resize_present(resize_state *r) {
+	if (!r->width)
+		return VS_FAILURE;
+	resize_blit(r->fbo, 0, r->width, r->height, r->target_width, r->target_height);
+	return VS_SUCCESS;
+}
+
+void resize_end_frame(resize_state *r, unsigned width, unsigned height) {
+	if (!r->capture)
+		return;
+	r->capture = VS_FALSE;
+	if (!resize_allocate(r, width, height))
+		return;
+	resize_blit(0, r->fbo, width, height, width, height);
+	r->width = width;
+	r->height = height;
+}
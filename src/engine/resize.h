@@ -0,0 +1,135 @@
+/**
+ * @file resize.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Coalescing of window resizes
+ *
+ * Every ConfigureNotify only records the size the window was given. The first frame of a drag is drawn at the new size
+ * as usual and kept in a texture before it is swapped. While the size keeps changing after that, frames show the kept
+ * frame stretched to the window instead of laying out and recording everything again. Once no ConfigureNotify has come
+ * for VS_RESIZE_SETTLE_NS the last size is applied and drawn for real.
+ */
+
+#ifndef VS_RESIZE_H
+#define VS_RESIZE_H
+
+/// How long the size has to stay the same before a drag is over
+#define VS_RESIZE_SETTLE_NS		100000000ul
+
+/*
+ * What a frame should do about the window's size
+ */
+#define VS_RESIZE_NONE			0
+/// The window has a new size to lay out and draw at
+#define VS_RESIZE_APPLY			1
+/// A drag is in progress, so the kept frame should be shown instead
+#define VS_RESIZE_STALE			2
+
+/**
+ * @brief Resize counts since the window was created
+ */
+typedef struct {
+	/// ConfigureNotify events that changed the size
+	unsigned long configures;
+
+	/// Sizes that were applied, each of them a relayout and a full frame
+	unsigned long resizes;
+
+	/// Frames that showed the kept frame stretched
+	unsigned long stale_frames;
+
+	/// Times the surface texture had to be allocated
+	unsigned long allocations;
+} resize_stats;
+
+/**
+ * @brief Resize state of a window
+ */
+typedef struct {
+	/// Latest size given by the X server
+	unsigned target_width;
+	unsigned target_height;
+
+	/// Set while the target size has not been applied
+	int pending;
+
+	/// When the target size last changed
+	unsigned long changed;
+
+	/// Set when the frame being drawn should be kept before it is swapped
+	int capture;
+
+	/// Copy of the first frame of a drag
+	unsigned fbo;
+	unsigned texture;
+	unsigned texture_width;
+	unsigned texture_height;
+	unsigned long bytes;
+
+	/// Size of the kept frame, or 0 when there is none
+	unsigned width;
+	unsigned height;
+
+	resize_stats stats;
+} resize_state;
+
+/**
+ * @brief Initializes the resize state of a window
+ *
+ * @param r Pointer to resize state
+ * @param width Width the window was created with
+ * @param height Height the window was created with
+ */
+void resize_init(resize_state *r, unsigned width, unsigned height);
+
+/**
+ * @brief Deletes the kept frame
+ *
+ * The GL context the window uses must be current.
+ *
+ * @param r Pointer to resize state
+ */
+void resize_destroy(resize_state *r);
+
+/**
+ * @brief Records the size from a ConfigureNotify
+ *
+ * @param r Pointer to resize state
+ * @param width New width in pixels
+ * @param height New height in pixels
+ */
+void resize_configure(resize_state *r, unsigned width, unsigned height);
+
+/**
+ * @brief Decides what the next frame does about the window's size
+ *
+ * @param r Pointer to resize state
+ * @param width Pointer to the window's width, which is set to the new width when the size is applied
+ * @param height Pointer to the window's height, which is set to the new height when the size is applied
+ *
+ * @return Returns VS_RESIZE_NONE, VS_RESIZE_APPLY or VS_RESIZE_STALE
+ */
+int resize_begin_frame(resize_state *r, unsigned *width, unsigned *height);
+
+/**
+ * @brief Shows the kept frame stretched over the window's draw buffer
+ *
+ * @param r Pointer to resize state
+ *
+ * @return Returns whether it was successful or not
+ */
+int resize_present(resize_state *r);
+
+/**
+ * @brief Keeps the frame in the draw buffer if resize_begin_frame() asked for it
+ *
+ * This is called right before the swap.
+ *
+ * @param r Pointer to resize state
+ * @param width Width of the frame
+ * @param height Height of the frame
+ */
+void resize_end_frame(resize_state *r, unsigned width, unsigned height);
+
+#endif
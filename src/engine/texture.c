@@ -0,0 +1,515 @@
+/**
+ * @file texture.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "texture.h"
+
+#include <glad/glad.h>
+
+/*
+ * http://www.libpng.org/pub/png/libpng.html
+ * The official PNG reference library.
+ */
+#include <png.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../venus_common.h"
+#include "../toolkit/widget.h"
+#include "glstate.h"
+#include "jobs.h"
+#include "arena.h"
+#include "memory.h"
+
+static void texture_decode(void *arg) {
+	VS_TRACE_SCOPE("texture_decode");
+	texture *tex = (texture*) arg;
+
+	png_image image;
+	memset(&image, 0, sizeof(png_image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (png_image_begin_read_from_file(&image, tex->path)) {
+		image.format = PNG_FORMAT_RGBA;
+		unsigned char *pixels = memory_alloc(VS_MEMORY_IMAGES, PNG_IMAGE_SIZE(image));
+		if (pixels && png_image_finish_read(&image, NULL, pixels, 0, NULL)) {
+			tex->width = image.width;
+			tex->height = image.height;
+			tex->pixels = pixels;
+			atomic_store(&tex->state, VS_TEXTURE_DECODED);
+			return;
+		}
+		memory_free(VS_MEMORY_IMAGES, pixels);
+		png_image_free(&image);
+	}
+	vs_log_error("Failed to decode %s: %s", tex->path, image.message);
+	atomic_store(&tex->state, VS_TEXTURE_FAILED);
+}
+
+/*
+ * Makes a texture for the pixels of one image, to be filled in by the caller
+ */
+static unsigned texture_gl_create(unsigned width, unsigned height) {
+	unsigned gl_texture;
+	glGenTextures(1, &gl_texture);
+	gl_bind_texture(0, gl_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return gl_texture;
+}
+
+/*
+ * Finds room for an image in an atlas page, creating a new page if none of them have room. The room is only taken by
+ * texture_atlas_commit(), so an upload that fails leaves the page as it was.
+ */
+static int texture_atlas_find(texture_cache *cache, unsigned width, unsigned height, unsigned *x, unsigned *y) {
+	// One pixel of padding keeps neighbours from bleeding into each other when filtered
+	width++;
+	height++;
+
+	int free_page = -1;
+	for (unsigned i = 0; i < cache->n_pages; ++i) {
+		texture_atlas *page = &cache->pages[i];
+		if (!page->gl_texture) {
+			if (free_page < 0)
+				free_page = i;
+			continue;
+		}
+
+		unsigned cursor_x = page->cursor_x;
+		unsigned shelf_y = page->shelf_y;
+		if (cursor_x + width > VS_TEXTURE_ATLAS_SIZE) {
+			shelf_y += page->shelf_height;
+			cursor_x = 0;
+		}
+		if (shelf_y + height > VS_TEXTURE_ATLAS_SIZE)
+			continue;
+
+		*x = cursor_x;
+		*y = shelf_y;
+		return i;
+	}
+
+	if (free_page < 0) {
+		texture_atlas *pages = memory_realloc(VS_MEMORY_IMAGES, cache->pages, sizeof(texture_atlas) * (cache->n_pages + 1));
+		if (!pages)
+			return -1;
+		cache->pages = pages;
+		free_page = cache->n_pages++;
+	}
+
+	texture_atlas *page = &cache->pages[free_page];
+	memset(page, 0, sizeof(texture_atlas));
+	page->gl_texture = texture_gl_create(VS_TEXTURE_ATLAS_SIZE, VS_TEXTURE_ATLAS_SIZE);
+	cache->stats.resident_bytes += VS_TEXTURE_ATLAS_SIZE * VS_TEXTURE_ATLAS_SIZE * 4;
+	cache->stats.n_atlas_pages++;
+	memory_gpu_alloc(VS_MEMORY_ATLASES, VS_TEXTURE_ATLAS_SIZE * VS_TEXTURE_ATLAS_SIZE * 4);
+
+	*x = 0;
+	*y = 0;
+	return free_page;
+}
+
+/*
+ * Takes the room texture_atlas_find() found for an image
+ */
+static void texture_atlas_commit(texture_atlas *page, unsigned x, unsigned y, unsigned width, unsigned height) {
+	width++;
+	height++;
+	if (y != page->shelf_y) {
+		page->shelf_y = y;
+		page->shelf_height = 0;
+	}
+	page->cursor_x = x + width;
+	if (height > page->shelf_height)
+		page->shelf_height = height;
+	page->n_entries++;
+}
+
+static void texture_atlas_delete_page(texture_cache *cache, texture_atlas *page) {
+	gl_delete_textures(1, &page->gl_texture);
+	page->gl_texture = 0;
+	cache->stats.resident_bytes -= VS_TEXTURE_ATLAS_SIZE * VS_TEXTURE_ATLAS_SIZE * 4;
+	cache->stats.n_atlas_pages--;
+	memory_gpu_free(VS_MEMORY_ATLASES, VS_TEXTURE_ATLAS_SIZE * VS_TEXTURE_ATLAS_SIZE * 4);
+}
+
+/*
+ * Gives a texture's room back to its atlas page, deleting the page once it holds nothing
+ */
+static void texture_atlas_release(texture_cache *cache, texture *tex) {
+	texture_atlas *page = &cache->pages[tex->atlas_page];
+	if (!--page->n_entries)
+		texture_atlas_delete_page(cache, page);
+	tex->atlas_page = -1;
+}
+
+/*
+ * Copies an atlas entry into a texture of its own. Atlas pages have no mipmaps, since their smaller levels would blend
+ * neighbouring entries together, so an entry that is drawn scaled is moved out to get them.
+ */
+static void texture_atlas_move_out(texture_cache *cache, texture *tex) {
+	const float s = VS_TEXTURE_ATLAS_SIZE;
+	unsigned gl_texture = texture_gl_create(tex->width, tex->height);
+	glCopyImageSubData(cache->pages[tex->atlas_page].gl_texture, GL_TEXTURE_2D, 0, (int) (tex->uv[0] * s),
+		(int) (tex->uv[1] * s), 0, gl_texture, GL_TEXTURE_2D, 0, 0, 0, 0, tex->width, tex->height, 1);
+	texture_atlas_release(cache, tex);
+
+	tex->gl_texture = gl_texture;
+	tex->uv[0] = 0.0f;
+	tex->uv[1] = 0.0f;
+	tex->uv[2] = 1.0f;
+	tex->uv[3] = 1.0f;
+	tex->bytes = (unsigned long) tex->width * tex->height * 4;
+	cache->stats.resident_bytes += tex->bytes;
+	memory_gpu_alloc(VS_MEMORY_TEXTURES, tex->bytes);
+}
+
+static void texture_generate_mipmaps(texture *tex) {
+	gl_bind_texture(0, tex->gl_texture);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	// A full mip chain adds a third to the base level
+	unsigned long base = (unsigned long) tex->width * tex->height * 4;
+	tex->cache->stats.resident_bytes += base / 3;
+	memory_gpu_resize(VS_MEMORY_TEXTURES, tex->bytes, tex->bytes + base / 3);
+	tex->bytes += base / 3;
+	tex->flags |= VS_TEXTURE_MIPMAP;
+}
+
+/*
+ * Copies a decoded image into the next pixel buffer object and uploads it from there. Fails without waiting if the
+ * buffer is still in use by the GPU.
+ */
+static int texture_upload(texture_cache *cache, texture *tex) {
+	VS_TRACE_SCOPE("texture_upload");
+	unsigned long size = (unsigned long) tex->width * tex->height * 4;
+	unsigned index = cache->pbo_index;
+
+	GLsync fence = (GLsync) cache->fences[index];
+	if (fence) {
+		if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			return VS_FAILURE;
+		glDeleteSync(fence);
+		cache->fences[index] = NULL;
+	}
+
+	// Atlas pages have to be created before the buffer is bound, or their NULL data would be read as a buffer offset
+	int page = -1;
+	unsigned x = 0;
+	unsigned y = 0;
+	if (!(tex->flags & (VS_TEXTURE_NO_ATLAS | VS_TEXTURE_MIPMAP)) && !atomic_load(&tex->scaled) &&
+		tex->width <= VS_TEXTURE_ATLAS_MAX && tex->height <= VS_TEXTURE_ATLAS_MAX
+	) {
+		page = texture_atlas_find(cache, tex->width, tex->height, &x, &y);
+	}
+
+	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, cache->pbos[index]);
+	if (size > cache->pbo_sizes[index]) {
+		memory_gpu_resize(VS_MEMORY_GL_BUFFERS, cache->pbo_sizes[index], size);
+		cache->pbo_sizes[index] = size;
+	}
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, cache->pbo_sizes[index], NULL, GL_STREAM_DRAW);
+	void *dest = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (!dest) {
+		gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		// Only evictions free pages, so a page made for this image alone would never be
+		if (page >= 0 && !cache->pages[page].n_entries)
+			texture_atlas_delete_page(cache, &cache->pages[page]);
+		return VS_FAILURE;
+	}
+	memcpy(dest, tex->pixels, size);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	if (page >= 0) {
+		const float s = VS_TEXTURE_ATLAS_SIZE;
+		gl_bind_texture(0, cache->pages[page].gl_texture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, tex->width, tex->height, GL_RGBA, GL_UNSIGNED_BYTE, (void*) 0);
+		texture_atlas_commit(&cache->pages[page], x, y, tex->width, tex->height);
+		tex->gl_texture = cache->pages[page].gl_texture;
+		tex->atlas_page = page;
+		tex->uv[0] = x / s;
+		tex->uv[1] = y / s;
+		tex->uv[2] = (x + tex->width) / s;
+		tex->uv[3] = (y + tex->height) / s;
+		tex->bytes = 0;
+	} else {
+		// With the buffer bound, the NULL data of the new texture is an offset, and reads the pixels that were just copied
+		tex->gl_texture = texture_gl_create(tex->width, tex->height);
+		tex->atlas_page = -1;
+		tex->uv[0] = 0.0f;
+		tex->uv[1] = 0.0f;
+		tex->uv[2] = 1.0f;
+		tex->uv[3] = 1.0f;
+		tex->bytes = size;
+		cache->stats.resident_bytes += size;
+		memory_gpu_alloc(VS_MEMORY_TEXTURES, size);
+	}
+
+	cache->fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	cache->pbo_index = (index + 1) % VS_TEXTURE_PBO_COUNT;
+
+	// Mipmaps are generated after the buffer is unbound since they are built from the texture itself
+	if (page < 0 && (tex->flags & VS_TEXTURE_MIPMAP || atomic_load(&tex->scaled)))
+		texture_generate_mipmaps(tex);
+
+	memory_free(VS_MEMORY_IMAGES, tex->pixels);
+	tex->pixels = NULL;
+	cache->stats.uploads++;
+	cache->stats.upload_bytes += size;
+	atomic_store(&tex->state, VS_TEXTURE_RESIDENT);
+	return VS_SUCCESS;
+}
+
+static void texture_evict(texture_cache *cache, texture *tex) {
+	int state = atomic_load(&tex->state);
+	if (state == VS_TEXTURE_DECODED) {
+		memory_free(VS_MEMORY_IMAGES, tex->pixels);
+		tex->pixels = NULL;
+	} else if (state != VS_TEXTURE_RESIDENT) {
+		return;
+	}
+
+	if (state == VS_TEXTURE_RESIDENT) {
+		if (tex->atlas_page >= 0) {
+			texture_atlas_release(cache, tex);
+		} else {
+			gl_delete_textures(1, &tex->gl_texture);
+			cache->stats.resident_bytes -= tex->bytes;
+			memory_gpu_free(VS_MEMORY_TEXTURES, tex->bytes);
+		}
+		cache->stats.evictions++;
+	}
+
+	tex->gl_texture = 0;
+	tex->atlas_page = -1;
+	tex->bytes = 0;
+	atomic_store(&tex->state, VS_TEXTURE_EVICTED);
+}
+
+static int texture_compare_last_used(const void *a, const void *b) {
+	unsigned used_a = atomic_load(&(*(texture**) a)->last_used);
+	unsigned used_b = atomic_load(&(*(texture**) b)->last_used);
+	return (used_a > used_b) - (used_a < used_b);
+}
+
+/*
+ * Evicts the least recently drawn textures until the cache is under budget. Textures drawn in the last frame are kept so
+ * that a budget smaller than one frame's worth of textures does not thrash.
+ *
+ * Evicting an atlas entry frees nothing until its page is empty, so pages are evicted whole, when the most recently
+ * drawn of their entries comes up, and only if none of their entries were drawn in the last frame.
+ */
+static void texture_enforce_budget(texture_cache *cache) {
+	if (cache->stats.resident_bytes <= cache->stats.budget)
+		return;
+
+	texture **candidates = frame_alloc(sizeof(texture*) * cache->n_textures);
+	if (!candidates)
+		return;
+
+	unsigned n_candidates = 0;
+	for (unsigned i = 0; i < cache->n_textures; ++i) {
+		texture *tex = cache->textures[i];
+		if (atomic_load(&tex->state) == VS_TEXTURE_RESIDENT && atomic_load(&tex->last_used) + 1 < cache->frame)
+			candidates[n_candidates++] = tex;
+	}
+	qsort(candidates, n_candidates, sizeof(texture*), texture_compare_last_used);
+
+	// Candidates on each page, and how many of them are still to come
+	unsigned *on_page = frame_alloc(sizeof(unsigned) * 2 * (cache->n_pages + 1));
+	if (!on_page)
+		return;
+	unsigned *to_come = on_page + cache->n_pages;
+	memset(on_page, 0, sizeof(unsigned) * 2 * cache->n_pages);
+	for (unsigned i = 0; i < n_candidates; ++i)
+		if (candidates[i]->atlas_page >= 0)
+			on_page[candidates[i]->atlas_page]++;
+	memcpy(to_come, on_page, sizeof(unsigned) * cache->n_pages);
+
+	for (unsigned i = 0; i < n_candidates && cache->stats.resident_bytes > cache->stats.budget; ++i) {
+		int page = candidates[i]->atlas_page;
+		if (page < 0) {
+			texture_evict(cache, candidates[i]);
+		} else if (!--to_come[page] && on_page[page] == cache->pages[page].n_entries) {
+			for (unsigned j = 0; j <= i; ++j)
+				if (candidates[j]->atlas_page == page)
+					texture_evict(cache, candidates[j]);
+		}
+	}
+}
+
+int texture_cache_init(texture_cache *cache, unsigned long budget) {
+	memset(cache, 0, sizeof(texture_cache));
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->stats.budget = budget;
+	cache->upload_budget = 8 * 1024 * 1024;
+	glGenBuffers(VS_TEXTURE_PBO_COUNT, cache->pbos);
+	for (unsigned i = 0; i < VS_TEXTURE_PBO_COUNT; ++i)
+		memory_gpu_alloc(VS_MEMORY_GL_BUFFERS, 0);
+	return VS_SUCCESS;
+}
+
+void texture_cache_destroy(texture_cache *cache) {
+	pthread_mutex_lock(&cache->lock);
+	for (unsigned i = 0; i < cache->n_textures; ++i) {
+		texture *tex = cache->textures[i];
+		while (atomic_load(&tex->state) == VS_TEXTURE_DECODING)
+			usleep(1000);
+		texture_evict(cache, tex);
+		memory_free(VS_MEMORY_IMAGES, tex->path);
+		memory_free(VS_MEMORY_IMAGES, tex);
+	}
+	memory_free(VS_MEMORY_IMAGES, cache->textures);
+
+	for (unsigned i = 0; i < cache->n_pages; ++i) {
+		if (cache->pages[i].gl_texture) {
+			gl_delete_textures(1, &cache->pages[i].gl_texture);
+			memory_gpu_free(VS_MEMORY_ATLASES, VS_TEXTURE_ATLAS_SIZE * VS_TEXTURE_ATLAS_SIZE * 4);
+		}
+	}
+	memory_free(VS_MEMORY_IMAGES, cache->pages);
+
+	for (unsigned i = 0; i < VS_TEXTURE_PBO_COUNT; ++i)
+		if (cache->fences[i])
+			glDeleteSync((GLsync) cache->fences[i]);
+	gl_delete_buffers(VS_TEXTURE_PBO_COUNT, cache->pbos);
+	for (unsigned i = 0; i < VS_TEXTURE_PBO_COUNT; ++i)
+		memory_gpu_free(VS_MEMORY_GL_BUFFERS, cache->pbo_sizes[i]);
+	pthread_mutex_unlock(&cache->lock);
+	pthread_mutex_destroy(&cache->lock);
+}
+
+int texture_cache_update(texture_cache *cache) {
+	pthread_mutex_lock(&cache->lock);
+	cache->frame++;
+
+	unsigned long uploaded = 0;
+	for (unsigned i = 0; i < cache->n_textures; ++i) {
+		texture *tex = cache->textures[i];
+		int state = atomic_load(&tex->state);
+
+		if (atomic_load(&tex->released) && state != VS_TEXTURE_DECODING) {
+			texture_evict(cache, tex);
+			memory_free(VS_MEMORY_IMAGES, tex->path);
+			memory_free(VS_MEMORY_IMAGES, tex);
+			cache->textures[i--] = cache->textures[--cache->n_textures];
+			continue;
+		}
+
+		switch (state) {
+		case VS_TEXTURE_EVICTED:
+			if (atomic_load(&tex->last_used) + 1 >= cache->frame) {
+				atomic_store(&tex->state, VS_TEXTURE_DECODING);
+				jobs_submit(texture_decode, tex);
+			}
+			break;
+		case VS_TEXTURE_DECODED:
+			if (uploaded < cache->upload_budget && texture_upload(cache, tex)) {
+				uploaded += (unsigned long) tex->width * tex->height * 4;
+
+				// Layers the image is cached in were rendered without it
+				if (tex->widget)
+					invalidate_widget(tex->widget);
+			}
+			break;
+		case VS_TEXTURE_RESIDENT:
+			if (atomic_load(&tex->scaled) && !(tex->flags & VS_TEXTURE_MIPMAP)) {
+				if (tex->atlas_page >= 0)
+					texture_atlas_move_out(cache, tex);
+				texture_generate_mipmaps(tex);
+				if (tex->widget)
+					invalidate_widget(tex->widget);
+			}
+			break;
+		case VS_TEXTURE_FAILED:
+			// Failed textures are counted once and then left empty
+			cache->stats.decode_failures++;
+			atomic_store(&tex->state, VS_TEXTURE_EMPTY);
+			break;
+		}
+	}
+
+	texture_enforce_budget(cache);
+	pthread_mutex_unlock(&cache->lock);
+	return VS_SUCCESS;
+}
+
+void texture_cache_set_budget(texture_cache *cache, unsigned long budget) {
+	pthread_mutex_lock(&cache->lock);
+	cache->stats.budget = budget;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+void texture_cache_stats(texture_cache *cache, texture_stats *stats) {
+	pthread_mutex_lock(&cache->lock);
+	*stats = cache->stats;
+	stats->n_resident = 0;
+	stats->n_pending = 0;
+	for (unsigned i = 0; i < cache->n_textures; ++i) {
+		int state = atomic_load(&cache->textures[i]->state);
+		if (state == VS_TEXTURE_RESIDENT)
+			stats->n_resident++;
+		else if (state == VS_TEXTURE_DECODING || state == VS_TEXTURE_DECODED)
+			stats->n_pending++;
+	}
+	pthread_mutex_unlock(&cache->lock);
+}
+
+texture *texture_load(texture_cache *cache, const char *path, int flags) {
+	texture *tex = memory_calloc(VS_MEMORY_IMAGES, 1, sizeof(texture));
+	if (!tex)
+		return NULL;
+	tex->path = memory_strdup(VS_MEMORY_IMAGES, path);
+	if (!tex->path) {
+		memory_free(VS_MEMORY_IMAGES, tex);
+		return NULL;
+	}
+	tex->cache = cache;
+	tex->flags = flags;
+	tex->atlas_page = -1;
+	atomic_init(&tex->state, VS_TEXTURE_DECODING);
+
+	pthread_mutex_lock(&cache->lock);
+	if (cache->n_textures == cache->texture_capacity) {
+		unsigned capacity = cache->texture_capacity ? cache->texture_capacity * 2 : 64;
+		texture **textures = memory_realloc(VS_MEMORY_IMAGES, cache->textures, sizeof(texture*) * capacity);
+		if (!textures) {
+			pthread_mutex_unlock(&cache->lock);
+			memory_free(VS_MEMORY_IMAGES, tex->path);
+			memory_free(VS_MEMORY_IMAGES, tex);
+			return NULL;
+		}
+		cache->textures = textures;
+		cache->texture_capacity = capacity;
+	}
+	cache->textures[cache->n_textures++] = tex;
+	atomic_init(&tex->last_used, cache->frame);
+	pthread_mutex_unlock(&cache->lock);
+
+	jobs_submit(texture_decode, tex);
+	return tex;
+}
+
+void texture_release(texture *tex) {
+	atomic_store(&tex->released, VS_TRUE);
+}
+
+void texture_touch(texture *tex, unsigned width, unsigned height) {
+	atomic_store_explicit(&tex->last_used, tex->cache->frame, memory_order_relaxed);
+	if (atomic_load(&tex->state) == VS_TEXTURE_RESIDENT && (width != tex->width || height != tex->height))
+		atomic_store_explicit(&tex->scaled, VS_TRUE, memory_order_relaxed);
+}
+
+int texture_ready(texture *tex) {
+	return atomic_load(&tex->state) == VS_TEXTURE_RESIDENT;
+}
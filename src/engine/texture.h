@@ -0,0 +1,229 @@
+/**
+ * @file texture.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Texture cache with asynchronous decoding, streaming uploads and a GPU memory budget
+ *
+ * Images are decoded on the worker pool. Decoded pixels are copied into a ring of pixel buffer objects and uploaded from
+ * there on the GL thread, a few per frame, so the render thread never waits for a decode or a transfer. Small images are
+ * packed into shared atlas pages until they are drawn scaled, when they are copied out to get mipmaps of their own.
+ * When the resident textures go over the cache's budget, the least recently drawn ones are evicted and decoded again
+ * the next time they are drawn.
+ */
+
+#ifndef VS_TEXTURE_H
+#define VS_TEXTURE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/// Generate mipmaps when the texture is uploaded
+#define VS_TEXTURE_MIPMAP		0x0001
+/// Never pack the texture into an atlas
+#define VS_TEXTURE_NO_ATLAS		0x0002
+
+#define VS_TEXTURE_EMPTY		0
+#define VS_TEXTURE_DECODING		1
+#define VS_TEXTURE_DECODED		2
+#define VS_TEXTURE_RESIDENT		3
+#define VS_TEXTURE_EVICTED		4
+#define VS_TEXTURE_FAILED		5
+
+/// Images no larger than this in either dimension are packed into an atlas
+#define VS_TEXTURE_ATLAS_MAX	128
+/// Width and height of an atlas page
+#define VS_TEXTURE_ATLAS_SIZE	1024
+/// Number of pixel buffer objects used for uploads
+#define VS_TEXTURE_PBO_COUNT	3
+
+typedef struct texture_cache texture_cache;
+
+/**
+ * @brief A texture owned by a texture cache
+ *
+ * The handle stays valid after its pixels are evicted from the GPU. Only gl_texture and uv should be used to draw it,
+ * and only while texture_ready() says so.
+ */
+typedef struct texture {
+	texture_cache *cache;
+	char *path;
+	int flags;
+
+	atomic_int state;
+	unsigned width;
+	unsigned height;
+
+	/// Decoded pixels waiting to be uploaded
+	unsigned char *pixels;
+
+	/// GL texture to draw with. For atlas entries this is the page's texture.
+	unsigned gl_texture;
+	float uv[4];
+
+	/// Atlas page the texture lives in, or -1
+	int atlas_page;
+
+	/// Bytes of GPU memory this texture holds on its own
+	unsigned long bytes;
+
+	/// Set when the texture was drawn larger or smaller than its size
+	atomic_int scaled;
+
+	/// Frame the texture was last drawn in
+	atomic_uint last_used;
+
+	/// Set by texture_release(), freed by the next update
+	atomic_int released;
+
+	/// Widget invalidated when the texture is uploaded or replaced, or NULL
+	void *widget;
+} texture;
+
+/**
+ * @brief An atlas page that small textures are packed into, one shelf at a time
+ */
+typedef struct {
+	unsigned gl_texture;
+	unsigned shelf_y;
+	unsigned shelf_height;
+	unsigned cursor_x;
+	unsigned n_entries;
+} texture_atlas;
+
+/**
+ * @brief Residency statistics of a texture cache
+ */
+typedef struct {
+	/// Textures currently on the GPU
+	unsigned n_resident;
+	/// Textures being decoded or waiting to be uploaded
+	unsigned n_pending;
+	/// Atlas pages currently on the GPU
+	unsigned n_atlas_pages;
+
+	/// GPU bytes currently held, counting whole atlas pages
+	unsigned long resident_bytes;
+	/// GPU byte budget
+	unsigned long budget;
+
+	/// Totals since the cache was created
+	unsigned long uploads;
+	unsigned long upload_bytes;
+	unsigned long evictions;
+	unsigned long decode_failures;
+} texture_stats;
+
+struct texture_cache {
+	pthread_mutex_t lock;
+
+	unsigned n_textures;
+	unsigned texture_capacity;
+	texture **textures;
+
+	unsigned n_pages;
+	texture_atlas *pages;
+
+	unsigned pbos[VS_TEXTURE_PBO_COUNT];
+	void *fences[VS_TEXTURE_PBO_COUNT];
+	unsigned long pbo_sizes[VS_TEXTURE_PBO_COUNT];
+	unsigned pbo_index;
+
+	/// Most bytes uploaded in a single frame
+	unsigned long upload_budget;
+
+	unsigned frame;
+	texture_stats stats;
+};
+
+/**
+ * @brief Initializes a texture cache
+ *
+ * The GL context the textures will belong to must be current.
+ *
+ * @param cache Pointer to texture cache
+ * @param budget GPU byte budget
+ *
+ * @return Returns whether it was successful or not
+ */
+int texture_cache_init(texture_cache *cache, unsigned long budget);
+
+/**
+ * @brief Deletes every texture in a cache and its GL objects
+ *
+ * Decodes that are still running are waited for.
+ *
+ * @param cache Pointer to texture cache
+ */
+void texture_cache_destroy(texture_cache *cache);
+
+/**
+ * @brief Advances the cache by one frame
+ *
+ * This must be called on the GL thread once per frame, before anything records textures for the frame. It uploads
+ * decoded images, frees released textures, requests decodes for evicted textures that were drawn again, and evicts the
+ * least recently drawn textures while the cache is over budget.
+ *
+ * @param cache Pointer to texture cache
+ *
+ * @return Returns whether it was successful or not
+ */
+int texture_cache_update(texture_cache *cache);
+
+/**
+ * @brief Sets the GPU byte budget of a texture cache
+ *
+ * @param cache Pointer to texture cache
+ * @param budget GPU byte budget
+ */
+void texture_cache_set_budget(texture_cache *cache, unsigned long budget);
+
+/**
+ * @brief Gets the residency statistics of a texture cache
+ *
+ * @param cache Pointer to texture cache
+ * @param stats Memory address where the statistics will be saved
+ */
+void texture_cache_stats(texture_cache *cache, texture_stats *stats);
+
+/**
+ * @brief Loads an image file into a texture
+ *
+ * This returns immediately. The image is decoded on a worker thread and uploaded by a later texture_cache_update().
+ *
+ * @param cache Pointer to texture cache
+ * @param path Path to a PNG file
+ * @param flags VS_TEXTURE_MIPMAP and VS_TEXTURE_NO_ATLAS
+ *
+ * @return Returns a new texture handle or NULL
+ */
+texture *texture_load(texture_cache *cache, const char *path, int flags);
+
+/**
+ * @brief Releases a texture handle
+ *
+ * @param tex Texture handle
+ */
+void texture_release(texture *tex);
+
+/**
+ * @brief Marks a texture as used in the current frame
+ *
+ * This is safe to call while recording on any thread.
+ *
+ * @param tex Texture handle
+ * @param width Width the texture is drawn at
+ * @param height Height the texture is drawn at
+ */
+void texture_touch(texture *tex, unsigned width, unsigned height);
+
+/**
+ * @brief Checks whether a texture can be drawn
+ *
+ * @param tex Texture handle
+ *
+ * @return Returns VS_TRUE if the texture is on the GPU
+ */
+int texture_ready(texture *tex);
+
+#endif
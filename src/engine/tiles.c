@@ -0,0 +1,343 @@
+/**
+ * @file tiles.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "tiles.h"
+
+#include <glad/glad.h>
+
+#include <string.h>
+#include <unistd.h>
+
+#include "../venus_common.h"
+#include "../toolkit/widget.h"
+#include "glstate.h"
+#include "jobs.h"
+#include "memory.h"
+
+#define VS_TILE_PAGE_BYTES		((unsigned long) VS_TILE_PAGE_SIZE * VS_TILE_PAGE_SIZE * 4)
+#define VS_TILE_PAGE_SLOTS		(VS_TILE_PAGE_TILES * VS_TILE_PAGE_TILES)
+
+/// Frames a tile that is not on the GPU is remembered for after it was last asked for
+#define VS_TILE_FORGET			120
+
+static unsigned tile_hash(const tile_source *source, int level, long x, long y) {
+	unsigned long h = (unsigned long) source * 0x9E3779B97F4A7C15ul;
+	h ^= ((unsigned long) level + 0x100) * 0xC2B2AE3D27D4EB4Ful;
+	h ^= (unsigned long) x * 0x165667B19E3779F9ul;
+	h ^= (unsigned long) y * 0x27D4EB2F165667C5ul;
+	return (unsigned) (h ^ h >> 29 ^ h >> 47) & (VS_TILE_BUCKETS - 1);
+}
+
+static tile *tile_find(tile_cache *cache, tile_source *source, int level, long x, long y) {
+	for (tile *t = cache->buckets[tile_hash(source, level, x, y)]; t; t = t->next)
+		if (t->source == source && t->level == level && t->x == x && t->y == y)
+			return t;
+	return NULL;
+}
+
+static void tile_render(void *arg) {
+	VS_TRACE_SCOPE("tile_render");
+	tile *t = (tile*) arg;
+
+	unsigned char *pixels = memory_alloc(VS_MEMORY_IMAGES, (size_t) VS_TILE_SIZE * VS_TILE_SIZE * 4);
+	int result = pixels && t->source->render(t->source->user, t->level, t->x, t->y, pixels);
+	if (!result) {
+		memory_free(VS_MEMORY_IMAGES, pixels);
+		pixels = NULL;
+	}
+	t->pixels = pixels;
+	if (!result)
+		atomic_fetch_add(&t->cache->failures, 1);
+	atomic_fetch_sub(&t->cache->n_rendering, 1);
+	atomic_store(&t->job, result ? VS_TILE_RENDERED : VS_TILE_FAILED);
+}
+
+static void tile_free_slot(tile_cache *cache, tile *t) {
+	if (t->slot < 0)
+		return;
+	cache->slots[t->slot] = NULL;
+	t->slot = -1;
+	t->gl_texture = 0;
+}
+
+/*
+ * Finds a slot for a tile, allocating a page while under budget and otherwise taking the slot of the least recently
+ * drawn tile. Tiles asked for in this frame or the last are never evicted.
+ */
+static int tile_allocate_slot(tile_cache *cache) {
+	for (unsigned i = 0; i < cache->n_pages * VS_TILE_PAGE_SLOTS; ++i)
+		if (!cache->slots[i])
+			return i;
+
+	if (!cache->n_pages || (cache->n_pages + 1) * VS_TILE_PAGE_BYTES <= cache->stats.budget) {
+		unsigned *pages = memory_realloc(VS_MEMORY_IMAGES, cache->pages, sizeof(unsigned) * (cache->n_pages + 1));
+		if (!pages)
+			return -1;
+		cache->pages = pages;
+		tile **slots = memory_realloc(VS_MEMORY_IMAGES, cache->slots,
+			sizeof(tile*) * (cache->n_pages + 1) * VS_TILE_PAGE_SLOTS);
+		if (!slots)
+			return -1;
+		cache->slots = slots;
+		memset(slots + cache->n_pages * VS_TILE_PAGE_SLOTS, 0, sizeof(tile*) * VS_TILE_PAGE_SLOTS);
+
+		unsigned *page = &cache->pages[cache->n_pages];
+		glGenTextures(1, page);
+		gl_bind_texture(0, *page);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, VS_TILE_PAGE_SIZE, VS_TILE_PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		memory_gpu_alloc(VS_MEMORY_TEXTURES, VS_TILE_PAGE_BYTES);
+		cache->stats.resident_bytes += VS_TILE_PAGE_BYTES;
+		return cache->n_pages++ * VS_TILE_PAGE_SLOTS;
+	}
+
+	int oldest = -1;
+	unsigned oldest_used = 0;
+	for (unsigned i = 0; i < cache->n_pages * VS_TILE_PAGE_SLOTS; ++i) {
+		unsigned used = atomic_load_explicit(&cache->slots[i]->last_used, memory_order_relaxed);
+		if (used + 1 < cache->frame && (oldest < 0 || used < oldest_used)) {
+			oldest = i;
+			oldest_used = used;
+		}
+	}
+	if (oldest >= 0) {
+		tile_free_slot(cache, cache->slots[oldest]);
+		cache->stats.evictions++;
+	}
+	return oldest;
+}
+
+static int tile_upload(tile_cache *cache, tile *t) {
+	VS_TRACE_SCOPE("tile_upload");
+	if (t->slot < 0) {
+		int slot = tile_allocate_slot(cache);
+		if (slot < 0)
+			return VS_FAILURE;
+		cache->slots[slot] = t;
+		t->slot = slot;
+
+		// Half a texel in from the edges, so neighbours in the page never bleed in when the tile is scaled
+		unsigned index = slot % VS_TILE_PAGE_SLOTS;
+		float x = (float) (index % VS_TILE_PAGE_TILES * VS_TILE_SIZE);
+		float y = (float) (index / VS_TILE_PAGE_TILES * VS_TILE_SIZE);
+		const float s = VS_TILE_PAGE_SIZE;
+		t->gl_texture = cache->pages[slot / VS_TILE_PAGE_SLOTS];
+		t->uv[0] = (x + 0.5f) / s;
+		t->uv[1] = (y + 0.5f) / s;
+		t->uv[2] = (x + VS_TILE_SIZE - 0.5f) / s;
+		t->uv[3] = (y + VS_TILE_SIZE - 0.5f) / s;
+	}
+
+	unsigned index = t->slot % VS_TILE_PAGE_SLOTS;
+	gl_bind_texture(0, t->gl_texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, index % VS_TILE_PAGE_TILES * VS_TILE_SIZE, index / VS_TILE_PAGE_TILES * VS_TILE_SIZE,
+		VS_TILE_SIZE, VS_TILE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, t->pixels);
+	memory_free(VS_MEMORY_IMAGES, t->pixels);
+	t->pixels = NULL;
+	atomic_store(&t->job, VS_TILE_IDLE);
+	cache->stats.uploads++;
+
+	// Layers the content is cached in have to be rendered again with the new tile
+	if (t->source->widget)
+		invalidate_widget(t->source->widget);
+	return VS_SUCCESS;
+}
+
+static void tile_unlink(tile_cache *cache, tile **link) {
+	tile *t = *link;
+	*link = t->next;
+	tile_free_slot(cache, t);
+	memory_free(VS_MEMORY_IMAGES, t->pixels);
+	memory_free(VS_MEMORY_IMAGES, t);
+	cache->n_tiles--;
+}
+
+/*
+ * Sends a tile that was asked for to be rendered, unless it is already being rendered or is up to date
+ */
+static void tile_request_render(tile_cache *cache, const tile_request *request, unsigned max_rendering) {
+	tile *t = tile_find(cache, request->source, request->level, request->x, request->y);
+	if (!t) {
+		t = memory_calloc(VS_MEMORY_IMAGES, 1, sizeof(tile));
+		if (!t)
+			return;
+		t->cache = cache;
+		t->source = request->source;
+		t->level = request->level;
+		t->x = request->x;
+		t->y = request->y;
+		t->slot = -1;
+		t->generation = atomic_load(&request->source->generation) - 1;
+		atomic_init(&t->job, VS_TILE_IDLE);
+		atomic_init(&t->last_used, cache->frame);
+
+		unsigned bucket = tile_hash(t->source, t->level, t->x, t->y);
+		t->next = cache->buckets[bucket];
+		cache->buckets[bucket] = t;
+		cache->n_tiles++;
+	}
+
+	unsigned generation = atomic_load(&t->source->generation);
+	int job = atomic_load(&t->job);
+	if (job == VS_TILE_RENDERING || job == VS_TILE_RENDERED)
+		return;
+	if (t->generation == generation && (t->slot >= 0 || job == VS_TILE_FAILED))
+		return;
+
+	// A burst of requests is not all queued, since most of it would be out of view before it was rendered
+	if (atomic_load(&cache->n_rendering) >= max_rendering) {
+		cache->stats.deferred++;
+		return;
+	}
+	t->generation = generation;
+	atomic_store(&t->job, VS_TILE_RENDERING);
+	atomic_fetch_add(&cache->n_rendering, 1);
+	cache->stats.renders++;
+	jobs_submit(tile_render, t);
+}
+
+void tile_cache_init(tile_cache *cache, unsigned long budget) {
+	memset(cache, 0, sizeof(tile_cache));
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->stats.budget = budget;
+}
+
+void tile_cache_destroy(tile_cache *cache) {
+	pthread_mutex_lock(&cache->lock);
+	for (unsigned b = 0; b < VS_TILE_BUCKETS; ++b) {
+		while (cache->buckets[b]) {
+			while (atomic_load(&cache->buckets[b]->job) == VS_TILE_RENDERING)
+				usleep(1000);
+			tile_unlink(cache, &cache->buckets[b]);
+		}
+	}
+	if (cache->n_pages)
+		gl_delete_textures(cache->n_pages, cache->pages);
+	memory_gpu_free(VS_MEMORY_TEXTURES, cache->n_pages * VS_TILE_PAGE_BYTES);
+	memory_free(VS_MEMORY_IMAGES, cache->pages);
+	memory_free(VS_MEMORY_IMAGES, cache->slots);
+	memory_free(VS_MEMORY_IMAGES, cache->requests);
+	pthread_mutex_unlock(&cache->lock);
+	pthread_mutex_destroy(&cache->lock);
+}
+
+void tile_cache_update(tile_cache *cache) {
+	pthread_mutex_lock(&cache->lock);
+	cache->frame++;
+
+	unsigned uploaded = 0;
+	for (unsigned b = 0; b < VS_TILE_BUCKETS; ++b) {
+		for (tile **link = &cache->buckets[b]; *link;) {
+			tile *t = *link;
+			int job = atomic_load(&t->job);
+			if (job == VS_TILE_RENDERED && uploaded < VS_TILE_UPLOADS && tile_upload(cache, t))
+				uploaded++;
+
+			// Tiles that are neither on the GPU nor on their way there are forgotten once nobody asks for them
+			unsigned used = atomic_load_explicit(&t->last_used, memory_order_relaxed);
+			if (t->slot < 0 && (job == VS_TILE_IDLE || job == VS_TILE_FAILED) && used + VS_TILE_FORGET < cache->frame) {
+				tile_unlink(cache, link);
+				continue;
+			}
+			link = &t->next;
+		}
+	}
+
+	// Tiles that will be drawn go ahead of tiles that are prefetched
+	unsigned max_rendering = jobs_thread_count() * 2;
+	for (int prefetch = 0; prefetch < 2; ++prefetch)
+		for (unsigned i = 0; i < cache->n_requests; ++i)
+			if (cache->requests[i].prefetch == prefetch)
+				tile_request_render(cache, &cache->requests[i], max_rendering);
+	cache->n_requests = 0;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+void tile_cache_set_budget(tile_cache *cache, unsigned long budget) {
+	pthread_mutex_lock(&cache->lock);
+	cache->stats.budget = budget;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+void tile_cache_stats(tile_cache *cache, tile_stats *stats) {
+	pthread_mutex_lock(&cache->lock);
+	*stats = cache->stats;
+	stats->failures = atomic_load(&cache->failures);
+	stats->n_pages = cache->n_pages;
+	stats->n_resident = 0;
+	for (unsigned i = 0; i < cache->n_pages * VS_TILE_PAGE_SLOTS; ++i)
+		stats->n_resident += cache->slots[i] != NULL;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+tile *tile_cache_get(tile_cache *cache, tile_source *source, int level, long x, long y, int prefetch) {
+	// The table only changes in updates, which never run while recording
+	tile *t = tile_find(cache, source, level, x, y);
+	if (t) {
+		atomic_store_explicit(&t->last_used, cache->frame, memory_order_relaxed);
+		int job = atomic_load(&t->job);
+		unsigned generation = atomic_load_explicit(&source->generation, memory_order_relaxed);
+		int wanted = job == VS_TILE_IDLE && (t->slot < 0 || t->generation != generation);
+		wanted = wanted || (job == VS_TILE_FAILED && t->generation != generation);
+		if (!wanted)
+			return t->slot >= 0 ? t : NULL;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	if (cache->n_requests == cache->request_capacity) {
+		unsigned capacity = cache->request_capacity ? cache->request_capacity * 2 : 64;
+		tile_request *requests = memory_realloc(VS_MEMORY_IMAGES, cache->requests, sizeof(tile_request) * capacity);
+		if (!requests) {
+			pthread_mutex_unlock(&cache->lock);
+			return t && t->slot >= 0 ? t : NULL;
+		}
+		cache->requests = requests;
+		cache->request_capacity = capacity;
+	}
+	tile_request *request = &cache->requests[cache->n_requests++];
+	request->source = source;
+	request->level = level;
+	request->x = x;
+	request->y = y;
+	request->prefetch = prefetch;
+	pthread_mutex_unlock(&cache->lock);
+
+	// An out of date tile is drawn until the new one arrives
+	return t && t->slot >= 0 ? t : NULL;
+}
+
+tile *tile_cache_peek(tile_cache *cache, tile_source *source, int level, long x, long y) {
+	tile *t = tile_find(cache, source, level, x, y);
+	if (!t || t->slot < 0)
+		return NULL;
+	atomic_store_explicit(&t->last_used, cache->frame, memory_order_relaxed);
+	return t;
+}
+
+void tile_cache_drop(tile_cache *cache, tile_source *source) {
+	pthread_mutex_lock(&cache->lock);
+	for (unsigned b = 0; b < VS_TILE_BUCKETS; ++b) {
+		for (tile **link = &cache->buckets[b]; *link;) {
+			if ((*link)->source != source) {
+				link = &(*link)->next;
+				continue;
+			}
+			while (atomic_load(&(*link)->job) == VS_TILE_RENDERING)
+				usleep(1000);
+			tile_unlink(cache, link);
+		}
+	}
+
+	unsigned n = 0;
+	for (unsigned i = 0; i < cache->n_requests; ++i)
+		if (cache->requests[i].source != source)
+			cache->requests[n++] = cache->requests[i];
+	cache->n_requests = n;
+	pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,230 @@
+/**
+ * @file tiles.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Cache of content tiles rendered on worker threads
+ *
+ * Content that is too large or too slow to draw every frame is cut into square tiles at power of two zoom levels. Tiles
+ * that are asked for while recording are rendered into memory by their source on the worker pool, and uploaded on the GL
+ * thread into slots of shared page textures, a few per frame. Recording never waits: a tile that is not on the GPU yet is
+ * simply not returned, and the caller draws something else in its place. When the cache runs out of room under its
+ * budget, the least recently drawn tiles give up their slots.
+ */
+
+#ifndef VS_TILES_H
+#define VS_TILES_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/// Width and height of a tile in pixels
+#define VS_TILE_SIZE			256
+
+/// Tiles along each side of a page texture
+#define VS_TILE_PAGE_TILES		4
+
+/// Width and height of a page texture
+#define VS_TILE_PAGE_SIZE		(VS_TILE_SIZE * VS_TILE_PAGE_TILES)
+
+/// Hash buckets tiles are looked up in
+#define VS_TILE_BUCKETS			1024
+
+/// Most tiles uploaded in a single frame
+#define VS_TILE_UPLOADS			8
+
+#define VS_TILE_IDLE			0
+#define VS_TILE_RENDERING		1
+#define VS_TILE_RENDERED		2
+#define VS_TILE_FAILED			3
+
+/**
+ * @brief Content that tiles are rendered from
+ *
+ * render is called on worker threads, any number at once, and must fill pixels with VS_TILE_SIZE rows of VS_TILE_SIZE
+ * RGBA pixels, top to bottom. Tile (x, y) of level l covers VS_TILE_SIZE * 2^l units of content on each side, starting at
+ * x and y times that.
+ */
+typedef struct {
+	int (*render)(void *user, int level, long x, long y, unsigned char *pixels);
+	void *user;
+
+	/// Widget invalidated when one of its tiles arrives, or NULL
+	void *widget;
+
+	/// Raised when the content changes. Tiles of an older generation are drawn until they are rendered again.
+	atomic_uint generation;
+} tile_source;
+
+typedef struct tile_cache tile_cache;
+
+/**
+ * @brief A tile of some content
+ */
+typedef struct tile {
+	tile_cache *cache;
+	tile_source *source;
+	int level;
+	long x;
+	long y;
+
+	/// VS_TILE_IDLE and friends, set to VS_TILE_RENDERED or VS_TILE_FAILED by the worker
+	atomic_int job;
+
+	/// Generation of the content the pixels being rendered or on the GPU are from
+	unsigned generation;
+
+	/// Rendered pixels waiting to be uploaded
+	unsigned char *pixels;
+
+	/// Slot of the page textures the tile is in, or -1 if it is not on the GPU
+	int slot;
+	unsigned gl_texture;
+	float uv[4];
+
+	/// Frame the tile was last asked for
+	atomic_uint last_used;
+
+	struct tile *next;
+} tile;
+
+/**
+ * @brief A tile that was asked for but is not in the cache
+ */
+typedef struct {
+	tile_source *source;
+	int level;
+	long x;
+	long y;
+	int prefetch;
+} tile_request;
+
+/**
+ * @brief Tile cache statistics
+ */
+typedef struct {
+	/// Tiles on the GPU
+	unsigned n_resident;
+
+	/// Page textures and the GPU bytes they hold
+	unsigned n_pages;
+	unsigned long resident_bytes;
+	unsigned long budget;
+
+	/// Totals since the cache was created
+	unsigned long renders;
+	unsigned long uploads;
+	unsigned long evictions;
+	unsigned long failures;
+
+	/// Requests dropped because enough tiles were being rendered already
+	unsigned long deferred;
+} tile_stats;
+
+struct tile_cache {
+	pthread_mutex_t lock;
+
+	tile *buckets[VS_TILE_BUCKETS];
+	unsigned n_tiles;
+
+	/// Tiles asked for while recording that the next update will look at, under the lock
+	unsigned n_requests;
+	unsigned request_capacity;
+	tile_request *requests;
+
+	unsigned n_pages;
+	unsigned *pages;
+
+	/// Tile in each slot, or NULL
+	tile **slots;
+
+	/// Tiles being rendered on the worker pool
+	atomic_uint n_rendering;
+
+	/// Renders that failed, counted by the workers
+	atomic_ulong failures;
+
+	unsigned frame;
+	tile_stats stats;
+};
+
+/**
+ * @brief Initializes a tile cache
+ *
+ * @param cache Pointer to tile cache
+ * @param budget GPU byte budget. At least one page is always allowed.
+ */
+void tile_cache_init(tile_cache *cache, unsigned long budget);
+
+/**
+ * @brief Deletes every tile in a cache and its page textures
+ *
+ * Renders that are still running are waited for. The GL context the cache belongs to must be current.
+ *
+ * @param cache Pointer to tile cache
+ */
+void tile_cache_destroy(tile_cache *cache);
+
+/**
+ * @brief Advances the cache by one frame
+ *
+ * This must be called on the GL thread once per frame, before anything records tiles for the frame. Tiles asked for in
+ * the last frame are sent to be rendered, tiles asked for to be drawn first, and rendered tiles are uploaded.
+ *
+ * @param cache Pointer to tile cache
+ */
+void tile_cache_update(tile_cache *cache);
+
+/**
+ * @brief Sets the GPU byte budget of a tile cache
+ *
+ * Pages already allocated are kept, but no more are allocated while the cache is over the budget.
+ *
+ * @param cache Pointer to tile cache
+ * @param budget GPU byte budget
+ */
+void tile_cache_set_budget(tile_cache *cache, unsigned long budget);
+
+/**
+ * @brief Gets the statistics of a tile cache
+ *
+ * @param cache Pointer to tile cache
+ * @param stats Memory address where the statistics will be saved
+ */
+void tile_cache_stats(tile_cache *cache, tile_stats *stats);
+
+/**
+ * @brief Asks for a tile while recording
+ *
+ * This is safe to call on any thread while recording. A tile that is not in the cache, or is out of date, is rendered
+ * after the next update.
+ *
+ * @param cache Pointer to tile cache
+ * @param source Content of the tile
+ * @param level Zoom level
+ * @param x Column of the tile
+ * @param y Row of the tile
+ * @param prefetch Set when the tile is not going to be drawn yet, so tiles that are go first
+ *
+ * @return Returns the tile if it is on the GPU, or NULL
+ */
+tile *tile_cache_get(tile_cache *cache, tile_source *source, int level, long x, long y, int prefetch);
+
+/**
+ * @brief Looks for a tile without asking for it
+ *
+ * @return Returns the tile if it is on the GPU, or NULL
+ */
+tile *tile_cache_peek(tile_cache *cache, tile_source *source, int level, long x, long y);
+
+/**
+ * @brief Drops every tile of a source
+ *
+ * Renders of the source that are still running are waited for. This must not be called while recording.
+ *
+ * @param cache Pointer to tile cache
+ * @param source Content to drop
+ */
+void tile_cache_drop(tile_cache *cache, tile_source *source);
+
+#endif
@@ -0,0 +1,156 @@
+/**
+ * @file trace.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "trace.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "../venus_common.h"
+#include "memory.h"
+
+atomic_int g_trace_enabled = VS_FALSE;
+
+typedef struct {
+	const char *name;
+	unsigned long start;
+	unsigned long end;
+} trace_event;
+
+/*
+ * A ring of spans written by one thread. Only the owning thread writes to it. Buffers are never freed, since a dump may
+ * be reading one after its thread has exited.
+ */
+typedef struct trace_buffer {
+	long tid;
+	atomic_ulong written;
+	struct trace_buffer *next;
+	trace_event events[VS_TRACE_EVENTS];
+} trace_buffer;
+
+static _Atomic(trace_buffer*) g_trace_buffers = NULL;
+static __thread trace_buffer *t_trace_buffer = NULL;
+
+static volatile sig_atomic_t g_trace_signaled = 0;
+static char *g_trace_signal_path = NULL;
+
+static trace_buffer *trace_thread_buffer() {
+	if (t_trace_buffer)
+		return t_trace_buffer;
+
+	trace_buffer *buffer = memory_calloc(VS_MEMORY_ENGINE, 1, sizeof(trace_buffer));
+	if (!buffer)
+		return NULL;
+	buffer->tid = syscall(SYS_gettid);
+
+	trace_buffer *head = atomic_load(&g_trace_buffers);
+	do {
+		buffer->next = head;
+	} while (!atomic_compare_exchange_weak(&g_trace_buffers, &head, buffer));
+
+	t_trace_buffer = buffer;
+	return buffer;
+}
+
+void trace_record(const char *name, unsigned long start, unsigned long end) {
+	trace_buffer *buffer = trace_thread_buffer();
+	if (!buffer)
+		return;
+
+	unsigned long written = atomic_load_explicit(&buffer->written, memory_order_relaxed);
+	trace_event *event = &buffer->events[written % VS_TRACE_EVENTS];
+	event->name = name;
+	event->start = start;
+	event->end = end;
+	atomic_store_explicit(&buffer->written, written + 1, memory_order_release);
+}
+
+static void trace_write_string(FILE *file, const char *string) {
+	fputc('"', file);
+	for (; *string; ++string) {
+		if (*string == '"' || *string == '\\')
+			fputc('\\', file);
+		fputc(*string, file);
+	}
+	fputc('"', file);
+}
+
+int venus_enable_tracing(int enabled) {
+	atomic_store(&g_trace_enabled, !!enabled);
+	return VS_SUCCESS;
+}
+
+int venus_dump_trace(const char *path) {
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		vs_log_error("Failed to open %s for the trace", path);
+		return VS_FAILURE;
+	}
+
+	long pid = getpid();
+	int first = VS_TRUE;
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+
+	for (trace_buffer *buffer = atomic_load(&g_trace_buffers); buffer; buffer = buffer->next) {
+		unsigned long written = atomic_load_explicit(&buffer->written, memory_order_acquire);
+
+		// Leave a margin for spans the thread may be overwriting while we read
+		unsigned long begin = 0;
+		if (written > VS_TRACE_EVENTS - 64)
+			begin = written - (VS_TRACE_EVENTS - 64);
+
+		for (unsigned long i = begin; i < written; ++i) {
+			trace_event *event = &buffer->events[i % VS_TRACE_EVENTS];
+			if (!first)
+				fputc(',', file);
+			first = VS_FALSE;
+
+			fputs("{\"ph\":\"X\",\"name\":", file);
+			trace_write_string(file, event->name);
+			fprintf(file, ",\"pid\":%ld,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f}",
+				pid, buffer->tid, event->start / 1000.0, (event->end - event->start) / 1000.0
+			);
+		}
+	}
+
+	fputs("]}\n", file);
+	fclose(file);
+	vs_log_info("Wrote trace to %s", path);
+	return VS_SUCCESS;
+}
+
+static void trace_signal_handler(int signum) {
+	g_trace_signaled = 1;
+}
+
+int venus_dump_trace_on_signal(int signum, const char *path) {
+	char *copy = memory_strdup(VS_MEMORY_ENGINE, path);
+	if (!copy)
+		vs_err(VS_FAILURE);
+	memory_free(VS_MEMORY_ENGINE, g_trace_signal_path);
+	g_trace_signal_path = copy;
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(struct sigaction));
+	action.sa_handler = trace_signal_handler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	if (sigaction(signum, &action, NULL))
+		vs_err(VS_FAILURE);
+	return VS_SUCCESS;
+}
+
+void trace_poll() {
+	if (!g_trace_signaled)
+		return;
+	g_trace_signaled = 0;
+	if (g_trace_signal_path)
+		venus_dump_trace(g_trace_signal_path);
+}
@@ -0,0 +1,63 @@
+/**
+ * @file trace.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Span tracing with Chrome trace export
+ *
+ * Spans are written to a ring buffer owned by the thread that records them, so recording never takes a lock. The rings
+ * are only read when a trace is dumped. Use the VS_TRACE_* macros from venus_common.h rather than these functions, so
+ * that tracing disappears when VS_COMPILE_DISABLE_TRACE is defined.
+ */
+
+#ifndef VS_TRACE_H
+#define VS_TRACE_H
+
+#include <stdatomic.h>
+
+#include "profile.h"
+
+/// Number of spans each thread keeps before it starts overwriting the oldest ones
+#define VS_TRACE_EVENTS		65536
+
+/// Set while spans are being recorded
+extern atomic_int g_trace_enabled;
+
+/**
+ * @brief A span that has been started but not finished
+ */
+typedef struct {
+	const char *name;
+	unsigned long start;
+} trace_scope;
+
+/**
+ * @brief Records a finished span on the calling thread
+ *
+ * @param name Name of the span. It must stay valid until the trace is dumped, so it should be a string literal.
+ * @param start Start time from profile_now()
+ * @param end End time from profile_now()
+ */
+void trace_record(const char *name, unsigned long start, unsigned long end);
+
+/**
+ * @brief Dumps the trace if a signal asked for it
+ *
+ * Signal handlers cannot safely write files, so the handler only raises a flag that this checks. It is called once a
+ * frame by swap_buffers().
+ */
+void trace_poll();
+
+static inline trace_scope trace_scope_begin(const char *name) {
+	trace_scope scope = {name, 0};
+	if (atomic_load_explicit(&g_trace_enabled, memory_order_relaxed))
+		scope.start = profile_now();
+	return scope;
+}
+
+static inline void trace_scope_end(trace_scope *scope) {
+	if (scope->start)
+		trace_record(scope->name, scope->start, profile_now());
+}
+
+#endif
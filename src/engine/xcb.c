@@ -0,0 +1,217 @@
+/**
+ * @file xcb.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "graphics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcb/xcbext.h>
+
+#include "../venus_common.h"
+#include "pacing.h"
+#include "profile.h"
+#include "replay.h"
+#include "../toolkit/animation.h"
+
+xcb_connection_t *g_xcb = NULL;		// XCB connection shared with g_display
+
+static const char *g_atom_names[VS_ATOM_COUNT] = {
+	"_NET_WM_NAME",
+	"UTF8_STRING",
+};
+
+static xcb_intern_atom_cookie_t g_atom_cookies[VS_ATOM_COUNT];
+static xcb_atom_t g_atoms[VS_ATOM_COUNT];
+static int g_atoms_resolved[VS_ATOM_COUNT];
+
+int xcb_platform_init() {
+	if (g_xcb)
+		return VS_SUCCESS;
+	if (!g_display)
+		vs_err(VS_FAILURE);
+	g_xcb = XGetXCBConnection(g_display);
+	if (!g_xcb)
+		vs_err(VS_FAILURE);
+	XSetEventQueueOwner(g_display, XCBOwnsEventQueue);
+
+	// The replies come back while the first window is being made and are only read when a title is set
+	for (unsigned i = 0; i < VS_ATOM_COUNT; ++i)
+		g_atom_cookies[i] = xcb_intern_atom(g_xcb, 0, strlen(g_atom_names[i]), g_atom_names[i]);
+	return VS_SUCCESS;
+}
+
+xcb_atom_t xcb_platform_atom(unsigned atom) {
+	if (atom >= VS_ATOM_COUNT || !g_xcb)
+		return XCB_ATOM_NONE;
+	if (!g_atoms_resolved[atom]) {
+		xcb_intern_atom_reply_t *reply = xcb_platform_reply(g_atom_cookies[atom].sequence, NULL);
+		g_atoms[atom] = reply ? reply->atom : XCB_ATOM_NONE;
+		g_atoms_resolved[atom] = VS_TRUE;
+		free(reply);
+	}
+	return g_atoms[atom];
+}
+
+void *xcb_platform_reply(unsigned sequence, xcb_generic_error_t **error) {
+	void *reply = NULL;
+	xcb_generic_error_t *e = NULL;
+	if (!xcb_poll_for_reply(g_xcb, sequence, &reply, &e))
+		reply = xcb_wait_for_reply(g_xcb, sequence, &e);
+	if (error)
+		*error = e;
+	else
+		free(e);
+	return reply;
+}
+
+/*
+ * Fills in the XEvent the rest of venus works with. Returns whether the event is one venus looks at.
+ */
+static int xcb_convert_event(const xcb_generic_event_t *in, XEvent *out) {
+	memset(out, 0, sizeof(XEvent));
+	out->type = in->response_type & ~0x80;
+	out->xany.serial = in->full_sequence;
+	out->xany.send_event = (in->response_type & 0x80) != 0;
+	out->xany.display = g_display;
+
+	switch (out->type) {
+	case KeyPress:
+	case KeyRelease: {
+		const xcb_key_press_event_t *e = (const xcb_key_press_event_t*) in;
+		out->xkey.window = e->event;
+		out->xkey.root = e->root;
+		out->xkey.subwindow = e->child;
+		out->xkey.time = e->time;
+		out->xkey.x = e->event_x;
+		out->xkey.y = e->event_y;
+		out->xkey.x_root = e->root_x;
+		out->xkey.y_root = e->root_y;
+		out->xkey.state = e->state;
+		out->xkey.keycode = e->detail;
+		out->xkey.same_screen = e->same_screen;
+		break;
+	}
+	case ButtonPress:
+	case ButtonRelease: {
+		const xcb_button_press_event_t *e = (const xcb_button_press_event_t*) in;
+		out->xbutton.window = e->event;
+		out->xbutton.root = e->root;
+		out->xbutton.subwindow = e->child;
+		out->xbutton.time = e->time;
+		out->xbutton.x = e->event_x;
+		out->xbutton.y = e->event_y;
+		out->xbutton.x_root = e->root_x;
+		out->xbutton.y_root = e->root_y;
+		out->xbutton.state = e->state;
+		out->xbutton.button = e->detail;
+		out->xbutton.same_screen = e->same_screen;
+		break;
+	}
+	case MotionNotify: {
+		const xcb_motion_notify_event_t *e = (const xcb_motion_notify_event_t*) in;
+		out->xmotion.window = e->event;
+		out->xmotion.root = e->root;
+		out->xmotion.subwindow = e->child;
+		out->xmotion.time = e->time;
+		out->xmotion.x = e->event_x;
+		out->xmotion.y = e->event_y;
+		out->xmotion.x_root = e->root_x;
+		out->xmotion.y_root = e->root_y;
+		out->xmotion.state = e->state;
+		out->xmotion.is_hint = e->detail;
+		out->xmotion.same_screen = e->same_screen;
+		break;
+	}
+	case Expose: {
+		const xcb_expose_event_t *e = (const xcb_expose_event_t*) in;
+		out->xexpose.window = e->window;
+		out->xexpose.x = e->x;
+		out->xexpose.y = e->y;
+		out->xexpose.width = e->width;
+		out->xexpose.height = e->height;
+		out->xexpose.count = e->count;
+		break;
+	}
+	case ConfigureNotify: {
+		const xcb_configure_notify_event_t *e = (const xcb_configure_notify_event_t*) in;
+		out->xconfigure.event = e->event;
+		out->xconfigure.window = e->window;
+		out->xconfigure.x = e->x;
+		out->xconfigure.y = e->y;
+		out->xconfigure.width = e->width;
+		out->xconfigure.height = e->height;
+		out->xconfigure.border_width = e->border_width;
+		out->xconfigure.above = e->above_sibling;
+		out->xconfigure.override_redirect = e->override_redirect;
+		break;
+	}
+	case MapNotify: {
+		const xcb_map_notify_event_t *e = (const xcb_map_notify_event_t*) in;
+		out->xmap.event = e->event;
+		out->xmap.window = e->window;
+		out->xmap.override_redirect = e->override_redirect;
+		break;
+	}
+	case UnmapNotify: {
+		const xcb_unmap_notify_event_t *e = (const xcb_unmap_notify_event_t*) in;
+		out->xunmap.event = e->event;
+		out->xunmap.window = e->window;
+		out->xunmap.from_configure = e->from_configure;
+		break;
+	}
+	case ReparentNotify: {
+		const xcb_reparent_notify_event_t *e = (const xcb_reparent_notify_event_t*) in;
+		out->xreparent.event = e->event;
+		out->xreparent.window = e->window;
+		out->xreparent.parent = e->parent;
+		out->xreparent.x = e->x;
+		out->xreparent.y = e->y;
+		out->xreparent.override_redirect = e->override_redirect;
+		break;
+	}
+	case DestroyNotify: {
+		const xcb_destroy_notify_event_t *e = (const xcb_destroy_notify_event_t*) in;
+		out->xdestroywindow.event = e->event;
+		out->xdestroywindow.window = e->window;
+		break;
+	}
+	default:
+		return VS_FALSE;
+	}
+	return VS_TRUE;
+}
+
+int venus_process_events() {
+	if (!xcb_platform_init())
+		return VS_FAILURE;
+
+	// Windows that were paced or skipped their frame wait here together, before the events their next frames will show
+	pacer_wait();
+	profile_begin(VS_PROFILE_EVENTS);
+
+	// Sends what Xlib has buffered for GLX and XTest along with XCB's own requests
+	XFlush(g_display);
+	xcb_generic_event_t *in;
+	while ((in = xcb_poll_for_event(g_xcb))) {
+		if (!in->response_type) {
+			// Requests that were not waited for report their errors here
+			vs_log_error("X error %u on request %u.%u", ((xcb_generic_error_t*) in)->error_code,
+				((xcb_generic_error_t*) in)->major_code, ((xcb_generic_error_t*) in)->minor_code);
+		} else {
+			XEvent event;
+			if (xcb_convert_event(in, &event) && !replay_blocks(&event))
+				xlib_dispatch_event(&event);
+		}
+		free(in);
+	}
+	replay_dispatch();
+	profile_end(VS_PROFILE_EVENTS);
+
+	// Animations step once per turn of the loop, after the events that may have started or stopped some
+	update_animations();
+	return VS_SUCCESS;
+}
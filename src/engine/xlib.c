@@ -3,3 +3,74 @@
  * Venus Graphics Engine
  * Copyright (C) 2020, Wesley Studt
  */
+
+#include "graphics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "replay.h"
+#include "memory.h"
+
+static window **g_windows = NULL;
+static unsigned g_n_windows = 0;
+
+int xlib_register_window(window *win) {
+	window **windows = memory_realloc(VS_MEMORY_ENGINE, g_windows, sizeof(window*) * (g_n_windows + 1));
+	if (!windows)
+		vs_err(VS_FAILURE);
+	g_windows = windows;
+	g_windows[g_n_windows++] = win;
+	return VS_SUCCESS;
+}
+
+int xlib_unregister_window(window *win) {
+	for (unsigned i = 0; i < g_n_windows; ++i) {
+		if (g_windows[i] == win) {
+			// Keep registration order, since recordings name windows by it
+			memmove(g_windows + i, g_windows + i + 1, sizeof(window*) * (--g_n_windows - i));
+			return VS_SUCCESS;
+		}
+	}
+	return VS_FAILURE;
+}
+
+window *xlib_find_window(Window xwin) {
+	for (unsigned i = 0; i < g_n_windows; ++i)
+		if (g_windows[i]->xwin == xwin)
+			return g_windows[i];
+	return NULL;
+}
+
+unsigned xlib_window_index(window *win) {
+	for (unsigned i = 0; i < g_n_windows; ++i)
+		if (g_windows[i] == win)
+			return i;
+	return g_n_windows;
+}
+
+window *xlib_window_at(unsigned index) {
+	return index < g_n_windows ? g_windows[index] : NULL;
+}
+
+int xlib_dispatch_event(XEvent *event) {
+	window *win = xlib_find_window(event->xany.window);
+	if (!win)
+		return VS_FAILURE;
+	replay_record_event(event, xlib_window_index(win));
+
+	// Only the size is kept, so a drag's burst of ConfigureNotify costs nothing until the next frame
+	if (event->type == ConfigureNotify)
+		resize_configure(&win->resize, event->xconfigure.width, event->xconfigure.height);
+	else if (event->type == Expose)
+		pacer_damage(&win->pacer);
+
+	latency_event stamps;
+	int followed = latency_arrive(&stamps, event);
+	if (win->event_callback)
+		win->event_callback(win, event);
+	if (followed)
+		latency_dispatched(&win->latency, &stamps);
+	return VS_SUCCESS;
+}
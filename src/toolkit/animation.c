@@ -0,0 +1,390 @@
+/**
+ * @file animation.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "animation.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "../engine/memory.h"
+#include "../engine/profile.h"
+#include "widget.h"
+
+/*
+ * Four lanes, which every SIMD instruction set has. GCC and Clang lower these to SSE, NEON or plain scalar code,
+ * whichever the target has.
+ */
+typedef float vs_f4 __attribute__((vector_size(16)));
+typedef int vs_i4 __attribute__((vector_size(16)));
+
+#define F4(x)	((vs_f4) {x, x, x, x})
+
+/*
+ * The arrays of a batch are only aligned like floats, so lanes are loaded and stored through memcpy
+ */
+static inline vs_f4 f4_load(const float *p) {
+	vs_f4 v;
+	memcpy(&v, p, sizeof(vs_f4));
+	return v;
+}
+
+static inline void f4_store(float *p, vs_f4 v) {
+	memcpy(p, &v, sizeof(vs_f4));
+}
+
+static inline vs_f4 f4_select(vs_i4 mask, vs_f4 a, vs_f4 b) {
+	return (vs_f4) (((vs_i4) a & mask) | ((vs_i4) b & ~mask));
+}
+
+/// Animations a batch grows by, which keeps every batch a whole number of vectors long
+#define VS_ANIM_GROWTH		64
+
+/// Keyframes kept in the track itself instead of allocated
+#define VS_ANIM_LOCAL_KEYS	2
+
+/*
+ * The part of an animation that is only looked at when it moves from one keyframe to the next
+ */
+typedef struct {
+	widget_t *widget;
+	unsigned property;
+	unsigned flags;
+	unsigned n_keys;
+
+	/// Keyframe the current segment starts at
+	unsigned key;
+	int finished;
+
+	animation_key *keys;
+	animation_key local[VS_ANIM_LOCAL_KEYS];
+} anim_track;
+
+/*
+ * Animations with the same easing curve, one array per field. Lanes past n hold whatever was there last and are
+ * evaluated along with the rest, but never written out.
+ */
+typedef struct {
+	unsigned n;
+	unsigned capacity;
+
+	/// Seconds into the current segment, negative during a delay
+	float *elapsed;
+	float *inv_duration;
+	float *from;
+	float *to;
+	float *value;
+
+	anim_track *tracks;
+} anim_batch;
+
+static anim_batch g_batches[VS_EASE_COUNT];
+static unsigned long g_last_update = 0;
+static animation_stats g_stats;
+
+/*
+ * What a property change leaves out of date
+ */
+#define VS_ANIM_CLEAN		0
+#define VS_ANIM_MOVED		1
+#define VS_ANIM_RESIZED		2
+
+static inline const animation_key *anim_keys(const anim_track *t) {
+	return t->n_keys > VS_ANIM_LOCAL_KEYS ? t->keys : t->local;
+}
+
+static unsigned char anim_channel(float value) {
+	long v = lrintf(value);
+	return v < 0 ? 0 : v > 255 ? 255 : (unsigned char) v;
+}
+
+static float anim_get(const widget_t *w, unsigned property) {
+	switch (property) {
+	case VS_ANIM_X:
+		return (float) w->x;
+	case VS_ANIM_Y:
+		return (float) w->y;
+	case VS_ANIM_WIDTH:
+		return (float) w->width;
+	case VS_ANIM_HEIGHT:
+		return (float) w->height;
+	case VS_ANIM_OPACITY:
+		return (255 - w->fade[3]) / 255.0f;
+	default:
+		return (float) (255 - w->fade[property - VS_ANIM_RED]);
+	}
+}
+
+static unsigned anim_set(widget_t *w, unsigned property, float value) {
+	switch (property) {
+	case VS_ANIM_X:
+	case VS_ANIM_Y: {
+		int *field = property == VS_ANIM_X ? &w->x : &w->y;
+		int v = (int) lrintf(value);
+		if (*field == v)
+			return VS_ANIM_CLEAN;
+		*field = v;
+		return VS_ANIM_MOVED;
+	}
+	case VS_ANIM_WIDTH:
+	case VS_ANIM_HEIGHT: {
+		unsigned *field = property == VS_ANIM_WIDTH ? &w->width : &w->height;
+		long v = lrintf(value);
+		unsigned size = v < 0 ? 0 : (unsigned) v;
+		if (*field == size)
+			return VS_ANIM_CLEAN;
+		*field = size;
+		return VS_ANIM_RESIZED;
+	}
+	default: {
+		unsigned channel = property == VS_ANIM_OPACITY ? 3 : property - VS_ANIM_RED;
+		unsigned char fade = 255 - anim_channel(property == VS_ANIM_OPACITY ? value * 255.0f : value);
+		if (w->fade[channel] == fade)
+			return VS_ANIM_CLEAN;
+		w->fade[channel] = fade;
+		return VS_ANIM_MOVED;
+	}
+	}
+}
+
+static int anim_grow(anim_batch *b) {
+	unsigned capacity = b->capacity + VS_ANIM_GROWTH;
+	anim_track *tracks = memory_realloc(VS_MEMORY_WIDGETS, b->tracks, sizeof(anim_track) * capacity);
+	if (!tracks)
+		return VS_FAILURE;
+	b->tracks = tracks;
+
+	// Every field array lives in one block
+	float *block = memory_calloc(VS_MEMORY_WIDGETS, (size_t) capacity * 5, sizeof(float));
+	if (!block)
+		return VS_FAILURE;
+	float *old = b->elapsed;
+	float **fields[] = {&b->elapsed, &b->inv_duration, &b->from, &b->to, &b->value};
+	for (unsigned i = 0; i < 5; ++i) {
+		if (old)
+			memcpy(block + (size_t) capacity * i, *fields[i], sizeof(float) * b->n);
+		*fields[i] = block + (size_t) capacity * i;
+	}
+	memory_free(VS_MEMORY_WIDGETS, old);
+	b->capacity = capacity;
+	return VS_SUCCESS;
+}
+
+static void anim_set_segment(anim_batch *b, unsigned i) {
+	const anim_track *t = &b->tracks[i];
+	const animation_key *keys = anim_keys(t);
+	float duration = keys[t->key + 1].time - keys[t->key].time;
+	b->from[i] = keys[t->key].value;
+	b->to[i] = keys[t->key + 1].value;
+	b->inv_duration[i] = duration > 0.0f ? 1.0f / duration : 0.0f;
+}
+
+/*
+ * Moves an animation on to the segment its clock is in, and finishes it when it has gone past the last keyframe
+ */
+static void anim_advance(anim_batch *b, unsigned i) {
+	anim_track *t = &b->tracks[i];
+	const animation_key *keys = anim_keys(t);
+	float total = keys[t->n_keys - 1].time - keys[0].time;
+
+	// After a long stall a repeating animation picks up where it would have been instead of stepping through every lap
+	if (t->flags & VS_ANIM_REPEAT) {
+		float position = keys[t->key].time - keys[0].time + b->elapsed[i];
+		if (position >= total) {
+			t->key = 0;
+			b->elapsed[i] = fmodf(position, total);
+		}
+	}
+
+	float duration = keys[t->key + 1].time - keys[t->key].time;
+	while (b->elapsed[i] >= duration) {
+		if (t->key + 2 < t->n_keys) {
+			t->key++;
+		} else if (t->flags & VS_ANIM_REPEAT) {
+			t->key = 0;
+		} else {
+			t->finished = VS_TRUE;
+			b->from[i] = keys[t->n_keys - 1].value;
+			b->to[i] = b->from[i];
+			return;
+		}
+		b->elapsed[i] -= duration;
+		duration = keys[t->key + 1].time - keys[t->key].time;
+	}
+	anim_set_segment(b, i);
+}
+
+static void anim_remove(anim_batch *b, unsigned i) {
+	anim_track *t = &b->tracks[i];
+	if (t->n_keys > VS_ANIM_LOCAL_KEYS)
+		memory_free(VS_MEMORY_WIDGETS, t->keys);
+	g_stats.live--;
+
+	unsigned last = --b->n;
+	if (i == last)
+		return;
+	b->tracks[i] = b->tracks[last];
+	b->elapsed[i] = b->elapsed[last];
+	b->inv_duration[i] = b->inv_duration[last];
+	b->from[i] = b->from[last];
+	b->to[i] = b->to[last];
+	b->value[i] = b->value[last];
+}
+
+/*
+ * Evaluates every lane of a batch with an easing curve, given as an expression of the progress p through the segment
+ */
+#define VS_ANIM_KERNEL(NAME, EXPR)																\
+static void anim_evaluate_##NAME(anim_batch *b) {												\
+	for (unsigned i = 0; i < b->n; i += 4) {													\
+		vs_f4 p = f4_load(b->elapsed + i) * f4_load(b->inv_duration + i);						\
+		p = f4_select(p < F4(0.0f), F4(0.0f), p);												\
+		p = f4_select(p > F4(1.0f), F4(1.0f), p);												\
+		vs_f4 q = F4(1.0f) - p;																	\
+		(void) q;																				\
+		vs_f4 e = (EXPR);																		\
+		vs_f4 from = f4_load(b->from + i);														\
+		f4_store(b->value + i, from + (f4_load(b->to + i) - from) * e);							\
+	}																							\
+}
+
+VS_ANIM_KERNEL(linear,			p)
+VS_ANIM_KERNEL(in_quad,			p * p)
+VS_ANIM_KERNEL(out_quad,		F4(1.0f) - q * q)
+VS_ANIM_KERNEL(in_out_quad,		f4_select(p < F4(0.5f), F4(2.0f) * p * p, F4(1.0f) - F4(2.0f) * q * q))
+VS_ANIM_KERNEL(in_cubic,		p * p * p)
+VS_ANIM_KERNEL(out_cubic,		F4(1.0f) - q * q * q)
+VS_ANIM_KERNEL(in_out_cubic,	f4_select(p < F4(0.5f), F4(4.0f) * p * p * p, F4(1.0f) - F4(4.0f) * q * q * q))
+
+static void (*const g_kernels[VS_EASE_COUNT])(anim_batch *b) = {
+	anim_evaluate_linear,
+	anim_evaluate_in_quad,
+	anim_evaluate_out_quad,
+	anim_evaluate_in_out_quad,
+	anim_evaluate_in_cubic,
+	anim_evaluate_out_cubic,
+	anim_evaluate_in_out_cubic
+};
+
+int animate_widget(void *widget, unsigned property, const animation_key *keys, unsigned n_keys, unsigned easing,
+	float delay, unsigned flags) {
+	widget_t *w = (widget_t*) widget;
+	if (property >= VS_ANIM_N_PROPERTIES || easing >= VS_EASE_COUNT || n_keys < 2)
+		vs_err(VS_FAILURE);
+	for (unsigned i = 1; i < n_keys; ++i)
+		if (keys[i].time < keys[i - 1].time)
+			vs_err(VS_FAILURE);
+	if (keys[n_keys - 1].time <= keys[0].time)
+		vs_err(VS_FAILURE);
+
+	if (w->animated & (1 << property))
+		stop_animations(w, property);
+
+	anim_batch *b = &g_batches[easing];
+	if (b->n == b->capacity && !anim_grow(b))
+		vs_err(VS_FAILURE);
+
+	anim_track *t = &b->tracks[b->n];
+	memset(t, 0, sizeof(anim_track));
+	animation_key *dest = t->local;
+	if (n_keys > VS_ANIM_LOCAL_KEYS) {
+		dest = t->keys = memory_alloc(VS_MEMORY_WIDGETS, sizeof(animation_key) * n_keys);
+		if (!dest)
+			vs_err(VS_FAILURE);
+	}
+	memcpy(dest, keys, sizeof(animation_key) * n_keys);
+	t->widget = w;
+	t->property = property;
+	t->flags = flags;
+	t->n_keys = n_keys;
+
+	unsigned i = b->n++;
+	b->elapsed[i] = -delay;
+	anim_set_segment(b, i);
+	w->animated |= 1 << property;
+	g_stats.live++;
+	return VS_SUCCESS;
+}
+
+int animate_widget_to(void *widget, unsigned property, float value, float duration, unsigned easing) {
+	if (property >= VS_ANIM_N_PROPERTIES)
+		vs_err(VS_FAILURE);
+	animation_key keys[] = {
+		{0.0f,		anim_get((widget_t*) widget, property)},
+		{duration,	value}
+	};
+	return animate_widget(widget, property, keys, 2, easing, 0.0f, 0);
+}
+
+void stop_animations(void *widget, unsigned property) {
+	widget_t *w = (widget_t*) widget;
+	unsigned mask = property == VS_ANIM_ALL ? 0xFF : 1 << property;
+	if (!(w->animated & mask))
+		return;
+
+	for (unsigned e = 0; e < VS_EASE_COUNT; ++e) {
+		anim_batch *b = &g_batches[e];
+		for (unsigned i = b->n; i-- > 0;)
+			if (b->tracks[i].widget == w && (mask & (1 << b->tracks[i].property)))
+				anim_remove(b, i);
+	}
+	w->animated &= ~mask;
+}
+
+void update_animations() {
+	unsigned long now = profile_now();
+	float dt = g_last_update ? (now - g_last_update) / 1e9f : 0.0f;
+	g_last_update = now;
+	if (!g_stats.live)
+		return;
+	VS_TRACE_SCOPE("update_animations");
+
+	for (unsigned e = 0; e < VS_EASE_COUNT; ++e) {
+		anim_batch *b = &g_batches[e];
+		if (!b->n)
+			continue;
+
+		for (unsigned i = 0; i < b->n; i += 4)
+			f4_store(b->elapsed + i, f4_load(b->elapsed + i) + F4(dt));
+
+		// Only animations that crossed a keyframe take the slow path
+		unsigned finished = 0;
+		for (unsigned i = 0; i < b->n; ++i) {
+			if (b->elapsed[i] * b->inv_duration[i] >= 1.0f || !b->inv_duration[i]) {
+				anim_advance(b, i);
+				finished += b->tracks[i].finished;
+			}
+		}
+
+		g_kernels[e](b);
+		g_stats.evaluated += b->n;
+
+		for (unsigned i = 0; i < b->n; ++i) {
+			widget_t *w = b->tracks[i].widget;
+			unsigned dirty = anim_set(w, b->tracks[i].property, b->value[i]);
+			if (dirty == VS_ANIM_CLEAN)
+				continue;
+			g_stats.changed++;
+
+			// A widget that only moved or was tinted looks the same to a layer of its own
+			invalidate_widget(dirty == VS_ANIM_MOVED && w->parent ? w->parent : w);
+		}
+
+		for (unsigned i = b->n; finished && i-- > 0;) {
+			if (!b->tracks[i].finished)
+				continue;
+			b->tracks[i].widget->animated &= ~(1 << b->tracks[i].property);
+			anim_remove(b, i);
+			g_stats.finished++;
+			finished--;
+		}
+	}
+	g_stats.update_ns = profile_now() - now;
+}
+
+void get_animation_stats(animation_stats *stats) {
+	*stats = g_stats;
+}
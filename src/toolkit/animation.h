@@ -0,0 +1,135 @@
+/**
+ * @file animation.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Keyframed animation of widget properties
+ *
+ * Animations are kept in one batch for each easing curve, with every field in its own array. Once per turn of the event
+ * loop, venus_process_events() advances all of them together: the clock, the easing curve and the interpolation run four
+ * animations at a time, and only the step from one keyframe to the next and writing the results out are done one by one.
+ * A result that does not change the property, because it rounds to the same pixel or the same color, is not written, so
+ * it neither invalidates nor damages anything.
+ */
+
+#ifndef VS_ANIMATION_H
+#define VS_ANIMATION_H
+
+/*
+ * Properties that can be animated. Positions and sizes are in pixels, opacity goes from 0 to 1 and the tint channels
+ * from 0 to 255, as with set_widget_tint().
+ */
+#define VS_ANIM_X				0
+#define VS_ANIM_Y				1
+#define VS_ANIM_WIDTH			2
+#define VS_ANIM_HEIGHT			3
+#define VS_ANIM_OPACITY			4
+#define VS_ANIM_RED				5
+#define VS_ANIM_GREEN			6
+#define VS_ANIM_BLUE			7
+#define VS_ANIM_N_PROPERTIES	8
+
+/// Every property, for stop_animations()
+#define VS_ANIM_ALL				VS_ANIM_N_PROPERTIES
+
+/*
+ * Easing curves applied between each pair of keyframes
+ */
+#define VS_EASE_LINEAR			0
+#define VS_EASE_IN_QUAD			1
+#define VS_EASE_OUT_QUAD		2
+#define VS_EASE_IN_OUT_QUAD		3
+#define VS_EASE_IN_CUBIC		4
+#define VS_EASE_OUT_CUBIC		5
+#define VS_EASE_IN_OUT_CUBIC	6
+#define VS_EASE_COUNT			7
+
+/// Start over from the first keyframe after the last one, until stopped
+#define VS_ANIM_REPEAT			0x0001
+
+/**
+ * @brief A value a property passes through
+ */
+typedef struct {
+	/// Seconds since the animation started
+	float time;
+	float value;
+} animation_key;
+
+/**
+ * @brief Animation counts
+ */
+typedef struct {
+	/// Animations running
+	unsigned long live;
+
+	/// Animations evaluated since the program started, counted once per frame each
+	unsigned long evaluated;
+
+	/// Properties that were written because their value changed
+	unsigned long changed;
+
+	/// Animations that reached their last keyframe
+	unsigned long finished;
+
+	/// Time the last update took
+	unsigned long update_ns;
+} animation_stats;
+
+/**
+ * @brief Animates a property of a widget through keyframes
+ *
+ * An animation already running on the same property of the widget is replaced. The property keeps the value of the last
+ * keyframe once the animation is over.
+ *
+ * @param widget Pointer to widget
+ * @param property VS_ANIM_X and friends
+ * @param keys Keyframes, in order of time. The first should be at time 0.
+ * @param n_keys Number of keyframes, at least 2
+ * @param easing VS_EASE_LINEAR and friends
+ * @param delay Seconds to hold the first keyframe's value for before starting
+ * @param flags VS_ANIM_REPEAT, or 0
+ *
+ * @return Returns whether it was successful or not
+ */
+int animate_widget(void *widget, unsigned property, const animation_key *keys, unsigned n_keys, unsigned easing,
+	float delay, unsigned flags);
+
+/**
+ * @brief Animates a property of a widget from where it is to a value
+ *
+ * @param widget Pointer to widget
+ * @param property VS_ANIM_X and friends
+ * @param value Value to end at
+ * @param duration Seconds the animation takes
+ * @param easing VS_EASE_LINEAR and friends
+ *
+ * @return Returns whether it was successful or not
+ */
+int animate_widget_to(void *widget, unsigned property, float value, float duration, unsigned easing);
+
+/**
+ * @brief Stops the animations of a widget where they are
+ *
+ * Widgets stop their animations when they are destroyed.
+ *
+ * @param widget Pointer to widget
+ * @param property VS_ANIM_X and friends, or VS_ANIM_ALL
+ */
+void stop_animations(void *widget, unsigned property);
+
+/**
+ * @brief Advances every animation to the current time and writes the properties that changed
+ *
+ * This is called by venus_process_events().
+ */
+void update_animations();
+
+/**
+ * @brief Gets the animation counts
+ *
+ * @param stats Memory address where the counts will be saved
+ */
+void get_animation_stats(animation_stats *stats);
+
+#endif
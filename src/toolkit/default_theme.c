@@ -8,26 +8,187 @@
 
 #include "default_theme.h"
 
+#include <math.h>
+
 #include "../window.h"
+#include "../venus_common.h"
 #include "theme.h"
 
+#include "widget.h"
 #include "widgets/text_field.h"
 #include "widgets/panel.h"
+#include "widgets/image.h"
+#include "widgets/chart.h"
 
 vtheme g_theme;
 
+static const unsigned char panel_white[] = {0xFF, 0xFF, 0xFF, 0xFF};
+
+static const vstyle default_style = {
+	.background = {0xEE, 0xEE, 0xEE, 0xFF},
+	.foreground = {0x21, 0x21, 0x21, 0xFF},
+	.border = {0x8A, 0x8A, 0x8A, 0xFF},
+	.font = "sans-serif",
+	.font_size = 12
+};
+
+static const vstyle_rule default_rules[] = {
+	{VS_TEXT_FIELD_ID, 0, VS_STYLE_BACKGROUND | VS_STYLE_BORDER_WIDTH | VS_STYLE_PADDING, {
+		.background = {0xFF, 0xFF, 0xFF, 0xFF}, .border_width = 1, .padding = {4, 6, 4, 6}
+	}},
+	{VS_TEXT_FIELD_ID, VS_STATE_HOVER, VS_STYLE_BORDER, {.border = {0x5A, 0x5A, 0x5A, 0xFF}}},
+	{VS_TEXT_FIELD_ID, VS_STATE_FOCUS, VS_STYLE_BORDER, {.border = {0x21, 0x96, 0xF3, 0xFF}}},
+	{VS_TEXT_FIELD_ID, VS_STATE_DISABLED, VS_STYLE_BACKGROUND | VS_STYLE_FOREGROUND | VS_STYLE_BORDER, {
+		.background = {0xF4, 0xF4, 0xF4, 0xFF}, .foreground = {0x9E, 0x9E, 0x9E, 0xFF}, .border = {0xC8, 0xC8, 0xC8, 0xFF}
+	}},
+	{VS_IMAGE_ID, 0, VS_STYLE_FOREGROUND, {.foreground = {0xFF, 0xFF, 0xFF, 0xFF}}},
+	{VS_IMAGE_ID, VS_STATE_DISABLED, VS_STYLE_FOREGROUND, {.foreground = {0xFF, 0xFF, 0xFF, 0x80}}}
+};
+
 void set_default_venus_theme(vtheme *theme) {
 	theme->draw_text_field = draw_text_field_default;
 	theme->draw_panel = draw_panel_default;
+	theme->draw_image = draw_image_default;
+	theme->draw_chart = draw_chart_default;
+	theme->base = default_style;
+	theme->rules = default_rules;
+	theme->n_rules = sizeof(default_rules) / sizeof(vstyle_rule);
 }
 
 int draw_text_field_default(window *win, void *text_field, void **params, unsigned n_params) {
 	vtext_field *t_f = (vtext_field*) text_field;
-	char *string = t_f->current_text;
-	
+	const vstyle *style = get_style(t_f);
+	render_list *list = params[VS_DRAW_PARAM_LIST];
+	int *origin = params[VS_DRAW_PARAM_ORIGIN];
 	
+	float x = origin[0];
+	float y = origin[1];
+	float border = style->border_width;
+	if (border)
+		render_push_quad(list, x, y, t_f->width, t_f->height, style->border, 0, NULL);
+	render_push_quad(list, x + border, y + border, t_f->width - border * 2, t_f->height - border * 2, style->background, 0,
+		NULL);
+	return VS_SUCCESS;
 }
 
 int draw_panel_default(window *win, void *panel, void **params, unsigned n_params) {
+	vpanel *p = (vpanel*) panel;
+	render_list *list = params[VS_DRAW_PARAM_LIST];
+	int *origin = params[VS_DRAW_PARAM_ORIGIN];
+	
+	const vstyle *style = get_style(p);
+	
+	// Panels that float over the window, like popups, are styled with a shadow and a blurred backdrop
+	if (style->shadow[3])
+		effect_draw_shadow(&win->effects, list, origin[0] + style->shadow_offset[0], origin[1] + style->shadow_offset[1],
+			p->width, p->height, style->radius, style->shadow_blur, style->shadow);
+	if (style->backdrop_blur)
+		render_push_backdrop(list, origin[0], origin[1], p->width, p->height, style->backdrop_blur, panel_white);
+	render_push_quad(list, origin[0], origin[1], p->width, p->height, style->background, 0, NULL);
+	return VS_SUCCESS;
+}
+
+int draw_image_default(window *win, void *image, void **params, unsigned n_params) {
+	vimage *i = (vimage*) image;
+	render_list *list = params[VS_DRAW_PARAM_LIST];
+	int *origin = params[VS_DRAW_PARAM_ORIGIN];
+	
+	if (!i->texture)
+		return VS_SUCCESS;
+	
+	unsigned width = i->width ? i->width : i->texture->width;
+	unsigned height = i->height ? i->height : i->texture->height;
+	
+	// Images that are still loading are simply left out until they are ready
+	texture_touch(i->texture, width, height);
+	if (!texture_ready(i->texture))
+		return VS_SUCCESS;
+	
+	if (!i->width || !i->height) {
+		width = i->texture->width;
+		height = i->texture->height;
+	}
+	render_push_quad(list, origin[0], origin[1], width, height, get_style(i)->foreground, i->texture->gl_texture,
+		i->texture->uv);
+	return VS_SUCCESS;
+}
+
+// Columns fetched from the pyramid at a time, so drawing needs no memory of its own
+#define VS_CHART_BATCH		256
+
+int draw_chart_default(window *win, void *chart, void **params, unsigned n_params) {
+	vchart *c = (vchart*) chart;
+	render_list *list = params[VS_DRAW_PARAM_LIST];
+	int *origin = params[VS_DRAW_PARAM_ORIGIN];
+	
+	render_push_quad(list, origin[0], origin[1], c->width, c->height, get_style(c)->background, 0, NULL);
+	if (!c->width || !c->height)
+		return VS_SUCCESS;
 	
+	float top = origin[1];
+	float bottom = top + c->height;
+	float scale = c->height / (c->y_max - c->y_min);
+	vchart view = *c;
+	for (unsigned s = 0; s < c->n_series; ++s) {
+		const chart_series *series = &c->series[s];
+		float min[VS_CHART_BATCH];
+		float max[VS_CHART_BATCH];
+		float last_min = INFINITY;
+		float last_max = -INFINITY;
+		
+		// Columns with the same extent are drawn as one quad, which flat stretches of a series are made of
+		float run_x = 0;
+		float run_top = 0;
+		float run_bottom = 0;
+		unsigned run = 0;
+		
+		for (unsigned begin = 0; begin < c->width; begin += VS_CHART_BATCH) {
+			unsigned n = c->width - begin < VS_CHART_BATCH ? c->width - begin : VS_CHART_BATCH;
+			view.first = c->first + c->span * begin / c->width;
+			view.span = c->span * n / c->width;
+			get_chart_columns(&view, series, n, min, max);
+			
+			// Runs carry over into the next batch, and are ended after the last one
+			unsigned end = begin + n < c->width ? n : n + 1;
+			for (unsigned i = 0; i < end; ++i) {
+				float y0 = 0;
+				float y1 = 0;
+				int empty = i == n || min[i] > max[i];
+				if (!empty) {
+					// Stretching to meet the last column keeps the plot connected
+					float hi = max[i] > last_min ? max[i] : last_min;
+					float lo = min[i] < last_max ? min[i] : last_max;
+					if (last_min > last_max) {
+						hi = max[i];
+						lo = min[i];
+					}
+					last_min = min[i];
+					last_max = max[i];
+					
+					y0 = floorf(top + (c->y_max - hi) * scale);
+					y1 = floorf(top + (c->y_max - lo) * scale) + 1;
+					y0 = y0 < top ? top : y0;
+					y1 = y1 > bottom ? bottom : y1;
+					if (run && y0 == run_top && y1 == run_bottom) {
+						run++;
+						continue;
+					}
+				} else if (i < n) {
+					last_min = INFINITY;
+					last_max = -INFINITY;
+				}
+				
+				if (run && run_top < run_bottom)
+					render_push_quad(list, run_x, run_top, run, run_bottom - run_top, series->color, 0, NULL);
+				run = 0;
+				if (!empty) {
+					run_x = origin[0] + begin + i;
+					run_top = y0;
+					run_bottom = y1;
+					run = 1;
+				}
+			}
+		}
+	}
+	return VS_SUCCESS;
 }
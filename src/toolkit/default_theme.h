@@ -10,3 +10,5 @@
 
 int draw_text_field_default(window *win, void *text_field, void **params, unsigned n_params);
 int draw_panel_default(window *win, void *panel, void **params, unsigned n_params);
+int draw_image_default(window *win, void *image, void **params, unsigned n_params);
+int draw_chart_default(window *win, void *chart, void **params, unsigned n_params);
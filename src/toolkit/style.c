@@ -0,0 +1,143 @@
+/**
+ * @file style.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "style.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "../venus_common.h"
+#include "../engine/graphics.h"
+#include "../engine/memory.h"
+#include "theme.h"
+#include "widget.h"
+
+#define VS_STATE_MASK			((1u << VS_STATE_BITS) - 1)
+
+/*
+ * Resolved styles by type and state. Entries are filled in the first time they are asked for and only freed when the
+ * theme is switched, so widgets can hold on to them.
+ */
+static vstyle *g_styles[VS_WIDGET_MAX_TYPES][1 << VS_STATE_BITS];
+static pthread_mutex_t g_style_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Copy of the rules of the theme last given to set_theme(), which g_theme points to
+static vstyle_rule *g_theme_rules = NULL;
+
+static void style_apply(vstyle *style, const vstyle_rule *rule) {
+	const vstyle *values = &rule->values;
+	if (rule->properties & VS_STYLE_BACKGROUND)
+		memcpy(style->background, values->background, 4);
+	if (rule->properties & VS_STYLE_FOREGROUND)
+		memcpy(style->foreground, values->foreground, 4);
+	if (rule->properties & VS_STYLE_BORDER)
+		memcpy(style->border, values->border, 4);
+	if (rule->properties & VS_STYLE_BORDER_WIDTH)
+		style->border_width = values->border_width;
+	if (rule->properties & VS_STYLE_PADDING)
+		memcpy(style->padding, values->padding, sizeof(style->padding));
+	if (rule->properties & VS_STYLE_RADIUS)
+		style->radius = values->radius;
+	if (rule->properties & VS_STYLE_FONT)
+		style->font = values->font;
+	if (rule->properties & VS_STYLE_FONT_SIZE)
+		style->font_size = values->font_size;
+	if (rule->properties & VS_STYLE_SHADOW) {
+		memcpy(style->shadow, values->shadow, 4);
+		style->shadow_blur = values->shadow_blur;
+		memcpy(style->shadow_offset, values->shadow_offset, sizeof(style->shadow_offset));
+	}
+	if (rule->properties & VS_STYLE_BACKDROP)
+		style->backdrop_blur = values->backdrop_blur;
+}
+
+static const vstyle *style_lookup(unsigned type, unsigned state) {
+	if (type >= VS_WIDGET_MAX_TYPES)
+		type = 0;
+	state &= VS_STATE_MASK;
+
+	vstyle *style = g_styles[type][state];
+	if (style)
+		return style;
+
+	style = memory_alloc(VS_MEMORY_WIDGETS, sizeof(vstyle));
+	if (!style)
+		return &g_theme.base;
+	*style = g_theme.base;
+	for (unsigned i = 0; i < g_theme.n_rules; ++i) {
+		const vstyle_rule *rule = &g_theme.rules[i];
+		if ((!rule->type || rule->type == type) && (state & rule->state) == rule->state)
+			style_apply(style, rule);
+	}
+	g_styles[type][state] = style;
+	return style;
+}
+
+const vstyle *resolve_style(unsigned type, unsigned state) {
+	pthread_mutex_lock(&g_style_lock);
+	const vstyle *style = style_lookup(type, state);
+	pthread_mutex_unlock(&g_style_lock);
+	return style;
+}
+
+const vstyle *get_style(void *widget) {
+	const vstyle *style = ((widget_t*) widget)->style;
+	return style ? style : &g_theme.base;
+}
+
+int set_widget_state(void *widget, unsigned state) {
+	widget_t *w = (widget_t*) widget;
+	if (w->state == state)
+		return VS_SUCCESS;
+	w->state = state;
+	w->style = resolve_style(w->type, state);
+	invalidate_widget(w);
+	return VS_SUCCESS;
+}
+
+static void restyle_widget(void *widget, void *arg) {
+	widget_t *w = (widget_t*) widget;
+	w->style = style_lookup(w->type, w->state);
+}
+
+int set_theme(const vtheme *theme) {
+	vstyle *old[VS_WIDGET_MAX_TYPES][1 << VS_STATE_BITS];
+
+	// The caller may free or reuse its rules as soon as this returns
+	vstyle_rule *rules = NULL;
+	if (theme->n_rules) {
+		rules = memory_alloc(VS_MEMORY_WIDGETS, sizeof(vstyle_rule) * theme->n_rules);
+		if (!rules)
+			vs_err(VS_FAILURE);
+		memcpy(rules, theme->rules, sizeof(vstyle_rule) * theme->n_rules);
+	}
+
+	pthread_mutex_lock(&g_style_lock);
+	vstyle_rule *old_rules = g_theme_rules;
+	g_theme = *theme;
+	g_theme.rules = rules;
+	g_theme_rules = rules;
+	memcpy(old, g_styles, sizeof(g_styles));
+	memset(g_styles, 0, sizeof(g_styles));
+
+	// Widgets of the same type and state share a style, so all but the first of them are a table lookup
+	for_each_widget(restyle_widget, NULL);
+	pthread_mutex_unlock(&g_style_lock);
+
+	vstyle **styles = &old[0][0];
+	for (unsigned i = 0; i < VS_WIDGET_MAX_TYPES << VS_STATE_BITS; ++i)
+		memory_free(VS_MEMORY_WIDGETS, styles[i]);
+	memory_free(VS_MEMORY_WIDGETS, old_rules);
+
+	window *win;
+	for (unsigned i = 0; (win = xlib_window_at(i)); ++i) {
+		for (unsigned l = 0; l < win->layers.n_layers; ++l)
+			layer_invalidate(win->layers.layers[l]);
+		pacer_damage(&win->pacer);
+	}
+	latency_damage();
+	return VS_SUCCESS;
+}
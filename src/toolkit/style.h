@@ -0,0 +1,120 @@
+/**
+ * @file style.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Styles resolved from theme rules
+ *
+ * A widget's style depends only on its type, its state and the theme, so styles are resolved once for each type and
+ * state the first time a widget needs them and shared by every widget with the same inputs. Widgets keep a pointer to
+ * their style, which is only looked up again when their state changes or the theme is switched.
+ */
+
+#ifndef VS_STYLE_H
+#define VS_STYLE_H
+
+/*
+ * Widget states. A style rule matches a widget when every state it names is set on the widget.
+ */
+#define VS_STATE_HOVER			0x0001
+#define VS_STATE_FOCUS			0x0002
+#define VS_STATE_PRESSED		0x0004
+#define VS_STATE_DISABLED		0x0008
+#define VS_STATE_BITS			4
+
+/*
+ * Properties a style rule can set
+ */
+#define VS_STYLE_BACKGROUND		0x0001
+#define VS_STYLE_FOREGROUND		0x0002
+#define VS_STYLE_BORDER			0x0004
+#define VS_STYLE_BORDER_WIDTH	0x0008
+#define VS_STYLE_PADDING		0x0010
+#define VS_STYLE_RADIUS			0x0020
+#define VS_STYLE_FONT			0x0040
+#define VS_STYLE_FONT_SIZE		0x0080
+#define VS_STYLE_SHADOW			0x0100
+#define VS_STYLE_BACKDROP		0x0200
+
+/**
+ * @brief How a widget looks
+ */
+typedef struct vstyle {
+	unsigned char background[4];
+
+	/// Color of text, or the tint of an image
+	unsigned char foreground[4];
+
+	unsigned char border[4];
+	unsigned border_width;
+
+	/// Space between the border and the content, top, right, bottom and left
+	unsigned padding[4];
+
+	/// Corner radius
+	unsigned radius;
+
+	/// Font family. It has to outlive the theme.
+	const char *font;
+	unsigned font_size;
+
+	/// Drop shadow color, how far past the widget it fades out, and how far it is moved. A transparent color is none.
+	unsigned char shadow[4];
+	unsigned shadow_blur;
+	int shadow_offset[2];
+
+	/// Blur radius of what is behind the widget, or 0 to leave it sharp
+	unsigned backdrop_blur;
+} vstyle;
+
+/**
+ * @brief Sets some properties of the widgets it matches
+ */
+typedef struct {
+	/// Widget type the rule applies to, or 0 for every type
+	unsigned type;
+
+	/// States a widget must be in for the rule to apply, or 0 for every state
+	unsigned state;
+
+	/// Properties the rule sets, VS_STYLE_BACKGROUND and friends
+	unsigned properties;
+
+	vstyle values;
+} vstyle_rule;
+
+/**
+ * @brief Resolves the style of a widget type in a state
+ *
+ * The theme's base style is copied and every rule that matches is applied on top of it in order, so later rules win.
+ * The result is cached until the theme is switched.
+ *
+ * @param type Widget type id, or 0 for widgets without a type
+ * @param state VS_STATE flags
+ *
+ * @return Returns the style, shared with every widget of the same type and state
+ */
+const vstyle *resolve_style(unsigned type, unsigned state);
+
+/**
+ * @brief Gets the style a widget is drawn with
+ *
+ * @param widget Pointer to widget
+ *
+ * @return Returns the widget's style, or the base style if it has none
+ */
+const vstyle *get_style(void *widget);
+
+/**
+ * @brief Sets the state of a widget
+ *
+ * The widget's style is looked up again and the widget is invalidated, but only if the state changed.
+ *
+ * @param widget Pointer to widget
+ * @param state VS_STATE flags
+ *
+ * @return Returns whether it was successful or not
+ */
+int set_widget_state(void *widget, unsigned state);
+
+#endif
@@ -6,14 +6,43 @@
  * Copyright (C) 2020, Wesley Studt
  */
 
+#ifndef VS_THEME_H
+#define VS_THEME_H
+
 #include "../window.h"
 
 #include "default_theme.h"
+#include "style.h"
 
 typedef struct {
 	int (*draw_text_field)(window *win, void *text_field, void **params, unsigned n_params);
 	int (*draw_panel)(window *win, void *panel, void **params, unsigned n_params);
+	int (*draw_image)(window *win, void *image, void **params, unsigned n_params);
+	int (*draw_chart)(window *win, void *chart, void **params, unsigned n_params);
+	
+	/// Style every widget starts from before the rules are applied
+	vstyle base;
+	
+	/// Style rules, applied in order
+	const vstyle_rule *rules;
+	unsigned n_rules;
 } vtheme;
 
 void set_default_venus_theme(vtheme *theme);
+
+/**
+ * @brief Switches the theme of every widget
+ * 
+ * Cached styles are dropped, every live widget is given its style under the new theme in one pass over the widget pools
+ * and every layer is invalidated. It must not be called while a window is being drawn.
+ * 
+ * @param theme Pointer to the new theme. It is copied along with its rules, but not the font names its styles point to,
+ * which must outlive the theme.
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_theme(const vtheme *theme);
+
 extern vtheme g_theme;
+
+#endif
@@ -0,0 +1,479 @@
+/**
+ * @file ui.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "ui.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../venus_common.h"
+#include "../engine/arena.h"
+#include "../engine/memory.h"
+#include "style.h"
+#include "widget.h"
+#include "widgets/chart.h"
+#include "widgets/image.h"
+#include "widgets/panel.h"
+#include "widgets/profile_overlay.h"
+#include "widgets/text_field.h"
+
+typedef struct {
+	const char *name;
+	unsigned id;
+	const widget_class *cls;
+} ui_type;
+
+static const ui_type g_ui_types[] = {
+	{"text_field", VS_TEXT_FIELD_ID, &g_text_field_class},
+	{"panel", VS_PANEL_ID, &g_panel_class},
+	{"image", VS_IMAGE_ID, &g_image_class},
+	{"profile_overlay", VS_PROFILE_OVERLAY_ID, &g_profile_overlay_class},
+	{"chart", VS_CHART_ID, &g_chart_class}
+};
+
+#define VS_UI_N_TYPES		(sizeof(g_ui_types) / sizeof(ui_type))
+
+static const ui_type *ui_find_type(unsigned id) {
+	for (unsigned i = 0; i < VS_UI_N_TYPES; ++i)
+		if (g_ui_types[i].id == id)
+			return &g_ui_types[i];
+	return NULL;
+}
+
+/*
+ * Compiler state. Nodes are appended in the order they appear, which is depth first, and stack holds the index of the
+ * last node seen on each level so children can be counted on their parent.
+ */
+typedef struct {
+	const char *path;
+	unsigned line;
+
+	ui_node *nodes;
+	unsigned n_nodes;
+	unsigned node_capacity;
+
+	char *strings;
+	unsigned strings_size;
+	unsigned string_capacity;
+
+	unsigned n_roots;
+	unsigned stack[VS_UI_MAX_DEPTH];
+	unsigned depth;
+} ui_compiler;
+
+static int ui_error(ui_compiler *c, const char *message, const char *token) {
+	vs_log_error("%s:%u: %s '%s'", c->path, c->line, message, token);
+	return VS_FAILURE;
+}
+
+static int ui_add_string(ui_compiler *c, const char *string, unsigned length, unsigned *offset) {
+	if (c->strings_size + length + 1 > c->string_capacity) {
+		unsigned capacity = c->string_capacity ? c->string_capacity * 2 : 4096;
+		while (capacity < c->strings_size + length + 1)
+			capacity *= 2;
+		char *strings = memory_realloc(VS_MEMORY_WIDGETS, c->strings, capacity);
+		if (!strings)
+			return VS_FAILURE;
+		c->strings = strings;
+		c->string_capacity = capacity;
+	}
+	*offset = c->strings_size;
+	memcpy(c->strings + c->strings_size, string, length);
+	c->strings[c->strings_size + length] = '\0';
+	c->strings_size += length + 1;
+	return VS_SUCCESS;
+}
+
+static int ui_parse_number(ui_compiler *c, const char *value, long *number) {
+	char *end;
+	*number = strtol(value, &end, 10);
+	if (end == value || *end)
+		return ui_error(c, "Expected a number, found", value);
+	return VS_SUCCESS;
+}
+
+static int ui_parse_state(ui_compiler *c, char *value, uint8_t *state) {
+	*state = 0;
+	for (char *flag = strtok(value, "|"); flag; flag = strtok(NULL, "|")) {
+		if (!strcmp(flag, "hover"))
+			*state |= VS_STATE_HOVER;
+		else if (!strcmp(flag, "focus"))
+			*state |= VS_STATE_FOCUS;
+		else if (!strcmp(flag, "pressed"))
+			*state |= VS_STATE_PRESSED;
+		else if (!strcmp(flag, "disabled"))
+			*state |= VS_STATE_DISABLED;
+		else
+			return ui_error(c, "Unknown state", flag);
+	}
+	return VS_SUCCESS;
+}
+
+static int ui_set_attribute(ui_compiler *c, ui_node *node, char *key, char *value) {
+	long number;
+	if (!strcmp(key, "name"))
+		return ui_add_string(c, value, strlen(value), &node->name);
+	if (!strcmp(key, "text") || !strcmp(key, "path")) {
+		unsigned type = key[0] == 't' ? VS_TEXT_FIELD_ID : VS_IMAGE_ID;
+		if (node->type != type)
+			return ui_error(c, "Attribute does not apply to this widget", key);
+		return ui_add_string(c, value, strlen(value), &node->text);
+	}
+	if (!strcmp(key, "state"))
+		return ui_parse_state(c, value, &node->state);
+	if (!strcmp(key, "layer")) {
+		if (!strcmp(value, "cached"))
+			node->layer = VS_LAYER_CACHED;
+		else if (!strcmp(value, "auto"))
+			node->layer = VS_LAYER_AUTO;
+		else
+			return ui_error(c, "Unknown layer mode", value);
+		return VS_SUCCESS;
+	}
+
+	if (!ui_parse_number(c, value, &number))
+		return VS_FAILURE;
+	if (!strcmp(key, "x"))
+		node->x = (int32_t) number;
+	else if (!strcmp(key, "y"))
+		node->y = (int32_t) number;
+	else if (!strcmp(key, "width") && number >= 0)
+		node->width = (uint32_t) number;
+	else if (!strcmp(key, "height") && number >= 0)
+		node->height = (uint32_t) number;
+	else
+		return ui_error(c, "Unknown attribute", key);
+	return VS_SUCCESS;
+}
+
+/*
+ * Splits off the next token of a line. Quoted tokens may hold spaces, and a backslash escapes the next character.
+ */
+static char *ui_next_token(char **cursor) {
+	char *p = *cursor;
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if (!*p)
+		return NULL;
+
+	char *token = p;
+	char *out = p;
+	int quoted = VS_FALSE;
+	for (; *p && (quoted || (*p != ' ' && *p != '\t')); ++p) {
+		if (*p == '"')
+			quoted = !quoted;
+		else if (*p == '\\' && p[1])
+			*out++ = *++p;
+		else
+			*out++ = *p;
+	}
+	if (*p)
+		p++;
+	*out = '\0';
+	*cursor = p;
+	return token;
+}
+
+static int ui_parse_line(ui_compiler *c, char *line) {
+	unsigned level = 0;
+	while (line[level] == '\t')
+		level++;
+	char *cursor = line + level;
+	if (*cursor == ' ')
+		return ui_error(c, "Indent with tabs, not", "spaces");
+	if (!*cursor || *cursor == '#')
+		return VS_SUCCESS;
+	if (level > c->depth || level >= VS_UI_MAX_DEPTH)
+		return ui_error(c, "Indented too far", cursor);
+
+	char *name = ui_next_token(&cursor);
+	const ui_type *type = NULL;
+	for (unsigned i = 0; i < VS_UI_N_TYPES; ++i)
+		if (!strcmp(g_ui_types[i].name, name))
+			type = &g_ui_types[i];
+	if (!type)
+		return ui_error(c, "Unknown widget type", name);
+
+	if (c->n_nodes == c->node_capacity) {
+		unsigned capacity = c->node_capacity ? c->node_capacity * 2 : 256;
+		ui_node *nodes = memory_realloc(VS_MEMORY_WIDGETS, c->nodes, sizeof(ui_node) * capacity);
+		if (!nodes)
+			return VS_FAILURE;
+		c->nodes = nodes;
+		c->node_capacity = capacity;
+	}
+	ui_node *node = &c->nodes[c->n_nodes];
+	memset(node, 0, sizeof(ui_node));
+	node->type = type->id;
+	node->name = VS_UI_NO_STRING;
+	node->text = VS_UI_NO_STRING;
+
+	for (char *token; (token = ui_next_token(&cursor));) {
+		char *value = strchr(token, '=');
+		if (!value)
+			return ui_error(c, "Expected key=value, found", token);
+		*value++ = '\0';
+		if (!ui_set_attribute(c, node, token, value))
+			return VS_FAILURE;
+	}
+
+	if (level)
+		c->nodes[c->stack[level - 1]].n_children++;
+	else
+		c->n_roots++;
+	c->stack[level] = c->n_nodes++;
+	c->depth = level + 1;
+	return VS_SUCCESS;
+}
+
+int compile_ui(const char *source_path, const char *blob_path) {
+	FILE *source = fopen(source_path, "r");
+	if (!source) {
+		vs_log_error("Failed to open %s", source_path);
+		return VS_FAILURE;
+	}
+
+	ui_compiler c;
+	memset(&c, 0, sizeof(ui_compiler));
+	c.path = source_path;
+
+	char line[1024];
+	int result = VS_SUCCESS;
+	while (result && fgets(line, sizeof(line), source)) {
+		c.line++;
+		line[strcspn(line, "\r\n")] = '\0';
+		result = ui_parse_line(&c, line);
+	}
+	fclose(source);
+
+	FILE *blob = result ? fopen(blob_path, "wb") : NULL;
+	if (blob) {
+		ui_header header;
+		memset(&header, 0, sizeof(ui_header));
+		memcpy(header.magic, VS_UI_MAGIC, 4);
+		header.version = VS_UI_VERSION;
+		header.n_nodes = c.n_nodes;
+		header.n_roots = c.n_roots;
+		header.nodes = sizeof(ui_header);
+		header.strings = sizeof(ui_header) + sizeof(ui_node) * c.n_nodes;
+		header.strings_size = c.strings_size;
+
+		result = fwrite(&header, sizeof(ui_header), 1, blob) == 1 &&
+			fwrite(c.nodes, sizeof(ui_node), c.n_nodes, blob) == c.n_nodes &&
+			fwrite(c.strings, 1, c.strings_size, blob) == c.strings_size;
+		result = !fclose(blob) && result;
+		if (!result)
+			vs_log_error("Failed to write %s", blob_path);
+	} else if (result) {
+		vs_log_error("Failed to open %s", blob_path);
+		result = VS_FAILURE;
+	}
+
+	memory_free(VS_MEMORY_WIDGETS, c.nodes);
+	memory_free(VS_MEMORY_WIDGETS, c.strings);
+	return result;
+}
+
+/*
+ * Checks that a mapped blob is well formed before anything is built from it, and counts its nodes by type
+ */
+static int ui_validate(const unsigned char *data, size_t size, unsigned *counts) {
+	const ui_header *header = (const ui_header*) data;
+	if (size < sizeof(ui_header) || memcmp(header->magic, VS_UI_MAGIC, 4) || header->version != VS_UI_VERSION)
+		return VS_FAILURE;
+	if ((uint64_t) header->nodes + (uint64_t) header->n_nodes * sizeof(ui_node) > size ||
+		(uint64_t) header->strings + header->strings_size > size || header->nodes % sizeof(uint32_t) ||
+		(header->strings_size && data[header->strings + header->strings_size - 1]))
+		return VS_FAILURE;
+
+	const ui_node *nodes = (const ui_node*) (data + header->nodes);
+	uint32_t remaining[VS_UI_MAX_DEPTH];
+	unsigned depth = 0;
+	unsigned n_roots = 0;
+	for (unsigned i = 0; i < header->n_nodes; ++i) {
+		const ui_node *node = &nodes[i];
+		if (!ui_find_type(node->type) ||
+			(node->name != VS_UI_NO_STRING && node->name >= header->strings_size) ||
+			(node->text != VS_UI_NO_STRING && node->text >= header->strings_size))
+			return VS_FAILURE;
+		counts[node->type]++;
+
+		if (depth)
+			remaining[depth - 1]--;
+		else
+			n_roots++;
+		while (depth && !remaining[depth - 1])
+			depth--;
+		if (node->n_children) {
+			if (depth == VS_UI_MAX_DEPTH)
+				return VS_FAILURE;
+			remaining[depth++] = node->n_children;
+		}
+	}
+	return !depth && n_roots == header->n_roots;
+}
+
+static void ui_setup_widget(window *win, const ui_node *node, widget_t *w, const char *strings) {
+	w->x = node->x;
+	w->y = node->y;
+	if (node->width)
+		w->width = node->width;
+	if (node->height)
+		w->height = node->height;
+	if (node->state) {
+		w->state = node->state;
+		w->style = resolve_style(w->type, w->state);
+	}
+
+	const char *text = node->text != VS_UI_NO_STRING ? strings + node->text : NULL;
+	if (node->type == VS_TEXT_FIELD_ID) {
+		vtext_field *t_f = (vtext_field*) w;
+		t_f->default_text = (char*) text;
+		t_f->current_text = (char*) text;
+	} else if (node->type == VS_IMAGE_ID && text) {
+		((vimage*) w)->texture = texture_load(&win->textures, text, 0);
+		if (((vimage*) w)->texture)
+			((vimage*) w)->texture->widget = w;
+	}
+	if (node->layer)
+		set_widget_layer(win, w, node->layer);
+}
+
+/*
+ * Creates every widget of the blob, one bulk call per type, and hands them out in node order
+ */
+static int ui_create_widgets(const ui_node *nodes, unsigned n_nodes, unsigned *counts, void **widgets) {
+	arena *scratch = scratch_arena();
+	arena_mark mark = arena_get_mark(scratch);
+	void **created = arena_alloc(scratch, sizeof(void*) * (n_nodes ? n_nodes : 1));
+	unsigned offsets[VS_WIDGET_MAX_TYPES];
+	int result = created != NULL;
+
+	unsigned total = 0;
+	for (unsigned i = 0; result && i < VS_UI_N_TYPES; ++i) {
+		unsigned id = g_ui_types[i].id;
+		offsets[id] = total;
+		if (!counts[id])
+			continue;
+		result = register_widget_type(id, g_ui_types[i].cls) && create_widgets(id, counts[id], created + total);
+		if (result)
+			total += counts[id];
+	}
+
+	if (result) {
+		for (unsigned i = 0; i < n_nodes; ++i)
+			widgets[i] = created[offsets[nodes[i].type]++];
+	} else {
+		for (unsigned i = 0; created && i < total; ++i)
+			destroy_widget(created[i]);
+	}
+	arena_release(scratch, mark);
+	return result;
+}
+
+int load_ui(window *win, void *parent, const char *path, ui_blob *blob) {
+	memset(blob, 0, sizeof(ui_blob));
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		vs_log_error("Failed to open %s", path);
+		return VS_FAILURE;
+	}
+	struct stat info;
+	void *data = MAP_FAILED;
+	if (!fstat(fd, &info) && info.st_size > 0)
+		data = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		vs_log_error("Failed to map %s", path);
+		return VS_FAILURE;
+	}
+	// Text fields point into the blob, so it is mapped copy on write in case anything writes to their strings
+	blob->data = data;
+	blob->size = info.st_size;
+
+	unsigned counts[VS_WIDGET_MAX_TYPES] = {0};
+	if (!ui_validate(blob->data, blob->size, counts)) {
+		vs_log_error("%s is not a venus UI blob", path);
+		munmap(data, blob->size);
+		return VS_FAILURE;
+	}
+
+	const ui_header *header = (const ui_header*) blob->data;
+	const ui_node *nodes = (const ui_node*) (blob->data + header->nodes);
+	const char *strings = (const char*) blob->data + header->strings;
+	blob->widgets = memory_alloc(VS_MEMORY_WIDGETS, sizeof(void*) * (header->n_nodes ? header->n_nodes : 1));
+	blob->roots = memory_alloc(VS_MEMORY_WIDGETS, sizeof(unsigned) * (header->n_roots ? header->n_roots : 1));
+	if (!blob->widgets || !blob->roots || !ui_create_widgets(nodes, header->n_nodes, counts, blob->widgets)) {
+		memory_free(VS_MEMORY_WIDGETS, blob->widgets);
+		memory_free(VS_MEMORY_WIDGETS, blob->roots);
+		munmap(data, blob->size);
+		memset(blob, 0, sizeof(ui_blob));
+		vs_err(VS_FAILURE);
+	}
+	blob->n_widgets = header->n_nodes;
+
+	// Children arrays are sized once from the node, so linking never reallocates or invalidates
+	widget_t *stack[VS_UI_MAX_DEPTH];
+	uint32_t remaining[VS_UI_MAX_DEPTH];
+	unsigned depth = 0;
+	for (unsigned i = 0; i < header->n_nodes; ++i) {
+		const ui_node *node = &nodes[i];
+		widget_t *w = (widget_t*) blob->widgets[i];
+		ui_setup_widget(win, node, w, strings);
+
+		if (depth) {
+			widget_t *p = stack[depth - 1];
+			w->parent = p;
+			w->index = p->n_children;
+			p->children[p->n_children++] = w;
+			remaining[depth - 1]--;
+		} else {
+			blob->roots[blob->n_roots++] = i;
+			add_widget(parent, w);
+		}
+		while (depth && !remaining[depth - 1])
+			depth--;
+		if (node->n_children) {
+			if (!allocate_children(w, node->n_children)) {
+				// The trees linked so far go with their roots, and the widgets after this one were never linked
+				for (unsigned j = i + 1; j < header->n_nodes; ++j)
+					destroy_widget(blob->widgets[j]);
+				unload_ui(blob);
+				vs_err(VS_FAILURE);
+			}
+			stack[depth] = w;
+			remaining[depth++] = node->n_children;
+		}
+	}
+	return VS_SUCCESS;
+}
+
+void *find_ui_widget(ui_blob *blob, const char *name) {
+	const ui_header *header = (const ui_header*) blob->data;
+	const ui_node *nodes = (const ui_node*) (blob->data + header->nodes);
+	const char *strings = (const char*) blob->data + header->strings;
+	for (unsigned i = 0; i < blob->n_widgets; ++i)
+		if (nodes[i].name != VS_UI_NO_STRING && !strcmp(strings + nodes[i].name, name))
+			return blob->widgets[i];
+	return NULL;
+}
+
+int unload_ui(ui_blob *blob) {
+	if (!blob->data)
+		vs_err(VS_FAILURE);
+	for (unsigned i = 0; i < blob->n_roots; ++i)
+		destroy_widget(blob->widgets[blob->roots[i]]);
+	memory_free(VS_MEMORY_WIDGETS, blob->widgets);
+	memory_free(VS_MEMORY_WIDGETS, blob->roots);
+	munmap((void*) blob->data, blob->size);
+	memset(blob, 0, sizeof(ui_blob));
+	return VS_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file ui.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ *
+ * @brief Compiled UI descriptions
+ *
+ * A UI description is a text file with one widget per line, nested by indenting with tabs:
+ *
+ *     # Comments start with a hash
+ *     panel name=console width=1242 height=768 layer=cached
+ *     	text_field x=10 y=10 width=200 height=24 text="Search"
+ *     	image x=220 y=10 path="logo.png" state=disabled
+ *
+ * Widget types are panel, text_field, image, profile_overlay and chart. Every type takes name, x, y, width, height,
+ * state (any of hover, focus, pressed and disabled joined with |) and layer (cached or auto). text_field takes text and
+ * image takes path. A width or height left out keeps the type's default.
+ *
+ * compile_ui() turns a description into a blob of fixed size nodes in depth first order followed by a string table, with
+ * every reference stored as an offset so the blob can be mapped anywhere. load_ui() maps a blob, creates the widgets of
+ * each type in bulk and links them into a tree without parsing anything. Strings are used in place, straight from the
+ * mapping.
+ */
+
+#ifndef VS_UI_H
+#define VS_UI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../window.h"
+
+#define VS_UI_MAGIC			"VSUI"
+#define VS_UI_VERSION		1
+
+/// Most levels of nesting in a description
+#define VS_UI_MAX_DEPTH		64
+
+/// String offset of a node that has no string
+#define VS_UI_NO_STRING		0xFFFFFFFFu
+
+typedef struct {
+	char magic[4];
+	uint32_t version;
+	uint32_t n_nodes;
+	uint32_t n_roots;
+
+	/// Offset of the first node
+	uint32_t nodes;
+
+	/// Offset and size of the string table
+	uint32_t strings;
+	uint32_t strings_size;
+	uint32_t reserved;
+} ui_header;
+
+typedef struct {
+	uint16_t type;
+	uint8_t state;
+	uint8_t layer;
+
+	/// Number of direct children, which follow the node in depth first order
+	uint32_t n_children;
+
+	int32_t x;
+	int32_t y;
+	uint32_t width;
+	uint32_t height;
+
+	/// Offsets into the string table, or VS_UI_NO_STRING
+	uint32_t name;
+	uint32_t text;
+} ui_node;
+
+/**
+ * @brief A loaded UI blob and the widgets made from it
+ */
+typedef struct {
+	/// The mapped blob
+	const unsigned char *data;
+	size_t size;
+
+	/// Widget of each node, in the order of the nodes
+	void **widgets;
+	unsigned n_widgets;
+
+	/// Indices of the nodes that were added to the parent
+	unsigned *roots;
+	unsigned n_roots;
+} ui_blob;
+
+/**
+ * @brief Compiles a UI description into a blob
+ *
+ * Errors are logged with the line they were found on.
+ *
+ * @param source_path Path of the description
+ * @param blob_path Path of the blob to write
+ *
+ * @return Returns whether it was successful or not
+ */
+int compile_ui(const char *source_path, const char *blob_path);
+
+/**
+ * @brief Maps a blob and builds its widgets
+ *
+ * The top level widgets of the blob are added to the parent. The blob stays mapped for as long as its widgets exist,
+ * since text fields point into it.
+ *
+ * @param win Pointer to the window the widgets will be shown in
+ * @param parent Pointer to the window or widget the top level widgets are added to
+ * @param path Path of a blob from compile_ui()
+ * @param blob Memory address where the loaded blob will be saved
+ *
+ * @return Returns whether it was successful or not
+ */
+int load_ui(window *win, void *parent, const char *path, ui_blob *blob);
+
+/**
+ * @brief Finds a widget of a loaded blob by name
+ *
+ * @param blob Pointer to the loaded blob
+ * @param name Name given to the widget in the description
+ *
+ * @return Returns the widget or NULL
+ */
+void *find_ui_widget(ui_blob *blob, const char *name);
+
+/**
+ * @brief Destroys the widgets of a blob and unmaps it
+ *
+ * Widgets made from the blob must be left for this to destroy.
+ *
+ * @param blob Pointer to the loaded blob
+ *
+ * @return Returns whether it was successful or not
+ */
+int unload_ui(ui_blob *blob);
+
+#endif
@@ -6,10 +6,203 @@
 
 #include "widget.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../venus_common.h"
+#include "../engine/graphics.h"
+#include "../engine/jobs.h"
+#include "../engine/layer.h"
+#include "../engine/memory.h"
+#include "animation.h"
+#include "style.h"
+
+/*
+ * Widgets of one type are carved out of slabs of VS_WIDGET_SLAB. Destroyed widgets go on a free list threaded through
+ * their first bytes, and slabs are only freed with the program, so churn never reaches the heap. Free widgets have a type
+ * of 0, which lets for_each_widget() tell them apart from live ones.
+ */
+typedef struct widget_slab {
+	struct widget_slab *next;
+} widget_slab;
+
+typedef struct {
+	const widget_class *cls;
+	unsigned stride;
+	void *free_list;
+	widget_slab *slabs;
+	widget_pool_stats stats;
+} widget_pool;
+
+static widget_pool g_widget_pools[VS_WIDGET_MAX_TYPES];
+static pthread_mutex_t g_widget_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int register_widget_type(unsigned id, const widget_class *cls) {
+	if (!id || id >= VS_WIDGET_MAX_TYPES || cls->size < sizeof(widget_t))
+		vs_err(VS_FAILURE);
+	
+	widget_pool *pool = &g_widget_pools[id];
+	pthread_mutex_lock(&g_widget_pool_lock);
+	int result = VS_SUCCESS;
+	if (!pool->cls) {
+		pool->cls = cls;
+		pool->stride = (cls->size + 15) & ~15u;
+	} else if (pool->cls != cls) {
+		result = VS_FAILURE;
+	}
+	pthread_mutex_unlock(&g_widget_pool_lock);
+	
+	if (!result)
+		vs_log_error("Widget type %u is already registered", id);
+	return result;
+}
+
+static int widget_pool_grow(widget_pool *pool) {
+	// The slab header is padded to the stride's alignment so every widget stays 16 byte aligned
+	widget_slab *slab = memory_alloc(VS_MEMORY_WIDGETS, 16 + (size_t) pool->stride * VS_WIDGET_SLAB);
+	if (!slab)
+		return VS_FAILURE;
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	pool->stats.slabs++;
+	
+	unsigned char *widgets = (unsigned char*) slab + 16;
+	for (unsigned i = VS_WIDGET_SLAB; i-- > 0;) {
+		widget_t *widget = (widget_t*) (widgets + (size_t) i * pool->stride);
+		widget->type = 0;
+		*(void**) widget = pool->free_list;
+		pool->free_list = widget;
+	}
+	pool->stats.free += VS_WIDGET_SLAB;
+	return VS_SUCCESS;
+}
+
+void *create_widget(unsigned id) {
+	if (!id || id >= VS_WIDGET_MAX_TYPES)
+		return NULL;
+	widget_pool *pool = &g_widget_pools[id];
+	
+	pthread_mutex_lock(&g_widget_pool_lock);
+	if (!pool->cls || (!pool->free_list && !widget_pool_grow(pool))) {
+		pthread_mutex_unlock(&g_widget_pool_lock);
+		return NULL;
+	}
+	widget_t *w = pool->free_list;
+	pool->free_list = *(void**) w;
+	pool->stats.free--;
+	pool->stats.live++;
+	const widget_class *cls = pool->cls;
+	pthread_mutex_unlock(&g_widget_pool_lock);
+	
+	memset(w, 0, cls->size);
+	w->func = cls->func;
+	w->type = id;
+	if (cls->init)
+		cls->init(w);
+	w->style = resolve_style(id, w->state);
+	return w;
+}
+
+int create_widgets(unsigned id, unsigned n, void **widgets) {
+	if (!id || id >= VS_WIDGET_MAX_TYPES)
+		vs_err(VS_FAILURE);
+	widget_pool *pool = &g_widget_pools[id];
+	
+	pthread_mutex_lock(&g_widget_pool_lock);
+	const widget_class *cls = pool->cls;
+	while (cls && pool->stats.free < n)
+		if (!widget_pool_grow(pool))
+			break;
+	if (!cls || pool->stats.free < n) {
+		pthread_mutex_unlock(&g_widget_pool_lock);
+		vs_err(VS_FAILURE);
+	}
+	for (unsigned i = 0; i < n; ++i) {
+		widgets[i] = pool->free_list;
+		pool->free_list = *(void**) widgets[i];
+	}
+	pool->stats.free -= n;
+	pool->stats.live += n;
+	pthread_mutex_unlock(&g_widget_pool_lock);
+	
+	// Every widget of one type and state shares a style, so it only has to be resolved once
+	const vstyle *style = resolve_style(id, 0);
+	for (unsigned i = 0; i < n; ++i) {
+		widget_t *w = (widget_t*) widgets[i];
+		memset(w, 0, cls->size);
+		w->func = cls->func;
+		w->type = id;
+		if (cls->init)
+			cls->init(w);
+		w->style = w->state ? resolve_style(id, w->state) : style;
+	}
+	return VS_SUCCESS;
+}
+
+static void destroy_subtree(widget_t *w) {
+	for (unsigned i = 0; i < w->n_children; ++i) {
+		widget_t *child = (widget_t*) w->children[i];
+		child->parent = NULL;
+		if (child->type)
+			destroy_subtree(child);
+	}
+	memory_free(VS_MEMORY_WIDGETS, w->children);
+	w->children = NULL;
+	w->n_children = 0;
+	
+	if (w->layer)
+		layer_cache_set(((layer*) w->layer)->cache, w, VS_LAYER_NONE);
+	if (w->animated)
+		stop_animations(w, VS_ANIM_ALL);
+	
+	widget_pool *pool = &g_widget_pools[w->type];
+	if (pool->cls->destroy)
+		pool->cls->destroy(w);
+	
+	pthread_mutex_lock(&g_widget_pool_lock);
+	w->type = 0;
+	*(void**) w = pool->free_list;
+	pool->free_list = w;
+	pool->stats.free++;
+	pool->stats.live--;
+	pthread_mutex_unlock(&g_widget_pool_lock);
+}
+
+int destroy_widget(void *widget) {
+	widget_t *w = (widget_t*) widget;
+	if (!w->type || w->type >= VS_WIDGET_MAX_TYPES || !g_widget_pools[w->type].cls)
+		vs_err(VS_FAILURE);
+	if (w->parent)
+		remove_widget(w->parent, w);
+	destroy_subtree(w);
+	return VS_SUCCESS;
+}
+
+void for_each_widget(void (*func)(void *widget, void *arg), void *arg) {
+	pthread_mutex_lock(&g_widget_pool_lock);
+	for (unsigned id = 1; id < VS_WIDGET_MAX_TYPES; ++id) {
+		widget_pool *pool = &g_widget_pools[id];
+		for (widget_slab *slab = pool->slabs; slab; slab = slab->next) {
+			unsigned char *widgets = (unsigned char*) slab + 16;
+			for (unsigned i = 0; i < VS_WIDGET_SLAB; ++i) {
+				widget_t *w = (widget_t*) (widgets + (size_t) i * pool->stride);
+				if (w->type == id)
+					func(w, arg);
+			}
+		}
+	}
+	pthread_mutex_unlock(&g_widget_pool_lock);
+}
+
+int get_widget_pool_stats(unsigned id, widget_pool_stats *stats) {
+	if (!id || id >= VS_WIDGET_MAX_TYPES)
+		vs_err(VS_FAILURE);
+	pthread_mutex_lock(&g_widget_pool_lock);
+	*stats = g_widget_pools[id].stats;
+	pthread_mutex_unlock(&g_widget_pool_lock);
+	return VS_SUCCESS;
+}
 
 int add_widget(void *parent, void *widget) {
 	widget_t *p = (widget_t*) parent;
@@ -26,9 +219,11 @@ int insert_widget(void *parent, unsigned index, void *widget) {
 	widget_t *w = (widget_t*) widget;
 	
 	allocate_children(p, p->n_children + 1);
-	memcpy(p->children[index + 1], p->children[index], p->n_children - (index + 1));
-	set_widget(p, index, w);
+	memmove(p->children + index + 1, p->children + index, sizeof(void*) * (p->n_children - index));
 	p->n_children++;
+	for (unsigned i = index + 1; i < p->n_children; ++i)
+		((widget_t*) p->children[i])->index = i;
+	set_widget(p, index, w);
 	return VS_SUCCESS;
 }
 
@@ -36,7 +231,10 @@ int set_widget(void *parent, unsigned index, void *widget) {
 	widget_t *p = (widget_t*) parent;
 	widget_t *w = (widget_t*) widget;
 	
-	set_widget(p, index, w);
+	p->children[index] = w;
+	w->parent = p;
+	w->index = index;
+	invalidate_widget(p);
 	return VS_SUCCESS;
 }
 
@@ -52,19 +250,291 @@ void *remove_widget_index(void *parent, unsigned index) {
 	widget_t *p = (widget_t*) parent;
 	widget_t *w = get_widget(p, index);
 	
-	memcpy(p->children[index], p->children[index + 1], p->n_children - (index + 1));
-	allocate_children(p, p->n_children - 1);
+	memmove(p->children + index, p->children + index + 1, sizeof(void*) * (p->n_children - (index + 1)));
 	p->n_children--;
+	for (unsigned i = index; i < p->n_children; ++i)
+		((widget_t*) p->children[i])->index = i;
+	allocate_children(p, p->n_children);
+	w->parent = NULL;
+	invalidate_widget(p);
 	return w;
 }
 
 void *get_widget(void *parent, unsigned index) {
 	widget_t *p = (widget_t*) parent;
-	return p->children + index;
+	return p->children[index];
+}
+
+static unsigned children_capacity(unsigned n) {
+	unsigned capacity = 1;
+	while (capacity < n)
+		capacity <<= 1;
+	return capacity;
 }
 
 int allocate_children(void *widget, unsigned size) {
 	widget_t *w = (widget_t*) widget;
-	w->children = realloc(w->children, sizeof(w) * size);
+	if (!size) {
+		memory_free(VS_MEMORY_WIDGETS, w->children);
+		w->children = NULL;
+		return VS_SUCCESS;
+	}
+	// Arrays are kept at powers of two, so only growing past one reallocates
+	unsigned capacity = children_capacity(size);
+	if (w->children && w->n_children && capacity <= children_capacity(w->n_children))
+		return VS_SUCCESS;
+	void **children = memory_realloc(VS_MEMORY_WIDGETS, w->children, sizeof(void*) * capacity);
+	if (!children)
+		return VS_FAILURE;
+	w->children = children;
+	return VS_SUCCESS;
+}
+
+/*
+ * What a widget inherits from its ancestors when it is drawn
+ */
+typedef struct {
+	int clip[4];
+	unsigned stencil;
+	unsigned char tint[4];
+} record_scope;
+
+static int record_push_node(render_recorder *recorder, void *widget, int x, int y, void *layer, unsigned kind,
+	const record_scope *scope) {
+	if (recorder->n_nodes == recorder->node_capacity) {
+		unsigned capacity = recorder->node_capacity ? recorder->node_capacity * 2 : 256;
+		render_node *nodes = memory_realloc(VS_MEMORY_RENDER, recorder->nodes, sizeof(render_node) * capacity);
+		if (!nodes)
+			return VS_FAILURE;
+		recorder->nodes = nodes;
+		recorder->node_capacity = capacity;
+	}
+	render_node *node = &recorder->nodes[recorder->n_nodes++];
+	node->widget = widget;
+	node->x = x;
+	node->y = y;
+	node->layer = layer;
+	memcpy(node->clip, scope->clip, sizeof(node->clip));
+	node->stencil = scope->stencil;
+	node->kind = kind;
+	memcpy(node->tint, scope->tint, sizeof(node->tint));
+	return VS_SUCCESS;
+}
+
+/*
+ * Flattens the widget tree into drawing order, keeping track of absolute positions and of the clip and tint every
+ * widget is drawn with. Subtrees with an active layer become a single node, and a rounded clip puts a node on each side
+ * of the children it clips.
+ */
+static int record_flatten(render_recorder *recorder, void *parent, int x, int y, const record_scope *scope) {
+	widget_t *p = (widget_t*) parent;
+	for (unsigned i = 0; i < p->n_children; ++i) {
+		widget_t *w = (widget_t*) p->children[i];
+		layer *l = (layer*) w->layer;
+		int wx = x + w->x;
+		int wy = y + w->y;
+		
+		record_scope inner = *scope;
+		for (unsigned c = 0; c < 4; ++c)
+			inner.tint[c] = (unsigned char) ((scope->tint[c] * (255 - w->fade[c]) + 127) / 255);
+		if (!inner.tint[3])
+			continue;
+		
+		if (l && l->active) {
+			if (!record_push_node(recorder, w, wx, wy, l, VS_RENDER_DRAW, &inner))
+				return VS_FAILURE;
+			continue;
+		}
+		
+		if (!record_push_node(recorder, w, wx, wy, NULL, VS_RENDER_DRAW, &inner))
+			return VS_FAILURE;
+		if (!w->n_children)
+			continue;
+		if (w->clip == VS_CLIP_NONE) {
+			if (!record_flatten(recorder, w, wx, wy, &inner))
+				return VS_FAILURE;
+			continue;
+		}
+		
+		// Children of a widget that is clipped away entirely are never visited
+		const int *clip = scope->clip;
+		inner.clip[0] = wx > clip[0] ? wx : clip[0];
+		inner.clip[1] = wy > clip[1] ? wy : clip[1];
+		inner.clip[2] = wx + (int) w->width < clip[2] ? wx + (int) w->width : clip[2];
+		inner.clip[3] = wy + (int) w->height < clip[3] ? wy + (int) w->height : clip[3];
+		if (inner.clip[0] >= inner.clip[2] || inner.clip[1] >= inner.clip[3])
+			continue;
+		
+		int rounded = w->clip == VS_CLIP_ROUNDED && recorder->stencil && scope->stencil < VS_RENDER_MAX_STENCIL &&
+			get_style(w)->radius;
+		if (!rounded) {
+			if (!record_flatten(recorder, w, wx, wy, &inner))
+				return VS_FAILURE;
+			continue;
+		}
+		inner.stencil++;
+		if (!record_push_node(recorder, w, wx, wy, NULL, VS_RENDER_CLIP_PUSH, &inner) ||
+			!record_flatten(recorder, w, wx, wy, &inner) ||
+			!record_push_node(recorder, w, wx, wy, NULL, VS_RENDER_CLIP_POP, &inner))
+			return VS_FAILURE;
+	}
+	return VS_SUCCESS;
+}
+
+static void record_nodes(window *win, render_node *nodes, unsigned n_nodes, render_list *list) {
+	void *params[VS_DRAW_N_PARAMS];
+	params[VS_DRAW_PARAM_LIST] = list;
+	for (unsigned i = 0; i < n_nodes; ++i) {
+		VS_TRACE_SCOPE("widget_draw");
+		widget_t *w = (widget_t*) nodes[i].widget;
+		render_set_clip(list, nodes[i].clip, nodes[i].stencil);
+		render_set_tint(list, nodes[i].tint);
+		if (nodes[i].kind != VS_RENDER_DRAW) {
+			render_push_clip_shape(list, nodes[i].kind, nodes[i].x, nodes[i].y, w->width, w->height,
+				get_style(w)->radius);
+			continue;
+		}
+		if (nodes[i].layer) {
+			layer_record(nodes[i].layer, list, nodes[i].x, nodes[i].y);
+			continue;
+		}
+		
+		int origin[2] = {nodes[i].x, nodes[i].y};
+		params[VS_DRAW_PARAM_ORIGIN] = origin;
+		if (w->func)
+			w->func(VS_WIDGET_DRAW, win, w, params, VS_DRAW_N_PARAMS);
+	}
+}
+
+typedef struct {
+	window *win;
+	unsigned n_slices;
+} record_job;
+
+static void record_slice(void *arg, unsigned index) {
+	VS_TRACE_SCOPE("record_slice");
+	record_job *job = (record_job*) arg;
+	render_recorder *recorder = &job->win->recorder;
+	
+	unsigned begin = (unsigned) (((unsigned long) recorder->n_nodes * index) / job->n_slices);
+	unsigned end = (unsigned) (((unsigned long) recorder->n_nodes * (index + 1)) / job->n_slices);
+	
+	render_list_clear(&recorder->slices[index]);
+	record_nodes(job->win, recorder->nodes + begin, end - begin, &recorder->slices[index]);
+}
+
+// Below this many widgets per slice, handing work to other threads costs more than it saves
+#define VS_RECORD_MIN_SLICE		256
+
+int record_widgets(window *win, render_list *list) {
+	VS_TRACE_SCOPE("record_widgets");
+	render_recorder *recorder = &win->recorder;
+	
+	// Clipping to the window drops whatever is outside of it before it reaches the GPU
+	record_scope scope = {{0, 0, (int) win->width, (int) win->height}, 0, {255, 255, 255, 255}};
+	recorder->n_nodes = 0;
+	recorder->stencil = VS_TRUE;
+	if (!record_flatten(recorder, win, 0, 0, &scope))
+		vs_err(VS_FAILURE);
+	
+	render_list_clear(list);
+	
+	unsigned n_slices = recorder->n_threads;
+	if (n_slices > recorder->n_nodes / VS_RECORD_MIN_SLICE)
+		n_slices = recorder->n_nodes / VS_RECORD_MIN_SLICE;
+	if (n_slices <= 1) {
+		record_nodes(win, recorder->nodes, recorder->n_nodes, list);
+		return VS_SUCCESS;
+	}
+	
+	if (n_slices > recorder->n_slices) {
+		render_list *slices = memory_realloc(VS_MEMORY_RENDER, recorder->slices, sizeof(render_list) * n_slices);
+		if (!slices)
+			vs_err(VS_FAILURE);
+		for (unsigned i = recorder->n_slices; i < n_slices; ++i)
+			render_list_init(&slices[i]);
+		recorder->slices = slices;
+		recorder->n_slices = n_slices;
+	}
+	
+	record_job job = {win, n_slices};
+	jobs_parallel(record_slice, &job, n_slices);
+	
+	if (!render_list_merge(list, recorder->slices, n_slices))
+		vs_err(VS_FAILURE);
+	
+#ifdef VS_COMPILE_CHECK_RENDER_THREADS
+	render_list single;
+	render_list_init(&single);
+	record_nodes(win, recorder->nodes, recorder->n_nodes, &single);
+	if (!render_list_equal(&single, list))
+		vs_log_error("Render list recorded on %u threads differs from the single threaded one", n_slices);
+	render_list_free(&single);
+#endif
+	return VS_SUCCESS;
+}
+
+int record_subtree(window *win, void *widget, render_list *list) {
+	render_recorder *recorder = &win->recorder;
+	
+	// Layer framebuffers have no stencil, and nothing outside the widget fits in its texture. The widget's own tint is
+	// left for when the layer is drawn.
+	widget_t *w = (widget_t*) widget;
+	record_scope scope = {{0, 0, (int) w->width, (int) w->height}, 0, {255, 255, 255, 255}};
+	recorder->n_nodes = 0;
+	recorder->stencil = VS_FALSE;
+	if (!record_push_node(recorder, widget, 0, 0, NULL, VS_RENDER_DRAW, &scope) ||
+		!record_flatten(recorder, widget, 0, 0, &scope))
+		vs_err(VS_FAILURE);
+	
+	render_list_clear(list);
+	record_nodes(win, recorder->nodes, recorder->n_nodes, list);
+	return VS_SUCCESS;
+}
+
+int set_widget_layer(window *win, void *widget, int mode) {
+	if (!layer_cache_set(&win->layers, widget, mode) && mode != VS_LAYER_NONE)
+		vs_err(VS_FAILURE);
+	return VS_SUCCESS;
+}
+
+int set_widget_clip(void *widget, unsigned mode) {
+	widget_t *w = (widget_t*) widget;
+	if (mode > VS_CLIP_ROUNDED)
+		vs_err(VS_FAILURE);
+	if (w->clip == mode)
+		return VS_SUCCESS;
+	w->clip = mode;
+	invalidate_widget(w);
+	return VS_SUCCESS;
+}
+
+int set_widget_tint(void *widget, const unsigned char *rgba) {
+	widget_t *w = (widget_t*) widget;
+	unsigned char fade[4];
+	for (unsigned i = 0; i < 4; ++i)
+		fade[i] = 255 - rgba[i];
+	if (!memcmp(w->fade, fade, 4))
+		return VS_SUCCESS;
+	memcpy(w->fade, fade, 4);
+	
+	// The widget looks the same to a layer of its own, since tints are applied when layers are drawn
+	invalidate_widget(w->parent ? w->parent : w);
+	return VS_SUCCESS;
+}
+
+int invalidate_widget(void *widget) {
+	latency_damage();
+	// Only the window has no parent, and it never has a layer
+	widget_t *w = (widget_t*) widget;
+	for (; w->parent; w = (widget_t*) w->parent)
+		if (w->layer)
+			layer_invalidate(w->layer);
+	
+	// Widgets that are not in a window end at a parentless widget instead
+	window *win;
+	for (unsigned i = 0; (win = xlib_window_at(i)); ++i)
+		if ((void*) win == (void*) w)
+			pacer_damage(&win->pacer);
 	return VS_SUCCESS;
 }
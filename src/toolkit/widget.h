@@ -9,29 +9,170 @@
 
 #define VS_WIDGET_DRAW		0x0001
 
+/*
+ * Parameters passed along with VS_WIDGET_DRAW. The render list is a render_list* the widget records into and the origin
+ * is an int[2] with the widget's absolute position in the window. Widgets can be drawn from any thread, so they must only
+ * write to the render list they are given.
+ */
+#define VS_DRAW_PARAM_LIST		0
+#define VS_DRAW_PARAM_ORIGIN	1
+#define VS_DRAW_N_PARAMS		2
+
 #include "../window.h"
 
+/*
+ * Fields every widget starts with. A widget type is a struct that opens with VS_WIDGET_HEADER and puts its own data after
+ * it, so that any widget can be cast to widget_t. The first three fields line up with the window, which is the root of
+ * every tree.
+ * 
+ * x and y are relative to the parent. layer is the cached layer of the widget's subtree, if it has one. type is the id the
+ * widget was created with by create_widget(), or 0 for widgets the toolkit does not own. state holds VS_STATE flags and
+ * style is the shared style they resolve to, which set_widget_state() keeps up to date. clip is how the widget's children
+ * are clipped to its bounds, set with set_widget_clip().
+ * 
+ * fade is how much of each channel set_widget_tint() takes away from the widget and its children, so that a zeroed
+ * widget is drawn just as its style says. animated has a bit set for each VS_ANIM property being animated.
+ */
+#define VS_WIDGET_HEADER																		\
+	unsigned n_children;																		\
+	void **children;																			\
+																								\
+	void *parent;																				\
+	unsigned index;																				\
+																								\
+	int x;																						\
+	int y;																						\
+																								\
+	unsigned width;																				\
+	unsigned height;																			\
+																								\
+	int (*func)(unsigned type, window *win, void *widget, void** params, unsigned n_params);	\
+																								\
+	void *layer;																				\
+	unsigned type;																				\
+																								\
+	unsigned state;																				\
+	const struct vstyle *style;																	\
+																								\
+	unsigned clip;																				\
+																								\
+	unsigned char fade[4];																		\
+	unsigned char animated;
+
 /*
  * Model for what a widget must look like
  */
 typedef struct {
-	unsigned n_children;
-	void **children;
+	VS_WIDGET_HEADER
+} widget_t;
+
+/// Highest widget type id plus one
+#define VS_WIDGET_MAX_TYPES		64
+
+/// Widgets carved out of each slab of a widget pool
+#define VS_WIDGET_SLAB			64
+
+/**
+ * @brief What the toolkit needs to know about a widget type
+ */
+typedef struct {
+	/// Size of the type's struct
+	unsigned size;
 	
-	void *parent;
-	unsigned index;
+	/// Handles messages such as VS_WIDGET_DRAW. It is copied into each widget's func.
+	int (*func)(unsigned type, window *win, void *widget, void** params, unsigned n_params);
 	
-	unsigned width;
-	unsigned height;
+	/// Sets the type's defaults on a zeroed widget, or NULL
+	void (*init)(void *widget);
 	
-	int (*func)(unsigned type, window *win, void *widget, void** params, unsigned n_params);
+	/// Frees what the widget owns apart from its children, or NULL
+	void (*destroy)(void *widget);
+} widget_class;
+
+/**
+ * @brief Widget pool statistics of one type
+ */
+typedef struct {
+	/// Widgets created and not destroyed
+	unsigned long live;
 	
-/*
- * The rest of the data needs to go here. The most important data needs to be at the top so that when a cast is performed the
- * only data kept is the most important
+	/// Destroyed widgets waiting to be reused
+	unsigned long free;
+	
+	/// Slabs allocated for the type
+	unsigned long slabs;
+} widget_pool_stats;
+
+/**
+ * @brief Registers a widget type
+ * 
+ * Registering the same class under the same id again does nothing, so create functions can register their type every
+ * time they are called.
+ * 
+ * @param id Type id, from 1 up to VS_WIDGET_MAX_TYPES - 1
+ * @param cls Pointer to the type's class. It must stay valid for as long as widgets of the type exist.
+ * 
+ * @return Returns an error code
  */
+int register_widget_type(unsigned id, const widget_class *cls);
 
-} widget_t;
+/**
+ * @brief Creates a widget of a registered type
+ * 
+ * Widgets come from a pool of slabs kept for each type, so creating and destroying many of them does not fragment the
+ * heap. The widget is zeroed, gets its type's func and is then given to the type's init.
+ * 
+ * @param id Type id
+ * 
+ * @return Returns the widget, or NULL if the type is not registered or memory ran out
+ */
+void *create_widget(unsigned id);
+
+/**
+ * @brief Creates many widgets of a registered type at once
+ * 
+ * This takes the pool's lock once for all of them, instead of once per widget like create_widget().
+ * 
+ * @param id Type id
+ * @param n Number of widgets
+ * @param widgets Memory address where the n widgets will be saved
+ * 
+ * @return Returns whether it was successful or not. Nothing is created on failure.
+ */
+int create_widgets(unsigned id, unsigned n, void **widgets);
+
+/**
+ * @brief Destroys a widget and every widget under it
+ * 
+ * The widget is removed from its parent, its layer is dropped and its memory goes back to its type's pool. Children
+ * the toolkit does not own, with a type of 0, are only detached.
+ * 
+ * @param widget Pointer to widget
+ * 
+ * @return Returns an error code
+ */
+int destroy_widget(void *widget);
+
+/**
+ * @brief Calls a function on every widget made by create_widget() that has not been destroyed
+ * 
+ * Widgets are visited slab by slab rather than tree by tree, so widgets that are not in a window are visited too. The
+ * function must not create or destroy widgets.
+ * 
+ * @param func Function to call with each widget
+ * @param arg Argument passed along to the function
+ */
+void for_each_widget(void (*func)(void *widget, void *arg), void *arg);
+
+/**
+ * @brief Gets the pool statistics of a widget type
+ * 
+ * @param id Type id
+ * @param stats Memory address where the statistics will be saved
+ * 
+ * @return Returns an error code
+ */
+int get_widget_pool_stats(unsigned id, widget_pool_stats *stats);
 
 /**
  * @brief Adds a new child widget
@@ -101,7 +242,8 @@ void *get_widget(void *parent, unsigned index);
  * @brief Allocates memory for children
  * 
  * If there are no children yet, this function allocates a new block of memory for the children array. If there are already
- * children, then it reallocates the memory to fit the new size.
+ * children, then it reallocates the memory to fit the new size. Arrays are rounded up to a power of two and do not shrink
+ * until they are emptied, so adding and removing children one at a time rarely reallocates.
  * 
  * @param parent Pointer to widget to be allocated
  * @param size Number of children widgets
@@ -110,4 +252,92 @@ void *get_widget(void *parent, unsigned index);
  */
 int allocate_children(void *widget, unsigned size);
 
+/**
+ * @brief Records every widget in a window into a render list
+ * 
+ * Widgets are recorded in drawing order: a parent before its children, and children in index order. When the window's
+ * recorder has more than one thread, the tree is cut into contiguous slices that are recorded in parallel and merged back
+ * in order, so the result is identical to recording on one thread.
+ * 
+ * @param win Pointer to window
+ * @param list Pointer to the render list to record into. It is cleared first.
+ * 
+ * @return Returns an error code
+ */
+int record_widgets(window *win, render_list *list);
+
+/**
+ * @brief Records a widget and its children into a render list, with the widget at the origin
+ * 
+ * This always records the widget itself, even if it has a layer. Layers further down the tree are recorded as quads.
+ * 
+ * @param win Pointer to window
+ * @param widget Pointer to widget
+ * @param list Pointer to the render list to record into. It is cleared first.
+ * 
+ * @return Returns an error code
+ */
+int record_subtree(window *win, void *widget, render_list *list);
+
+/**
+ * @brief Sets whether a widget's subtree is cached in a layer
+ * 
+ * A cached subtree is rendered into a texture once and then drawn as a single quad until something in it is invalidated.
+ * VS_LAYER_AUTO only caches the subtree while it goes VS_LAYER_STABLE_FRAMES frames without being invalidated.
+ * 
+ * @param win Pointer to the window the widget is in
+ * @param widget Pointer to widget
+ * @param mode VS_LAYER_NONE, VS_LAYER_CACHED or VS_LAYER_AUTO
+ * 
+ * @return Returns an error code
+ */
+int set_widget_layer(window *win, void *widget, int mode);
+
+/// Children are drawn wherever they are
+#define VS_CLIP_NONE			0
+/// Children are cut to the widget's rectangle
+#define VS_CLIP_RECT			1
+/// Children are cut to the widget's rectangle with its style's corner radius
+#define VS_CLIP_ROUNDED			2
+
+/**
+ * @brief Sets how a widget's children are clipped to its bounds
+ * 
+ * Rectangular clips cut quads on the CPU as they are recorded, so any number of nested clips costs no draw calls, and
+ * children that are clipped away entirely are not recorded at all. Rounded clips draw their shape into the stencil
+ * buffer, which costs a draw call on each side of the children. Inside a cached layer, rounded clips fall back to
+ * rectangles.
+ * 
+ * @param widget Pointer to widget
+ * @param mode VS_CLIP_NONE, VS_CLIP_RECT or VS_CLIP_ROUNDED
+ * 
+ * @return Returns an error code
+ */
+int set_widget_clip(void *widget, unsigned mode);
+
+/**
+ * @brief Sets the color a widget and its children are multiplied by
+ * 
+ * The alpha channel is the widget's opacity. Children are tinted one by one, so where they overlap they show through
+ * each other. A widget with a cached layer is tinted as a whole. Widgets that are fully transparent are not recorded.
+ * 
+ * @param widget Pointer to widget
+ * @param rgba Tint, which is {255, 255, 255, 255} for none
+ * 
+ * @return Returns an error code
+ */
+int set_widget_tint(void *widget, const unsigned char *rgba);
+
+/**
+ * @brief Marks a widget as changed
+ * 
+ * Every layer the widget is in is rendered again before it is next drawn. This must be called whenever a widget changes
+ * how it looks. Adding, inserting, setting and removing children does it automatically.
+ * 
+ * @param widget Pointer to widget
+ * 
+ * @return Returns an error code
+ */
+int invalidate_widget(void *widget);
+
 #endif
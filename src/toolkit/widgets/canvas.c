@@ -0,0 +1,232 @@
+/**
+ * @file canvas.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "canvas.h"
+
+#include <math.h>
+
+#include "../../venus_common.h"
+#include "../../window.h"
+
+#include "../style.h"
+
+static const unsigned char canvas_white[] = {0xFF, 0xFF, 0xFF, 0xFF};
+static const float canvas_whole[] = {0.0f, 0.0f, 1.0f, 1.0f};
+
+typedef struct {
+	render_list *list;
+
+	/// Left, top, right and bottom edges of the canvas, which tiles are cropped to
+	float bounds[4];
+} canvas_target;
+
+/*
+ * Draws part of a tile into a rectangle cropped to the canvas. sub is the part of the tile, from 0 to 1 on each axis.
+ */
+static void canvas_push(const canvas_target *target, const float *rect, const tile *t, const float *sub) {
+	float left = rect[0];
+	float top = rect[1];
+	float right = rect[2];
+	float bottom = rect[3];
+	float u0 = t->uv[0] + (t->uv[2] - t->uv[0]) * sub[0];
+	float v0 = t->uv[1] + (t->uv[3] - t->uv[1]) * sub[1];
+	float u1 = t->uv[0] + (t->uv[2] - t->uv[0]) * sub[2];
+	float v1 = t->uv[1] + (t->uv[3] - t->uv[1]) * sub[3];
+	float du = (u1 - u0) / (right - left);
+	float dv = (v1 - v0) / (bottom - top);
+
+	if (left < target->bounds[0]) {
+		u0 += (target->bounds[0] - left) * du;
+		left = target->bounds[0];
+	}
+	if (top < target->bounds[1]) {
+		v0 += (target->bounds[1] - top) * dv;
+		top = target->bounds[1];
+	}
+	if (right > target->bounds[2]) {
+		u1 -= (right - target->bounds[2]) * du;
+		right = target->bounds[2];
+	}
+	if (bottom > target->bounds[3]) {
+		v1 -= (bottom - target->bounds[3]) * dv;
+		bottom = target->bounds[3];
+	}
+	if (right <= left || bottom <= top)
+		return;
+
+	float uv[] = {u0, v0, u1, v1};
+	render_push_quad(target->list, left, top, right - left, bottom - top, canvas_white, t->gl_texture, uv);
+}
+
+/*
+ * Draws whatever is on the GPU in place of a missing tile: the part of the nearest tile above it, or else the tiles of
+ * the level below it that are there
+ */
+static void canvas_fallback(const canvas_target *target, vcanvas *canvas, int level, long x, long y, const float *rect) {
+	for (int k = 1; k <= VS_CANVAS_FALLBACK && level + k <= VS_CANVAS_MAX_LEVEL; ++k) {
+		// Shifting floors negative rows and columns too
+		long px = x >> k;
+		long py = y >> k;
+		tile *parent = tile_cache_peek(canvas->tiles, &canvas->source, level + k, px, py);
+		if (!parent)
+			continue;
+
+		float n = (float) (1 << k);
+		float sub[] = {(x - (px << k)) / n, (y - (py << k)) / n, (x - (px << k) + 1) / n, (y - (py << k) + 1) / n};
+		canvas_push(target, rect, parent, sub);
+		return;
+	}
+
+	if (level == VS_CANVAS_MIN_LEVEL)
+		return;
+	float middle[] = {(rect[0] + rect[2]) * 0.5f, (rect[1] + rect[3]) * 0.5f};
+	for (int j = 0; j < 2; ++j) {
+		for (int i = 0; i < 2; ++i) {
+			tile *child = tile_cache_peek(canvas->tiles, &canvas->source, level - 1, x * 2 + i, y * 2 + j);
+			if (!child)
+				continue;
+			float quarter[] = {i ? middle[0] : rect[0], j ? middle[1] : rect[1], i ? rect[2] : middle[0],
+				j ? rect[3] : middle[1]};
+			canvas_push(target, quarter, child, canvas_whole);
+		}
+	}
+}
+
+/*
+ * Asks for the tiles in columns x0 to x1 - 1 and rows y0 to y1 - 1 ahead of time
+ */
+static void canvas_prefetch(vcanvas *canvas, int level, long x0, long y0, long x1, long y1) {
+	for (long y = y0; y < y1; ++y)
+		for (long x = x0; x < x1; ++x)
+			tile_cache_get(canvas->tiles, &canvas->source, level, x, y, VS_TRUE);
+}
+
+/*
+ * Pixel position of the edge of a tile, rounded so that neighbouring tiles always meet
+ */
+static inline float canvas_edge(long index, double size, double view, double scale, int origin) {
+	return origin + (float) floor((index * size - view) * scale + 0.5);
+}
+
+static int draw_canvas(window *win, vcanvas *canvas, void **params, unsigned n_params) {
+	render_list *list = params[VS_DRAW_PARAM_LIST];
+	int *origin = params[VS_DRAW_PARAM_ORIGIN];
+
+	render_push_quad(list, origin[0], origin[1], canvas->width, canvas->height, get_style(canvas)->background, 0,
+		NULL);
+	if (!canvas->width || !canvas->height || canvas->scale <= 0)
+		return VS_SUCCESS;
+
+	// The level whose tiles are drawn at between half and all of their size, so they are never blurred by stretching
+	int level = (int) floor(-log2(canvas->scale));
+	if (level < VS_CANVAS_MIN_LEVEL)
+		level = VS_CANVAS_MIN_LEVEL;
+	if (level > VS_CANVAS_MAX_LEVEL)
+		level = VS_CANVAS_MAX_LEVEL;
+	double size = ldexp(VS_TILE_SIZE, level);
+
+	long x0 = (long) floor(canvas->view_x / size);
+	long y0 = (long) floor(canvas->view_y / size);
+	long x1 = (long) ceil((canvas->view_x + canvas->width / canvas->scale) / size);
+	long y1 = (long) ceil((canvas->view_y + canvas->height / canvas->scale) / size);
+
+	canvas_target target = {list, {origin[0], origin[1], origin[0] + canvas->width, origin[1] + canvas->height}};
+	for (long y = y0; y < y1; ++y) {
+		for (long x = x0; x < x1; ++x) {
+			float rect[] = {
+				canvas_edge(x, size, canvas->view_x, canvas->scale, origin[0]),
+				canvas_edge(y, size, canvas->view_y, canvas->scale, origin[1]),
+				canvas_edge(x + 1, size, canvas->view_x, canvas->scale, origin[0]),
+				canvas_edge(y + 1, size, canvas->view_y, canvas->scale, origin[1])
+			};
+			tile *t = tile_cache_get(canvas->tiles, &canvas->source, level, x, y, VS_FALSE);
+			if (t)
+				canvas_push(&target, rect, t, canvas_whole);
+			else
+				canvas_fallback(&target, canvas, level, x, y, rect);
+		}
+	}
+
+	// Tiles the view is moving towards are asked for early, more of them the faster it moves
+	long ahead_x = 1 + (long) (fabs(canvas->pan_x) / size);
+	long ahead_y = 1 + (long) (fabs(canvas->pan_y) / size);
+	if (ahead_x > VS_CANVAS_PREFETCH)
+		ahead_x = VS_CANVAS_PREFETCH;
+	if (ahead_y > VS_CANVAS_PREFETCH)
+		ahead_y = VS_CANVAS_PREFETCH;
+	if (canvas->pan_x > 0)
+		canvas_prefetch(canvas, level, x1, y0, x1 + ahead_x, y1);
+	else if (canvas->pan_x < 0)
+		canvas_prefetch(canvas, level, x0 - ahead_x, y0, x0, y1);
+	if (canvas->pan_y > 0)
+		canvas_prefetch(canvas, level, x0, y1, x1, y1 + ahead_y);
+	else if (canvas->pan_y < 0)
+		canvas_prefetch(canvas, level, x0, y0 - ahead_y, x1, y0);
+
+	// A pan only says where the view is heading until it stops, so later redraws do not keep prefetching that way
+	canvas->pan_x = 0;
+	canvas->pan_y = 0;
+
+	// The level above costs a quarter as much and is what is shown while zooming out or jumping far
+	if (level < VS_CANVAS_MAX_LEVEL)
+		canvas_prefetch(canvas, level + 1, x0 >> 1, y0 >> 1, ((x1 - 1) >> 1) + 1, ((y1 - 1) >> 1) + 1);
+	return VS_SUCCESS;
+}
+
+int call_canvas(unsigned type, window *win, void *widget, void** params, unsigned n_params) {
+	if (type == VS_WIDGET_DRAW)
+		return draw_canvas(win, widget, params, n_params);
+	return VS_FAIL_VENUS;
+}
+
+static void init_canvas(void *widget) {
+	vcanvas *canvas = (vcanvas*) widget;
+	canvas->width = 320;
+	canvas->height = 240;
+	canvas->scale = 1.0;
+}
+
+static void destroy_canvas(void *widget) {
+	vcanvas *canvas = (vcanvas*) widget;
+	if (canvas->tiles)
+		tile_cache_drop(canvas->tiles, &canvas->source);
+}
+
+const widget_class g_canvas_class = {sizeof(vcanvas), call_canvas, init_canvas, destroy_canvas};
+
+vcanvas *create_canvas(window *win, int (*render)(void *user, int level, long x, long y, unsigned char *pixels),
+	void *user) {
+	register_widget_type(VS_CANVAS_ID, &g_canvas_class);
+	vcanvas *canvas = create_widget(VS_CANVAS_ID);
+	if (!canvas)
+		return NULL;
+
+	canvas->source.render = render;
+	canvas->source.user = user;
+	canvas->source.widget = canvas;
+	atomic_init(&canvas->source.generation, 0);
+	canvas->tiles = &win->tiles;
+	return canvas;
+}
+
+int set_canvas_view(vcanvas *canvas, double x, double y, double scale) {
+	if (scale <= 0)
+		vs_err(VS_FAILURE);
+	if (canvas->view_x == x && canvas->view_y == y && canvas->scale == scale)
+		return VS_SUCCESS;
+	canvas->pan_x += x - canvas->view_x;
+	canvas->pan_y += y - canvas->view_y;
+	canvas->view_x = x;
+	canvas->view_y = y;
+	canvas->scale = scale;
+	invalidate_widget(canvas);
+	return VS_SUCCESS;
+}
+
+int invalidate_canvas(vcanvas *canvas) {
+	atomic_fetch_add(&canvas->source.generation, 1);
+	return invalidate_widget(canvas);
+}
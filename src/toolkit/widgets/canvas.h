@@ -0,0 +1,86 @@
+/**
+ * @file canvas.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#ifndef VS_WIDGET_CANVAS_H
+#define VS_WIDGET_CANVAS_H
+
+#include "../widget.h"
+#include "../../engine/tiles.h"
+
+#define VS_CANVAS_ID		0x0006
+
+/// Zoom levels tiles are rendered at, level 0 being one unit of content per pixel
+#define VS_CANVAS_MIN_LEVEL	-8
+#define VS_CANVAS_MAX_LEVEL	24
+
+/// Levels above the one being drawn that are looked through for a stand in when a tile is missing
+#define VS_CANVAS_FALLBACK	4
+
+/// Most rows or columns of tiles prefetched ahead of a pan
+#define VS_CANVAS_PREFETCH	2
+
+typedef struct {
+	VS_WIDGET_HEADER
+
+	tile_source source;
+	tile_cache *tiles;
+
+	/// Content at the top left corner
+	double view_x;
+	double view_y;
+
+	/// Pixels per unit of content
+	double scale;
+
+	/// Change of the view since it was last drawn, which tiles are prefetched in the direction of
+	double pan_x;
+	double pan_y;
+} vcanvas;
+
+/// Class canvases are registered with
+extern const widget_class g_canvas_class;
+
+/**
+ * @brief Creates a new canvas
+ *
+ * A canvas shows content of any size, cut into VS_TILE_SIZE tiles at power of two zoom levels that are rendered on the
+ * worker pool into the window's tile cache. A canvas never waits for its content: while a tile renders, the nearest
+ * tile above or below it that is on the GPU is drawn scaled in its place, and the background shows through where there
+ * is none. Tiles in the direction the view last moved are prefetched. See tile_source for what render has to do.
+ *
+ * @param win Pointer to the window the canvas will be shown in
+ * @param render Renders one tile of content on a worker thread
+ * @param user Passed to render
+ *
+ * @return Returns a new canvas, which is freed with destroy_widget()
+ */
+vcanvas *create_canvas(window *win, int (*render)(void *user, int level, long x, long y, unsigned char *pixels),
+	void *user);
+
+/**
+ * @brief Sets the part of its content a canvas shows
+ *
+ * @param canvas Pointer to canvas
+ * @param x Content at the left edge
+ * @param y Content at the top edge
+ * @param scale Pixels per unit of content
+ *
+ * @return Returns whether it was successful or not
+ */
+int set_canvas_view(vcanvas *canvas, double x, double y, double scale);
+
+/**
+ * @brief Marks the content of a canvas as changed
+ *
+ * Every tile is rendered again. The old tiles are drawn until the new ones arrive.
+ *
+ * @param canvas Pointer to canvas
+ *
+ * @return Returns whether it was successful or not
+ */
+int invalidate_canvas(vcanvas *canvas);
+
+#endif
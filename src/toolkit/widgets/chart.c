@@ -0,0 +1,227 @@
+/**
+ * @file chart.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#include "chart.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "../../venus_common.h"
+#include "../../window.h"
+#include "../../engine/memory.h"
+
+#include "../theme.h"
+
+/// Pyramid entries of a chunk, which is every level above the samples added up
+#define VS_CHART_PYRAMID	(VS_CHART_CHUNK / (VS_CHART_FANOUT - 1))
+
+typedef struct {
+	float min;
+	float max;
+} chart_range;
+
+/*
+ * Level 1 of the pyramid summarizes VS_CHART_FANOUT samples per entry and starts at the beginning of levels, and every
+ * level after it follows the one before. An entry is only valid once the first sample it covers has been appended.
+ */
+typedef struct {
+	unsigned n;
+	chart_range total;
+	float samples[VS_CHART_CHUNK];
+	chart_range levels[VS_CHART_PYRAMID];
+} chart_chunk;
+
+/*
+ * Samples that are not numbers are gaps, which never change a range
+ */
+static inline void chart_merge(chart_range *r, float min, float max) {
+	if (min < r->min)
+		r->min = min;
+	if (max > r->max)
+		r->max = max;
+}
+
+static void chart_chunk_append(chart_chunk *chunk, float value) {
+	unsigned i = chunk->n++;
+	chunk->samples[i] = value;
+
+	float min = value;
+	float max = value;
+	if (isnan(value)) {
+		min = INFINITY;
+		max = -INFINITY;
+	}
+	if (!i) {
+		chunk->total.min = min;
+		chunk->total.max = max;
+	} else {
+		chart_merge(&chunk->total, min, max);
+	}
+
+	// The sample is the first of its entry on every level up to the first one it is not aligned to
+	int first = VS_TRUE;
+	unsigned j = i;
+	for (unsigned offset = 0, size = VS_CHART_CHUNK / VS_CHART_FANOUT; size; offset += size, size /= VS_CHART_FANOUT) {
+		first = first && j % VS_CHART_FANOUT == 0;
+		j /= VS_CHART_FANOUT;
+		chart_range *r = &chunk->levels[offset + j];
+		if (first) {
+			r->min = min;
+			r->max = max;
+		} else {
+			chart_merge(r, min, max);
+		}
+	}
+}
+
+/*
+ * Finds the range of samples a to b - 1 of a chunk. Entries are scanned at the edges of each level until the rest line
+ * up with whole entries of the level above, so at most 2 * VS_CHART_FANOUT entries are scanned per level.
+ */
+static void chart_chunk_range(const chart_chunk *chunk, unsigned a, unsigned b, chart_range *r) {
+	if (!a && b == chunk->n) {
+		chart_merge(r, chunk->total.min, chunk->total.max);
+		return;
+	}
+
+	for (; a < b && a % VS_CHART_FANOUT; ++a)
+		chart_merge(r, chunk->samples[a], chunk->samples[a]);
+	for (; a < b && b % VS_CHART_FANOUT; --b)
+		chart_merge(r, chunk->samples[b - 1], chunk->samples[b - 1]);
+	a /= VS_CHART_FANOUT;
+	b /= VS_CHART_FANOUT;
+
+	for (unsigned offset = 0, size = VS_CHART_CHUNK / VS_CHART_FANOUT; a < b; offset += size, size /= VS_CHART_FANOUT) {
+		const chart_range *level = chunk->levels + offset;
+		if (size < VS_CHART_FANOUT) {
+			for (; a < b; ++a)
+				chart_merge(r, level[a].min, level[a].max);
+			break;
+		}
+		for (; a < b && a % VS_CHART_FANOUT; ++a)
+			chart_merge(r, level[a].min, level[a].max);
+		for (; a < b && b % VS_CHART_FANOUT; --b)
+			chart_merge(r, level[b - 1].min, level[b - 1].max);
+		a /= VS_CHART_FANOUT;
+		b /= VS_CHART_FANOUT;
+	}
+}
+
+static void chart_series_range(const chart_series *series, unsigned long a, unsigned long b, chart_range *r) {
+	for (unsigned long c = a / VS_CHART_CHUNK; c * VS_CHART_CHUNK < b; ++c) {
+		unsigned long base = c * VS_CHART_CHUNK;
+		unsigned first = a > base ? (unsigned) (a - base) : 0;
+		unsigned last = b < base + VS_CHART_CHUNK ? (unsigned) (b - base) : VS_CHART_CHUNK;
+		chart_chunk_range(series->chunks[c], first, last, r);
+	}
+}
+
+void get_chart_columns(const vchart *chart, const chart_series *series, unsigned n_columns, float *min, float *max) {
+	double step = chart->span / n_columns;
+	for (unsigned i = 0; i < n_columns; ++i) {
+		// Columns narrower than a sample still show the sample they are on
+		double left = floor(chart->first + step * i);
+		double right = floor(chart->first + step * (i + 1));
+		if (right <= left)
+			right = left + 1;
+		if (left < 0)
+			left = 0;
+		if (right > series->n_samples)
+			right = series->n_samples;
+
+		chart_range r = {INFINITY, -INFINITY};
+		if (left < right)
+			chart_series_range(series, (unsigned long) left, (unsigned long) right, &r);
+		min[i] = r.min;
+		max[i] = r.max;
+	}
+}
+
+int call_chart(unsigned type, window *win, void *widget, void** params, unsigned n_params) {
+	if (type == VS_WIDGET_DRAW)
+		return g_theme.draw_chart(win, widget, params, n_params);
+	return VS_FAIL_VENUS;
+}
+
+static void init_chart(void *widget) {
+	vchart *chart = (vchart*) widget;
+	chart->width = 320;
+	chart->height = 160;
+	chart->span = 1000;
+	chart->y_min = -1.0f;
+	chart->y_max = 1.0f;
+}
+
+static void destroy_chart(void *widget) {
+	vchart *chart = (vchart*) widget;
+	for (unsigned i = 0; i < chart->n_series; ++i) {
+		chart_series *series = &chart->series[i];
+		for (unsigned c = 0; c < series->n_chunks; ++c)
+			memory_free(VS_MEMORY_WIDGETS, series->chunks[c]);
+		memory_free(VS_MEMORY_WIDGETS, series->chunks);
+	}
+}
+
+const widget_class g_chart_class = {sizeof(vchart), call_chart, init_chart, destroy_chart};
+
+vchart *create_chart() {
+	register_widget_type(VS_CHART_ID, &g_chart_class);
+	return create_widget(VS_CHART_ID);
+}
+
+chart_series *add_chart_series(vchart *chart, const unsigned char *color) {
+	if (chart->n_series == VS_CHART_MAX_SERIES)
+		vs_err(NULL);
+	chart_series *series = &chart->series[chart->n_series++];
+	memset(series, 0, sizeof(chart_series));
+	memcpy(series->color, color, 4);
+	return series;
+}
+
+int append_chart_samples(vchart *chart, chart_series *series, const float *values, unsigned long n) {
+	unsigned long begin = series->n_samples;
+	for (unsigned long i = 0; i < n; ++i) {
+		unsigned c = (unsigned) (series->n_samples / VS_CHART_CHUNK);
+		if (c == series->n_chunks) {
+			if (c == series->chunk_capacity) {
+				unsigned capacity = series->chunk_capacity ? series->chunk_capacity * 2 : 16;
+				void **chunks = memory_realloc(VS_MEMORY_WIDGETS, series->chunks, sizeof(void*) * capacity);
+				if (!chunks)
+					vs_err(VS_FAILURE);
+				series->chunks = chunks;
+				series->chunk_capacity = capacity;
+			}
+			chart_chunk *chunk = memory_alloc(VS_MEMORY_WIDGETS, sizeof(chart_chunk));
+			if (!chunk)
+				vs_err(VS_FAILURE);
+			chunk->n = 0;
+			series->chunks[series->n_chunks++] = chunk;
+		}
+		chart_chunk_append(series->chunks[c], values[i]);
+		series->n_samples++;
+	}
+
+	if (chart->follow && series->n_samples - chart->span > chart->first) {
+		chart->first = series->n_samples - chart->span;
+		invalidate_widget(chart);
+	} else if (begin < chart->first + chart->span && series->n_samples > chart->first) {
+		invalidate_widget(chart);
+	}
+	return VS_SUCCESS;
+}
+
+int set_chart_view(vchart *chart, double first, double span, float y_min, float y_max) {
+	if (span <= 0 || y_max == y_min)
+		vs_err(VS_FAILURE);
+	if (chart->first == first && chart->span == span && chart->y_min == y_min && chart->y_max == y_max)
+		return VS_SUCCESS;
+	chart->first = first;
+	chart->span = span;
+	chart->y_min = y_min;
+	chart->y_max = y_max;
+	invalidate_widget(chart);
+	return VS_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file chart.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#ifndef VS_WIDGET_CHART_H
+#define VS_WIDGET_CHART_H
+
+#include "../widget.h"
+
+#define VS_CHART_ID			0x0005
+
+/// Samples in each chunk of a series
+#define VS_CHART_CHUNK		65536
+
+/// Entries of one level of a chunk's pyramid summarized by each entry of the level above it
+#define VS_CHART_FANOUT		8
+
+/// Most series a chart can have
+#define VS_CHART_MAX_SERIES	16
+
+/**
+ * @brief Evenly spaced samples plotted by a chart
+ *
+ * Samples are stored in chunks of VS_CHART_CHUNK, which never move once allocated, so appending never copies what is
+ * already there. Each chunk keeps a pyramid of minimums and maximums, every level VS_CHART_FANOUT times smaller than the
+ * one below it, that is kept up to date as samples are appended. The minimum and maximum of any range are found by
+ * scanning at most a few entries on each level, however many samples the range holds.
+ */
+typedef struct {
+	void **chunks;
+	unsigned n_chunks;
+	unsigned chunk_capacity;
+
+	unsigned long n_samples;
+	unsigned char color[4];
+} chart_series;
+
+typedef struct {
+	VS_WIDGET_HEADER
+
+	chart_series series[VS_CHART_MAX_SERIES];
+	unsigned n_series;
+
+	/// Index of the sample at the left edge, which can be fractional or negative
+	double first;
+
+	/// Samples across the width of the chart
+	double span;
+
+	/// Values at the bottom and top edges
+	float y_min;
+	float y_max;
+
+	/// Set to keep the newest sample at the right edge as samples are appended
+	int follow;
+} vchart;
+
+/// Class charts are registered with
+extern const widget_class g_chart_class;
+
+/**
+ * @brief Creates a new chart
+ *
+ * A chart draws each series as one column of pixels per pixel of its width, spanning the smallest and largest sample in
+ * the column, so drawing costs the same whether a series holds a thousand samples or a hundred million. Columns are
+ * stretched to meet their neighbours so the plot reads as a line when zoomed in.
+ *
+ * @return Returns a new chart, which is freed with destroy_widget()
+ */
+vchart *create_chart();
+
+/**
+ * @brief Adds a series to a chart
+ *
+ * @param chart Pointer to chart
+ * @param color Color the series is drawn in
+ *
+ * @return Returns the series, or NULL if the chart has VS_CHART_MAX_SERIES already
+ */
+chart_series *add_chart_series(vchart *chart, const unsigned char *color);
+
+/**
+ * @brief Appends samples to a series
+ *
+ * The chart is only invalidated if the samples are in view, or it follows the newest samples. Samples must be
+ * appended on the thread that draws the chart.
+ *
+ * @param chart Pointer to chart
+ * @param series Pointer to one of the chart's series
+ * @param values Samples to append
+ * @param n Number of samples
+ *
+ * @return Returns whether it was successful or not
+ */
+int append_chart_samples(vchart *chart, chart_series *series, const float *values, unsigned long n);
+
+/**
+ * @brief Sets the part of its series a chart shows
+ *
+ * @param chart Pointer to chart
+ * @param first Index of the sample at the left edge
+ * @param span Samples across the width of the chart
+ * @param y_min Value at the bottom edge
+ * @param y_max Value at the top edge
+ *
+ * @return Returns whether it was successful or not
+ */
+int set_chart_view(vchart *chart, double first, double span, float y_min, float y_max);
+
+/**
+ * @brief Gets the smallest and largest sample in each column of a chart
+ *
+ * Column i covers the samples from first + span * i / n_columns up to the next column, and always at least one sample.
+ * A column without any samples has a minimum greater than its maximum.
+ *
+ * @param chart Pointer to chart
+ * @param series Pointer to one of the chart's series
+ * @param n_columns Number of columns
+ * @param min Memory address where the n_columns minimums will be saved
+ * @param max Memory address where the n_columns maximums will be saved
+ */
+void get_chart_columns(const vchart *chart, const chart_series *series, unsigned n_columns, float *min, float *max);
+
+#endif
@@ -0,0 +1,40 @@
+/** 
+ * @file image.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+ 
+#include "image.h"
+
+#include "../../venus_common.h"
+#include "../../window.h"
+#include "../../engine/graphics.h"
+
+#include "../theme.h"
+
+int call_image(unsigned type, window *win, void *widget, void** params, unsigned n_params) {
+	if (type == VS_WIDGET_DRAW)
+		return g_theme.draw_image(win, widget, params, n_params);
+	return VS_FAIL_VENUS;
+}
+
+static void destroy_image(void *widget) {
+	vimage *image = (vimage*) widget;
+	if (image->texture)
+		texture_release(image->texture);
+}
+
+const widget_class g_image_class = {sizeof(vimage), call_image, NULL, destroy_image};
+
+vimage *create_image(window *win, const char *path) {
+	register_widget_type(VS_IMAGE_ID, &g_image_class);
+	vimage *image = create_widget(VS_IMAGE_ID);
+	if (!image)
+		return NULL;
+	
+	image->texture = texture_load(&win->textures, path, 0);
+	if (image->texture)
+		image->texture->widget = image;
+	
+	return image;
+}
@@ -0,0 +1,36 @@
+/** 
+ * @file image.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#ifndef VS_WIDGET_IMAGE_H
+#define VS_WIDGET_IMAGE_H
+
+#include "../widget.h"
+
+#define VS_IMAGE_ID			0x0003
+
+typedef struct {
+	VS_WIDGET_HEADER
+
+	texture *texture;
+} vimage;
+
+/// Class images are registered with
+extern const widget_class g_image_class;
+
+/**
+ * @brief Creates a new image
+ * 
+ * The image file is decoded in the background and the image is drawn once it has been uploaded. An image with a width or
+ * height of 0 is drawn at the size of the image file.
+ * 
+ * @param win Pointer to the window the image will be shown in
+ * @param path Path to a PNG file
+ * 
+ * @return Returns a new image, which is freed with destroy_widget()
+ */
+vimage *create_image(window *win, const char *path);
+
+#endif
@@ -14,15 +14,14 @@
 
 int call_panel(unsigned type, window *win, void *widget, void** params, unsigned n_params) {
 	if (type == VS_WIDGET_DRAW)
-		return g_theme.draw_panel(widget, win, params, n_params);
+		return g_theme.draw_panel(win, widget, params, n_params);
 	return VS_FAIL_VENUS;
 }
 
+const widget_class g_panel_class = {sizeof(vpanel), call_panel, NULL, NULL};
+
 vpanel *create_panel() {
-	vpanel *panel = malloc(sizeof(vpanel));
-	
-	panel->func = call_panel;
-	
-	return panel;
+	register_widget_type(VS_PANEL_ID, &g_panel_class);
+	return create_widget(VS_PANEL_ID);
 }
 
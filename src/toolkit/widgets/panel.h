@@ -4,30 +4,24 @@
  * Copyright (C) 2020, Wesley Studt
  */
 
-#ifndef VS_WIDGET_TEXT_FIELD_H
-#define VS_WIDGET_TEXT_FIELD_H
+#ifndef VS_WIDGET_PANEL_H
+#define VS_WIDGET_PANEL_H
 
 #include "../widget.h"
 
 #define VS_PANEL_ID			0x0002
 
 typedef struct {
-	unsigned n_children;
-	void **children;
-	
-	void *parent;
-	unsigned index;
-	
-	unsigned width;
-	unsigned height;
-	
-	int (*func)(unsigned type, window *win, void *widget, void** params, unsigned n_params);
+	VS_WIDGET_HEADER
 } vpanel;
 
+/// Class panels are registered with
+extern const widget_class g_panel_class;
+
 /**
  * @brief Creates a new panel
  * 
- * @return Returns a new panel
+ * @return Returns a new panel, which is freed with destroy_widget()
  */
 vpanel *create_panel();
 
@@ -0,0 +1,129 @@
+/** 
+ * @file profile_overlay.c
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+ 
+#include "profile_overlay.h"
+
+#include "../../venus_common.h"
+#include "../../window.h"
+#include "../../engine/profile.h"
+
+static const unsigned char overlay_background[] = {0x00, 0x00, 0x00, 0xA0};
+static const unsigned char overlay_budget[] = {0xFF, 0xFF, 0xFF, 0x60};
+static const unsigned char overlay_gpu[] = {0xFF, 0x30, 0x30, 0xFF};
+static const unsigned char overlay_phases[VS_PROFILE_N_PHASES][4] = {
+	{0x4C, 0xAF, 0x50, 0xFF},
+	{0x21, 0x96, 0xF3, 0xFF},
+	{0xFF, 0xC1, 0x07, 0xFF},
+	{0x9C, 0x27, 0xB0, 0xFF},
+	{0x79, 0x79, 0x79, 0xFF}
+};
+static const unsigned char overlay_memory[VS_MEMORY_N_TAGS][4] = {
+	{0x4C, 0xAF, 0x50, 0xFF},
+	{0x00, 0xBC, 0xD4, 0xFF},
+	{0xFF, 0xC1, 0x07, 0xFF},
+	{0xE9, 0x1E, 0x63, 0xFF},
+	{0x79, 0x79, 0x79, 0xFF},
+	{0x21, 0x96, 0xF3, 0xFF},
+	{0xFF, 0x57, 0x22, 0xFF},
+	{0x9C, 0x27, 0xB0, 0xFF},
+	{0xCD, 0xDC, 0x39, 0xFF},
+	{0x60, 0x7D, 0x8B, 0xFF}
+};
+
+/*
+ * Draws the live memory of tags first to last - 1 as one bar, scaled so that the sum of their peaks fills it
+ */
+static void draw_memory_bar(render_list *list, float x, float y, float width, unsigned first, unsigned last) {
+	memory_usage usage[VS_MEMORY_N_TAGS];
+	unsigned long peak = 0;
+	for (unsigned tag = first; tag < last; ++tag) {
+		venus_get_memory_usage(tag, &usage[tag]);
+		peak += usage[tag].peak_bytes;
+	}
+	if (!peak)
+		return;
+
+	float scale = width / peak;
+	for (unsigned tag = first; tag < last; ++tag) {
+		float size = usage[tag].live_bytes * scale;
+		if (size <= 0)
+			continue;
+		render_push_quad(list, x, y, size, VS_PROFILE_OVERLAY_MEMORY - 1, overlay_memory[tag], 0, NULL);
+		x += size;
+	}
+}
+
+static int draw_profile_overlay(window *win, vprofile_overlay *overlay, void **params, unsigned n_params) {
+	render_list *list = params[VS_DRAW_PARAM_LIST];
+	int *origin = params[VS_DRAW_PARAM_ORIGIN];
+	float x = origin[0];
+	float y = origin[1];
+	float height = (float) overlay->height - VS_PROFILE_OVERLAY_MEMORY * 2;
+	
+	render_push_quad(list, x, y, overlay->width, overlay->height, overlay_background, 0, NULL);
+	float memory = y + height;
+	draw_memory_bar(list, x, memory, overlay->width, 0, VS_MEMORY_FIRST_GPU);
+	draw_memory_bar(list, x, memory + VS_PROFILE_OVERLAY_MEMORY, overlay->width, VS_MEMORY_FIRST_GPU, VS_MEMORY_N_TAGS);
+	
+	// A line at 60 frames per second
+	float budget = height - height * 16666666.0f / overlay->scale_ns;
+	if (budget > 0)
+		render_push_quad(list, x, y + budget, overlay->width, 1, overlay_budget, 0, NULL);
+	
+	frame_record records[VS_PROFILE_OVERLAY_FRAMES];
+	unsigned n = venus_get_frame_records(records, VS_PROFILE_OVERLAY_FRAMES);
+	float bar = (float) overlay->width / VS_PROFILE_OVERLAY_FRAMES;
+	float scale = height / overlay->scale_ns;
+	
+	for (unsigned i = 0; i < n; ++i) {
+		float left = x + (VS_PROFILE_OVERLAY_FRAMES - n + i) * bar;
+		float bottom = y + height;
+		for (unsigned p = 0; p < VS_PROFILE_N_PHASES; ++p) {
+			float size = records[i].cpu_ns[p] * scale;
+			if (size > bottom - y)
+				size = bottom - y;
+			if (size <= 0)
+				continue;
+			render_push_quad(list, left, bottom - size, bar, size, overlay_phases[p], 0, NULL);
+			bottom -= size;
+		}
+		
+		if (records[i].gpu_ns) {
+			float gpu = records[i].gpu_ns * scale;
+			if (gpu > height)
+				gpu = height;
+			render_push_quad(list, left, y + height - gpu, bar, 1, overlay_gpu, 0, NULL);
+		}
+	}
+	return VS_SUCCESS;
+}
+
+int call_profile_overlay(unsigned type, window *win, void *widget, void** params, unsigned n_params) {
+	if (type == VS_WIDGET_DRAW)
+		return draw_profile_overlay(win, widget, params, n_params);
+	return VS_FAIL_VENUS;
+}
+
+static void init_profile_overlay(void *widget) {
+	vprofile_overlay *overlay = (vprofile_overlay*) widget;
+	overlay->width = 240;
+	overlay->height = 80;
+	overlay->scale_ns = 33333333;
+	profile_watch(overlay);
+}
+
+static void destroy_profile_overlay(void *widget) {
+	profile_unwatch(widget);
+}
+
+const widget_class g_profile_overlay_class = {
+	sizeof(vprofile_overlay), call_profile_overlay, init_profile_overlay, destroy_profile_overlay
+};
+
+vprofile_overlay *create_profile_overlay() {
+	register_widget_type(VS_PROFILE_OVERLAY_ID, &g_profile_overlay_class);
+	return create_widget(VS_PROFILE_OVERLAY_ID);
+}
@@ -0,0 +1,44 @@
+/** 
+ * @file profile_overlay.h
+ * Venus Graphics Engine
+ * Copyright (C) 2020, Wesley Studt
+ */
+
+#ifndef VS_WIDGET_PROFILE_OVERLAY_H
+#define VS_WIDGET_PROFILE_OVERLAY_H
+
+#include "../widget.h"
+
+#define VS_PROFILE_OVERLAY_ID	0x0004
+
+/// Frames shown by a profile overlay
+#define VS_PROFILE_OVERLAY_FRAMES	120
+
+/// Height of each of the two memory bars under the graph
+#define VS_PROFILE_OVERLAY_MEMORY	6
+
+typedef struct {
+	VS_WIDGET_HEADER
+	
+	/// Frame time shown at the full height of the widget, in nanoseconds
+	unsigned long scale_ns;
+} vprofile_overlay;
+
+/// Class profile overlays are registered with
+extern const widget_class g_profile_overlay_class;
+
+/**
+ * @brief Creates a new profile overlay
+ * 
+ * The overlay draws the last VS_PROFILE_OVERLAY_FRAMES frame records as a bar graph, one bar per frame with the CPU
+ * phases stacked in different colors and a line marking the GPU time. Under the graph, one bar splits the CPU memory
+ * held by venus by subsystem and another does the same for GPU memory, each drawn against the sum of its subsystems'
+ * peaks. It is a debugging aid, so it is not themed. The graph shows nothing unless the profiler is on, and the overlay
+ * should not be put inside a cached layer. While the profiler is on, the overlay is invalidated with every frame record,
+ * so the window it is in keeps drawing.
+ * 
+ * @return Returns a new profile overlay, which is freed with destroy_widget()
+ */
+vprofile_overlay *create_profile_overlay();
+
+#endif
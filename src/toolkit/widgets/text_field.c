@@ -14,14 +14,13 @@
 
 int call_text_field(unsigned type, window *win, void *widget, void** params, unsigned n_params) {
 	if (type == VS_WIDGET_DRAW)
-		return g_theme.draw_text_field(widget, win, params, n_params);
+		return g_theme.draw_text_field(win, widget, params, n_params);
 	return VS_FAIL_VENUS;
 }
 
+const widget_class g_text_field_class = {sizeof(vtext_field), call_text_field, NULL, NULL};
+
 vtext_field *create_text_field() {
-	vtext_field *field = malloc(sizeof(vtext_field));
-	
-	field->func = call_text_field;
-	
-	return field;
+	register_widget_type(VS_TEXT_FIELD_ID, &g_text_field_class);
+	return create_widget(VS_TEXT_FIELD_ID);
 }
@@ -12,25 +12,19 @@
 #define VS_TEXT_FIELD_ID	0x0001
 
 typedef struct {
-	unsigned n_children;
-	void **children;
-	
-	void *parent;
-	unsigned index;
-	
-	unsigned width;
-	unsigned height;
-	
-	int (*func)(unsigned type, window *win, void *widget, void** params, unsigned n_params);
+	VS_WIDGET_HEADER
 
 	char *default_text;
 	char *current_text;
 } vtext_field;
 
+/// Class text fields are registered with
+extern const widget_class g_text_field_class;
+
 /**
  * @brief Creates a new text field
  * 
- * @return Returns a new text field
+ * @return Returns a new text field, which is freed with destroy_widget()
  */
 vtext_field *create_text_field();
 
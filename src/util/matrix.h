@@ -13,17 +13,39 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <stdio.h>
+#include "../engine/arena.h"
+#include "../engine/memory.h"
+
 unsigned matrix_rows(void *mat);
 unsigned matrix_columns(void *mat);
 unsigned matrix_size(void *mat);
 void matrix_delete(void *mat);
 
+/**
+ * @brief Defines a new matrix type along with its functions
+ * 
+ * Matrices made by arena_create_NAME() belong to the arena they came from and must not be given to matrix_delete() or
+ * NAME_resize().
+ * 
+ * @param TYPE The datatype the matrix should contain
+ * @param NAME The name of the new matrix
+ */
 #define VS_DEFINE_MATRIX(TYPE, NAME)														\
 typedef TYPE *NAME;																			\
 																							\
 NAME create_##NAME(unsigned rows, unsigned columns) {										\
-	char *source = malloc(sizeof(unsigned) * 2 + rows * columns * sizeof(TYPE));			\
+	size_t bytes = sizeof(unsigned) * 2 + rows * columns * sizeof(TYPE);					\
+	char *source = memory_alloc(VS_MEMORY_VECTORS, bytes);									\
+	*((unsigned*) source) = rows;															\
+	*((unsigned*) source + 1) = columns;													\
+	source += sizeof(unsigned) * 2;															\
+	return (NAME) source;																	\
+}																							\
+																							\
+NAME arena_create_##NAME(arena *a, unsigned rows, unsigned columns) {						\
+	char *source = arena_alloc(a, sizeof(unsigned) * 2 + rows * columns * sizeof(TYPE));	\
+	if (!source)																			\
+		return NULL;																		\
 	*((unsigned*) source) = rows;															\
 	*((unsigned*) source + 1) = columns;													\
 	source += sizeof(unsigned) * 2;															\
@@ -32,7 +54,8 @@ NAME create_##NAME(unsigned rows, unsigned columns) {										\
 																							\
 void NAME##_resize(NAME mat, unsigned new_rows, unsigned new_columns) {						\
 	char *source = ((char*) mat - sizeof(unsigned) * 2);									\
-	source = realloc(source, sizeof(unsigned) * 2 + new_rows * new_columns * sizeof(TYPE));	\
+	size_t bytes = sizeof(unsigned) * 2 + new_rows * new_columns * sizeof(TYPE);			\
+	source = memory_realloc(VS_MEMORY_VECTORS, source, bytes);								\
 }																							\
 																							\
 void NAME##_add(NAME dest, NAME src0, NAME src1) {											\
@@ -100,13 +123,14 @@ TYPE NAME##_determinant(NAME matrix) {														\
 	unsigned columns = matrix_columns(matrix);												\
 	if (size != columns)																	\
 		return 0;																			\
-	printf("size is %i\n", size);															\
 	if (size == 2)																			\
 		return (matrix[0] * matrix[3]) - (matrix[1] * matrix[2]);							\
-	zlog_info(g_log, "creating submatrix");													\
-	NAME submatrix = create_##NAME(size - 1, size - 1);										\
+	arena *scratch = scratch_arena();														\
+	arena_mark mark = arena_get_mark(scratch);												\
+	NAME submatrix = arena_create_##NAME(scratch, size - 1, size - 1);						\
+	if (!submatrix)																			\
+		return 0;																			\
 	TYPE determinant = 0;																	\
-	printf("got here\n");																	\
 	for (unsigned a = 0; a < size; ++a) {													\
 		for (unsigned b = 0; b < size - 1; ++b) {											\
 			for (unsigned c = 1; c < size; ++c) {											\
@@ -121,8 +145,7 @@ TYPE NAME##_determinant(NAME matrix) {														\
 		else																				\
 			determinant -= NAME##_determinant(submatrix);									\
 	}																						\
-	zlog_info(g_log, "freeing submatrix");													\
-	matrix_delete(submatrix);																\
+	arena_release(scratch, mark);															\
 	return determinant;																		\
 }																							\
 																							\
@@ -11,6 +11,9 @@
 #include <stdarg.h>
 #include <string.h>
 
+#include "../engine/arena.h"
+#include "../engine/memory.h"
+
 unsigned vec_size(void *vec);
 void vec_delete(void *vec);
 
@@ -25,16 +28,26 @@ extern "C" {
  * Venus is a GUI/graphics library, it needs to manipulate points in two-dimensional space and three-dimensional space. This
  * requires functions that can add, multiply, etc., vectors.
  * 
+ * Vectors made by arena_create_NAME() belong to the arena they came from and must not be given to vec_delete() or
+ * NAME_resize().
+ * 
  * @param TYPE The datatype the vector should contain
  * @param NAME The name of the new vector
  */
 	
 #define VS_INTERNAL_SET_VECTOR(arg0, args...)
 
+/*
+ * Type a TYPE is promoted to when it is passed through "...", which is what va_arg() has to read. Integers narrower than
+ * int become int through the unary plus, and float becomes double.
+ */
+#define VS_INTERNAL_PROMOTED(TYPE) __typeof__(_Generic(+(TYPE) 0, float: 0.0, default: +(TYPE) 0))
+
 #define VS_DEFINE_VECTOR_HEADER(TYPE, NAME)													\
 typedef TYPE *NAME;																			\
 																							\
 NAME create_##NAME(unsigned size);															\
+NAME arena_create_##NAME(arena *a, unsigned size);											\
 NAME make_##NAME(unsigned size, ...);														\
 void NAME##_resize(NAME vec, unsigned new_size);											\
 void NAME##_add(NAME dest, NAME src0, NAME src1);											\
@@ -55,7 +68,17 @@ TYPE NAME##_dot(NAME src0, NAME src1);														\
 #define VS_DEFINE_VECTOR_SOURCE(TYPE, NAME)													\
 																							\
 NAME create_##NAME(unsigned size) {															\
-	char *source = malloc(sizeof(unsigned) + sizeof(TYPE) * size);							\
+	size_t bytes = sizeof(unsigned) + sizeof(TYPE) * size;									\
+	char *source = memory_alloc(VS_MEMORY_VECTORS, bytes);									\
+	*((unsigned*) source) = size;															\
+	source += sizeof(unsigned);																\
+	return (NAME) source;																	\
+}																							\
+																							\
+NAME arena_create_##NAME(arena *a, unsigned size) {											\
+	char *source = arena_alloc(a, sizeof(unsigned) + sizeof(TYPE) * size);					\
+	if (!source)																			\
+		return NULL;																		\
 	*((unsigned*) source) = size;															\
 	source += sizeof(unsigned);																\
 	return (NAME) source;																	\
@@ -66,19 +89,16 @@ NAME make_##NAME(unsigned size, ...) {														\
 																							\
 	va_list values;																			\
 	va_start(values, size);																	\
-	if (sizeof(TYPE) < sizeof(int))															\
-		for (unsigned i = 0; i < size; ++i)													\
-			vector[i] = (TYPE) va_arg(values, int);											\
-	else																					\
-		for (unsigned i = 0; i < size; ++i)													\
-			vector[i] = va_arg(values, TYPE);												\
+	for (unsigned i = 0; i < size; ++i)														\
+		vector[i] = (TYPE) va_arg(values, VS_INTERNAL_PROMOTED(TYPE));						\
 	va_end(values);																			\
 	return vector;																			\
 }																							\
 																							\
 void NAME##_resize(NAME vec, unsigned new_size) {											\
 	char *source = ((char*) vec - sizeof(unsigned));										\
-	source = realloc(source, sizeof(unsigned) + new_size * sizeof(TYPE));					\
+	size_t bytes = sizeof(unsigned) + new_size * sizeof(TYPE);								\
+	source = memory_realloc(VS_MEMORY_VECTORS, source, bytes);								\
 }																							\
 																							\
 void NAME##_add(NAME dest, NAME src0, NAME src1) {											\
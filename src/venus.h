@@ -47,4 +47,286 @@ int flush();
  */
 int venus_begin_loop();
 
+/**
+ * @brief Dispatches every pending event to its window without blocking
+ * 
+ * Animations are advanced afterwards, so this should be called once per frame. Before the events are read, it sleeps
+ * until the earliest time a window that is paced, or that skipped its last frame, should start its next one.
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_process_events();
+
+#define VS_REPLAY_REALTIME		0
+#define VS_REPLAY_FAST			1
+
+/**
+ * @brief Starts writing every dispatched event to a file
+ * 
+ * Events are written with their timing and with a marker at every swap, so a replay can reproduce the session.
+ * 
+ * @param path Path of the recording
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_record_events(const char *path);
+
+/**
+ * @brief Stops the recording started by venus_record_events()
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_stop_recording();
+
+/**
+ * @brief Starts feeding a recording back through venus_process_events()
+ * 
+ * Real input is dropped while the replay runs. In VS_REPLAY_REALTIME mode, events are dispatched with their recorded
+ * timing. In VS_REPLAY_FAST mode, each frame gets exactly the events it got when recorded, as fast as frames are drawn.
+ * Windows are matched by the order they were created in, so the program should open them in the same order.
+ * 
+ * @param path Path of the recording
+ * @param mode VS_REPLAY_REALTIME or VS_REPLAY_FAST
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_replay_events(const char *path, int mode);
+
+/**
+ * @brief Stops the replay started by venus_replay_events()
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_stop_replay();
+
+/**
+ * @brief Checks whether the replay has dispatched every event
+ * 
+ * @return Returns VS_TRUE once there is no replay running
+ */
+int venus_replay_finished();
+
+#define VS_PROFILE_EVENTS		0
+#define VS_PROFILE_LAYOUT		1
+#define VS_PROFILE_RECORD		2
+#define VS_PROFILE_SUBMIT		3
+#define VS_PROFILE_SWAP			4
+#define VS_PROFILE_N_PHASES		5
+
+/// Number of frames the profiler keeps
+#define VS_PROFILE_FRAMES		256
+
+/**
+ * @brief Where the time of one frame went
+ * 
+ * A frame starts when the last one was swapped and ends when it is swapped. All times are in nanoseconds.
+ */
+typedef struct {
+	/// Frame number, counting from 1
+	unsigned long frame;
+	
+	/// CLOCK_MONOTONIC time the frame started at
+	unsigned long start_ns;
+	
+	/// Time from the start of the frame to the end of its swap
+	unsigned long frame_ns;
+	
+	/// CPU time spent in each phase, indexed by VS_PROFILE_EVENTS and friends
+	unsigned long cpu_ns[VS_PROFILE_N_PHASES];
+	
+	/// GPU time spent drawing the frame, or 0 if the result has not come back yet
+	unsigned long gpu_ns;
+} frame_record;
+
+/**
+ * @brief Turns the frame profiler on or off
+ * 
+ * The profiler is off by default. When it is on, every frame is timed on the CPU by phase and on the GPU with timer
+ * queries that are read back a few frames later, so nothing ever waits on the GPU.
+ * 
+ * @param enabled VS_TRUE to turn the profiler on
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_enable_profiler(int enabled);
+
+/**
+ * @brief Copies the most recent frame records
+ * 
+ * This is safe to call from any thread while frames are being drawn.
+ * 
+ * @param records Memory address where the records will be saved, oldest first
+ * @param n Most records to copy, up to VS_PROFILE_FRAMES
+ * 
+ * @return Returns the number of records copied
+ */
+unsigned venus_get_frame_records(frame_record *records, unsigned n);
+
+#define VS_LATENCY_KEY			0
+#define VS_LATENCY_BUTTON		1
+#define VS_LATENCY_MOTION		2
+#define VS_LATENCY_N_KINDS		3
+
+#define VS_LATENCY_QUEUE		0
+#define VS_LATENCY_DISPATCH		1
+#define VS_LATENCY_RENDER		2
+#define VS_LATENCY_SWAP			3
+#define VS_LATENCY_PRESENT		4
+#define VS_LATENCY_N_STAGES		5
+
+/// Number of buckets in a latency histogram
+#define VS_LATENCY_BUCKETS		256
+
+/// Width of each bucket in nanoseconds
+#define VS_LATENCY_BUCKET_NS	500000ul
+
+/**
+ * @brief Input-to-photon latency of one kind of input event
+ * 
+ * Latency runs from the X server's timestamp of the event, or from its arrival if the server's clock cannot be compared,
+ * to the completion of the swap that showed its effect. Only events whose callback damaged a widget are counted.
+ */
+typedef struct {
+	/// Number of events measured
+	unsigned long count;
+	
+	/// Bucket i counts events that took between i and i + 1 times VS_LATENCY_BUCKET_NS
+	unsigned long buckets[VS_LATENCY_BUCKETS];
+	
+	/// Events that took longer than the last bucket
+	unsigned long overflow;
+	
+	unsigned long min_ns;
+	unsigned long max_ns;
+	unsigned long total_ns;
+	
+	/// Total time spent in each stage, indexed by VS_LATENCY_QUEUE and friends
+	unsigned long stage_ns[VS_LATENCY_N_STAGES];
+	
+	/// Events timed to the completion of their swap rather than to the return of glXSwapBuffers()
+	unsigned long presented;
+} latency_histogram;
+
+/**
+ * @brief Turns the input latency probe on or off
+ * 
+ * The probe is off by default. It uses GLX_OML_sync_control to learn when swaps complete if the driver has it.
+ * 
+ * @param enabled VS_TRUE to turn the probe on
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_enable_latency_probe(int enabled);
+
+/**
+ * @brief Copies the latency histogram of one kind of input event
+ * 
+ * @param kind VS_LATENCY_KEY, VS_LATENCY_BUTTON or VS_LATENCY_MOTION
+ * @param histogram Memory address where the histogram will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_get_latency_histogram(unsigned kind, latency_histogram *histogram);
+
+/**
+ * @brief Empties every latency histogram
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_reset_latency_histograms();
+
+#define VS_MEMORY_WIDGETS		0
+#define VS_MEMORY_VECTORS		1
+#define VS_MEMORY_RENDER		2
+#define VS_MEMORY_IMAGES		3
+#define VS_MEMORY_ENGINE		4
+#define VS_MEMORY_GL_BUFFERS	5
+#define VS_MEMORY_TEXTURES		6
+#define VS_MEMORY_PROGRAMS		7
+#define VS_MEMORY_ATLASES		8
+#define VS_MEMORY_LAYERS		9
+#define VS_MEMORY_N_TAGS		10
+
+/// Tags from this one on count GPU memory, the ones before it count CPU memory
+#define VS_MEMORY_FIRST_GPU		VS_MEMORY_GL_BUFFERS
+
+/**
+ * @brief Memory held by one subsystem
+ * 
+ * CPU memory is counted as the size of the heap blocks handed out, which can be a little more than what was asked for.
+ * GPU memory is the size of the storage requested from GL, which the driver may round up or place differently.
+ */
+typedef struct {
+	/// Bytes held right now
+	unsigned long live_bytes;
+	
+	/// Most bytes ever held at once
+	unsigned long peak_bytes;
+	
+	/// Allocations or GL objects held right now
+	unsigned long live_objects;
+	
+	/// Allocations or GL objects ever made
+	unsigned long total_objects;
+} memory_usage;
+
+/**
+ * @brief Copies the memory usage of one subsystem
+ * 
+ * This is safe to call from any thread.
+ * 
+ * @param tag VS_MEMORY_WIDGETS or one of the other VS_MEMORY tags
+ * @param usage Memory address where the usage will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_get_memory_usage(unsigned tag, memory_usage *usage);
+
+/**
+ * @brief Logs every subsystem that still holds memory
+ * 
+ * venus_terminate() calls this once every window has been destroyed, when anything still held has leaked. Arenas of
+ * threads that are still running and trace buffers, which last as long as the program, are counted under
+ * VS_MEMORY_ENGINE.
+ * 
+ * @return Returns the number of allocations and GL objects still held
+ */
+unsigned long venus_report_leaks();
+
+/**
+ * @brief Turns span tracing on or off
+ * 
+ * Tracing is off by default. When it is on, engine spans such as window creation, shader compiles, buffer uploads,
+ * widget draws and swaps are recorded on the thread that runs them. Building with VS_COMPILE_DISABLE_TRACE removes the
+ * spans entirely.
+ * 
+ * @param enabled VS_TRUE to turn tracing on
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_enable_tracing(int enabled);
+
+/**
+ * @brief Writes the recorded spans as a Chrome trace
+ * 
+ * The file can be opened in chrome://tracing or the Perfetto UI.
+ * 
+ * @param path Path of the JSON file to write
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_dump_trace(const char *path);
+
+/**
+ * @brief Writes the trace whenever a signal is received
+ * 
+ * The trace is written by the next swap_buffers() after the signal arrives, not by the signal handler.
+ * 
+ * @param signum Signal to listen for, such as SIGUSR1
+ * @param path Path of the JSON file to write
+ * 
+ * @return Returns whether it was successful or not
+ */
+int venus_dump_trace_on_signal(int signum, const char *path);
+
 #endif
@@ -52,12 +52,72 @@ extern int (*g_error_callback)(void *win, unsigned err);
 #define VS_FAIL_GLX_NO_VISUAL			(0x0001 | VS_FAIL_GLX)
 #define VS_FAIL_GLX_INVALID_VERSION		(0x0002 | VS_FAIL_GLX)
 
+#include "engine/log.h"
+
+/*
+ * Logging below VS_COMPILE_LOG_LEVEL is removed at compile time, arguments included. Everything else is queued for the
+ * logging thread.
+ */
+#ifndef VS_COMPILE_LOG_LEVEL
+#define VS_COMPILE_LOG_LEVEL VS_LOG_INFO
+#endif
+
+#if VS_COMPILE_LOG_LEVEL <= VS_LOG_DEBUG
+#define vs_log_debug(...) log_write(VS_LOG_DEBUG, __VA_ARGS__)
+#else
+#define vs_log_debug(...) ((void) 0)
+#endif
+
+#if VS_COMPILE_LOG_LEVEL <= VS_LOG_INFO
+#define vs_log_info(...) log_write(VS_LOG_INFO, __VA_ARGS__)
+#else
+#define vs_log_info(...) ((void) 0)
+#endif
+
+#if VS_COMPILE_LOG_LEVEL <= VS_LOG_WARN
+#define vs_log_warn(...) log_write(VS_LOG_WARN, __VA_ARGS__)
+#else
+#define vs_log_warn(...) ((void) 0)
+#endif
+
+#if VS_COMPILE_LOG_LEVEL <= VS_LOG_ERROR
+#define vs_log_error(...) log_write(VS_LOG_ERROR, __VA_ARGS__)
+#else
+#define vs_log_error(...) ((void) 0)
+#endif
+
+#if VS_COMPILE_LOG_LEVEL <= VS_LOG_FATAL
+#define vs_log_fatal(...) log_write(VS_LOG_FATAL, __VA_ARGS__)
+#else
+#define vs_log_fatal(...) ((void) 0)
+#endif
+
 #ifdef VS_COMPILE_DO_NOT_PRINT_ERROR
 #define vs_err(ERR) return ERR
 #else
-#define vs_err(ERR) {zlog_error(g_log, #ERR); return ERR;}
+#define vs_err(ERR) {vs_log_error(#ERR); return ERR;}
 #endif
 
 #define vs_has_err(X) !(X)
 
+/*
+ * Tracing spans. VS_TRACE_SCOPE() times the rest of the enclosing block, VS_TRACE_BEGIN() and VS_TRACE_END() time the
+ * code between them. Names must be string literals.
+ */
+#ifdef VS_COMPILE_DISABLE_TRACE
+#define VS_TRACE_SCOPE(NAME)
+#define VS_TRACE_BEGIN(NAME)
+#define VS_TRACE_END(NAME)
+#else
+#include "engine/trace.h"
+
+#define VS_TRACE_CONCAT_(A, B) A##B
+#define VS_TRACE_CONCAT(A, B) VS_TRACE_CONCAT_(A, B)
+#define VS_TRACE_SCOPE(NAME) \
+	trace_scope VS_TRACE_CONCAT(vs_trace_scope_, __LINE__) __attribute__((cleanup(trace_scope_end))) = \
+		trace_scope_begin(NAME)
+#define VS_TRACE_BEGIN(NAME) trace_scope vs_trace_##NAME = trace_scope_begin(#NAME)
+#define VS_TRACE_END(NAME) trace_scope_end(&vs_trace_##NAME)
+#endif
+
 #endif
@@ -27,16 +27,32 @@
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 
+// Windows are made through XCB, which shares its connection with Xlib
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+
 // OpenGL Extension to the X Window System
 #include <GL/glx.h>
 
+// Synthetic input for automated latency measurement
+#include <X11/extensions/XTest.h>
+#include <X11/keysym.h>
+
 #include <stdlib.h>
+#include <string.h>
 
 #include "venus_common.h"
 #include "engine/graphics.h"
+#include "engine/arena.h"
+#include "engine/jobs.h"
+#include "engine/replay.h"
 #include "toolkit/theme.h"
+#include "toolkit/widget.h"
 
 int create_window(window *win) {
+	VS_TRACE_SCOPE("create_window");
+	if (!xcb_platform_init())
+		return VS_FAILURE;
 	
 	// Attributes for XVisualInfo
 	int attributes[] = {
@@ -57,80 +73,381 @@ int create_window(window *win) {
 	GLXFBConfig framebuffer;
 	XVisualInfo *visual_info = glx_get_visual(attributes, &framebuffer);
 	if (visual_info == NULL) {
-		zlog_info(g_log, "No appropriate visual found");
+		vs_log_info("No appropriate visual found");
 		return VS_FAILURE;
 	} else {
-		zlog_info(g_log, "Visual %p selected", (void*) visual_info->visualid);
+		vs_log_info("Visual %p selected", (void*) visual_info->visualid);
 	}
 	
-	XSetWindowAttributes set_window_attributes;
-	set_window_attributes.colormap = XCreateColormap(g_display, g_root, visual_info->visual, AllocNone);
-	set_window_attributes.event_mask = ExposureMask | KeyPressMask | PointerMotionMask;
-
-	// Create the window
-	win->xwin = XCreateWindow(
-		g_display,
-		g_root,
-		0,
+	win->n_children = 0;
+	win->children = NULL;
+	win->parent = NULL;
+	win->width = VS_WINDOW_DEFAULT_WIDTH;
+	win->height = VS_WINDOW_DEFAULT_HEIGHT;
+	win->event_callback = NULL;
+	win->resize_callback = NULL;
+	resize_init(&win->resize, win->width, win->height);
+	pacer_init(&win->pacer);
+	memset(&win->gpu_timer, 0, sizeof(gpu_timer));
+	memset(&win->latency, 0, sizeof(latency_probe));
+	render_list_init(&win->render);
+	render_recorder_init(&win->recorder);
+	
+	// Nothing here has a reply, so the requests are only sent with the next flush and the window never waits on them
+	uint32_t values[] = {
+		// The border has to be given when the visual's depth differs from the root's
 		0,
-		1242,
-		768,
-		0,	
-		visual_info->depth,
-		InputOutput,
-		visual_info->visual,
-		CWColormap | CWEventMask,
-		&set_window_attributes
-	);
-
-	win->context = malloc(sizeof(GLXContext));
-	*(win->context) = glx_make_context(visual_info, framebuffer, NULL, GL_TRUE);
+		
+		// Keep the old contents in the top left corner on a resize instead of clearing the window every step
+		XCB_GRAVITY_NORTH_WEST,
+		XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE | XCB_EVENT_MASK_BUTTON_PRESS |
+			XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_STRUCTURE_NOTIFY,
+		
+		// Colormap
+		0
+	};
+	win->colormap = values[3] = xcb_generate_id(g_xcb);
+	xcb_create_colormap(g_xcb, XCB_COLORMAP_ALLOC_NONE, win->colormap, g_root, visual_info->visualid);
+	win->xwin = xcb_generate_id(g_xcb);
+	xcb_create_window(g_xcb, visual_info->depth, win->xwin, g_root, 0, 0, win->width, win->height, 0,
+		XCB_WINDOW_CLASS_INPUT_OUTPUT, visual_info->visualid,
+		XCB_CW_BORDER_PIXEL | XCB_CW_BIT_GRAVITY | XCB_CW_EVENT_MASK | XCB_CW_COLORMAP, values);
+
+	win->context = glx_make_context(visual_info, framebuffer, NULL, GL_TRUE);
+	gl_state_init(&win->gl);
 	glx_make_current(win);
 	XFree(visual_info);
 
 	if (!GLVersion.major) {
 		if (!gladLoadGL()) {
-			zlog_fatal(g_log, "Failed to load OpenGL");
+			vs_log_fatal("Failed to load OpenGL");
 			return VS_FAILURE;
 		}
-		zlog_info(g_log, "Loaded OpenGL %i.%i", GLVersion.major, GLVersion.minor);
+		vs_log_info("Loaded OpenGL %i.%i", GLVersion.major, GLVersion.minor);
+	}
+	
+	if (!gl_render_init(&win->renderer)) {
+		vs_log_error("Failed to create the window's renderer");
+		return VS_FAILURE;
 	}
+	texture_cache_init(&win->textures, VS_TEXTURE_DEFAULT_BUDGET);
+	layer_cache_init(&win->layers, VS_LAYER_DEFAULT_BUDGET);
+	tile_cache_init(&win->tiles, VS_TILE_DEFAULT_BUDGET);
+	path_cache_init(&win->paths);
+	effect_cache_init(&win->effects, VS_EFFECT_DEFAULT_BUDGET);
+	win->renderer.effects = &win->effects;
+	capture_init(&win->capture);
+	
+	xlib_register_window(win);
 	return VS_SUCCESS;
 }
 
 int destroy_window(window *win) {
+	xlib_unregister_window(win);
+	glx_make_current(win);
+	
+	// The window owns the widgets in it, and their layers have to go before the layer cache does
+	for (unsigned i = 0; i < win->n_children; ++i) {
+		widget_t *w = (widget_t*) win->children[i];
+		w->parent = NULL;
+		if (w->type)
+			destroy_widget(w);
+	}
+	allocate_children(win, 0);
+	win->n_children = 0;
+	
+	gl_profile_gpu_destroy(&win->gpu_timer);
+	capture_destroy(&win->capture);
+	resize_destroy(&win->resize);
+	layer_cache_destroy(&win->layers);
+	tile_cache_destroy(&win->tiles);
+	path_cache_destroy(&win->paths);
+	effect_cache_destroy(&win->effects);
+	texture_cache_destroy(&win->textures);
+	gl_render_destroy(&win->renderer);
+	render_list_free(&win->render);
+	render_recorder_free(&win->recorder);
+	if (g_current_window == win)
+		g_current_window = NULL;
 	glXMakeCurrent(g_display, None, NULL);
-	glXDestroyContext(g_display, *(win->context));
-	XDestroyWindow(g_display, win->xwin);
-	XFree(win->context);
+	glXDestroyContext(g_display, win->context);
+	xcb_destroy_window(g_xcb, win->xwin);
+	xcb_free_colormap(g_xcb, win->colormap);
+	return VS_SUCCESS;
 }
 
 int set_title(window *win, char *title) {
-	XStoreName(g_display, win->xwin, title);
+	unsigned length = strlen(title);
+	xcb_change_property(g_xcb, XCB_PROP_MODE_REPLACE, win->xwin, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, length, title);
+	
+	// Window managers prefer the UTF-8 name when there is one
+	xcb_atom_t name = xcb_platform_atom(VS_ATOM_NET_WM_NAME);
+	xcb_atom_t utf8 = xcb_platform_atom(VS_ATOM_UTF8_STRING);
+	if (name != XCB_ATOM_NONE && utf8 != XCB_ATOM_NONE)
+		xcb_change_property(g_xcb, XCB_PROP_MODE_REPLACE, win->xwin, name, utf8, 8, length, title);
+	return VS_SUCCESS;
 }
 
 int set_background_color(window *win, color color) {
-	glClearColor((float) color[0] / 255.0f,(float) color[1] / 255.0f, (float) color[2] / 255.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glXSwapBuffers(g_display, win->xwin);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glXSwapBuffers(g_display, win->xwin);
+	glx_make_current(win);
+	pacer_damage(&win->pacer);
+	gl_clear_color((float) color[0] / 255.0f,(float) color[1] / 255.0f, (float) color[2] / 255.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 	return VS_SUCCESS;
 }
 
 int show(window *win) {
-	XMapWindow(g_display, win->xwin);
+	xcb_map_window(g_xcb, win->xwin);
 	return VS_SUCCESS;
 }
 
 int hide(window *win) {
-	XUnmapWindow(g_display, win->xwin);
+	xcb_unmap_window(g_xcb, win->xwin);
+	return VS_SUCCESS;
+}
+
+int set_event_callback(window *win, int (*callback)(void *win, void *event)) {
+	win->event_callback = callback;
+	return VS_SUCCESS;
+}
+
+int set_resize_callback(window *win, int (*callback)(void *win, unsigned width, unsigned height)) {
+	win->resize_callback = callback;
+	return VS_SUCCESS;
+}
+
+int get_resize_stats(window *win, resize_stats *stats) {
+	*stats = win->resize.stats;
+	return VS_SUCCESS;
+}
+
+int set_swap_interval(window *win, int interval) {
+	glx_make_current(win);
+	return pacer_set_interval(&win->pacer, win->xwin, interval);
+}
+
+int set_frame_pacing(window *win, int enabled) {
+	win->pacer.pacing = !!enabled;
+	return VS_SUCCESS;
+}
+
+int set_present_on_damage(window *win, int enabled) {
+	win->pacer.present_on_damage = !!enabled;
+	pacer_damage(&win->pacer);
+	return VS_SUCCESS;
+}
+
+int get_frame_stats(window *win, frame_stats *stats) {
+	*stats = win->pacer.stats;
+	return VS_SUCCESS;
+}
+
+int capture_frame(window *win, const char *path, int format) {
+	if (format != VS_CAPTURE_PNG && format != VS_CAPTURE_RAW)
+		vs_err(VS_FAILURE);
+	if (!capture_request(&win->capture, path, format))
+		return VS_FAILURE;
+	pacer_damage(&win->pacer);
+	return VS_SUCCESS;
+}
+
+int get_capture_stats(window *win, capture_stats *stats) {
+	capture_get_stats(&win->capture, stats);
+	return VS_SUCCESS;
+}
+
+int set_render_threads(window *win, unsigned n_threads) {
+	win->recorder.n_threads = n_threads ? n_threads : jobs_thread_count();
+	return VS_SUCCESS;
+}
+
+int set_texture_budget(window *win, unsigned long bytes) {
+	texture_cache_set_budget(&win->textures, bytes);
+	return VS_SUCCESS;
+}
+
+int get_texture_stats(window *win, texture_stats *stats) {
+	texture_cache_stats(&win->textures, stats);
+	return VS_SUCCESS;
+}
+
+int set_layer_budget(window *win, unsigned long bytes) {
+	win->layers.stats.budget = bytes;
+	return VS_SUCCESS;
+}
+
+int get_layer_stats(window *win, layer_stats *stats) {
+	*stats = win->layers.stats;
+	stats->n_layers = win->layers.n_layers;
+	stats->n_active = 0;
+	for (unsigned i = 0; i < win->layers.n_layers; ++i)
+		if (win->layers.layers[i]->active)
+			stats->n_active++;
+	return VS_SUCCESS;
+}
+
+int set_tile_budget(window *win, unsigned long bytes) {
+	tile_cache_set_budget(&win->tiles, bytes);
+	return VS_SUCCESS;
+}
+
+int get_tile_stats(window *win, tile_stats *stats) {
+	tile_cache_stats(&win->tiles, stats);
+	return VS_SUCCESS;
+}
+
+int get_path_stats(window *win, path_stats *stats) {
+	pthread_mutex_lock(&win->paths.lock);
+	*stats = win->paths.stats;
+	pthread_mutex_unlock(&win->paths.lock);
+	return VS_SUCCESS;
+}
+
+static void invalidate_layers(window *win) {
+	for (unsigned i = 0; i < win->layers.n_layers; ++i)
+		layer_invalidate(win->layers.layers[i]);
+}
+
+int set_effect_quality(window *win, unsigned quality) {
+	if (!effect_cache_set_quality(&win->effects, quality))
+		return VS_FAILURE;
+	invalidate_layers(win);
+	pacer_damage(&win->pacer);
+	return VS_SUCCESS;
+}
+
+int set_effect_budget(window *win, unsigned long bytes) {
+	win->effects.stats.budget = bytes;
+	return VS_SUCCESS;
+}
+
+int get_effect_stats(window *win, effect_stats *stats) {
+	pthread_mutex_lock(&win->effects.lock);
+	*stats = win->effects.stats;
+	pthread_mutex_unlock(&win->effects.lock);
+	return VS_SUCCESS;
+}
+
+int draw_window(window *win) {
+	glx_make_current(win);
+	
+	// Laying out and recording at every step of a drag would stall it, so the kept frame stands in until it settles
+	int resized = resize_begin_frame(&win->resize, &win->width, &win->height);
+	if (resized != VS_RESIZE_NONE)
+		pacer_damage(&win->pacer);
+	if (resized == VS_RESIZE_STALE) {
+		pacer_begin_frame(&win->pacer);
+		return resize_present(&win->resize);
+	}
+	if (resized == VS_RESIZE_APPLY && win->resize_callback)
+		win->resize_callback(win, win->width, win->height);
+	
+	// Images and tiles that arrive invalidate their widgets, which damages the window, so the caches are advanced even for
+	// frames that are skipped. Shadows that were asked for are rendered in the next frame that is drawn.
+	unsigned long uploads = win->textures.stats.uploads;
+	profile_begin(VS_PROFILE_SUBMIT);
+	texture_cache_update(&win->textures);
+	tile_cache_update(&win->tiles);
+	profile_end(VS_PROFILE_SUBMIT);
+	if (win->textures.stats.uploads != uploads || win->effects.n_pending)
+		pacer_damage(&win->pacer);
+	if (!pacer_begin_frame(&win->pacer))
+		return VS_SUCCESS;
+	
+	gl_profile_gpu_poll(&win->gpu_timer);
+	gl_profile_gpu_begin(&win->gpu_timer);
+	
+	// Meshes only age in frames that are recorded, so a window that sits still keeps its icons
+	path_cache_update(&win->paths);
+	
+	// Shadows asked for last frame are left out of layers rendered since, so new ones render the layers again
+	profile_begin(VS_PROFILE_SUBMIT);
+	if (effect_cache_update(&win->effects, &win->renderer))
+		invalidate_layers(win);
+	layer_cache_update(&win->layers, win, &win->renderer);
+	profile_end(VS_PROFILE_SUBMIT);
+	
+	profile_begin(VS_PROFILE_RECORD);
+	int recorded = record_widgets(win, &win->render);
+	profile_end(VS_PROFILE_RECORD);
+	
+	int result = VS_FAILURE;
+	if (recorded) {
+		profile_begin(VS_PROFILE_SUBMIT);
+		result = gl_render_submit(&win->renderer, &win->render, win->width, win->height);
+		profile_end(VS_PROFILE_SUBMIT);
+	}
+	
+	gl_profile_gpu_end(&win->gpu_timer);
+	if (atomic_load_explicit(&g_latency_enabled, memory_order_relaxed))
+		latency_rendered(&win->latency);
+	return result;
+}
+
+int synthesize_input(window *win, unsigned kind) {
+	switch (kind) {
+	case VS_LATENCY_MOTION: {
+		// Alternate between two points so every event actually moves the pointer
+		static int toggle = 0;
+		toggle = !toggle;
+		xcb_translate_coordinates_cookie_t cookie = xcb_translate_coordinates(g_xcb, win->xwin, g_root,
+			win->width / 4 + toggle * win->width / 2, win->height / 2);
+		xcb_translate_coordinates_reply_t *reply = xcb_platform_reply(cookie.sequence, NULL);
+		if (!reply)
+			vs_err(VS_FAILURE);
+		XTestFakeMotionEvent(g_display, DefaultScreen(g_display), reply->dst_x, reply->dst_y, CurrentTime);
+		free(reply);
+		break;
+	}
+	case VS_LATENCY_BUTTON:
+		XTestFakeButtonEvent(g_display, Button1, True, CurrentTime);
+		XTestFakeButtonEvent(g_display, Button1, False, CurrentTime);
+		break;
+	case VS_LATENCY_KEY: {
+		KeyCode key = XKeysymToKeycode(g_display, XK_space);
+		XTestFakeKeyEvent(g_display, key, True, CurrentTime);
+		XTestFakeKeyEvent(g_display, key, False, CurrentTime);
+		break;
+	}
+	default:
+		vs_err(VS_FAILURE);
+	}
+	XFlush(g_display);
+	return VS_SUCCESS;
+}
+
+int get_gl_state_stats(window *win, gl_state_stats *stats) {
+	*stats = win->gl.last_frame;
 	return VS_SUCCESS;
 }
 
 int swap_buffers(window *win) {
-	glXSwapBuffers(g_display, win->xwin);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	VS_TRACE_BEGIN(swap_buffers);
+	glx_make_current(win);
+	int swap = pacer_should_swap(&win->pacer);
+	if (swap)
+		resize_end_frame(&win->resize, win->width, win->height);
+	capture_end_frame(&win->capture, win->width, win->height, swap);
+	gl_state_end_frame(&win->gl);
+	
+	profile_begin(VS_PROFILE_SWAP);
+	if (swap) {
+		if (atomic_load_explicit(&g_latency_enabled, memory_order_relaxed))
+			glx_latency_swap(&win->latency, win->xwin);
+		else
+			glXSwapBuffers(g_display, win->xwin);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	}
+	profile_end(VS_PROFILE_SWAP);
+	VS_TRACE_END(swap_buffers);
+	pacer_end_frame(&win->pacer, swap);
+	
+	profile_frame_end();
+	replay_frame();
+	arena_end_frame();
+#ifndef VS_COMPILE_DISABLE_TRACE
+	trace_poll();
+#endif
 	return VS_SUCCESS;
 }
 
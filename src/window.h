@@ -10,6 +10,18 @@
 #include "venus.h"
 
 #include "util/types.h"
+#include "engine/render.h"
+#include "engine/texture.h"
+#include "engine/layer.h"
+#include "engine/glstate.h"
+#include "engine/profile.h"
+#include "engine/latency.h"
+#include "engine/resize.h"
+#include "engine/pacing.h"
+#include "engine/capture.h"
+#include "engine/tiles.h"
+#include "engine/path.h"
+#include "engine/effects.h"
 
 typedef unsigned long __x_win;
 typedef struct __GLXcontextRec *__glx_context;
@@ -17,7 +29,7 @@ typedef struct __GLXcontextRec *__glx_context;
 /**
  * @brief Structure that contains the basic building blocks for each venus window.
  * 
- * It carries an X Window and a pointer to it's own separate GLXContext that can be used to draw on the window.
+ * It carries an X Window and it's own separate GLXContext that can be used to draw on the window.
  */
 
 typedef struct {
@@ -27,13 +39,87 @@ typedef struct {
 	/// Child widgets
 	void **children;
 	
-	/// Pointer to the window's unique GLXContext
-	__glx_context *context;
+	/// Always NULL. This lines up with the parent of a widget so that walking up the tree ends at the window.
+	void *parent;
+	
+	/// The window's unique GLXContext
+	__glx_context context;
+	
+	/// Shadow of the GL state of the window's context
+	gl_state gl;
 	
 	/// X window
 	__x_win xwin;
+	
+	/// Colormap of the window's visual
+	__x_win colormap;
+	
+	/// Size of the window in pixels
+	unsigned width;
+	unsigned height;
+	
+	/// The render list built every frame
+	render_list render;
+	
+	/// Scratch state used to record the render list
+	render_recorder recorder;
+	
+	/// GL objects used to submit the render list
+	render_context renderer;
+	
+	/// Images loaded for this window
+	texture_cache textures;
+	
+	/// Widget subtrees cached in textures
+	layer_cache layers;
+	
+	/// Tiles of canvases, rendered on worker threads
+	tile_cache tiles;
+	
+	/// Meshes of the vector paths drawn in the window
+	path_cache paths;
+	
+	/// Cached shadows, and the blur passes behind backdrops
+	effect_cache effects;
+	
+	/// GPU timer queries used by the profiler
+	gpu_timer gpu_timer;
+	
+	/// Input events waiting to reach the screen, used by the latency probe
+	latency_probe latency;
+	
+	/// Sizes from ConfigureNotify waiting to be applied
+	resize_state resize;
+	
+	/// Swap interval, pacing and damage
+	frame_pacer pacer;
+	
+	/// Frame captures in flight
+	capture_ring capture;
+	
+	/// Called with every X event sent to the window. The event is an XEvent*.
+	int (*event_callback)(void *win, void *event);
+	
+	/// Called once the window has settled on a new size, before the frame at that size is drawn
+	int (*resize_callback)(void *win, unsigned width, unsigned height);
 } window;
 
+/// Size of a new window
+#define VS_WINDOW_DEFAULT_WIDTH		1242
+#define VS_WINDOW_DEFAULT_HEIGHT	768
+
+/// GPU memory a window's texture cache may hold before it starts evicting
+#define VS_TEXTURE_DEFAULT_BUDGET	(256ul * 1024 * 1024)
+
+/// GPU memory a window's cached layers may hold
+#define VS_LAYER_DEFAULT_BUDGET		(64ul * 1024 * 1024)
+
+/// GPU memory a window's canvas tiles may hold before the least recently drawn are evicted
+#define VS_TILE_DEFAULT_BUDGET		(128ul * 1024 * 1024)
+
+/// GPU memory a window's cached shadows may hold before the least recently drawn are evicted
+#define VS_EFFECT_DEFAULT_BUDGET	(32ul * 1024 * 1024)
+
 /**
  * @brief Creates a new window
  * 
@@ -48,7 +134,8 @@ int create_window(window *win);
 /**
  * @brief Destroys a window
  * 
- * You should always destroy any window you create in order to ensure that no memory is leaked.
+ * You should always destroy any window you create in order to ensure that no memory is leaked. Every widget in the window
+ * that was made by create_widget() is destroyed with it.
  * 
  * @param win Pointer to window
  * 
@@ -98,9 +185,271 @@ int show(window *win);
  */
 int hide(window *win);
 
+/**
+ * @brief Sets the function called with every X event sent to a window
+ * 
+ * @param win Pointer to window
+ * @param callback Function to call. The event is an XEvent*.
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_event_callback(window *win, int (*callback)(void *win, void *event));
+
+/**
+ * @brief Sets the function called when a window settles on a new size
+ * 
+ * Resizes are coalesced, so while the user drags the window's border the function is only called for the first size
+ * and the last one. This is the place to lay the window's widgets out again.
+ * 
+ * @param win Pointer to window
+ * @param callback Function to call with the new size in pixels
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_resize_callback(window *win, int (*callback)(void *win, unsigned width, unsigned height));
+
+/**
+ * @brief Gets how many resizes a window has seen and how many of them were drawn
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the counts will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_resize_stats(window *win, resize_stats *stats);
+
+/**
+ * @brief Sets how many vblanks a window's swaps wait for
+ * 
+ * @param win Pointer to window
+ * @param interval VS_SWAP_IMMEDIATE, VS_SWAP_VSYNC, VS_SWAP_ADAPTIVE, or a number of vblanks per swap
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_swap_interval(window *win, int interval);
+
+/**
+ * @brief Sets whether a window starts its frames as late as it can
+ * 
+ * With pacing on, the next venus_process_events() sleeps until the time the window's frames take is left before the next
+ * vblank. Events processed after that are drawn in the very next frame. It has no effect without vsync.
+ * 
+ * @param win Pointer to window
+ * @param enabled Whether frames are paced
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_frame_pacing(window *win, int enabled);
+
+/**
+ * @brief Sets whether a window only draws and swaps frames when something in it changed
+ * 
+ * A window is damaged by invalidate_widget(), by adding or removing widgets, by images finishing loading, by exposure,
+ * resizes and theme switches. Widgets changed without any of these are not drawn until something else damages the
+ * window. Frames that are skipped wait for the next vblank instead.
+ * 
+ * @param win Pointer to window
+ * @param enabled Whether undamaged frames are skipped
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_present_on_damage(window *win, int enabled);
+
+/**
+ * @brief Gets how many frames a window presented, skipped and missed
+ * 
+ * Missed vblanks are only counted between frames presented back to back with vsync on.
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the counts will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_frame_stats(window *win, frame_stats *stats);
+
+/**
+ * @brief Captures the next frame a window swaps to a file
+ * 
+ * The frame is read back without waiting for the GPU and written out on a worker thread a frame or two later, so this
+ * can be called every frame. Captures in flight only move along while the window keeps swapping frames.
+ * 
+ * @param win Pointer to window
+ * @param path File to write the frame to
+ * @param format VS_CAPTURE_PNG or VS_CAPTURE_RAW
+ * 
+ * @return Returns whether it was successful or not. It fails, and the capture is dropped, when VS_CAPTURE_SLOTS captures
+ * are already in flight.
+ */
+int capture_frame(window *win, const char *path, int format);
+
+/**
+ * @brief Gets how many of a window's captures were written, dropped or failed
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the counts will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_capture_stats(window *win, capture_stats *stats);
+
+/**
+ * @brief Sets how many threads record a window's widgets
+ * 
+ * Recording is split across threads only when there are enough widgets to make it worthwhile. Submission to OpenGL
+ * always happens on the calling thread. The result is the same no matter how many threads are used.
+ * 
+ * @param win Pointer to window
+ * @param n_threads Number of threads. 0 uses every thread in the worker pool.
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_render_threads(window *win, unsigned n_threads);
+
+/**
+ * @brief Sets how much GPU memory a window's images may hold
+ * 
+ * @param win Pointer to window
+ * @param bytes GPU byte budget
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_texture_budget(window *win, unsigned long bytes);
+
+/**
+ * @brief Gets residency statistics for a window's images
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the statistics will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_texture_stats(window *win, texture_stats *stats);
+
+/**
+ * @brief Sets how much GPU memory a window's cached layers may hold
+ * 
+ * @param win Pointer to window
+ * @param bytes GPU byte budget
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_layer_budget(window *win, unsigned long bytes);
+
+/**
+ * @brief Gets layer cache hits, misses and memory use for a window
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the statistics will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_layer_stats(window *win, layer_stats *stats);
+
+/**
+ * @brief Sets how much GPU memory a window's canvas tiles may hold
+ * 
+ * @param win Pointer to window
+ * @param bytes GPU byte budget
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_tile_budget(window *win, unsigned long bytes);
+
+/**
+ * @brief Gets tile cache residency, render and upload statistics for a window
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the statistics will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_tile_stats(window *win, tile_stats *stats);
+
+/**
+ * @brief Gets how many path meshes a window has cached and how often they were reused
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the statistics will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_path_stats(window *win, path_stats *stats);
+
+/**
+ * @brief Sets the resolution a window blurs shadows and backdrops at
+ * 
+ * Lower quality blurs a downsampled copy, which is cheaper and looks much the same for wide blurs. Every shadow is
+ * rendered again at the new quality.
+ * 
+ * @param win Pointer to window
+ * @param quality VS_EFFECT_QUALITY_LOW, VS_EFFECT_QUALITY_MEDIUM or VS_EFFECT_QUALITY_HIGH
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_effect_quality(window *win, unsigned quality);
+
+/**
+ * @brief Sets how much GPU memory a window's cached shadows may hold
+ * 
+ * @param win Pointer to window
+ * @param bytes GPU byte budget
+ * 
+ * @return Returns whether it was successful or not
+ */
+int set_effect_budget(window *win, unsigned long bytes);
+
+/**
+ * @brief Gets how many shadows a window has cached, how often they were reused and what its backdrops cost
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the statistics will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_effect_stats(window *win, effect_stats *stats);
+
+/**
+ * @brief Gets how many GL state changes the last frame made and how many redundant ones were skipped
+ * 
+ * @param win Pointer to window
+ * @param stats Memory address where the counts will be saved
+ * 
+ * @return Returns whether it was successful or not
+ */
+int get_gl_state_stats(window *win, gl_state_stats *stats);
+
+/**
+ * @brief Sends a synthetic input event to a window through XTest
+ * 
+ * Motion alternates between two points inside the window, and keys and buttons send a press followed by a release. The
+ * events come back through the X server like real input, so they can drive the latency probe.
+ * 
+ * @param win Pointer to window
+ * @param kind VS_LATENCY_KEY, VS_LATENCY_BUTTON or VS_LATENCY_MOTION
+ * 
+ * @return Returns whether it was successful or not
+ */
+int synthesize_input(window *win, unsigned kind);
+
+/**
+ * @brief Draws every widget in a window
+ * 
+ * This uploads any images that finished decoding, renders any cached layers that are out of date, records the widget
+ * tree into the window's render list and submits it to OpenGL. While the window is being resized, the first frame of
+ * the drag is stretched over the window instead, until the size settles.
+ * 
+ * @param win Pointer to window
+ * 
+ * @return Returns whether it was successful or not
+ */
+int draw_window(window *win);
+
 /**
  * @brief Swaps the framebuffers and clears the draw buffer
  * 
+ * Nothing is swapped if draw_window() skipped the frame. With pacing on, or after a skipped frame, the next
+ * venus_process_events() sleeps until it is time to start the next frame. One sleep covers every window.
+ * 
  * TODO This is just a temporary function. I will delete it later because the dev does not need access to the GL buffers
  * 
  * @return Returns whether it was successful or not